@@ -44,11 +44,13 @@
 
 #include <drivers/block/block.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/sound/sound.h>
 #include <drivers/video/terminal.h>
 #include <drivers/video/keys.h>
 
 #include <lib/brkpt.h>
+#include <lib/cmd.h>
 #include <lib/inidsk.h>
 #include <lib/iniram.h>
 #include <lib/initerm.h>
@@ -474,19 +476,59 @@ static void st_set_reset (void *ext, unsigned char val)
 		st_reset(sim, 0);
 }
 
+static
+void st_setup_idle (atari_st_t *sim, ini_sct_t *ini)
+{
+	ini_sct_t     *sct;
+	mem_blk_t     *blk;
+	unsigned long addr, size;
+
+	blk = mem_get_blk (sim->mem, sim->rom_addr);
+
+	if (blk != NULL) {
+		e68_set_idle_rom (sim->cpu, sim->rom_addr, mem_blk_get_size (blk));
+	}
+
+	/* the cpu reads RAM through the memory functions */
+	if (sim->ram != NULL) {
+		e68_set_idle_ram (sim->cpu, mem_blk_get_addr (sim->ram), mem_blk_get_size (sim->ram));
+	}
+
+	sct = NULL;
+
+	while ((sct = ini_next_sct (ini, sct, "idle")) != NULL) {
+		ini_get_uint32 (sct, "address", &addr, 0);
+		ini_get_uint32 (sct, "size", &size, 2);
+
+		pce_log_tag (MSG_INF, "IDLE:", "addr=0x%06lx size=0x%lx\n",
+			addr, size
+		);
+
+		if (e68_add_idle_range (sim->cpu, addr, size)) {
+			pce_log (MSG_ERR, "*** too many idle ranges\n");
+		}
+	}
+}
+
 static
 void st_setup_cpu (atari_st_t *sim, ini_sct_t *ini)
 {
 	ini_sct_t  *sct;
 	const char *model;
-	unsigned   speed;
+	unsigned   speed, idle;
+	int        lazy, lazy_check;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "68000");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "lazy_cc", &lazy, 1);
+	ini_get_bool (sct, "lazy_cc_check", &lazy_check, 0);
+	ini_get_uint16 (sct, "idle", &idle, 16);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d\n", model, speed);
+	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d lazy_cc=%d check=%d idle=%u\n",
+		model, speed, lazy, lazy_check, idle
+	);
 
 	if ((sim->cpu = e68_new()) == NULL) {
 		return;
@@ -496,6 +538,11 @@ void st_setup_cpu (atari_st_t *sim, ini_sct_t *ini)
 		pce_log (MSG_ERR, "*** unknown cpu model (%s)\n", model);
 	}
 
+	e68_set_lazy_cc (sim->cpu, lazy, lazy_check);
+
+	e68_set_idle (sim->cpu, idle);
+	st_setup_idle (sim, ini);
+
 	e68_set_mem_fct (sim->cpu, sim->mem,
 		mem_get_uint8,
 		mem_get_uint16_be,
@@ -746,9 +793,9 @@ void st_setup_disks (atari_st_t *sim, ini_sct_t *ini)
 }
 
 static
-void st_setup_terminal (atari_st_t *sim, ini_sct_t *ini)
+void st_setup_terminal (atari_st_t *sim, ini_sct_t *ini, const char *terminal)
 {
-	sim->trm = ini_get_terminal (ini, par_terminal);
+	sim->trm = ini_get_terminal (ini, terminal);
 
 	if (sim->trm == NULL) {
 		return;
@@ -821,7 +868,7 @@ void st_setup_debug (atari_st_t *sim, ini_sct_t *ini)
 	ini_get_bool (sct, "trace_bios", &sim->debug.trace_bios, 0);
 }
 
-void st_init (atari_st_t *sim, ini_sct_t *ini)
+void st_init (atari_st_t *sim, ini_sct_t *ini, const char *terminal)
 {
 	unsigned i;
 
@@ -852,6 +899,9 @@ void st_init (atari_st_t *sim, ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->mon = NULL;
+	sim->trc = NULL;
+
 	st_setup_system (sim, ini);
 	st_setup_mem (sim, ini);
 	st_setup_cpu (sim, ini);
@@ -865,7 +915,7 @@ void st_init (atari_st_t *sim, ini_sct_t *ini)
 	st_setup_fdc (sim, ini);
 	st_setup_acsi (sim, ini);
 	st_setup_dma (sim, ini);
-	st_setup_terminal (sim, ini);
+	st_setup_terminal (sim, ini, terminal);
 	st_setup_video (sim, ini);
 	st_setup_viking (sim, ini);
 
@@ -885,7 +935,7 @@ void st_init (atari_st_t *sim, ini_sct_t *ini)
 	st_clock_discontinuity (sim);
 }
 
-atari_st_t *st_new (ini_sct_t *ini)
+atari_st_t *st_new (ini_sct_t *ini, const char *terminal)
 {
 	atari_st_t *sim;
 
@@ -895,7 +945,11 @@ atari_st_t *st_new (ini_sct_t *ini)
 		return (NULL);
 	}
 
-	st_init (sim, ini);
+	/* this machine has its own char I/O reactor and monitor symbols */
+	chr_io_set_owner (sim);
+	cmd_set_owner (sim);
+
+	st_init (sim, ini, terminal);
 
 	return (sim);
 }
@@ -921,6 +975,7 @@ void st_free (atari_st_t *sim)
 	e6850_free (&sim->acia0);
 	e68901_free (&sim->mfp);
 	st_smf_free (&sim->smf);
+	trace_del (sim->trc);
 	e68_del (sim->cpu);
 	mem_del (sim->mem);
 
@@ -931,6 +986,8 @@ void st_del (atari_st_t *sim)
 {
 	if (sim != NULL) {
 		st_free (sim);
+		cmd_del_owner (sim);
+		chr_io_del_owner (sim);
 		free (sim);
 	}
 }
@@ -961,6 +1018,31 @@ void st_set_pause (atari_st_t *sim, int pause)
 	}
 }
 
+int st_set_trace (atari_st_t *sim, const char *fname)
+{
+	e68_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "68000");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	e68_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void st_set_speed (atari_st_t *sim, unsigned factor)
 {
 	st_log_deb ("speed = %u\n", factor);
@@ -1204,6 +1286,8 @@ void st_clock (atari_st_t *sim, unsigned n, int runcpu)
 		trm_check (sim->trm);
 	}
 
+	chr_io_poll();
+
 	if (e6850_receive_ready (&sim->acia0)) {
 		unsigned char val;
 
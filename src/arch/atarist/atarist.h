@@ -49,6 +49,8 @@
 #include <drivers/video/keys.h>
 
 #include <lib/brkpt.h>
+#include <lib/monitor.h>
+#include <lib/trace.h>
 
 #include <libini/libini.h>
 
@@ -71,6 +73,12 @@ struct atari_st_s {
 	memory_t      *mem;
 	mem_blk_t     *ram;
 	bp_set_t      bps;
+
+	/* the monitor that controls this instance or NULL */
+	monitor_t     *mon;
+
+	/* the execution trace recorder or NULL */
+	trace_t       *trc;
 	e68901_t      mfp;
 	e6850_t       acia0;
 	e6850_t       acia1;
@@ -135,16 +143,18 @@ struct atari_st_s {
 
 /*****************************************************************************
  * @short Initialize an Atari ST context
- * @param sim  The Atari ST context
- * @param ini  A libini section. Can be NULL.
+ * @param sim      The Atari ST context
+ * @param ini      A libini section. Can be NULL.
+ * @param terminal The terminal driver or NULL to use the config file
  *****************************************************************************/
-void st_init (atari_st_t *sim, ini_sct_t *ini);
+void st_init (atari_st_t *sim, ini_sct_t *ini, const char *terminal);
 
 /*****************************************************************************
  * @short Create and initialize a new Atari ST context
- * @param ini  A libini section. Can be NULL.
+ * @param ini      A libini section. Can be NULL.
+ * @param terminal The terminal driver or NULL to use the config file
  *****************************************************************************/
-atari_st_t *st_new (ini_sct_t *ini);
+atari_st_t *st_new (ini_sct_t *ini, const char *terminal);
 
 /*****************************************************************************
  * @short Free an Atari ST context
@@ -172,6 +182,12 @@ void st_set_pause (atari_st_t *sim, int pause);
 
 void st_set_speed (atari_st_t *sim, unsigned factor);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int st_set_trace (atari_st_t *sim, const char *fname);
+
 int st_set_cpu_model (atari_st_t *sim, const char *model);
 
 void st_set_parport_drv (atari_st_t *sim, char_drv_t *drv);
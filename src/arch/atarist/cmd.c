@@ -27,6 +27,9 @@
 
 #include <string.h>
 
+#include <drivers/char/char-io.h>
+
+#include <lib/cmd.h>
 #include <lib/console.h>
 #include <lib/log.h>
 #include <lib/monitor.h>
@@ -565,6 +568,36 @@ void st_run (atari_st_t *sim)
 	pce_stop();
 }
 
+int st_run_slice (void *ext)
+{
+	unsigned   i;
+	atari_st_t *sim;
+
+	sim = ext;
+
+	chr_io_set_owner (sim);
+	cmd_set_owner (sim);
+
+	for (i = 0; i < PCE_ST_SLICE; i++) {
+		st_clock (sim, 16, 1);
+
+		if (sim->brk) {
+			break;
+		}
+
+		sim->cpu->halt &= ~HALT_STOP;
+	}
+
+	if (sim->brk == PCE_BRK_ABORT) {
+		return (1);
+	}
+
+	/* there is no monitor to stop in */
+	sim->brk = 0;
+
+	return (0);
+}
+
 
 
 /*
@@ -582,10 +615,10 @@ void st_run_emscripten (atari_st_t *sim)
 	st_clock_discontinuity (sim);
 
 #ifdef __EMSCRIPTEN__
-	emscripten_set_main_loop(st_run_emscripten_step, 0, 1);
+	emscripten_set_main_loop_arg (st_run_emscripten_step, sim, 0, 1);
 #else
 	while (!sim->brk) {
-		st_run_emscripten_step();
+		st_run_emscripten_step (sim);
 	}
 #endif
 
@@ -596,9 +629,9 @@ void st_run_emscripten (atari_st_t *sim)
 /*
  * run one iteration
  */
-void st_run_emscripten_step (void)
+void st_run_emscripten_step (void *ext)
 {
-	atari_st_t *sim = par_sim;
+	atari_st_t *sim = ext;
 
 	/*
 	 * for each 'emscripten step' we'll run a bunch of actual cycles
@@ -1459,6 +1492,8 @@ int st_cmd (atari_st_t *sim, cmd_t *cmd)
 
 void st_cmd_init (atari_st_t *sim, monitor_t *mon)
 {
+	sim->mon = mon;
+
 	mon_cmd_add (mon, par_cmd, sizeof (par_cmd) / sizeof (par_cmd[0]));
 	mon_cmd_add_bp (mon);
 
@@ -34,12 +34,18 @@ void st_print_state_cpu (atari_st_t *sim);
 
 void st_run (atari_st_t *sim);
 
+/*
+ * Run one time slice without a monitor, for use with a runner_t.
+ * Returns 1 if the instance has terminated.
+ */
+int st_run_slice (void *ext);
+
 int st_cmd (atari_st_t *sim, cmd_t *cmd);
 
 void st_cmd_init (atari_st_t *sim, monitor_t *mon);
 
 /* emscripten specific run loop */
 void st_run_emscripten (atari_st_t *sim);
-void st_run_emscripten_step (void);
+void st_run_emscripten_step (void *ext);
 
 #endif
@@ -37,6 +37,7 @@
 #include <lib/log.h>
 #include <lib/monitor.h>
 #include <lib/path.h>
+#include <lib/runner.h>
 #include <lib/sysdep.h>
 
 #include <libini/libini.h>
@@ -51,16 +52,21 @@
 #endif
 
 
-const char *par_terminal = NULL;
+static const char *par_terminal = NULL;
 
-atari_st_t  *par_sim = NULL;
+static const char *par_trace = NULL;
 
-monitor_t  par_mon;
+static atari_st_t *par_sim = NULL;
 
-ini_sct_t  *par_cfg = NULL;
+static monitor_t  par_mon;
 
+static ini_sct_t  *par_cfg = NULL;
+
+static ini_strings_t par_ini_pre;
 static ini_strings_t par_ini_str;
 
+static runner_t      *par_runner = NULL;
+
 
 static pce_option_t opts[] = {
 	{ '?', 0, "help", NULL, "Print usage information" },
@@ -68,13 +74,16 @@ static pce_option_t opts[] = {
 	{ 'd', 1, "path", "string", "Add a directory to the search path" },
 	{ 'i', 1, "ini-prefix", "string", "Add an ini string before the config file" },
 	{ 'I', 1, "ini-append", "string", "Add an ini string after the config file" },
+	{ 'j', 1, "threads", "int", "Set the number of threads for -n [1]" },
 	{ 'l', 1, "log", "string", "Set the log file name [none]" },
+	{ 'n', 1, "instances", "int", "Run several instances without monitor [1]" },
 	{ 'p', 1, "cpu", "string", "Set the CPU model" },
 	{ 'q', 0, "quiet", NULL, "Set the log level to error [no]" },
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
 	{ 'R', 0, "no-monitor", NULL, "Never stop running [no]" },
 	{ 's', 1, "speed", "int", "Set the CPU speed" },
 	{ 't', 1, "terminal", "string", "Set the terminal device" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -121,6 +130,11 @@ void sig_int (int s)
 	fprintf (stderr, "pce-atarist: sigint\n");
 	fflush (stderr);
 
+	if (par_runner != NULL) {
+		runner_stop (par_runner);
+		return;
+	}
+
 	if (par_sim->brk == 0) {
 		par_sim->brk = PCE_BRK_STOP;
 	}
@@ -135,6 +149,11 @@ void sig_term (int s)
 	fprintf (stderr, "pce-atarist: sigterm\n");
 	fflush (stderr);
 
+	if (par_runner != NULL) {
+		runner_stop (par_runner);
+		return;
+	}
+
 	par_sim->brk = PCE_BRK_ABORT;
 }
 
@@ -193,6 +212,152 @@ int cmd_set_sym (atari_st_t *sim, const char *sym, unsigned long val)
 	return (1);
 }
 
+int emu_msg(const char *msg, const char *val);
+__attribute__((used)) int emu_msg(const char *msg, const char *val)
+{
+	if (par_sim == 0)
+	{
+		pce_log(MSG_ERR, "emu_msg: no simulator\n");
+		return 1;
+	}
+	pce_log(MSG_DEB, "emu_msg: %s %s\n", msg, val);
+	return trm_set_msg_emu(par_sim->trm, msg, val);
+}
+
+
+static
+ini_sct_t *st_load_config (const char *fname, unsigned inst)
+{
+	char      buf[64];
+	ini_sct_t *ini, *sct;
+
+	ini = ini_sct_new (NULL);
+
+	if (ini == NULL) {
+		return (NULL);
+	}
+
+	sprintf (buf, "cfg.instance = %u\n", inst);
+
+	if (ini_read_str (ini, buf) || ini_str_eval (&par_ini_pre, ini, 0)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	if (pce_load_config (ini, fname)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	sct = ini_next_sct (ini, NULL, "atarist");
+
+	if (sct == NULL) {
+		sct = ini;
+	}
+
+	if (ini_str_eval (&par_ini_str, sct, 0)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	return (ini);
+}
+
+/*
+ * Run cnt independent instances on a pool of threads. Each instance
+ * loads its own copy of the config file, with cfg.instance set to
+ * its index.
+ */
+static
+int st_run_multi (const char *fname, unsigned cnt, unsigned threads)
+{
+	int        r;
+	unsigned   i;
+	ini_sct_t  **ini, *sct;
+	atari_st_t **sim;
+	runner_t   run;
+
+	ini = malloc (cnt * sizeof (ini_sct_t *));
+	sim = malloc (cnt * sizeof (atari_st_t *));
+
+	if ((ini == NULL) || (sim == NULL)) {
+		free (ini);
+		free (sim);
+		return (1);
+	}
+
+	runner_init (&run, threads);
+
+	for (i = 0; i < cnt; i++) {
+		ini[i] = NULL;
+		sim[i] = NULL;
+	}
+
+	r = 0;
+
+	for (i = 0; i < cnt; i++) {
+		if ((ini[i] = st_load_config (fname, i)) == NULL) {
+			pce_log (MSG_ERR, "*** loading the config for instance %u failed\n", i);
+			r = 1;
+			break;
+		}
+
+		if ((sct = ini_next_sct (ini[i], NULL, "atarist")) == NULL) {
+			sct = ini[i];
+		}
+
+		if (i == 0) {
+			pce_path_ini (sct);
+		}
+
+		sim[i] = st_new (sct, (par_terminal != NULL) ? par_terminal : "null");
+
+		if (sim[i] == NULL) {
+			pce_log (MSG_ERR, "*** setting up instance %u failed\n", i);
+			r = 1;
+			break;
+		}
+
+		cmd_init (sim[i], cmd_get_sym, cmd_set_sym);
+
+		st_reset (sim[i], 1);
+
+		if (i > 0) {
+			mem_share_rom (sim[i]->mem, sim[0]->mem);
+		}
+
+		runner_add (&run, sim[i], st_run_slice);
+	}
+
+	if (r == 0) {
+		pce_log_tag (MSG_INF, "RUNNER:", "instances=%u threads=%u\n",
+			run.cnt, run.threads
+		);
+
+		par_runner = &run;
+
+		pce_start();
+
+		runner_run (&run);
+
+		pce_stop();
+
+		par_runner = NULL;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		st_del (sim[i]);
+		ini_sct_del (ini[i]);
+	}
+
+	runner_free (&run);
+
+	free (sim);
+	free (ini);
+
+	return (r);
+}
+
 void st_log_deb (const char *msg, ...)
 {
 	va_list       va;
@@ -217,12 +382,15 @@ int main (int argc, char *argv[])
 	int       r;
 	char      **optarg;
 	int       run, nomon;
+	unsigned  inst, threads;
 	char      *cfg;
 	ini_sct_t *sct;
 
 	cfg = NULL;
 	run = 0;
 	nomon = 0;
+	inst = 1;
+	threads = 1;
 
 	pce_log_init();
 	pce_log_add_fp (stderr, 0, MSG_INF);
@@ -233,6 +401,7 @@ int main (int argc, char *argv[])
 		return (1);
 	}
 
+	ini_str_init (&par_ini_pre);
 	ini_str_init (&par_ini_str);
 
 	while (1) {
@@ -264,23 +433,25 @@ int main (int argc, char *argv[])
 			break;
 
 		case 'i':
-			if (ini_read_str (par_cfg, optarg[0])) {
-				fprintf (stderr,
-					"%s: error parsing ini string (%s)\n",
-					argv[0], optarg[0]
-				);
-				return (1);
-			}
+			ini_str_add (&par_ini_pre, optarg[0], "\n", NULL);
 			break;
 
 		case 'I':
 			ini_str_add (&par_ini_str, optarg[0], "\n", NULL);
 			break;
 
+		case 'j':
+			threads = strtoul (optarg[0], NULL, 0);
+			break;
+
 		case 'l':
 			pce_log_add_fname (optarg[0], MSG_DEB);
 			break;
 
+		case 'n':
+			inst = strtoul (optarg[0], NULL, 0);
+			break;
+
 		case 'p':
 			ini_str_add (&par_ini_str, "cpu.model = \"",
 				optarg[0], "\"\n"
@@ -309,6 +480,10 @@ int main (int argc, char *argv[])
 			par_terminal = optarg[0];
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 'v':
 			pce_log_set_level (stderr, MSG_DEB);
 			break;
@@ -326,6 +501,25 @@ int main (int argc, char *argv[])
 
 	st_log_banner();
 
+	if (inst > 1) {
+		atexit (st_atexit);
+		signal (SIGINT, sig_int);
+		signal (SIGTERM, sig_term);
+
+		r = st_run_multi (cfg, inst, threads);
+
+		ini_str_free (&par_ini_pre);
+		ini_str_free (&par_ini_str);
+		ini_sct_del (par_cfg);
+		pce_log_done();
+
+		return (r);
+	}
+
+	if (ini_str_eval (&par_ini_pre, par_cfg, 1)) {
+		return (1);
+	}
+
 	if (pce_load_config (par_cfg, cfg)) {
 		return (1);
 	}
@@ -354,7 +548,15 @@ int main (int argc, char *argv[])
 
 	pce_console_init (stdin, stdout);
 
-	par_sim = st_new (sct);
+	par_sim = st_new (sct, par_terminal);
+
+	if (par_trace != NULL) {
+		if (st_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
 
 	mon_init (&par_mon);
 	mon_set_cmd_fct (&par_mon, st_cmd, par_sim);
@@ -29,6 +29,9 @@
 
 #define ST_CPU_CLOCK 8000000
 
+/* the number of st_clock() calls in a runner time slice */
+#define PCE_ST_SLICE 32768
+
 
 struct atari_st_s;
 typedef struct atari_st_s atari_st_t;
@@ -36,10 +39,6 @@ typedef struct atari_st_s atari_st_t;
 
 extern int        par_verbose;
 
-extern const char *par_terminal;
-
-extern atari_st_t *par_sim;
-
 
 void sim_stop (void);
 
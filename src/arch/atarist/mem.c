@@ -307,7 +307,7 @@ void st_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 		if (st_mem_check_ram_addr(sim, addr))
 		{
 			if (addr < sim->ram->size)
-				sim->ram->data[addr] = val;
+				mem_blk_set_uint8 (sim->ram, addr, val);
 		}
 		return;
 	}
@@ -439,7 +439,7 @@ void st_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 		if (st_mem_check_ram_addr(sim, addr))
 		{
 			if (addr < sim->ram->size)
-				buf_set_uint16_be(sim->ram->data, addr, val);
+				mem_blk_set_uint16_be (sim->ram, addr, val);
 		}
 		return;
 	}
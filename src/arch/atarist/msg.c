@@ -37,9 +37,6 @@
 #include <lib/sysdep.h>
 
 
-extern monitor_t par_mon;
-
-
 typedef struct {
 	const char *msg;
 
@@ -127,7 +124,9 @@ int st_set_msg_emu_exit (atari_st_t *sim, const char *msg, const char *val)
 {
 	sim->brk = PCE_BRK_ABORT;
 
-	mon_set_terminate (&par_mon, 1);
+	if (sim->mon != NULL) {
+		mon_set_terminate (sim->mon, 1);
+	}
 
 	return (0);
 }
@@ -519,31 +518,13 @@ static st_msg_list_t set_msg_list[] = {
 };
 
 
-int emu_msg(const char *msg, const char *val);
-__attribute__((used)) int emu_msg(const char *msg, const char *val)
-{
-	if (par_sim == 0)
-	{
-		pce_log(MSG_ERR, "emu_msg: no simulator\n");
-		return 1;
-	}
-	pce_log(MSG_DEB, "emu_msg: %s %s\n", msg, val);
-	return trm_set_msg_emu(par_sim->trm, msg, val);
-}
-
-
 int st_set_msg (void *ext, const char *msg, const char *val)
 {
 	atari_st_t *sim = (atari_st_t *)ext;
 	int           r;
 	st_msg_list_t *lst;
 
-	/* a hack, for debugging only */
-	if (sim == NULL) {
-		sim = par_sim;
-	}
-
-	if (msg == NULL) {
+	if ((sim == NULL) || (msg == NULL)) {
 		return (1);
 	}
 
@@ -700,7 +700,33 @@ void bios_boot (cpm80_t *sim, int warm)
 static
 void bios_const (cpm80_t *sim)
 {
-	e8080_set_a (sim->cpu, con_ready (sim) ? 0xff : 0x00);
+	unsigned long clk;
+
+	if (con_ready (sim)) {
+		sim->con_idle_cnt = 0;
+		e8080_set_a (sim->cpu, 0xff);
+		return;
+	}
+
+	e8080_set_a (sim->cpu, 0x00);
+
+	/* a program that only polls the console is waiting for input */
+	clk = e8080_get_clock (sim->cpu);
+
+	if ((clk - sim->con_idle_clk) < CPM80_IDLE_CLK) {
+		if (sim->con_idle_cnt < CPM80_IDLE_POLLS) {
+			sim->con_idle_cnt += 1;
+		}
+	}
+	else {
+		sim->con_idle_cnt = 0;
+	}
+
+	sim->con_idle_clk = clk;
+
+	if (sim->con_idle_cnt >= CPM80_IDLE_POLLS) {
+		c80_idle_wait (sim, sim->con);
+	}
 }
 
 /*
@@ -714,7 +740,7 @@ void bios_conin (cpm80_t *sim)
 	if (con_getc (sim, &c)) {
 		c = 0x1a;
 		e8080_set_pc (sim->cpu, e8080_get_pc (sim->cpu) - 1);
-		c80_idle (sim);
+		c80_idle_wait (sim, sim->con);
 	}
 
 	e8080_set_a (sim->cpu, c);
@@ -779,7 +805,7 @@ void bios_reader (cpm80_t *sim)
 	if (aux_getc (sim, &c)) {
 		c = 0x1a;
 		e8080_set_pc (sim->cpu, e8080_get_pc (sim->cpu) - 1);
-		c80_idle (sim);
+		c80_idle_wait (sim, sim->aux);
 	}
 
 	e8080_set_a (sim->cpu, c);
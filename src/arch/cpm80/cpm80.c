@@ -243,6 +243,9 @@ void c80_setup_cpu (cpm80_t *sim, ini_sct_t *ini)
 
 		e8080_set_mem_map_rd (sim->cpu, 0, size - 1, data);
 		e8080_set_mem_map_wr (sim->cpu, 0, size - 1, data);
+		e8080_set_mem_map_dirty (sim->cpu, 0, size - 1,
+			mem_blk_dirty_map (sim->ram), MEM_DIRTY_SHIFT
+		);
 	}
 
 	sim->clock = clock;
@@ -273,6 +276,9 @@ void c80_setup_char (cpm80_t *sim, ini_sct_t *ini)
 	sim->aux_buf = 0;
 	sim->aux_buf_cnt = 0;
 
+	sim->con_idle_cnt = 0;
+	sim->con_idle_clk = 0;
+
 	sct = ini_next_sct (ini, NULL, "system");
 
 	ini_get_string (sct, "con", &con, NULL);
@@ -339,6 +345,8 @@ cpm80_t *c80_new (ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->trc = NULL;
+
 	c80_setup_system (sim, ini);
 	c80_setup_mem (sim, ini);
 	c80_setup_cpu (sim, ini);
@@ -377,6 +385,7 @@ void c80_del (cpm80_t *sim)
 
 	dsks_del (sim->dsks);
 	c80_del_char (sim);
+	trace_del (sim->trc);
 	e8080_del (sim->cpu);
 	mem_del (sim->mem);
 	bps_free (&sim->bps);
@@ -389,6 +398,31 @@ void c80_stop (cpm80_t *sim)
 	c80_set_msg (sim, "emu.stop", NULL);
 }
 
+int c80_set_trace (cpm80_t *sim, const char *fname)
+{
+	e8080_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, (e8080_get_flags (sim->cpu) & E8080_FLAG_Z80) ? "z80" : "8080");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	e8080_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void c80_reset (cpm80_t *sim)
 {
 	e8080_reset (sim->cpu);
@@ -492,6 +526,15 @@ void c80_idle (cpm80_t *sim)
 	c80_clock_discontinuity (sim);
 }
 
+void c80_idle_wait (cpm80_t *sim, char_drv_t *drv)
+{
+	if (chr_wait (drv, CPM80_IDLE_WAIT) < 0) {
+		pce_usleep (10000);
+	}
+
+	c80_clock_discontinuity (sim);
+}
+
 void c80_clock_discontinuity (cpm80_t *sim)
 {
 	sim->sync_clk = 0;
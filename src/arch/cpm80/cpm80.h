@@ -30,6 +30,7 @@
 #include <drivers/char/char.h>
 #include <libini/libini.h>
 #include <lib/brkpt.h>
+#include <lib/trace.h>
 
 
 #define PCE_BRK_STOP  1
@@ -39,6 +40,15 @@
 #define CPM80_CPU_SYNC  100
 #define CPM80_DRIVE_MAX 16
 
+/*
+ * The console is considered idle after CPM80_IDLE_POLLS status polls
+ * without input that are less than CPM80_IDLE_CLK clock cycles apart.
+ * The host then blocks for up to CPM80_IDLE_WAIT microseconds.
+ */
+#define CPM80_IDLE_POLLS 64
+#define CPM80_IDLE_CLK   2048
+#define CPM80_IDLE_WAIT  50000
+
 #define CPM80_MODEL_PLAIN 0
 #define CPM80_MODEL_CPM   1
 
@@ -56,6 +66,9 @@ typedef struct cpm80_s {
 
 	bp_set_t       bps;
 
+	/* the execution trace recorder or NULL */
+	trace_t      *trc;
+
 	unsigned long  clk_cnt;
 	unsigned long  clk_div;
 
@@ -82,6 +95,9 @@ typedef struct cpm80_s {
 	unsigned char  aux_buf;
 	unsigned char  aux_buf_cnt;
 
+	unsigned       con_idle_cnt;
+	unsigned long  con_idle_clk;
+
 	disks_t        *dsks;
 
 	unsigned char  boot;
@@ -117,6 +133,12 @@ void c80_stop (cpm80_t *sim);
 
 void c80_reset (cpm80_t *sim);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int c80_set_trace (cpm80_t *sim, const char *fname);
+
 int c80_set_cpu_model (cpm80_t *sim, const char *str);
 
 int c80_set_con_read (cpm80_t *sim, const char *fname);
@@ -126,6 +148,13 @@ int c80_set_aux_write (cpm80_t *sim, const char *fname, int append);
 
 void c80_idle (cpm80_t *sim);
 
+/*!***************************************************************************
+ * @short Block the host until input is available on a character driver
+ *
+ * If the driver does not support waiting, this is the same as c80_idle().
+ *****************************************************************************/
+void c80_idle_wait (cpm80_t *sim, char_drv_t *drv);
+
 void c80_clock_discontinuity (cpm80_t *sim);
 
 void c80_set_clock (cpm80_t *sim, unsigned long clock);
@@ -49,6 +49,8 @@ ini_sct_t  *par_cfg = NULL;
 
 static ini_strings_t par_ini_str;
 
+static const char    *par_trace = NULL;
+
 
 static pce_option_t opts[] = {
 	{ '?', 0, "help", NULL, "Print usage information" },
@@ -62,6 +64,7 @@ static pce_option_t opts[] = {
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
 	{ 'R', 0, "no-monitor", NULL, "Never stop running [no]" },
 	{ 's', 1, "speed", "int", "Set the CPU speed" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -278,6 +281,10 @@ int main (int argc, char *argv[])
 			run = 1;
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 'R':
 			nomon = 1;
 			break;
@@ -321,6 +328,14 @@ int main (int argc, char *argv[])
 
 	par_sim = c80_new (sct);
 
+	if (par_trace != NULL) {
+		if (c80_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
+
 	signal (SIGINT, sig_int);
 	signal (SIGTERM, sig_term);
 	signal (SIGSEGV, sig_segv);
@@ -224,7 +224,7 @@ void sim_print_state_cpu (dos_t *sim, FILE *fp)
 		e86_get_ds (c), e86_get_si (c),
 		e86_get_es (c), e86_get_di (c),
 		e86_get_ss (c), e86_get_sp (c),
-		c->flg
+		e86_get_flags (c)
 	);
 
 	fprintf (fp,
@@ -439,8 +439,11 @@ int sim_init (dos_t *sim, unsigned kb)
 
 	for (i = 0; i < sim->file_cnt; i++) {
 		sim->file[i] = NULL;
+		sim->map[i] = NULL;
 	}
 
+	sim->use_mmap = 0;
+
 	sim->file[0] = stdin;
 	sim->file[1] = stdout;
 	sim->file[2] = stderr;
@@ -35,6 +35,18 @@
 #define DOS_DRIVES_MAX 26
 
 
+/*
+ * A read-only file that is mapped into host memory. Handles that are
+ * duplicated share the map and with it the file position.
+ */
+typedef struct {
+	unsigned       refcnt;
+	unsigned char  *data;
+	unsigned long  size;
+	unsigned long  pos;
+} dos_map_t;
+
+
 typedef struct {
 	e8086_t        cpu;
 
@@ -52,6 +64,10 @@ typedef struct {
 	unsigned       file_cnt;
 	FILE           *file[DOS_FILES_MAX];
 
+	/* map read-only files into memory */
+	char           use_mmap;
+	dos_map_t      *map[DOS_FILES_MAX];
+
 	unsigned       drive_cnt;
 	char           *drive[DOS_DRIVES_MAX];
 
@@ -35,6 +35,10 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 
 static
 unsigned sim_get_free_fd (dos_t *sim)
@@ -60,6 +64,219 @@ FILE *int21_get_fp (dos_t *sim, unsigned fd)
 	return (sim->file[fd]);
 }
 
+/*
+ * Map a file that was opened read-only into memory
+ */
+static
+void int21_map_file (dos_t *sim, unsigned fd)
+{
+#ifdef HAVE_SYS_MMAN_H
+	void        *p;
+	struct stat st;
+	dos_map_t   *map;
+
+	sim->map[fd] = NULL;
+
+	if (fstat (fileno (sim->file[fd]), &st)) {
+		return;
+	}
+
+	if (!S_ISREG (st.st_mode) || (st.st_size == 0) || (st.st_size > 0x7fffffff)) {
+		return;
+	}
+
+	p = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno (sim->file[fd]), 0);
+
+	if (p == MAP_FAILED) {
+		return;
+	}
+
+	if ((map = malloc (sizeof (dos_map_t))) == NULL) {
+		munmap (p, st.st_size);
+		return;
+	}
+
+	map->refcnt = 1;
+	map->data = p;
+	map->size = st.st_size;
+	map->pos = 0;
+
+	sim->map[fd] = map;
+#endif
+}
+
+static
+void int21_unmap_file (dos_t *sim, unsigned fd)
+{
+	dos_map_t *map;
+
+	if ((map = sim->map[fd]) == NULL) {
+		return;
+	}
+
+	sim->map[fd] = NULL;
+
+	map->refcnt -= 1;
+
+	if (map->refcnt > 0) {
+		return;
+	}
+
+#ifdef HAVE_SYS_MMAN_H
+	munmap (map->data, map->size);
+#endif
+
+	free (map);
+}
+
+/*
+ * Get the current size of a mapped file, which may have grown since
+ * it was mapped
+ */
+static
+unsigned long int21_map_get_size (dos_t *sim, unsigned fd)
+{
+	struct stat st;
+
+	if (fstat (fileno (sim->file[fd]), &st)) {
+		return (sim->map[fd]->size);
+	}
+
+	return (st.st_size);
+}
+
+/*
+ * Make the stdio file position match the mapped file position
+ */
+static
+void int21_sync_map (dos_t *sim, unsigned fd)
+{
+	if (sim->map[fd] != NULL) {
+		fseek (sim->file[fd], sim->map[fd]->pos, SEEK_SET);
+	}
+}
+
+static
+unsigned int21_fread (dos_t *sim, unsigned fd, void *buf, unsigned cnt)
+{
+	unsigned      n;
+	unsigned char *p;
+	dos_map_t     *map;
+
+	map = sim->map[fd];
+
+	if (map == NULL) {
+		return (fread (buf, 1, cnt, sim->file[fd]));
+	}
+
+	p = buf;
+	n = 0;
+
+	if (map->pos < map->size) {
+		n = cnt;
+
+		if (n > (map->size - map->pos)) {
+			n = map->size - map->pos;
+		}
+
+		memcpy (p, map->data + map->pos, n);
+
+		map->pos += n;
+	}
+
+	if (n < cnt) {
+		/* read data beyond the mapped end if the file has grown */
+		if (int21_map_get_size (sim, fd) > map->pos) {
+			fseek (sim->file[fd], map->pos, SEEK_SET);
+			n += fread (p + n, 1, cnt - n, sim->file[fd]);
+			map->pos = ftell (sim->file[fd]);
+		}
+	}
+
+	return (n);
+}
+
+/*
+ * Read up to cnt bytes from a file to the linear address addr
+ */
+static
+unsigned int21_read_blk (dos_t *sim, unsigned fd, unsigned long addr, unsigned cnt)
+{
+	unsigned      i, n, r, ret;
+	unsigned char buf[512];
+
+	if ((addr + cnt) <= sim->mem_cnt) {
+		return (int21_fread (sim, fd, sim->mem + addr, cnt));
+	}
+
+	/* partly outside of memory */
+	ret = 0;
+
+	while (ret < cnt) {
+		n = cnt - ret;
+
+		if (n > sizeof (buf)) {
+			n = sizeof (buf);
+		}
+
+		r = int21_fread (sim, fd, buf, n);
+
+		for (i = 0; i < r; i++) {
+			if ((addr + i) < sim->mem_cnt) {
+				sim->mem[addr + i] = buf[i];
+			}
+		}
+
+		ret += r;
+		addr += r;
+
+		if (r < n) {
+			break;
+		}
+	}
+
+	return (ret);
+}
+
+/*
+ * Write up to cnt bytes from the linear address addr to a file
+ */
+static
+unsigned int21_write_blk (dos_t *sim, FILE *fp, unsigned long addr, unsigned cnt)
+{
+	unsigned      i, n, r, ret;
+	unsigned char buf[512];
+
+	if ((addr + cnt) <= sim->mem_cnt) {
+		return (fwrite (sim->mem + addr, 1, cnt, fp));
+	}
+
+	ret = 0;
+
+	while (ret < cnt) {
+		n = cnt - ret;
+
+		if (n > sizeof (buf)) {
+			n = sizeof (buf);
+		}
+
+		for (i = 0; i < n; i++) {
+			buf[i] = ((addr + i) < sim->mem_cnt) ? sim->mem[addr + i] : 0;
+		}
+
+		r = fwrite (buf, 1, n, fp);
+
+		ret += r;
+		addr += r;
+
+		if (r < n) {
+			break;
+		}
+	}
+
+	return (ret);
+}
+
 static
 void int21_find_done (dos_t *sim)
 {
@@ -761,6 +978,12 @@ int int21_fct_3d (dos_t *sim)
 
 	free (name);
 
+	sim->map[fd] = NULL;
+
+	if (sim->use_mmap && ((e86_get_al (&sim->cpu) & 0x0f) == 0)) {
+		int21_map_file (sim, fd);
+	}
+
 	int21_ret (sim, 0, fd);
 
 	return (0);
@@ -783,6 +1006,8 @@ int int21_fct_3e (dos_t *sim)
 		return (int21_ret (sim, 1, 0x0006));
 	}
 
+	int21_unmap_file (sim, fd);
+
 	if ((fp != stdin) && (fp != stdout) && (fp != stderr)) {
 		fclose (fp);
 	}
@@ -802,11 +1027,14 @@ int int21_fct_3f (dos_t *sim)
 {
 	int            c;
 	int            tty, lf;
-	unsigned       i, cnt;
+	unsigned       fd;
+	unsigned       i, n, r, cnt;
 	unsigned short seg, ofs;
 	FILE           *fp;
 
-	if ((fp = int21_get_fp (sim, e86_get_bx (&sim->cpu))) == NULL) {
+	fd = e86_get_bx (&sim->cpu);
+
+	if ((fp = int21_get_fp (sim, fd)) == NULL) {
 		return (int21_ret (sim, 1, 6));
 	}
 
@@ -816,6 +1044,32 @@ int int21_fct_3f (dos_t *sim)
 	seg = e86_get_ds (&sim->cpu);
 	ofs = e86_get_dx (&sim->cpu);
 
+	if (tty == 0) {
+		/* read in blocks, wrapping around at the end of the segment */
+		i = 0;
+
+		while (i < cnt) {
+			n = cnt - i;
+
+			if (n > (0x10000 - ofs)) {
+				n = 0x10000 - ofs;
+			}
+
+			r = int21_read_blk (sim, fd, ((unsigned long) seg << 4) + ofs, n);
+
+			i += r;
+			ofs = (ofs + r) & 0xffff;
+
+			if (r < n) {
+				break;
+			}
+		}
+
+		int21_ret (sim, 0, i);
+
+		return (0);
+	}
+
 	lf = 0;
 
 	for (i = 0; i < cnt; i++) {
@@ -828,7 +1082,7 @@ int int21_fct_3f (dos_t *sim)
 				break;
 			}
 
-			if (tty && (c == 0x0a)) {
+			if (c == 0x0a) {
 				c = 0x0d;
 				lf = 1;
 			}
@@ -837,7 +1091,7 @@ int int21_fct_3f (dos_t *sim)
 		sim_set_uint8 (sim, seg, ofs, c);
 		ofs = (ofs + 1) & 0xffff;
 
-		if (tty && (c == 0x0a)) {
+		if (c == 0x0a) {
 			i += 1;
 			break;
 		}
@@ -854,8 +1108,7 @@ int int21_fct_3f (dos_t *sim)
 static
 int int21_fct_40 (dos_t *sim)
 {
-	int            c;
-	unsigned       i, cnt;
+	unsigned       i, n, r, cnt;
 	unsigned short seg, ofs;
 	FILE           *fp;
 
@@ -871,10 +1124,23 @@ int int21_fct_40 (dos_t *sim)
 		ftruncate (fileno (fp), ftell (fp));
 	}
 
-	for (i = 0; i < cnt; i++) {
-		c = sim_get_uint8 (sim, seg, ofs);
-		fputc (c, fp);
-		ofs = (ofs + 1) & 0xfffff;
+	i = 0;
+
+	while (i < cnt) {
+		n = cnt - i;
+
+		if (n > (0x10000 - ofs)) {
+			n = 0x10000 - ofs;
+		}
+
+		r = int21_write_blk (sim, fp, ((unsigned long) seg << 4) + ofs, n);
+
+		i += r;
+		ofs = (ofs + r) & 0xffff;
+
+		if (r < n) {
+			break;
+		}
 	}
 
 	fflush (fp);
@@ -917,6 +1183,42 @@ int int21_fct_41 (dos_t *sim)
 	return (0);
 }
 
+static
+int int21_seek_map (dos_t *sim, unsigned fd, unsigned long ofs)
+{
+	long      pos;
+	dos_map_t *map;
+
+	map = sim->map[fd];
+
+	pos = (ofs & 0x80000000) ? -(long) ((~ofs + 1) & 0xffffffff) : (long) ofs;
+
+	switch (e86_get_al (&sim->cpu)) {
+	case 0:
+		break;
+	case 1:
+		pos += map->pos;
+		break;
+	case 2:
+		pos += int21_map_get_size (sim, fd);
+		break;
+	default:
+		return (int21_ret (sim, 1, 0x0001));
+	}
+
+	if (pos < 0) {
+		return (int21_ret (sim, 1, 0x0019));
+	}
+
+	map->pos = pos;
+
+	e86_set_dx (&sim->cpu, (pos >> 16) & 0xffff);
+
+	int21_ret (sim, 0, pos & 0xffff);
+
+	return (0);
+}
+
 /*
  * 42: Seek
  */
@@ -924,16 +1226,23 @@ static
 int int21_fct_42 (dos_t *sim)
 {
 	FILE          *fp;
+	unsigned      fd;
 	unsigned long ofs;
 	int           whence;
 
-	if ((fp = int21_get_fp (sim, e86_get_bx (&sim->cpu))) == NULL) {
+	fd = e86_get_bx (&sim->cpu);
+
+	if ((fp = int21_get_fp (sim, fd)) == NULL) {
 		return (int21_ret (sim, 1, 6));
 	}
 
 	ofs = e86_get_cx (&sim->cpu);
 	ofs = (ofs << 16) | e86_get_dx (&sim->cpu);
 
+	if (sim->map[fd] != NULL) {
+		return (int21_seek_map (sim, fd, ofs));
+	}
+
 	switch (e86_get_al (&sim->cpu)) {
 	case 0:
 		whence = SEEK_SET;
@@ -1111,6 +1420,8 @@ int int21_fct_45 (dos_t *sim)
 		return (int21_ret (sim, 1, 0x0001));
 	}
 
+	int21_sync_map (sim, e86_get_bx (&sim->cpu));
+
 	fd1 = fileno (fp);
 	fd2 = dup (fd1);
 
@@ -1133,6 +1444,11 @@ int int21_fct_45 (dos_t *sim)
 		return (int21_ret (sim, 1, 0x0001));
 	}
 
+	/* both handles share the mapped file position */
+	if ((sim->map[fd] = sim->map[e86_get_bx (&sim->cpu)]) != NULL) {
+		sim->map[fd]->refcnt += 1;
+	}
+
 	return (int21_ret (sim, 0, fd));
 }
 
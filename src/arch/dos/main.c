@@ -42,6 +42,7 @@ static pce_option_t opts[] = {
 	{ 'e', 1, "setenv", "string", "Add a string to the environment" },
 	{ 'l', 0, "log-int", NULL, "Log interrupts [no]" },
 	{ 'm', 1, "memory", "int", "Set the memory size in KiB [640]" },
+	{ 'M', 0, "mmap", NULL, "Map read-only files into memory [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
 };
@@ -165,6 +166,7 @@ int main (int argc, char **argv)
 	char     **optarg;
 	char     *prog_dos, *prog_host;
 	char     log_int;
+	char     use_mmap;
 	unsigned mem;
 	dos_t    sim;
 
@@ -172,6 +174,7 @@ int main (int argc, char **argv)
 
 	mem = 640;
 	log_int = 0;
+	use_mmap = 0;
 
 	while (1) {
 		r = pce_getopt (argc, argv, &optarg, opts);
@@ -217,6 +220,10 @@ int main (int argc, char **argv)
 			mem = strtoul (optarg[0], NULL, 0);
 			break;
 
+		case 'M':
+			use_mmap = 1;
+			break;
+
 		default:
 			return (1);
 		}
@@ -231,6 +238,7 @@ int main (int argc, char **argv)
 	}
 
 	sim.log_int = log_int || 0;
+	sim.use_mmap = use_mmap;
 
 	for (i = 0; i < 26; i++) {
 		if (par_drives[i] != NULL) {
@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <drivers/char/char-io.h>
+
 #include <lib/brkpt.h>
 #include <lib/cmd.h>
 #include <lib/console.h>
@@ -378,8 +380,12 @@ void prt_state_uart (e8250_t *uart, unsigned base)
 	);
 }
 
-void prt_state_cpu (e8086_t *c)
+void prt_state_cpu (ibmpc_t *pc)
 {
+	e8086_t *c;
+
+	c = pc->cpu;
+
 	pce_prt_sep ("8086");
 
 	pce_printf (
@@ -387,8 +393,8 @@ void prt_state_cpu (e8086_t *c)
 		"SP=%04X  BP=%04X  SI=%04X  DI=%04X INT=%02X%c\n",
 		e86_get_ax (c), e86_get_bx (c), e86_get_cx (c), e86_get_dx (c),
 		e86_get_sp (c), e86_get_bp (c), e86_get_si (c), e86_get_di (c),
-		par_pc->current_int & 0xff,
-		(par_pc->current_int & 0x100) ? '*' : ' '
+		pc->current_int & 0xff,
+		(pc->current_int & 0x100) ? '*' : ' '
 	);
 
 	pce_printf ("DS=%04X  ES=%04X  SS=%04X  CS=%04X  IP=%04X  F =%04X",
@@ -471,7 +477,7 @@ void prt_state_pc (ibmpc_t *pc)
 	prt_state_pit (&pc->pit);
 	prt_state_pic (&pc->pic);
 	prt_state_dma (&pc->dma);
-	prt_state_cpu (pc->cpu);
+	prt_state_cpu (pc);
 }
 
 static
@@ -483,7 +489,7 @@ void prt_state (ibmpc_t *pc)
 	e86_disasm_cur (pc->cpu, &op);
 	disasm_str (str, &op);
 
-	prt_state_cpu (pc->cpu);
+	prt_state_cpu (pc);
 
 	pce_printf ("%04X:%04X  %s\n",
 		(unsigned) e86_get_cs (pc->cpu),
@@ -552,16 +558,38 @@ void pc_run (ibmpc_t *pc)
 	pce_stop();
 }
 
+int pc_run_slice (void *ext)
+{
+	unsigned i;
+	ibmpc_t  *pc;
+
+	pc = ext;
+
+	chr_io_set_owner (pc);
+	cmd_set_owner (pc);
+
+	for (i = 0; i < PCE_IBMPC_SLICE; i++) {
+		pc_clock (pc, 4 * pc->speed_current);
+
+		if (pc->brk) {
+			break;
+		}
+	}
+
+	if (pc->brk == PCE_BRK_ABORT) {
+		return (1);
+	}
+
+	/* there is no monitor to stop in */
+	pc->brk = 0;
+
+	return (0);
+}
 
-/*
- * emscripten specific main loop
- */
 
 /*
- * store global pointer to simulation state struct
- * so that pc_run_emscripten_step doesn't require it as a parameter
+ * emscripten specific main loop
  */
-ibmpc_t *ibmpc_sim = NULL;
 
 #ifdef __EMSCRIPTEN__
 /*
@@ -569,17 +597,15 @@ ibmpc_t *ibmpc_sim = NULL;
  */
 void pc_run_emscripten (ibmpc_t *pc)
 {
-	ibmpc_sim = pc;
-
 	pce_start ();
 
 	pc_clock_discontinuity (pc);
 
 #ifdef __EMSCRIPTEN__
-	emscripten_set_main_loop(pc_run_emscripten_step, 0, 1);
+	emscripten_set_main_loop_arg (pc_run_emscripten_step, pc, 0, 1);
 #else
 	while (!pc->brk) {
-		pc_run_emscripten_step();
+		pc_run_emscripten_step (pc);
 	}
 #endif
 
@@ -590,8 +616,10 @@ void pc_run_emscripten (ibmpc_t *pc)
 /*
  * run one iteration
  */
-void pc_run_emscripten_step ()
+void pc_run_emscripten_step (void *ext)
 {
+	ibmpc_t *pc = ext;
+
 	/*
 	 * for each 'emscripten step' we'll run a bunch of actual cycles
 	 * to minimise overhead from emscripten's main loop management
@@ -599,9 +627,9 @@ void pc_run_emscripten_step ()
 	int i;
 	for (i = 0; i < 10000; ++i)
 	{
-		pc_clock (ibmpc_sim, 4 * ibmpc_sim->speed_current);
+		pc_clock (pc, 4 * pc->speed_current);
 
-		if (ibmpc_sim->brk) {
+		if (pc->brk) {
 			pce_stop();
 #ifdef __EMSCRIPTEN__
 			emscripten_cancel_main_loop();
@@ -1244,7 +1272,7 @@ void pc_cmd_r (cmd_t *cmd, ibmpc_t *pc)
 	char          sym[256];
 
 	if (cmd_match_eol (cmd)) {
-		prt_state_cpu (pc->cpu);
+		prt_state_cpu (pc);
 		return;
 	}
 
@@ -1290,7 +1318,7 @@ void pc_cmd_s (cmd_t *cmd, ibmpc_t *pc)
 			prt_state_pc (pc);
 		}
 		else if (cmd_match (cmd, "cpu")) {
-			prt_state_cpu (pc->cpu);
+			prt_state_cpu (pc);
 		}
 		else if (cmd_match (cmd, "dma")) {
 			prt_state_dma (&pc->dma);
@@ -1514,6 +1542,8 @@ int pc_cmd (ibmpc_t *pc, cmd_t *cmd)
 
 void pc_cmd_init (ibmpc_t *pc, monitor_t *mon)
 {
+	pc->mon = mon;
+
 	mon_cmd_add (mon, par_cmd, sizeof (par_cmd) / sizeof (par_cmd[0]));
 	mon_cmd_add_bp (mon);
 
@@ -32,15 +32,21 @@
 #include <lib/monitor.h>
 
 
-void prt_state_cpu (e8086_t *c);
+void prt_state_cpu (ibmpc_t *pc);
 
 void pc_run (ibmpc_t *pc);
 
+/*
+ * Run one time slice without a monitor, for use with a runner_t.
+ * Returns 1 if the instance has terminated.
+ */
+int pc_run_slice (void *ext);
+
 int pc_cmd (ibmpc_t *pc, cmd_t *cmd);
 
 void pc_cmd_init (ibmpc_t *pc, monitor_t *mon);
 
 void pc_run_emscripten (ibmpc_t *pc);
-void pc_run_emscripten_step ();
+void pc_run_emscripten_step (void *ext);
 
 #endif
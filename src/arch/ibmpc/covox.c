@@ -23,10 +23,9 @@
 #include "main.h"
 #include "covox.h"
 
-#include <stdint.h>
 #include <stdlib.h>
 
-#include <drivers/sound/sound.h>
+#include <drivers/sound/mixer.h>
 
 
 #define PC_COVOX_SRATE 7000
@@ -39,17 +38,13 @@
 #endif
 
 
-static void pc_covox_flush (pc_covox_t *cov);
-
-
 void pc_covox_init (pc_covox_t *cov)
 {
-	cov->drv = NULL;
+	cov->mix = NULL;
+	cov->mix_src = -1;
 
 	cov->disney = 0;
 
-	cov->playing = 0;
-
 	cov->data_val = 0;
 	cov->ctrl_val = 0;
 
@@ -58,32 +53,17 @@ void pc_covox_init (pc_covox_t *cov)
 	cov->fifo_i = 0;
 	cov->fifo_n = 0;
 
-	cov->timeout_clk = 0;
-	cov->timeout_val = 0;
-
 	cov->clk = 0;
 	cov->rem = 0;
 
-	cov->srate = 44100;
-
-	cov->srate_div = 0;
-
-	cov->lowpass_freq = 0;
-
-	snd_iir2_init (&cov->iir);
-
-	cov->buf_cnt = 0;
+	cov->get_clk_ext = NULL;
+	cov->get_clk = NULL;
 
 	pc_covox_set_volume (cov, 500);
 }
 
 void pc_covox_free (pc_covox_t *cov)
 {
-	pc_covox_flush (cov);
-
-	if (cov->drv != NULL) {
-		snd_close (cov->drv);
-	}
 }
 
 pc_covox_t *pc_covox_new (void)
@@ -124,34 +104,19 @@ void pc_covox_set_mode (pc_covox_t *cov, unsigned mode)
 	}
 }
 
-int pc_covox_set_driver (pc_covox_t *cov, const char *driver, unsigned long srate)
+int pc_covox_set_mixer (pc_covox_t *cov, sound_mix_t *mix)
 {
-	if (cov->drv != NULL) {
-		snd_close (cov->drv);
-	}
+	cov->mix = NULL;
 
-	if ((cov->drv = snd_open (driver)) == NULL) {
+	if ((cov->mix_src = snd_mix_add_src (mix)) < 0) {
 		return (1);
 	}
 
-	cov->srate = srate;
-
-	if (snd_set_params (cov->drv, 1, srate, 1)) {
-		snd_close (cov->drv);
-		cov->drv = NULL;
-		return (1);
-	}
+	cov->mix = mix;
 
 	return (0);
 }
 
-void pc_covox_set_lowpass (pc_covox_t *cov, unsigned long freq)
-{
-	cov->lowpass_freq = freq;
-
-	snd_iir2_set_lowpass (&cov->iir, cov->lowpass_freq, cov->srate);
-}
-
 void pc_covox_set_volume (pc_covox_t *cov, unsigned vol)
 {
 	if (vol > 1000) {
@@ -162,64 +127,10 @@ void pc_covox_set_volume (pc_covox_t *cov, unsigned vol)
 }
 
 
-static
-void pc_covox_play (pc_covox_t *cov, uint16_t *buf, unsigned cnt)
-{
-	if (cov->lowpass_freq > 0) {
-		snd_iir2_filter (&cov->iir, buf, buf, cnt, 1, 1);
-	}
-
-	snd_write (cov->drv, buf, cnt);
-}
-
-static
-void pc_covox_write (pc_covox_t *cov, uint16_t val, unsigned long cnt)
-{
-	unsigned idx;
-
-	if (cov->drv == NULL) {
-		return;
-	}
-
-	idx = cov->buf_cnt;
-
-	while (cnt > 0) {
-		cov->buf[idx++] = val;
-
-		if (idx >= PC_COVOX_BUF) {
-			pc_covox_play (cov, cov->buf, idx);
-
-			idx = 0;
-		}
-
-		cnt -= 1;
-	}
-
-	cov->buf_cnt = idx;
-}
-
-static
-void pc_covox_flush (pc_covox_t *cov)
-{
-	if (cov->buf_cnt == 0) {
-		return;
-	}
-
-	pc_covox_play (cov, cov->buf, cov->buf_cnt);
-
-	snd_iir2_reset (&cov->iir);
-
-	cov->buf_cnt = 0;
-}
-
 static inline
-uint16_t pc_covox_get_smp (pc_covox_t *cov, unsigned val)
+long pc_covox_get_smp (pc_covox_t *cov, unsigned val)
 {
-	unsigned ret;
-
-	ret = cov->vol * ((long) (val & 0xff) - 0x80);
-
-	return (ret & 0xffff);
+	return ((long) cov->vol * ((long) (val & 0xff) - 0x80));
 }
 
 static
@@ -260,132 +171,58 @@ int pc_covox_fifo_next (pc_covox_t *cov)
 	return (0);
 }
 
-static
-void pc_covox_on (pc_covox_t *cov)
-{
-#if DEBUG_COVOX >= 1
-	pc_log_deb ("covox on\n");
-#endif
-
-	cov->playing = 1;
-
-	cov->timeout_val = cov->data_val;
-	cov->timeout_clk = 0;
-
-	cov->rem = 0;
-
-	cov->srate_div = 0;
-
-	/* Fill the sound buffer a bit so we don't underrun immediately */
-	pc_covox_write (cov, 0, cov->srate / 8);
-}
-
-static
-void pc_covox_off (pc_covox_t *cov)
-{
-#if DEBUG_COVOX >= 1
-	pc_log_deb ("covox off\n");
-#endif
-
-	cov->playing = 0;
-
-	pc_covox_flush (cov);
-}
-
+/*
+ * Take the samples from the fifo at PC_COVOX_SRATE and pass them to the
+ * mixer, tagged with the time at which they were taken.
+ */
 static
 void pc_covox_check_disney (pc_covox_t *cov)
 {
-	unsigned long clk, cnt, tmp;
-
-	tmp = cov->get_clk (cov->get_clk_ext);
-	clk = tmp - cov->clk;
-	cov->clk = tmp;
-
-	if (cov->playing == 0) {
-		if (cov->fifo_n == 0) {
-			return;
-		}
+	unsigned long clk, cnt, n;
 
-		pc_covox_on (cov);
+	clk = cov->get_clk (cov->get_clk_ext);
+	cnt = clk - cov->clk;
 
-		pc_covox_fifo_next (cov);
+	if ((cov->fifo_n == 0) && (cov->smp == 0)) {
+		cov->clk = clk;
+		return;
 	}
 
-	tmp = cov->rem + cov->srate * clk;
-	cov->rem = tmp % PC_COVOX_CLOCK;
-	cnt = tmp / PC_COVOX_CLOCK;
-
 	while (cnt > 0) {
-		pc_covox_write (cov, cov->smp, 1);
-
-		cov->srate_div += PC_COVOX_SRATE;
-
-		while (cov->srate_div >= cov->srate) {
-			if (pc_covox_fifo_next (cov)) {
-				cov->timeout_clk += 1;
+		/* the input clocks until the next sample is taken */
+		n = (PC_COVOX_CLOCK - cov->rem + PC_COVOX_SRATE - 1) / PC_COVOX_SRATE;
 
-				if (cov->timeout_clk > (2 * PC_COVOX_SRATE)) {
-					pc_covox_off (cov);
-					return;
-				}
-			}
-			else {
-				cov->timeout_clk = 0;
-			}
-
-			cov->srate_div -= cov->srate;
+		if (n > cnt) {
+			cov->rem += cnt * PC_COVOX_SRATE;
+			break;
 		}
 
-		cnt -= 1;
-	}
-}
-
-static
-void pc_covox_check_covox (pc_covox_t *cov)
-{
-	unsigned long clk, cnt, tmp;
-
-	tmp = cov->get_clk (cov->get_clk_ext);
-	clk = tmp - cov->clk;
-	cov->clk = tmp;
+		cov->rem += n * PC_COVOX_SRATE;
+		cov->rem -= PC_COVOX_CLOCK;
+		cov->clk += n;
+		cnt -= n;
 
-	if (cov->playing == 0) {
-		if (cov->timeout_val != cov->data_val) {
-			pc_covox_on (cov);
-		}
-		return;
-	}
-	else if (cov->timeout_val == cov->data_val) {
-		cov->timeout_clk += clk;
+		pc_covox_fifo_next (cov);
 
-		if (cov->timeout_clk > (2 * PC_COVOX_CLOCK)) {
-			pc_covox_off (cov);
-			return;
+		if (cov->mix != NULL) {
+			snd_mix_set_val (cov->mix, cov->mix_src, cov->clk, cov->smp);
 		}
 	}
-	else {
-		cov->timeout_val = cov->data_val;
-		cov->timeout_clk = clk;
-	}
-
-	tmp = cov->rem + cov->srate * clk;
-	cov->rem = tmp % PC_COVOX_CLOCK;
-	cnt = tmp / PC_COVOX_CLOCK;
 
-	if (cnt > 0) {
-		pc_covox_write (cov, cov->smp, cnt);
-	}
+	cov->clk = clk;
 }
 
 void pc_covox_set_data (pc_covox_t *cov, unsigned char val)
 {
-	if (cov->disney == 0) {
-		pc_covox_check_covox (cov);
+	cov->data_val = val;
 
+	if ((cov->disney == 0) && (cov->mix != NULL)) {
 		cov->smp = pc_covox_get_smp (cov, val);
-	}
 
-	cov->data_val = val;
+		snd_mix_set_val (cov->mix, cov->mix_src,
+			cov->get_clk (cov->get_clk_ext), cov->smp
+		);
+	}
 }
 
 void pc_covox_set_ctrl (pc_covox_t *cov, unsigned char val)
@@ -428,7 +265,4 @@ void pc_covox_clock (pc_covox_t *cov, unsigned long cnt)
 	if (cov->disney) {
 		pc_covox_check_disney (cov);
 	}
-	else {
-		pc_covox_check_covox (cov);
-	}
 }
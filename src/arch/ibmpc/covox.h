@@ -24,47 +24,31 @@
 #define PCE_IBMPC_COVOX_H 1
 
 
-#include <stdint.h>
+#include <drivers/sound/mixer.h>
 
-#include <drivers/sound/sound.h>
 
-#define PC_COVOX_BUF  2048
 #define PC_COVOX_FIFO 16
 
 
 typedef struct {
-	sound_drv_t    *drv;
+	sound_mix_t    *mix;
+	int            mix_src;
 
 	char           disney;
 
-	char           playing;
-
 	unsigned char  data_val;
 	unsigned char  ctrl_val;
 
-	uint16_t       smp;
+	long           smp;
 	unsigned       vol;
 
 	unsigned char  fifo[PC_COVOX_FIFO];
 	unsigned       fifo_i;
 	unsigned       fifo_n;
 
-	uint16_t       timeout_val;
-	unsigned long  timeout_clk;
-
 	unsigned long  clk;
 	unsigned long  rem;
 
-	unsigned long  srate;
-
-	unsigned long  srate_div;
-
-	unsigned long  lowpass_freq;
-	sound_iir2_t   iir;
-
-	unsigned       buf_cnt;
-	uint16_t       buf[PC_COVOX_BUF];
-
 	void           *get_clk_ext;
 	unsigned long  (*get_clk) (void *ext);
 } pc_covox_t;
@@ -80,9 +64,7 @@ void pc_covox_set_clk_fct (pc_covox_t *cov, void *ext, void *fct);
 
 void pc_covox_set_mode (pc_covox_t *cov, unsigned mode);
 
-int pc_covox_set_driver (pc_covox_t *cov, const char *driver, unsigned long srate);
-
-void pc_covox_set_lowpass (pc_covox_t *cov, unsigned long freq);
+int pc_covox_set_mixer (pc_covox_t *cov, sound_mix_t *mix);
 
 void pc_covox_set_volume (pc_covox_t *cov, unsigned vol);
 
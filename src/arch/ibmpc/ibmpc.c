@@ -35,6 +35,7 @@
 #endif
 
 #include <lib/brkpt.h>
+#include <lib/cmd.h>
 #include <lib/inidsk.h>
 #include <lib/iniram.h>
 #include <lib/initerm.h>
@@ -58,6 +59,7 @@
 #include <devices/fdc.h>
 #include <devices/hdc.h>
 #include <devices/memory.h>
+#include <devices/ne2000.h>
 #include <devices/nvram.h>
 #include <devices/parport.h>
 #include <devices/serport.h>
@@ -71,6 +73,8 @@
 #include <devices/video/wy700.h>
 
 #include <drivers/block/block.h>
+#include <drivers/char/char-io.h>
+#include <drivers/sound/mixer.h>
 
 #include <drivers/pti/pti-io.h>
 
@@ -82,9 +86,6 @@
 #define PCE_IBMPC_SLEEP 25000
 
 
-static char *par_intlog[256];
-
-
 static
 unsigned char pc_get_port8 (void *ext, unsigned long addr)
 {
@@ -184,6 +185,79 @@ void pc_set_port16 (void *ext, unsigned long addr, unsigned short val)
 }
 
 
+/*
+ * Get a pointer to guest RAM for DMA block transfers
+ */
+static
+unsigned char *pc_dma_get_ptr (ibmpc_t *pc, unsigned long addr, unsigned cnt, int wr)
+{
+	mem_blk_t *blk;
+
+	blk = mem_get_blk (pc->mem, addr);
+
+	if ((blk == NULL) || (blk->data == NULL)) {
+		return (NULL);
+	}
+
+	if (wr) {
+		if (blk->readonly || (blk->set_uint8 != NULL)) {
+			return (NULL);
+		}
+	}
+	else {
+		if (blk->get_uint8 != NULL) {
+			return (NULL);
+		}
+	}
+
+	if ((addr + cnt - 1) > blk->addr2) {
+		return (NULL);
+	}
+
+	return (blk->data + (addr - blk->addr1));
+}
+
+/*
+ * Mark guest RAM written by a DMA block transfer as dirty
+ */
+static
+void pc_dma_done (ibmpc_t *pc, unsigned long addr, unsigned cnt)
+{
+	mem_blk_t *blk;
+
+	if ((blk = mem_get_blk (pc->mem, addr)) != NULL) {
+		mem_blk_dirty_set (blk, addr - blk->addr1, cnt);
+	}
+}
+
+static
+unsigned char *pc_dma2_get_ptr (void *ext, unsigned long addr, unsigned cnt, int wr)
+{
+	ibmpc_t *pc = (ibmpc_t *)ext;
+	return (pc_dma_get_ptr (pc, pc->dma_page[2] + addr, cnt, wr));
+}
+
+static
+unsigned char *pc_dma3_get_ptr (void *ext, unsigned long addr, unsigned cnt, int wr)
+{
+	ibmpc_t *pc = (ibmpc_t *)ext;
+	return (pc_dma_get_ptr (pc, pc->dma_page[3] + addr, cnt, wr));
+}
+
+static
+void pc_dma2_done (void *ext, unsigned long addr, unsigned cnt)
+{
+	ibmpc_t *pc = (ibmpc_t *)ext;
+	pc_dma_done (pc, pc->dma_page[2] + addr, cnt);
+}
+
+static
+void pc_dma3_done (void *ext, unsigned long addr, unsigned cnt)
+{
+	ibmpc_t *pc = (ibmpc_t *)ext;
+	pc_dma_done (pc, pc->dma_page[3] + addr, cnt);
+}
+
 static
 void pc_dma2_set_mem8 (void *ext, unsigned long addr, unsigned char val)
 {
@@ -654,14 +728,17 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 	ini_sct_t     *sct;
 	const char    *model;
 	unsigned      speed;
+	int           lazy, lazy_check;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "8088");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "lazy_flags", &lazy, 1);
+	ini_get_bool (sct, "lazy_flags_check", &lazy_check, 0);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%uX\n",
-		model, speed
+	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%uX lazy_flags=%d check=%d\n",
+		model, speed, lazy, lazy_check
 	);
 
 	pc->cpu = e86_new();
@@ -670,6 +747,8 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 		pce_log (MSG_ERR, "*** unknown cpu model (%s)\n", model);
 	}
 
+	e86_set_lazy_flags (pc->cpu, lazy, lazy_check);
+
 	e86_set_mem (pc->cpu, pc->mem,
 		mem_get_uint8,
 		mem_set_uint8,
@@ -677,6 +756,8 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 		mem_set_uint16_le
 	);
 
+	e86_set_mem_blk (pc->cpu, mem_set_blk);
+
 	e86_set_prt (pc->cpu, pc->prt,
 		mem_get_uint8,
 		mem_set_uint8,
@@ -686,6 +767,7 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 
 	if (pc->ram != NULL) {
 		e86_set_ram (pc->cpu, pc->ram->data, pc->ram->size);
+		e86_set_ram_dirty_map (pc->cpu, mem_blk_dirty_map (pc->ram), MEM_DIRTY_SHIFT);
 	}
 	else {
 		e86_set_ram (pc->cpu, NULL, 0);
@@ -705,6 +787,7 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 static
 void pc_setup_dma (ibmpc_t *pc, ini_sct_t *ini)
 {
+	int           burst;
 	unsigned long addr;
 	ini_sct_t     *sct;
 	mem_blk_t     *blk;
@@ -712,8 +795,11 @@ void pc_setup_dma (ibmpc_t *pc, ini_sct_t *ini)
 	sct = ini_next_sct (ini, NULL, "dmac");
 
 	ini_get_uint32 (sct, "address", &addr, 0);
+	ini_get_bool (sct, "burst", &burst, 1);
 
-	pce_log_tag (MSG_INF, "DMAC:", "addr=0x%08lx size=0x%04x\n", addr, 16);
+	pce_log_tag (MSG_INF, "DMAC:", "addr=0x%08lx size=0x%04x burst=%d\n",
+		addr, 16, burst
+	);
 
 	pc->dma_page[0] = 0;
 	pc->dma_page[1] = 0;
@@ -723,6 +809,7 @@ void pc_setup_dma (ibmpc_t *pc, ini_sct_t *ini)
 	pc->dack0 = 0;
 
 	e8237_init (&pc->dma);
+	e8237_set_burst (&pc->dma, burst);
 
 	blk = mem_blk_new (addr, 16, 0);
 	if (blk == NULL) {
@@ -923,6 +1010,56 @@ void pc_setup_cassette (ibmpc_t *pc, ini_sct_t *ini)
 	}
 }
 
+/*
+ * Open the sound driver of the mixer, unless this has already been done.
+ */
+static
+void pc_setup_sound_driver (ibmpc_t *pc, const char *driver,
+	unsigned chn, unsigned long srate, unsigned long lowpass)
+{
+	if ((driver == NULL) || snd_mix_have_driver (&pc->mix)) {
+		return;
+	}
+
+	snd_mix_set_lowpass (&pc->mix, lowpass);
+
+	if (snd_mix_set_driver (&pc->mix, driver, chn, srate)) {
+		pce_log (MSG_ERR, "*** setting sound driver failed (%s)\n",
+			driver
+		);
+	}
+}
+
+static
+void pc_setup_sound (ibmpc_t *pc, ini_sct_t *ini)
+{
+	const char    *driver;
+	unsigned      chn;
+	unsigned long srate;
+	unsigned long lowpass;
+	ini_sct_t     *sct;
+
+	snd_mix_init (&pc->mix, PCE_IBMPC_CLK2);
+
+	sct = ini_next_sct (ini, NULL, "sound");
+
+	if (sct == NULL) {
+		return;
+	}
+
+	ini_get_string (sct, "driver", &driver, NULL);
+	ini_get_uint16 (sct, "channels", &chn, 1);
+	ini_get_uint32 (sct, "sample_rate", &srate, 44100);
+	ini_get_uint32 (sct, "lowpass", &lowpass, 0);
+
+	pce_log_tag (MSG_INF, "SOUND:", "channels=%u srate=%lu lowpass=%lu driver=%s\n",
+		chn, srate, lowpass,
+		(driver != NULL) ? driver : "<none>"
+	);
+
+	pc_setup_sound_driver (pc, driver, chn, srate, lowpass);
+}
+
 static
 void pc_setup_speaker (ibmpc_t *pc, ini_sct_t *ini)
 {
@@ -951,16 +1088,11 @@ void pc_setup_speaker (ibmpc_t *pc, ini_sct_t *ini)
 		(driver != NULL) ? driver : "<none>"
 	);
 
-	if (driver != NULL) {
-		if (pc_speaker_set_driver (&pc->spk, driver, srate)) {
-			pce_log (MSG_ERR,
-				"*** setting sound driver failed (%s)\n",
-				driver
-			);
-		}
-	}
+	pc_setup_sound_driver (pc, driver, 1, srate, lowpass);
 
-	pc_speaker_set_lowpass (&pc->spk, lowpass);
+	if (pc_speaker_set_mixer (&pc->spk, &pc->mix)) {
+		pce_log (MSG_ERR, "*** adding the speaker to the mixer failed\n");
+	}
 
 	pc_speaker_set_volume (&pc->spk, volume);
 }
@@ -1015,13 +1147,10 @@ void pc_setup_covox (ibmpc_t *pc, ini_sct_t *ini)
 
 	pc_covox_set_clk_fct (pc->cov, pc, pc_get_clock2);
 
-	if (driver != NULL) {
-		if (pc_covox_set_driver (pc->cov, driver, srate)) {
-			pce_log (MSG_ERR,
-				"*** setting sound driver failed (%s)\n",
-				driver
-			);
-		}
+	pc_setup_sound_driver (pc, driver, 1, srate, lowpass);
+
+	if (pc_covox_set_mixer (pc->cov, &pc->mix)) {
+		pce_log (MSG_ERR, "*** adding the covox to the mixer failed\n");
 	}
 
 	if (strcmp (mode, "covox") == 0) {
@@ -1034,8 +1163,6 @@ void pc_setup_covox (ibmpc_t *pc, ini_sct_t *ini)
 		pce_log (MSG_ERR, "*** unknown mode (%s)\n", mode);
 	}
 
-	pc_covox_set_lowpass (pc->cov, lowpass);
-
 	pc_covox_set_volume (pc->cov, volume);
 
 	parport_set_data_fct (pc->parport[port], pc->cov, pc_covox_set_data);
@@ -1044,9 +1171,9 @@ void pc_setup_covox (ibmpc_t *pc, ini_sct_t *ini)
 }
 
 static
-void pc_setup_terminal (ibmpc_t *pc, ini_sct_t *ini)
+void pc_setup_terminal (ibmpc_t *pc, ini_sct_t *ini, const char *terminal)
 {
-	pc->trm = ini_get_terminal (ini, par_terminal);
+	pc->trm = ini_get_terminal (ini, terminal);
 
 	if (pc->trm == NULL) {
 		return;
@@ -1221,7 +1348,7 @@ int pc_setup_vga (ibmpc_t *pc, ini_sct_t *sct)
 }
 
 static
-void pc_setup_video (ibmpc_t *pc, ini_sct_t *ini)
+void pc_setup_video (ibmpc_t *pc, ini_sct_t *ini, const char *video)
 {
 	const char *dev;
 	ini_sct_t  *sct;
@@ -1231,14 +1358,14 @@ void pc_setup_video (ibmpc_t *pc, ini_sct_t *ini)
 	sct = ini_next_sct (ini, NULL, "video");
 	ini_get_string (sct, "device", &dev, "cga");
 
-	if (par_video != NULL) {
-		while ((sct != NULL) && (strcmp (par_video, dev) != 0)) {
+	if (video != NULL) {
+		while ((sct != NULL) && (strcmp (video, dev) != 0)) {
 			sct = ini_next_sct (ini, sct, "video");
 			ini_get_string (sct, "device", &dev, "cga");
 		}
 
 		if (sct == NULL) {
-			dev = par_video;
+			dev = video;
 		}
 	}
 
@@ -1383,6 +1510,16 @@ void pc_setup_fdc (ibmpc_t *pc, ini_sct_t *ini)
 
 	pc->dma.chn[2].memwr_ext = pc;
 	pc->dma.chn[2].memwr = pc_dma2_set_mem8;
+
+	pc->dma.chn[2].memptr_ext = pc;
+	pc->dma.chn[2].memptr = pc_dma2_get_ptr;
+	pc->dma.chn[2].memdone = pc_dma2_done;
+
+	pc->dma.chn[2].iord_blk_ext = &pc->fdc->e8272;
+	pc->dma.chn[2].iord_blk = e8272_read_data_blk;
+
+	pc->dma.chn[2].iowr_blk_ext = &pc->fdc->e8272;
+	pc->dma.chn[2].iowr_blk = e8272_write_data_blk;
 }
 
 static
@@ -1449,6 +1586,16 @@ void pc_setup_hdc (ibmpc_t *pc, ini_sct_t *ini)
 
 	pc->dma.chn[3].memwr_ext = pc;
 	pc->dma.chn[3].memwr = pc_dma3_set_mem8;
+
+	pc->dma.chn[3].memptr_ext = pc;
+	pc->dma.chn[3].memptr = pc_dma3_get_ptr;
+	pc->dma.chn[3].memdone = pc_dma3_done;
+
+	pc->dma.chn[3].iord_blk_ext = pc->hdc;
+	pc->dma.chn[3].iord_blk = hdc_read_data_blk;
+
+	pc->dma.chn[3].iowr_blk_ext = pc->hdc;
+	pc->dma.chn[3].iowr_blk = hdc_write_data_blk;
 }
 
 static
@@ -1598,6 +1745,55 @@ void pc_setup_serport (ibmpc_t *pc, ini_sct_t *ini)
 	}
 }
 
+static
+void pc_setup_ne2000 (ibmpc_t *pc, ini_sct_t *ini)
+{
+	unsigned long addr;
+	unsigned      irq;
+	const char    *mac;
+	const char    *driver;
+	ini_sct_t     *sct;
+
+	pc->ne2000 = NULL;
+
+	sct = ini_next_sct (ini, NULL, "ne2000");
+
+	if (sct == NULL) {
+		return;
+	}
+
+	ini_get_uint32 (sct, "address", &addr, 0x300);
+	ini_get_uint16 (sct, "irq", &irq, 5);
+	ini_get_string (sct, "mac", &mac, NULL);
+	ini_get_string (sct, "driver", &driver, NULL);
+
+	pce_log_tag (MSG_INF,
+		"NE2000:", "addr=0x%04lx irq=%u driver=%s\n",
+		addr, irq, (driver == NULL) ? "<none>" : driver
+	);
+
+	pc->ne2000 = ne2000_new (addr);
+
+	if (pc->ne2000 == NULL) {
+		pce_log (MSG_ERR, "*** creating ne2000 failed\n");
+		return;
+	}
+
+	if (mac != NULL) {
+		if (ne2000_set_mac_str (pc->ne2000, mac)) {
+			pce_log (MSG_ERR, "*** bad mac address (%s)\n", mac);
+		}
+	}
+
+	if (ne2000_set_driver (pc->ne2000, driver)) {
+		pce_log (MSG_ERR, "*** can't open driver (%s)\n", driver);
+	}
+
+	ne2000_set_irq_fct (pc->ne2000, &pc->pic, e8259_get_irq_fct (&pc->pic, irq));
+
+	mem_add_blk (pc->prt, ne2000_get_reg (pc->ne2000), 0);
+}
+
 static
 void pc_setup_ems (ibmpc_t *pc, ini_sct_t *ini)
 {
@@ -1651,15 +1847,20 @@ void pc_setup_xms (ibmpc_t *pc, ini_sct_t *ini)
 	}
 }
 
-ibmpc_t *pc_new (ini_sct_t *ini)
+ibmpc_t *pc_new (ini_sct_t *ini, const char *terminal, const char *video)
 {
-	ibmpc_t *pc;
+	unsigned i;
+	ibmpc_t  *pc;
 
 	pc = malloc (sizeof (ibmpc_t));
 	if (pc == NULL) {
 		return (NULL);
 	}
 
+	/* this machine has its own char I/O reactor and monitor symbols */
+	chr_io_set_owner (pc);
+	cmd_set_owner (pc);
+
 	pc->cfg = ini;
 
 	pc->disk_id = 0;
@@ -1668,6 +1869,14 @@ ibmpc_t *pc_new (ini_sct_t *ini)
 
 	bps_init (&pc->bps);
 
+	pc->mon = NULL;
+
+	for (i = 0; i < 256; i++) {
+		pc->intlog[i] = NULL;
+	}
+
+	pc->trc = NULL;
+
 	pc_setup_system (pc, ini);
 	pc_setup_m24 (pc, ini);
 	pc_setup_atari_pc (pc, ini);
@@ -1683,11 +1892,12 @@ ibmpc_t *pc_new (ini_sct_t *ini)
 	pc_setup_ppi (pc, ini);
 	pc_setup_kbd (pc, ini);
 	pc_setup_cassette (pc, ini);
+	pc_setup_sound (pc, ini);
 	pc_setup_speaker (pc, ini);
 
-	pc_setup_terminal (pc, ini);
+	pc_setup_terminal (pc, ini, terminal);
 
-	pc_setup_video (pc, ini);
+	pc_setup_video (pc, ini, video);
 
 	if (pc->trm != NULL) {
 		trm_open (pc->trm, 640, 480);
@@ -1699,6 +1909,7 @@ ibmpc_t *pc_new (ini_sct_t *ini)
 	pc_setup_hdc (pc, ini);
 	pc_setup_serport (pc, ini);
 	pc_setup_parport (pc, ini);
+	pc_setup_ne2000 (pc, ini);
 	pc_setup_ems (pc, ini);
 	pc_setup_xms (pc, ini);
 	pc_setup_covox (pc, ini);
@@ -1748,6 +1959,8 @@ void pc_del_serport (ibmpc_t *pc)
 
 void pc_del (ibmpc_t *pc)
 {
+	unsigned i;
+
 	if (pc == NULL) {
 		return;
 	}
@@ -1758,6 +1971,7 @@ void pc_del (ibmpc_t *pc)
 
 	pc_del_xms (pc);
 	pc_del_ems (pc);
+	ne2000_del (pc->ne2000);
 	pc_del_parport (pc);
 	pc_del_serport (pc);
 	hdc_del (pc->hdc);
@@ -1770,11 +1984,14 @@ void pc_del (ibmpc_t *pc)
 
 	pc_covox_del (pc->cov);
 	pc_speaker_free (&pc->spk);
+	snd_mix_free (&pc->mix);
 	cas_del (pc->cas);
 	e8237_free (&pc->dma);
 	e8255_free (&pc->ppi);
 	e8253_free (&pc->pit);
 	e8259_free (&pc->pic);
+
+	trace_del (pc->trc);
 	e86_del (pc->cpu);
 
 	nvr_del (pc->nvr);
@@ -1783,6 +2000,13 @@ void pc_del (ibmpc_t *pc)
 
 	ini_sct_del (pc->cfg);
 
+	for (i = 0; i < 256; i++) {
+		free (pc->intlog[i]);
+	}
+
+	cmd_del_owner (pc);
+	chr_io_del_owner (pc);
+
 	free (pc);
 }
 
@@ -1842,14 +2066,14 @@ int pc_set_parport_file (ibmpc_t *pc, unsigned port, const char *fname)
 
 const char *pc_intlog_get (ibmpc_t *pc, unsigned n)
 {
-	return (par_intlog[n & 0xff]);
+	return (pc->intlog[n & 0xff]);
 }
 
 void pc_intlog_set (ibmpc_t *pc, unsigned n, const char *expr)
 {
 	char **str;
 
-	str = &par_intlog[n & 0xff];
+	str = &pc->intlog[n & 0xff];
 
 	free (*str);
 
@@ -1867,7 +2091,7 @@ int pc_intlog_check (ibmpc_t *pc, unsigned n)
 	const char    *str;
 	cmd_t         cmd;
 
-	str = par_intlog[n & 0xff];
+	str = pc->intlog[n & 0xff];
 
 	if (str == NULL) {
 		return (0);
@@ -1884,6 +2108,87 @@ int pc_intlog_check (ibmpc_t *pc, unsigned n)
 	return (0);
 }
 
+static
+unsigned char pc_trace_get_port8 (ibmpc_t *pc, unsigned long addr)
+{
+	unsigned char val;
+
+	val = mem_get_uint8 (pc->prt, addr);
+
+	trace_mem (pc->trc, TRACE_IO_RD, addr, val, 1);
+
+	return (val);
+}
+
+static
+unsigned short pc_trace_get_port16 (ibmpc_t *pc, unsigned long addr)
+{
+	unsigned short val;
+
+	val = mem_get_uint16_le (pc->prt, addr);
+
+	trace_mem (pc->trc, TRACE_IO_RD, addr, val, 2);
+
+	return (val);
+}
+
+static
+void pc_trace_set_port8 (ibmpc_t *pc, unsigned long addr, unsigned char val)
+{
+	trace_mem (pc->trc, TRACE_IO_WR, addr, val, 1);
+
+	mem_set_uint8 (pc->prt, addr, val);
+}
+
+static
+void pc_trace_set_port16 (ibmpc_t *pc, unsigned long addr, unsigned short val)
+{
+	trace_mem (pc->trc, TRACE_IO_WR, addr, val, 2);
+
+	mem_set_uint16_le (pc->prt, addr, val);
+}
+
+int pc_set_trace (ibmpc_t *pc, const char *fname, int io)
+{
+	e86_set_trace_fct (pc->cpu, NULL, NULL);
+
+	e86_set_prt (pc->cpu, pc->prt,
+		mem_get_uint8,
+		mem_set_uint8,
+		mem_get_uint16_le,
+		mem_set_uint16_le
+	);
+
+	trace_del (pc->trc);
+
+	pc->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	pc->trc = trace_new (fname, "8086");
+
+	if (pc->trc == NULL) {
+		return (1);
+	}
+
+	e86_set_trace_fct (pc->cpu, pc->trc, trace_exec);
+
+	if (io) {
+		e86_set_prt (pc->cpu, pc,
+			(e86_get_uint8_f) pc_trace_get_port8,
+			(e86_set_uint8_f) pc_trace_set_port8,
+			(e86_get_uint16_f) pc_trace_get_port16,
+			(e86_set_uint16_f) pc_trace_set_port16
+		);
+	}
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s io=%d\n", fname, io != 0);
+
+	return (0);
+}
+
 /*
  * Get the segment address of the PCE ROM extension
  */
@@ -1967,6 +2272,10 @@ void pc_reset (ibmpc_t *pc)
 		hdc_reset (pc->hdc);
 	}
 
+	if (pc->ne2000 != NULL) {
+		ne2000_reset (pc->ne2000);
+	}
+
 	if (pc->xms != NULL) {
 		xms_reset (pc->xms);
 	}
@@ -2126,6 +2435,8 @@ void pc_clock (ibmpc_t *pc, unsigned long cnt)
 				trm_check (pc->trm);
 			}
 
+			chr_io_poll();
+
 			if (pc->atari_pc_rtc != NULL) {
 				mc146818a_clock (pc->atari_pc_rtc, clk);
 			}
@@ -2138,12 +2449,16 @@ void pc_clock (ibmpc_t *pc, unsigned long cnt)
 				hdc_clock (pc->hdc, clk);
 			}
 
-			pc_speaker_clock (&pc->spk, clk);
+			if (pc->ne2000 != NULL) {
+				ne2000_clock (pc->ne2000, clk);
+			}
 
 			if (pc->cov != NULL) {
 				pc_covox_clock (pc->cov, clk);
 			}
 
+			snd_mix_clock (&pc->mix, pc_get_clock2 (pc));
+
 			for (i = 0; i < 4; i++) {
 				if (pc->serport[i] != NULL) {
 					ser_clock (pc->serport[i], clk);
@@ -45,6 +45,7 @@
 #include <devices/fdc.h>
 #include <devices/hdc.h>
 #include <devices/memory.h>
+#include <devices/ne2000.h>
 #include <devices/nvram.h>
 #include <devices/parport.h>
 #include <devices/serport.h>
@@ -52,9 +53,13 @@
 
 #include <drivers/block/block.h>
 
+#include <drivers/sound/mixer.h>
+
 #include <drivers/video/terminal.h>
 
 #include <lib/brkpt.h>
+#include <lib/monitor.h>
+#include <lib/trace.h>
 
 #include <libini/libini.h>
 
@@ -78,6 +83,7 @@ typedef struct ibmpc_t {
 	e8259_t            pic;
 	pc_kbd_t           kbd;
 	cassette_t         *cas;
+	sound_mix_t        mix;
 	pc_speaker_t       spk;
 	pc_covox_t         *cov;
 
@@ -100,10 +106,20 @@ typedef struct ibmpc_t {
 	serport_t          *serport[4];
 	parport_t          *parport[4];
 
+	ne2000_t           *ne2000;
+
 	ini_sct_t          *cfg;
 
 	bp_set_t           bps;
 
+	/* the monitor that controls this instance or NULL */
+	monitor_t          *mon;
+
+	char               *intlog[256];
+
+	/* the execution trace recorder or NULL */
+	trace_t            *trc;
+
 	unsigned           bootdrive;
 	unsigned           disk_id;
 
@@ -157,10 +173,11 @@ typedef struct ibmpc_t {
 } ibmpc_t;
 
 
-extern ibmpc_t *par_pc;
-
-
-ibmpc_t *pc_new (ini_sct_t *ini);
+/*
+ * terminal and video select the terminal driver and the video device,
+ * overriding the config file. Both can be NULL.
+ */
+ibmpc_t *pc_new (ini_sct_t *ini, const char *terminal, const char *video);
 
 void pc_del (ibmpc_t *pc);
 
@@ -176,6 +193,13 @@ int pc_intlog_check (ibmpc_t *pc, unsigned n);
 
 unsigned pc_get_pcex_seg (ibmpc_t *pc);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ * @param io    If true, I/O port accesses are recorded as well
+ *****************************************************************************/
+int pc_set_trace (ibmpc_t *pc, const char *fname, int io);
+
 /*!***************************************************************************
  * @short Reset the PC
  *****************************************************************************/
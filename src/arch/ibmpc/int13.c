@@ -139,6 +139,7 @@ void dsk_int13_02 (disks_t *dsks, e8086_t *cpu)
 
 		if ((addr + n) <= cpu->ram_cnt) {
 			memcpy (cpu->ram + addr, buf, n);
+			e86_dirty_ram (cpu, addr, n);
 			addr += n;
 		}
 		else {
@@ -40,20 +40,26 @@
 #include <lib/log.h>
 #include <lib/monitor.h>
 #include <lib/path.h>
+#include <lib/runner.h>
 #include <lib/sysdep.h>
 
-const char           *par_terminal = NULL;
-const char           *par_video = NULL;
+static const char    *par_terminal = NULL;
+static const char    *par_video = NULL;
 
-monitor_t            par_mon;
+static const char    *par_trace = NULL;
+static int           par_trace_io = 0;
 
-ibmpc_t              *par_pc = NULL;
+static monitor_t     par_mon;
 
-ini_sct_t            *par_cfg = NULL;
+static ibmpc_t       *par_pc = NULL;
+
+static ini_sct_t     *par_cfg = NULL;
 
 static ini_strings_t par_ini_str1;
 static ini_strings_t par_ini_str2;
 
+static runner_t      *par_runner = NULL;
+
 
 static pce_option_t opts[] = {
 	{ '?', 0, "help", NULL, "Print usage information" },
@@ -63,13 +69,17 @@ static pce_option_t opts[] = {
 	{ 'g', 1, "video", "string", "Set the video device" },
 	{ 'i', 1, "ini-prefix", "string", "Add an ini string before the config file" },
 	{ 'I', 1, "ini-append", "string", "Add an ini string after the config file" },
+	{ 'M', 0, "trace-io", NULL, "Include I/O port accesses in the trace [no]" },
+	{ 'j', 1, "threads", "int", "Set the number of threads for -n [1]" },
 	{ 'l', 1, "log", "string", "Set the log file name [none]" },
+	{ 'n', 1, "instances", "int", "Run several instances without monitor [1]" },
 	{ 'p', 1, "cpu", "string", "Set the CPU model" },
 	{ 'q', 0, "quiet", NULL, "Set the log level to error [no]" },
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
 	{ 'R', 0, "no-monitor", NULL, "Never stop running [no]" },
 	{ 's', 1, "speed", "int", "Set the CPU speed" },
 	{ 't', 1, "terminal", "string", "Set the terminal device" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -116,6 +126,11 @@ void sig_int (int s)
 	fprintf (stderr, "pce-ibmpc: sigint\n");
 	fflush (stderr);
 
+	if (par_runner != NULL) {
+		runner_stop (par_runner);
+		return;
+	}
+
 	if (par_pc->brk == 0) {
 		par_pc->brk = PCE_BRK_STOP;
 	}
@@ -130,6 +145,11 @@ void sig_term (int s)
 	fprintf (stderr, "pce-ibmpc: sigterm\n");
 	fflush (stderr);
 
+	if (par_runner != NULL) {
+		runner_stop (par_runner);
+		return;
+	}
+
 	if (par_pc->brk == PCE_BRK_ABORT) {
 		exit (1);
 	}
@@ -144,7 +164,7 @@ void sig_segv (int s)
 	fflush (stderr);
 
 	if ((par_pc != NULL) && (par_pc->cpu != NULL)) {
-		prt_state_cpu (par_pc->cpu);
+		prt_state_cpu (par_pc);
 	}
 
 	pce_set_fd_interactive (0, 1);
@@ -157,7 +177,7 @@ void sim_stop (void)
 	ibmpc_t *pc = par_pc;
 
 	pce_prt_sep ("BREAK");
-	prt_state_cpu (pc->cpu);
+	prt_state_cpu (pc);
 
 	pc_set_msg (pc, "emu.stop", NULL);
 }
@@ -193,6 +213,142 @@ int cmd_set_sym (ibmpc_t *pc, const char *sym, unsigned long val)
 	return (1);
 }
 
+static
+ini_sct_t *pc_load_config (const char *fname, unsigned inst)
+{
+	char      buf[64];
+	ini_sct_t *ini, *sct;
+
+	ini = ini_sct_new (NULL);
+
+	if (ini == NULL) {
+		return (NULL);
+	}
+
+	sprintf (buf, "cfg.instance = %u\n", inst);
+
+	if (ini_read_str (ini, buf) || ini_str_eval (&par_ini_str1, ini, 0)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	if (pce_load_config (ini, fname)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	sct = ini_next_sct (ini, NULL, "pc");
+
+	if (sct == NULL) {
+		sct = ini;
+	}
+
+	if (ini_str_eval (&par_ini_str2, sct, 0)) {
+		ini_sct_del (ini);
+		return (NULL);
+	}
+
+	return (ini);
+}
+
+/*
+ * Run cnt independent instances on a pool of threads. Each instance
+ * loads its own copy of the config file, with cfg.instance set to
+ * its index.
+ */
+static
+int pc_run_multi (const char *fname, unsigned cnt, unsigned threads)
+{
+	int       r;
+	unsigned  i;
+	ini_sct_t **ini, *sct;
+	ibmpc_t   **sim;
+	runner_t  run;
+
+	ini = malloc (cnt * sizeof (ini_sct_t *));
+	sim = malloc (cnt * sizeof (ibmpc_t *));
+
+	if ((ini == NULL) || (sim == NULL)) {
+		free (ini);
+		free (sim);
+		return (1);
+	}
+
+	runner_init (&run, threads);
+
+	for (i = 0; i < cnt; i++) {
+		ini[i] = NULL;
+		sim[i] = NULL;
+	}
+
+	r = 0;
+
+	for (i = 0; i < cnt; i++) {
+		if ((ini[i] = pc_load_config (fname, i)) == NULL) {
+			pce_log (MSG_ERR, "*** loading the config for instance %u failed\n", i);
+			r = 1;
+			break;
+		}
+
+		if ((sct = ini_next_sct (ini[i], NULL, "pc")) == NULL) {
+			sct = ini[i];
+		}
+
+		if (i == 0) {
+			pce_path_ini (sct);
+		}
+
+		sim[i] = pc_new (sct, (par_terminal != NULL) ? par_terminal : "null",
+			par_video
+		);
+
+		if (sim[i] == NULL) {
+			pce_log (MSG_ERR, "*** setting up instance %u failed\n", i);
+			r = 1;
+			break;
+		}
+
+		cmd_init (sim[i], cmd_get_sym, cmd_set_sym);
+
+		pc_reset (sim[i]);
+		pc_clock_discontinuity (sim[i]);
+
+		if (i > 0) {
+			mem_share_rom (sim[i]->mem, sim[0]->mem);
+		}
+
+		runner_add (&run, sim[i], pc_run_slice);
+	}
+
+	if (r == 0) {
+		pce_log_tag (MSG_INF, "RUNNER:", "instances=%u threads=%u\n",
+			run.cnt, run.threads
+		);
+
+		par_runner = &run;
+
+		pce_start();
+
+		runner_run (&run);
+
+		pce_stop();
+
+		par_runner = NULL;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		pc_del (sim[i]);
+		ini_sct_del (ini[i]);
+	}
+
+	runner_free (&run);
+
+	free (sim);
+	free (ini);
+
+	return (r);
+}
+
 void pc_log_deb (const char *msg, ...)
 {
 	va_list        va;
@@ -219,12 +375,15 @@ int main (int argc, char *argv[])
 	int       r;
 	char      **optarg;
 	int       run, nomon;
+	unsigned  inst, threads;
 	char      *cfg;
 	ini_sct_t *sct;
 
 	cfg = NULL;
 	run = 0;
 	nomon = 0;
+	inst = 1;
+	threads = 1;
 
 	pce_log_init();
 	pce_log_add_fp (stderr, 0, MSG_INF);
@@ -283,10 +442,22 @@ int main (int argc, char *argv[])
 			ini_str_add (&par_ini_str2, optarg[0], "\n", NULL);
 			break;
 
+		case 'j':
+			threads = strtoul (optarg[0], NULL, 0);
+			break;
+
 		case 'l':
 			pce_log_add_fname (optarg[0], MSG_DEB);
 			break;
 
+		case 'M':
+			par_trace_io = 1;
+			break;
+
+		case 'n':
+			inst = strtoul (optarg[0], NULL, 0);
+			break;
+
 		case 'p':
 			ini_str_add (&par_ini_str2, "cpu.model = \"",
 				optarg[0], "\"\n"
@@ -310,6 +481,10 @@ int main (int argc, char *argv[])
 			ini_str_add (&par_ini_str1, "cfg.terminal = \"", optarg[0], "\"\n");
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 's':
 			ini_str_add (&par_ini_str2, "cpu.speed = ",
 				optarg[0], "\n"
@@ -333,6 +508,21 @@ int main (int argc, char *argv[])
 
 	pc_log_banner();
 
+	if (inst > 1) {
+		atexit (pc_atexit);
+		signal (SIGINT, sig_int);
+		signal (SIGTERM, sig_term);
+
+		r = pc_run_multi (cfg, inst, threads);
+
+		ini_str_free (&par_ini_str1);
+		ini_str_free (&par_ini_str2);
+		ini_sct_del (par_cfg);
+		pce_log_done();
+
+		return (r);
+	}
+
 	if (ini_str_eval (&par_ini_str1, par_cfg, 1)) {
 		return (1);
 	}
@@ -359,7 +549,15 @@ int main (int argc, char *argv[])
 
 	pce_path_ini (sct);
 
-	par_pc = pc_new (sct);
+	par_pc = pc_new (sct, par_terminal, par_video);
+
+	if (par_trace != NULL) {
+		if (pc_set_trace (par_pc, par_trace, par_trace_io)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
 
 	signal (SIGINT, sig_int);
 	signal (SIGTERM, sig_term);
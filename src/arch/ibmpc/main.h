@@ -36,9 +36,8 @@
 #define PCE_IBMPC_M24   4
 #define PCE_IBMPC_ATARI 8
 
-
-extern const char *par_terminal;
-extern const char *par_video;
+/* the number of pc_clock() calls in a runner time slice */
+#define PCE_IBMPC_SLICE 16384
 
 
 void sim_stop (void);
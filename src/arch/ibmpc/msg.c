@@ -36,9 +36,6 @@
 #include <lib/sysdep.h>
 
 
-extern monitor_t par_mon;
-
-
 typedef struct {
 	const char *msg;
 
@@ -118,7 +115,11 @@ static
 int pc_set_msg_emu_exit (ibmpc_t *pc, const char *msg, const char *val)
 {
 	pc->brk = PCE_BRK_ABORT;
-	mon_set_terminate (&par_mon, 1);
+
+	if (pc->mon != NULL) {
+		mon_set_terminate (pc->mon, 1);
+	}
+
 	return (0);
 }
 
@@ -306,12 +307,7 @@ int pc_set_msg (void *ext, const char *msg, const char *val)
 	int           r;
 	pc_msg_list_t *lst;
 
-	/* a hack, for debugging only */
-	if (pc == NULL) {
-		pc = par_pc;
-	}
-
-	if (msg == NULL) {
+	if ((pc == NULL) || (msg == NULL)) {
 		return (1);
 	}
 
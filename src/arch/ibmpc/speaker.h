@@ -24,41 +24,18 @@
 #define PCE_IBMPC_SPEAKER_H 1
 
 
-#include <stdint.h>
-
-#include <drivers/sound/sound.h>
-
-
-#define PC_SPEAKER_BUF 1024
+#include <drivers/sound/mixer.h>
 
 
 typedef struct {
-	sound_drv_t    *drv;
-
-	char           playing;
+	sound_mix_t    *mix;
+	int            mix_src;
 
 	char           speaker_msk;
 	char           speaker_out;
 
-	uint16_t       timeout_val;
-	unsigned long  timeout_clk;
-
-	unsigned long  clk;
-	unsigned long  rem;
-
-	unsigned long  sample_acc;
-
-	unsigned long  srate;
-
-	unsigned long  lowpass_freq;
-	sound_iir2_t   iir;
-
-	unsigned       buf_cnt;
-	uint16_t       buf[PC_SPEAKER_BUF];
-
-	uint16_t       val_msk;
-	uint16_t       val_on;
-	uint16_t       val_off;
+	long           val_on;
+	long           val_off;
 
 	void           *get_clk_ext;
 	unsigned long  (*get_clk) (void *ext);
@@ -73,16 +50,12 @@ void pc_speaker_del (pc_speaker_t *spk);
 
 void pc_speaker_set_clk_fct (pc_speaker_t *spk, void *ext, void *fct);
 
-int pc_speaker_set_driver (pc_speaker_t *spk, const char *driver, unsigned long srate);
-
-void pc_speaker_set_lowpass (pc_speaker_t *spk, unsigned long freq);
+int pc_speaker_set_mixer (pc_speaker_t *spk, sound_mix_t *mix);
 
 void pc_speaker_set_volume (pc_speaker_t *spk, unsigned vol);
 
 void pc_speaker_set_msk (pc_speaker_t *spk, unsigned char val);
 void pc_speaker_set_out (pc_speaker_t *spk, unsigned char val);
 
-void pc_speaker_clock (pc_speaker_t *spk, unsigned long cnt);
-
 
 #endif
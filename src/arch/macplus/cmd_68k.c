@@ -29,6 +29,8 @@
 
 #include <cpu/e68000/e68000.h>
 
+#include <drivers/char/char-io.h>
+
 #include <lib/brkpt.h>
 #include <lib/cmd.h>
 #include <lib/console.h>
@@ -407,6 +409,34 @@ void mac_run (macplus_t *sim)
 	pce_stop();
 }
 
+int mac_run_slice (void *ext)
+{
+	unsigned  i;
+	macplus_t *sim;
+
+	sim = ext;
+
+	chr_io_set_owner (sim);
+	cmd_set_owner (sim);
+
+	for (i = 0; i < PCE_MAC_SLICE; i++) {
+		mac_clock (sim, 0);
+
+		if (sim->brk) {
+			break;
+		}
+	}
+
+	if (sim->brk == PCE_BRK_ABORT) {
+		return (1);
+	}
+
+	/* there is no monitor to stop in */
+	sim->brk = 0;
+
+	return (0);
+}
+
 #ifdef __EMSCRIPTEN__
 /*
  * emscripten specific main loop
@@ -423,10 +453,10 @@ void mac_run_emscripten (macplus_t *sim)
 	mac_clock_discontinuity (sim);
 
 #ifdef __EMSCRIPTEN__
-	emscripten_set_main_loop(mac_run_emscripten_step, 0, 1);
+	emscripten_set_main_loop_arg (mac_run_emscripten_step, sim, 0, 1);
 #else
 	while (!sim->brk) {
-		mac_run_emscripten_step();
+		mac_run_emscripten_step (sim);
 	}
 #endif
 
@@ -437,9 +467,9 @@ void mac_run_emscripten (macplus_t *sim)
 /*
  * run one iteration
  */
-void mac_run_emscripten_step ()
+void mac_run_emscripten_step (void *ext)
 {
-	macplus_t *sim = par_sim;
+	macplus_t *sim = ext;
 	int mousex;
 	int mousey;
 	int mousehack_interval = 100;
@@ -1150,6 +1180,8 @@ int mac_cmd (macplus_t *sim, cmd_t *cmd)
 
 void mac_cmd_init (macplus_t *sim, monitor_t *mon)
 {
+	sim->mon = mon;
+
 	mon_cmd_add (mon, par_cmd, sizeof (par_cmd) / sizeof (par_cmd[0]));
 	mon_cmd_add_bp (mon);
 
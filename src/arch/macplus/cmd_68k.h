@@ -34,12 +34,18 @@ void mac_prt_state (macplus_t *sim, const char *str);
 
 void mac_run (macplus_t *sim);
 
+/*
+ * Run one time slice without a monitor, for use with a runner_t.
+ * Returns 1 if the instance has terminated.
+ */
+int mac_run_slice (void *ext);
+
 int mac_cmd (macplus_t *sim, cmd_t *cmd);
 
 void mac_cmd_init (macplus_t *sim, monitor_t *mon);
 
 /* emscripten specific run loop */
 void mac_run_emscripten (macplus_t *sim);
-void mac_run_emscripten_step ();
+void mac_run_emscripten_step (void *ext);
 
 #endif
@@ -77,6 +77,11 @@ int mac_hook (void *ext, unsigned val)
 			e68_set_areg32 (sim->cpu, 1, sim->sony.a1);
 			e68_set_pc_prefetch (sim->cpu, sim->sony.pc);
 
+			/* the driver may have read into the video buffer */
+			if (sim->video != NULL) {
+				mac_video_invalidate (sim->video);
+			}
+
 			return (0);
 		}
 		break;
@@ -46,10 +46,12 @@
 #include <devices/nvram.h>
 
 #include <drivers/block/block.h>
+#include <drivers/char/char-io.h>
 
 #include <drivers/video/terminal.h>
 
 #include <lib/brkpt.h>
+#include <lib/cmd.h>
 #include <lib/inidsk.h>
 #include <lib/iniram.h>
 #include <lib/initerm.h>
@@ -263,10 +265,20 @@ void mac_set_vbuf (macplus_t *sim, unsigned long addr)
 	unsigned char *vbuf;
 	mem_blk_t     *blk;
 
+	sim->vbuf = addr;
+
 	if (addr < mem_blk_get_size (sim->ram)) {
 		vbuf = mem_blk_get_data (sim->ram) + addr;
+
+		/* mark CPU writes to the video buffer */
+		e68_set_wmap (sim->cpu, addr,
+			mac_video_get_vbuf_size (sim->video),
+			MAC_VIDEO_DIRTY_SHIFT, sim->video->dirty
+		);
 	}
 	else {
+		e68_set_wmap (sim->cpu, 0, 0, 0, NULL);
+
 		blk = mem_get_blk (sim->mem, addr);
 
 		if (blk == NULL) {
@@ -688,19 +700,47 @@ void mac_setup_mem (macplus_t *sim, ini_sct_t *ini)
 	}
 }
 
+static
+void mac_setup_idle (macplus_t *sim, ini_sct_t *ini)
+{
+	ini_sct_t     *sct;
+	unsigned long addr, size;
+
+	sct = NULL;
+
+	while ((sct = ini_next_sct (ini, sct, "idle")) != NULL) {
+		ini_get_uint32 (sct, "address", &addr, 0);
+		ini_get_uint32 (sct, "size", &size, 2);
+
+		pce_log_tag (MSG_INF, "IDLE:", "addr=0x%06lx size=0x%lx\n",
+			addr, size
+		);
+
+		if (e68_add_idle_range (sim->cpu, addr, size)) {
+			pce_log (MSG_ERR, "*** too many idle ranges\n");
+		}
+	}
+}
+
 static
 void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 {
 	ini_sct_t  *sct;
 	const char *model;
-	unsigned   speed;
+	unsigned   speed, idle;
+	int        lazy, lazy_check;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "68000");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "lazy_cc", &lazy, 1);
+	ini_get_bool (sct, "lazy_cc_check", &lazy_check, 0);
+	ini_get_uint16 (sct, "idle", &idle, 16);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d\n", model, speed);
+	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d lazy_cc=%d check=%d idle=%u\n",
+		model, speed, lazy, lazy_check, idle
+	);
 
 	sim->cpu = e68_new();
 	if (sim->cpu == NULL) {
@@ -711,6 +751,13 @@ void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 		pce_log (MSG_ERR, "*** unknown cpu model (%s)\n", model);
 	}
 
+	e68_set_lazy_cc (sim->cpu, lazy, lazy_check);
+
+	/* RAM, ROM and their mirrors */
+	e68_set_idle (sim->cpu, idle);
+	e68_set_idle_rom (sim->cpu, 0, 0x580000);
+	mac_setup_idle (sim, ini);
+
 	e68_set_mem_fct (sim->cpu, sim->mem,
 		&mem_get_uint8,
 		&mem_get_uint16_be,
@@ -720,6 +767,12 @@ void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 		&mem_set_uint32_be
 	);
 
+	if (sim->ram != NULL) {
+		e68_set_ram_dirty_map (sim->cpu, mem_blk_dirty_map (sim->ram),
+			MEM_DIRTY_SHIFT
+		);
+	}
+
 	e68_set_reset_fct (sim->cpu, sim, mac_set_reset);
 
 	e68_set_hook_fct (sim->cpu, sim, mac_hook);
@@ -1007,7 +1060,7 @@ void mac_setup_disks (macplus_t *sim, ini_sct_t *ini)
 }
 
 static
-void mac_setup_iwm (macplus_t *sim, ini_sct_t *ini)
+void mac_setup_iwm (macplus_t *sim, ini_sct_t *ini, unsigned disk_boot)
 {
 	unsigned   n;
 	int        single, rotate, inserted;
@@ -1037,7 +1090,7 @@ void mac_setup_iwm (macplus_t *sim, ini_sct_t *ini)
 		ini_get_bool (sctdev, "inserted", &inserted, inserted);
 
 		if ((drive >= 1) && (drive <= 8)) {
-			if (par_disk_boot & (1U << (drive - 1))) {
+			if (disk_boot & (1U << (drive - 1))) {
 				inserted = 1;
 			}
 		}
@@ -1125,7 +1178,7 @@ void mac_setup_scsi (macplus_t *sim, ini_sct_t *ini)
 }
 
 static
-void mac_setup_sony (macplus_t *sim, ini_sct_t *ini)
+void mac_setup_sony (macplus_t *sim, ini_sct_t *ini, unsigned disk_boot)
 {
 	unsigned  i;
 	int       format_hd_as_dd;
@@ -1149,7 +1202,7 @@ void mac_setup_sony (macplus_t *sim, ini_sct_t *ini)
 	}
 
 	for (i = 0; i < SONY_DRIVES; i++) {
-		if (par_disk_boot & (1U << i)) {
+		if (disk_boot & (1U << i)) {
 			val = 1;
 		}
 		else {
@@ -1211,9 +1264,9 @@ void mac_setup_sound (macplus_t *sim, ini_sct_t *ini)
 }
 
 static
-void mac_setup_terminal (macplus_t *sim, ini_sct_t *ini)
+void mac_setup_terminal (macplus_t *sim, ini_sct_t *ini, const char *terminal)
 {
-	sim->trm = ini_get_terminal (ini, par_terminal);
+	sim->trm = ini_get_terminal (ini, terminal);
 
 	if (sim->trm == NULL) {
 		return;
@@ -1286,12 +1339,14 @@ void mac_setup_video (macplus_t *sim, ini_sct_t *ini)
 	}
 }
 
-void mac_init (macplus_t *sim, ini_sct_t *ini)
+void mac_init (macplus_t *sim, ini_sct_t *ini, const char *terminal,
+	unsigned disk_boot)
 {
 	unsigned i;
 
 	sim->trm = NULL;
 	sim->video = NULL;
+	sim->vbuf = 0;
 
 	sim->reset = 0;
 
@@ -1326,6 +1381,9 @@ void mac_init (macplus_t *sim, ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->mon = NULL;
+	sim->trc = NULL;
+
 	mac_setup_system (sim, ini);
 	mac_setup_mem (sim, ini);
 	mac_setup_cpu (sim, ini);
@@ -1336,11 +1394,11 @@ void mac_init (macplus_t *sim, ini_sct_t *ini)
 	mac_setup_kbd (sim, ini);
 	mac_setup_adb (sim, ini);
 	mac_setup_disks (sim, ini);
-	mac_setup_iwm (sim, ini);
+	mac_setup_iwm (sim, ini, disk_boot);
 	mac_setup_scsi (sim, ini);
-	mac_setup_sony (sim, ini);
+	mac_setup_sony (sim, ini, disk_boot);
 	mac_setup_sound (sim, ini);
-	mac_setup_terminal (sim, ini);
+	mac_setup_terminal (sim, ini, terminal);
 	mac_setup_video (sim, ini);
 
 	pce_load_mem_ini (sim->mem, ini);
@@ -1350,7 +1408,7 @@ void mac_init (macplus_t *sim, ini_sct_t *ini)
 	mac_clock_discontinuity (sim);
 }
 
-macplus_t *mac_new (ini_sct_t *ini)
+macplus_t *mac_new (ini_sct_t *ini, const char *terminal, unsigned disk_boot)
 {
 	macplus_t *sim;
 
@@ -1359,7 +1417,11 @@ macplus_t *mac_new (ini_sct_t *ini)
 		return (NULL);
 	}
 
-	mac_init (sim, ini);
+	/* this machine has its own char I/O reactor and monitor symbols */
+	chr_io_set_owner (sim);
+	cmd_set_owner (sim);
+
+	mac_init (sim, ini, terminal, disk_boot);
 
 	return (sim);
 }
@@ -1392,6 +1454,7 @@ void mac_free (macplus_t *sim)
 	mac_ser_free (&sim->ser[0]);
 	e8530_free (&sim->scc);
 	e6522_free (&sim->via);
+	trace_del (sim->trc);
 	e68_del (sim->cpu);
 	mem_del (sim->mem);
 
@@ -1405,6 +1468,8 @@ void mac_del (macplus_t *sim)
 {
 	if (sim != NULL) {
 		mac_free (sim);
+		cmd_del_owner (sim);
+		chr_io_del_owner (sim);
 		free (sim);
 	}
 }
@@ -1462,6 +1527,31 @@ void mac_adjust_speed (macplus_t *sim)
 	mac_clock_discontinuity (sim);
 }
 
+int mac_set_trace (macplus_t *sim, const char *fname)
+{
+	e68_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "68000");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	e68_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void mac_set_speed (macplus_t *sim, unsigned idx, unsigned factor)
 {
 	if (idx >= PCE_MAC_SPEED_CNT) {
@@ -1684,6 +1774,8 @@ void mac_clock (macplus_t *sim, unsigned n)
 		trm_check (sim->trm);
 	}
 
+	chr_io_poll();
+
 	mac_check_mouse (sim);
 
 	mac_rtc_clock (&sim->rtc, sim->clk_div[3]);
@@ -49,6 +49,8 @@
 #include <drivers/video/terminal.h>
 
 #include <lib/brkpt.h>
+#include <lib/monitor.h>
+#include <lib/trace.h>
 
 
 #define PCE_MAC_PLUS    1
@@ -78,6 +80,12 @@ struct macplus_s {
 
 	bp_set_t           bps;
 
+	/* the monitor that controls this instance or NULL */
+	monitor_t          *mon;
+
+	/* the execution trace recorder or NULL */
+	trace_t            *trc;
+
 	e6522_t            via;
 	e8530_t            scc;
 	mac_rtc_t          rtc;
@@ -105,6 +113,9 @@ struct macplus_s {
 	unsigned long      vbuf1;
 	unsigned long      vbuf2;
 
+	/* the address of the displayed video buffer */
+	unsigned long      vbuf;
+
 	unsigned long      sbuf1;
 	unsigned long      sbuf2;
 
@@ -140,13 +151,17 @@ struct macplus_s {
 };
 
 
-void mac_init (macplus_t *sim, ini_sct_t *ini);
+void mac_init (macplus_t *sim, ini_sct_t *ini, const char *terminal,
+	unsigned disk_boot
+);
 
 /*****************************************************************************
  * @short Create a new macplus context
- * @param ini A libini macplus section. Can be NULL.
+ * @param ini       A libini macplus section. Can be NULL.
+ * @param terminal  The terminal driver or NULL to use the config file
+ * @param disk_boot A bit mask of disks that are inserted at startup
  *****************************************************************************/
-macplus_t *mac_new (ini_sct_t *ini);
+macplus_t *mac_new (ini_sct_t *ini, const char *terminal, unsigned disk_boot);
 
 void mac_free (macplus_t *sim);
 
@@ -170,6 +185,12 @@ void mac_set_pause (macplus_t *sim, int pause);
 
 void mac_set_speed (macplus_t *sim, unsigned idx, unsigned factor);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int mac_set_trace (macplus_t *sim, const char *fname);
+
 int mac_set_msg_trm (macplus_t *sim, const char *msg, const char *val);
 
 int mac_set_cpu_model (macplus_t *sim, const char *model);
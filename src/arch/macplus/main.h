@@ -41,20 +41,15 @@
 
 #define MAC_CPU_CLOCK 7833600
 
+/* the number of mac_clock() calls in a runner time slice */
+#define PCE_MAC_SLICE 65536
+
 
 struct macplus_s;
 typedef struct macplus_s macplus_t;
 
 extern int        par_verbose;
 
-extern const char *par_terminal;
-
-extern unsigned   par_disk_boot;
-
-extern macplus_t  *par_sim;
-
-extern unsigned   par_sig_int;
-
 void mac_log_deb (const char *msg, ...) __attribute__((format(printf, 1, 2)));
 
 void sim_stop (void);
@@ -49,6 +49,12 @@ void mac_set_overlay (macplus_t *sim, int overlay)
 		mem_rmv_blk (sim->mem, sim->ram_ovl);
 		mem_add_blk (sim->mem, sim->ram, 0);
 
+		/*
+		 * Writes through the overlay clone were not tracked in the
+		 * dirty page map of the RAM block.
+		 */
+		mem_blk_dirty_set (sim->ram, 0, mem_blk_get_size (sim->ram));
+
 		e68_set_ram (sim->cpu,
 			mem_blk_get_data (sim->ram),
 			mem_blk_get_size (sim->ram)
@@ -113,6 +119,17 @@ int mac_addr_map (macplus_t *sim, unsigned long *addr)
 	return (0);
 }
 
+/*
+ * Mark writes to the video buffer that bypass the CPU RAM fast path
+ */
+static
+void mac_mem_set_dirty (macplus_t *sim, unsigned long addr, unsigned cnt)
+{
+	if (sim->video != NULL) {
+		mac_video_set_dirty (sim->video, addr - sim->vbuf, cnt);
+	}
+}
+
 unsigned char mac_mem_get_uint8 (void *ext, unsigned long addr)
 {
 	macplus_t *sim = ext;
@@ -176,6 +193,7 @@ void mac_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint8 (sim->mem, addr, val);
+		mac_mem_set_dirty (sim, addr, 1);
 	}
 
 	if ((addr >= 0x580000) && (addr < 0x600000)) {
@@ -198,6 +216,7 @@ void mac_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint16_be (sim->mem, addr, val);
+		mac_mem_set_dirty (sim, addr, 2);
 	}
 
 #ifdef DEBUG_MEM
@@ -211,9 +230,29 @@ void mac_mem_set_uint32 (void *ext, unsigned long addr, unsigned long val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint32_be (sim->mem, addr, val);
+		mac_mem_set_dirty (sim, addr, 4);
 	}
 
 #ifdef DEBUG_MEM
 	mac_log_deb ("mem: set 32: %06lX <- %02lX\n", addr, val);
 #endif
 }
+
+/*
+ * Monitor writes go to the physical address space directly
+ */
+void mac_mem_set_uint8_mon (void *ext, unsigned long addr, unsigned char val)
+{
+	macplus_t *sim = ext;
+
+	mem_set_uint8 (sim->mem, addr, val);
+	mac_mem_set_dirty (sim, addr, 1);
+}
+
+void mac_mem_set_uint8_mon_rw (void *ext, unsigned long addr, unsigned char val)
+{
+	macplus_t *sim = ext;
+
+	mem_set_uint8_rw (sim->mem, addr, val);
+	mac_mem_set_dirty (sim, addr, 1);
+}
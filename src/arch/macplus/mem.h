@@ -37,6 +37,8 @@ unsigned long mac_mem_get_uint32 (void *ext, unsigned long addr);
 void mac_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val);
 void mac_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val);
 void mac_mem_set_uint32 (void *ext, unsigned long addr, unsigned long val);
+void mac_mem_set_uint8_mon (void *ext, unsigned long addr, unsigned char val);
+void mac_mem_set_uint8_mon_rw (void *ext, unsigned long addr, unsigned char val);
 
 
 #endif
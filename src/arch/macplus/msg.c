@@ -33,9 +33,6 @@
 #include <lib/sysdep.h>
 
 
-extern monitor_t par_mon;
-
-
 typedef struct {
 	const char *msg;
 
@@ -123,7 +120,9 @@ int mac_set_msg_emu_exit (macplus_t *sim, const char *msg, const char *val)
 {
 	sim->brk = PCE_BRK_ABORT;
 
-	mon_set_terminate (&par_mon, 1);
+	if (sim->mon != NULL) {
+		mon_set_terminate (sim->mon, 1);
+	}
 
 	return (0);
 }
@@ -344,12 +343,7 @@ int mac_set_msg (void *ext, const char *msg, const char *val)
 	int            r;
 	mac_msg_list_t *lst;
 
-	/* a hack, for debugging only */
-	if (sim == NULL) {
-		sim = par_sim;
-	}
-
-	if (msg == NULL) {
+	if ((sim == NULL) || (msg == NULL)) {
 		return (1);
 	}
 
@@ -40,28 +40,40 @@
 
 int mac_video_init (mac_video_t *mv, unsigned w, unsigned h)
 {
+	unsigned i, j;
+
 	mv->vbuf = NULL;
 	mv->trm = NULL;
 
 	mv->w = w;
 	mv->h = h;
 
-	mv->force = 0;
+	mv->line_bytes = (w + 7) / 8;
 
-	mv->cmp_cnt = 8;
+	mv->dirty_cnt = (unsigned long) mv->line_bytes * h;
+	mv->dirty_cnt = (mv->dirty_cnt + (1UL << MAC_VIDEO_DIRTY_SHIFT) - 1) >> MAC_VIDEO_DIRTY_SHIFT;
 
-	mv->vcmp = malloc ((unsigned long) ((mv->w + 7) / 8) * mv->h);
+	mv->dirty = malloc (mv->dirty_cnt);
 
-	if (mv->vcmp == NULL) {
+	if (mv->dirty == NULL) {
 		return (1);
 	}
 
-	mv->rgb = malloc (3UL * (unsigned long) w * mv->cmp_cnt);
+	memset (mv->dirty, 1, mv->dirty_cnt);
+
+	mv->ibuf = malloc ((unsigned long) w * h);
 
-	if (mv->rgb == NULL) {
+	if (mv->ibuf == NULL) {
+		free (mv->dirty);
 		return (1);
 	}
 
+	for (i = 0; i < 256; i++) {
+		for (j = 0; j < 8; j++) {
+			mv->exp[i][j] = (i >> (7 - j)) & 1;
+		}
+	}
+
 	mv->brightness = 255;
 
 	mv->col0[0] = 0;
@@ -101,6 +113,8 @@ mac_video_t *mac_video_new (unsigned w, unsigned h)
 
 void mac_video_free (mac_video_t *mv)
 {
+	free (mv->ibuf);
+	free (mv->dirty);
 }
 
 void mac_video_del (mac_video_t *mv)
@@ -120,6 +134,40 @@ void mac_video_set_vbi_fct (mac_video_t *mv, void *ext, void *fct)
 void mac_video_set_vbuf (mac_video_t *mv, const unsigned char *vbuf)
 {
 	mv->vbuf = vbuf;
+
+	mac_video_invalidate (mv);
+}
+
+unsigned long mac_video_get_vbuf_size (const mac_video_t *mv)
+{
+	return ((unsigned long) mv->line_bytes * mv->h);
+}
+
+void mac_video_set_dirty (mac_video_t *mv, unsigned long ofs, unsigned long cnt)
+{
+	unsigned long size, i, j;
+
+	size = mac_video_get_vbuf_size (mv);
+
+	if ((cnt == 0) || (ofs >= size)) {
+		return;
+	}
+
+	if (cnt > (size - ofs)) {
+		cnt = size - ofs;
+	}
+
+	i = ofs >> MAC_VIDEO_DIRTY_SHIFT;
+	j = (ofs + cnt - 1) >> MAC_VIDEO_DIRTY_SHIFT;
+
+	while (i <= j) {
+		mv->dirty[i++] = 1;
+	}
+}
+
+void mac_video_invalidate (mac_video_t *mv)
+{
+	memset (mv->dirty, 1, mv->dirty_cnt);
 }
 
 void mac_video_set_terminal (mac_video_t *mv, terminal_t *trm)
@@ -139,8 +187,6 @@ void mac_video_set_color (mac_video_t *mv, unsigned long col0, unsigned long col
 		mv->col0[i] = (col0 >> (8 * (2 - i))) & 0xff;
 		mv->col1[i] = (col1 >> (8 * (2 - i))) & 0xff;
 	}
-
-	mv->force = 1;
 }
 
 void mac_video_set_brightness (mac_video_t *mv, unsigned val)
@@ -149,10 +195,7 @@ void mac_video_set_brightness (mac_video_t *mv, unsigned val)
 		val = 255;
 	}
 
-	if (mv->brightness != val) {
-		mv->force = 1;
-		mv->brightness = val;
-	}
+	mv->brightness = val;
 }
 
 static
@@ -169,15 +212,57 @@ void mac_video_set_vbi (mac_video_t *mv, unsigned char val)
 	}
 }
 
+/*
+ * Check if any byte in line y was modified
+ */
 static
-void mac_video_update (mac_video_t *mv)
+int mac_video_line_dirty (const mac_video_t *mv, unsigned y)
 {
-	unsigned            y;
-	unsigned            i, j;
-	unsigned            k, n;
+	unsigned long i, j;
+
+	i = (unsigned long) mv->line_bytes * y;
+	j = i + mv->line_bytes - 1;
+
+	i >>= MAC_VIDEO_DIRTY_SHIFT;
+	j >>= MAC_VIDEO_DIRTY_SHIFT;
+
+	while (i <= j) {
+		if (mv->dirty[i++]) {
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+static
+void mac_video_expand_line (mac_video_t *mv, unsigned y)
+{
+	unsigned            i, n;
 	const unsigned char *src;
-	unsigned char       *dst, *rgb;
-	unsigned char       col0[3], col1[3];
+	unsigned char       *dst;
+
+	src = mv->vbuf + (unsigned long) mv->line_bytes * y;
+	dst = mv->ibuf + (unsigned long) mv->w * y;
+
+	n = mv->w / 8;
+
+	for (i = 0; i < n; i++) {
+		memcpy (dst, mv->exp[src[i]], 8);
+		dst += 8;
+	}
+
+	if (mv->w & 7) {
+		memcpy (dst, mv->exp[src[n]], mv->w & 7);
+	}
+}
+
+static
+void mac_video_update (mac_video_t *mv)
+{
+	unsigned      i;
+	unsigned      y, y0;
+	unsigned char col[3];
 
 	if (mv->trm == NULL) {
 		return;
@@ -187,62 +272,47 @@ void mac_video_update (mac_video_t *mv)
 		return;
 	}
 
+	trm_set_size (mv->trm, mv->w, mv->h);
+
+	/* a set bit is drawn in col0, a clear bit in col1 */
 	for (i = 0; i < 3; i++) {
-		col0[i] = (mv->brightness * mv->col0[i]) / 255;
-		col1[i] = (mv->brightness * mv->col1[i]) / 255;
+		col[i] = (mv->brightness * mv->col1[i]) / 255;
 	}
 
-	trm_set_size (mv->trm, mv->w, mv->h);
+	trm_set_palette (mv->trm, 0, col);
 
-	src = mv->vbuf;
-	dst = mv->vcmp;
-	rgb = mv->rgb;
+	for (i = 0; i < 3; i++) {
+		col[i] = (mv->brightness * mv->col0[i]) / 255;
+	}
+
+	trm_set_palette (mv->trm, 1, col);
 
 	y = 0;
-	while (y < mv->h) {
-		n = mv->h - y;
 
-		if (n > mv->cmp_cnt) {
-			n = mv->cmp_cnt;
+	while (y < mv->h) {
+		if (mac_video_line_dirty (mv, y) == 0) {
+			y += 1;
+			continue;
 		}
 
-		k = n * ((mv->w + 7) / 8);
-
-		if (mv->force || (memcmp (dst, src, k) != 0)) {
-			memcpy (dst, src, k);
+		y0 = y;
 
-			j = 0;
-			for (i = 0; i < (8 * k); i++) {
-				if (dst[i >> 3] & (0x80 >> (i & 7))) {
-					rgb[j + 0] = col0[0];
-					rgb[j + 1] = col0[1];
-					rgb[j + 2] = col0[2];
-				}
-				else {
-					rgb[j + 0] = col1[0];
-					rgb[j + 1] = col1[1];
-					rgb[j + 2] = col1[2];
-				}
-
-				j += mv->trm->term_bpp;
-			}
-
-			trm_set_lines (mv->trm, rgb, y, n);
+		while ((y < mv->h) && mac_video_line_dirty (mv, y)) {
+			mac_video_expand_line (mv, y);
+			y += 1;
 		}
 
-		src += k;
-		dst += k;
-
-		y += n;
+		trm_set_lines_idx (mv->trm, mv->ibuf + (unsigned long) mv->w * y0, y0, y - y0);
 	}
 
-	mv->force = 0;
+	memset (mv->dirty, 0, mv->dirty_cnt);
 
 	trm_update (mv->trm);
 }
 
 void mac_video_redraw (mac_video_t *mv)
 {
+	mac_video_invalidate (mv);
 	mac_video_update (mv);
 }
 
@@ -27,19 +27,28 @@
 #include <drivers/video/terminal.h>
 
 
+/* the number of video buffer bytes per dirty map entry is 2^shift */
+#define MAC_VIDEO_DIRTY_SHIFT 6
+
+
 typedef struct {
 	const unsigned char *vbuf;
 
 	unsigned            w;
 	unsigned            h;
 
-	char                force;
+	/* the number of video buffer bytes per line */
+	unsigned            line_bytes;
 
-	unsigned            cmp_cnt;
+	/* one byte per 2^MAC_VIDEO_DIRTY_SHIFT video buffer bytes */
+	unsigned long       dirty_cnt;
+	unsigned char       *dirty;
 
-	unsigned char       *vcmp;
+	/* palette indices, 1 byte per pixel */
+	unsigned char       *ibuf;
 
-	unsigned char       *rgb;
+	/* the palette indices for the 8 pixels in a byte */
+	unsigned char       exp[256][8];
 
 	unsigned            brightness;
 	unsigned char       col0[3];
@@ -64,6 +73,26 @@ void mac_video_del (mac_video_t *mv);
 void mac_video_set_vbi_fct (mac_video_t *mv, void *ext, void *fct);
 
 void mac_video_set_vbuf (mac_video_t *mv, const unsigned char *vbuf);
+
+/*!***************************************************************************
+ * @short Get the size of the video buffer in bytes
+ *****************************************************************************/
+unsigned long mac_video_get_vbuf_size (const mac_video_t *mv);
+
+/*!***************************************************************************
+ * @short Mark a range of the video buffer as modified
+ * @param ofs The offset into the video buffer
+ * @param cnt The number of bytes
+ *
+ * Only lines that were marked are redrawn. Writes by the CPU to the
+ * video buffer must be reported either here or through mv->dirty.
+ *****************************************************************************/
+void mac_video_set_dirty (mac_video_t *mv, unsigned long ofs, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Mark the entire video buffer as modified
+ *****************************************************************************/
+void mac_video_invalidate (mac_video_t *mv);
 void mac_video_set_terminal (mac_video_t *mv, terminal_t *trm);
 
 /*****************************************************************************
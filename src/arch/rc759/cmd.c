@@ -402,7 +402,7 @@ void print_state_cpu (e8086_t *c)
 
 	pce_printf ("CS=%04X  DS=%04X  ES=%04X  SS=%04X  IP=%04X  F =%04X",
 		e86_get_cs (c), e86_get_ds (c), e86_get_es (c), e86_get_ss (c),
-		e86_get_ip (c), c->flg
+		e86_get_ip (c), e86_get_flags (c)
 	);
 
 	pce_printf ("  I%c D%c O%c S%c Z%c A%c P%c C%c\n",
@@ -780,6 +780,8 @@ void rc759_setup_cpu (rc759_t *sim, ini_sct_t *ini)
 		(e86_set_uint16_f) mem_set_uint16_le
 	);
 
+	e86_set_mem_blk (sim->cpu, mem_set_blk);
+
 	e86_set_prt (sim->cpu, sim->iop,
 		(e86_get_uint8_f) mem_get_uint8,
 		(e86_set_uint8_f) mem_set_uint8,
@@ -789,6 +791,7 @@ void rc759_setup_cpu (rc759_t *sim, ini_sct_t *ini)
 
 	if (sim->ram != NULL) {
 		e86_set_ram (sim->cpu, sim->ram->data, sim->ram->size);
+		e86_set_ram_dirty_map (sim->cpu, mem_blk_dirty_map (sim->ram), MEM_DIRTY_SHIFT);
 	}
 	else {
 		e86_set_ram (sim->cpu, NULL, 0);
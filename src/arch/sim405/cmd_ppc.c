@@ -154,6 +154,12 @@ void s405_prt_state_ppc (sim405_t *sim)
 		t, efrq
 	);
 
+	if (c->bc != NULL) {
+		pce_printf ("  BC: HIT=%lu  MISS=%lu  CHECK=%d  ERR=%lu\n",
+			c->bc->hit, c->bc->miss, c->bc->check, c->bc->check_err
+		);
+	}
+
 	pce_printf (
 		" MSR=%08lX  XER=%08lX   CR=%08lX  XER=[%c%c%c]"
 		"     CR0=[%c%c%c%c]\n",
@@ -59,6 +59,7 @@ static pce_option_t opts[] = {
 	{ 'p', 1, "cpu", "string", "Set the CPU model" },
 	{ 'q', 0, "quiet", NULL, "Set the log level to error [no]" },
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -77,6 +78,8 @@ ini_sct_t            *par_cfg = NULL;
 
 static ini_strings_t par_ini_str;
 
+static const char    *par_trace = NULL;
+
 
 static
 void print_help (void)
@@ -261,6 +264,10 @@ int main (int argc, char *argv[])
 			run = 1;
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 'v':
 			pce_log_set_level (stderr, MSG_DEB);
 			break;
@@ -316,6 +323,14 @@ int main (int argc, char *argv[])
 	cmd_init (par_sim, cmd_get_sym, cmd_set_sym);
 	ppc_cmd_init (par_sim, &mon);
 
+	if (par_trace != NULL) {
+		if (s405_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
+
 	s405_reset (par_sim);
 
 	if (run) {
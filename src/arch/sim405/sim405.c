@@ -75,6 +75,7 @@ void s405_setup_system (sim405_t *sim, ini_sct_t *ini)
 	unsigned long uicinv;
 	unsigned long serial_clock;
 	int           sync_time_base;
+	int           bcache, bcache_check;
 
 	sct = ini_next_sct (ini, NULL, "system");
 
@@ -86,6 +87,8 @@ void s405_setup_system (sim405_t *sim, ini_sct_t *ini)
 	ini_get_uint32 (sct, "uic_invert", &uicinv, 0x0000007f);
 	ini_get_uint32 (sct, "serial_clock", &serial_clock, 115200);
 	ini_get_bool (sct, "sync_time_base", &sync_time_base, 1);
+	ini_get_bool (sct, "block_cache", &bcache, 1);
+	ini_get_bool (sct, "block_cache_check", &bcache_check, 0);
 
 	pce_log_tag (MSG_INF, "CPU:", "model=%s uic-inv=%08lX sync_time_base=%d\n",
 		model, uicinv, sync_time_base
@@ -106,6 +109,17 @@ void s405_setup_system (sim405_t *sim, ini_sct_t *ini)
 
 	if (sim->ram != NULL) {
 		p405_set_ram (sim->ppc, mem_blk_get_data (sim->ram), mem_blk_get_size (sim->ram));
+		p405_set_ram_dirty_map (sim->ppc, mem_blk_dirty_map (sim->ram), MEM_DIRTY_SHIFT);
+	}
+
+	if (bcache) {
+		pce_log_tag (MSG_INF, "CPU:", "block cache=1 check=%d\n",
+			bcache_check
+		);
+
+		if (p405_set_bcache (sim->ppc, 1, bcache_check)) {
+			pce_log (MSG_ERR, "*** can't enable the block cache\n");
+		}
 	}
 
 	p405_set_dcr_fct (sim->ppc, sim, &s405_get_dcr, &s405_set_dcr);
@@ -413,6 +427,8 @@ sim405_t *s405_new (ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->trc = NULL;
+
 	dev_lst_init (&sim->devlst);
 
 	sim->mem = mem_new();
@@ -461,6 +477,7 @@ void s405_del (sim405_t *sim)
 	ser_del (sim->serport[0]);
 
 	p405uic_free (&sim->uic);
+	trace_del (sim->trc);
 	p405_del (sim->ppc);
 
 	mem_del (sim->mem);
@@ -641,6 +658,31 @@ void s405_set_keycode (sim405_t *sim, unsigned char val)
 	}
 }
 
+int s405_set_trace (sim405_t *sim, const char *fname)
+{
+	p405_set_trace_fct (sim->ppc, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "ppc405");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	p405_set_trace_fct (sim->ppc, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void s405_reset (sim405_t *sim)
 {
 	p405_reset (sim->ppc);
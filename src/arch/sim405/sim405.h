@@ -56,6 +56,7 @@
 #include <devices/slip.h>
 
 #include <lib/brkpt.h>
+#include <lib/trace.h>
 #include <lib/log.h>
 #include <lib/inidsk.h>
 #include <lib/load.h>
@@ -123,6 +124,9 @@ typedef struct sim405_s {
 
 	bp_set_t           bps;
 
+	/* the execution trace recorder or NULL */
+	trace_t            *trc;
+
 	/* OCM DCRs */
 	uint32_t           ocm0_iscntl;
 	uint32_t           ocm0_isarc;
@@ -184,6 +188,12 @@ unsigned long long s405_get_clkcnt (sim405_t *sim);
  *****************************************************************************/
 void s405_reset (sim405_t *sim);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int s405_set_trace (sim405_t *sim, const char *fname);
+
 void s405_clock_discontinuity (sim405_t *sim);
 
 /*****************************************************************************
@@ -98,6 +98,12 @@ void sarm_prt_state_cpu (arm_t *c, FILE *fp)
 		(opcnt > 0) ? ((double) (clkcnt + delay) / (double) opcnt) : 1.0
 	);
 
+	if (c->ic != NULL) {
+		fprintf (fp, "IC: HIT=%lu  MISS=%lu  CHECK=%d  ERR=%lu\n",
+			c->ic->hit, c->ic->miss, c->ic->check, c->ic->check_err
+		);
+	}
+
 	fprintf (fp, "r00=%08lX  r04=%08lX  r08=%08lX  r12=%08lX  CPSR=%08lX\n",
 		(unsigned long) arm_get_gpr (c, 0),
 		(unsigned long) arm_get_gpr (c, 4),
@@ -57,6 +57,7 @@ static pce_option_t opts[] = {
 	{ 'l', 1, "log", "string", "Set the log file name [none]" },
 	{ 'q', 0, "quiet", NULL, "Set the log level to error [no]" },
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -73,6 +74,8 @@ ini_sct_t            *par_cfg = NULL;
 
 static ini_strings_t par_ini_str;
 
+static const char    *par_trace = NULL;
+
 
 static
 void print_help (void)
@@ -264,6 +267,10 @@ int main (int argc, char *argv[])
 			run = 1;
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 'v':
 			pce_log_set_level (stderr, MSG_DEB);
 			break;
@@ -299,6 +306,14 @@ int main (int argc, char *argv[])
 
 	par_sim = sarm_new (sct);
 
+	if (par_trace != NULL) {
+		if (sarm_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
+
 	signal (SIGINT, sig_int);
 	signal (SIGTERM, sig_term);
 	signal (SIGSEGV, sig_segv);
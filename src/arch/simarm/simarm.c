@@ -54,6 +54,7 @@ void sarm_setup_cpu (simarm_t *sim, ini_sct_t *ini)
 	ini_sct_t     *sct;
 	const char    *model;
 	unsigned long id;
+	int           icache, icache_check;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
@@ -71,6 +72,8 @@ void sarm_setup_cpu (simarm_t *sim, ini_sct_t *ini)
 	}
 
 	ini_get_uint32 (sct, "id", &id, id);
+	ini_get_bool (sct, "icache", &icache, 1);
+	ini_get_bool (sct, "icache_check", &icache_check, 0);
 
 	pce_log_tag (MSG_INF, "CPU:", "model=%s id=0x%08lx endian=%s\n",
 		model, id, sim->bigendian ? "big" : "little"
@@ -109,6 +112,17 @@ void sarm_setup_cpu (simarm_t *sim, ini_sct_t *ini)
 
 	if (sim->ram != NULL) {
 		arm_set_ram (sim->cpu, mem_blk_get_data (sim->ram), mem_blk_get_size (sim->ram));
+		arm_set_ram_dirty_map (sim->cpu, mem_blk_dirty_map (sim->ram), MEM_DIRTY_SHIFT);
+	}
+
+	if (icache) {
+		pce_log_tag (MSG_INF, "CPU:", "instruction cache=1 check=%d\n",
+			icache_check
+		);
+
+		if (arm_set_icache (sim->cpu, 1, icache_check)) {
+			pce_log (MSG_ERR, "*** can't enable the instruction cache\n");
+		}
 	}
 }
 
@@ -362,6 +376,8 @@ simarm_t *sarm_new (ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->trc = NULL;
+
 	sim->mem = mem_new();
 
 	ini_get_ram (sim->mem, ini, &sim->ram);
@@ -398,6 +414,7 @@ void sarm_del (simarm_t *sim)
 	tmr_del (sim->timer);
 	ict_del (sim->intc);
 
+	trace_del (sim->trc);
 	arm_del (sim->cpu);
 
 	mem_del (sim->mem);
@@ -431,6 +448,31 @@ void sarm_clock_discontinuity (simarm_t *sim)
 	pce_get_interval_us (&sim->rclk_interval);
 }
 
+int sarm_set_trace (simarm_t *sim, const char *fname)
+{
+	arm_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "arm");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	arm_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void sarm_reset (simarm_t *sim)
 {
 	arm_reset (sim->cpu);
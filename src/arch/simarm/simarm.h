@@ -47,6 +47,7 @@
 #include <libini/libini.h>
 
 #include <lib/brkpt.h>
+#include <lib/trace.h>
 
 
 /*****************************************************************************
@@ -74,6 +75,9 @@ typedef struct simarm_s {
 
 	bp_set_t           bps;
 
+	/* the execution trace recorder or NULL */
+	trace_t            *trc;
+
 	int                bigendian;
 
 	unsigned long      rclk_interval;
@@ -110,6 +114,12 @@ void sarm_clock_discontinuity (simarm_t *sim);
  *****************************************************************************/
 void sarm_reset (simarm_t *sim);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int sarm_set_trace (simarm_t *sim, const char *fname);
+
 /*****************************************************************************
  * @short Clock the simulator
  * @param n The number of clock cycles. Must not be 0.
@@ -43,6 +43,8 @@ unsigned  par_sig_int = 0;
 
 ini_sct_t *par_cfg = NULL;
 
+static char *par_trace = NULL;
+
 static monitor_t par_mon;
 
 
@@ -58,6 +60,7 @@ void prt_help (void)
 		"  -p, --cpu string       Set the cpu model\n"
 		"  -q, --quiet            Quiet operation [no]\n"
 		"  -r, --run              Start running immediately\n"
+		"  -T, --trace string     Record an execution trace [none]\n"
 		"  -v, --verbose          Verbose operation [no]\n",
 		stdout
 	);
@@ -249,6 +252,14 @@ int main (int argc, char *argv[])
 		else if (str_isarg2 (argv[i], "-r", "--run")) {
 			run = 1;
 		}
+		else if (str_isarg2 (argv[i], "-T", "--trace")) {
+			i += 1;
+			if (i >= argc) {
+				return (1);
+			}
+
+			par_trace = argv[i];
+		}
 		else {
 			printf ("%s: unknown option (%s)\n", argv[0], argv[i]);
 			return (1);
@@ -274,6 +285,14 @@ int main (int argc, char *argv[])
 
 	par_sim = ss32_new (sct);
 
+	if (par_trace != NULL) {
+		if (ss32_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
+
 	signal (SIGINT, &sig_int);
 	signal (SIGSEGV, &sig_segv);
 
@@ -142,6 +142,8 @@ sims32_t *ss32_new (ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->trc = NULL;
+
 	sim->mem = mem_new();
 
 	ini_get_ram (sim->mem, ini, &sim->ram);
@@ -164,6 +166,7 @@ void ss32_del (sims32_t *sim)
 	ser_del (sim->serport[1]);
 	ser_del (sim->serport[0]);
 
+	trace_del (sim->trc);
 	s32_del (sim->cpu);
 
 	mem_del (sim->mem);
@@ -190,6 +193,31 @@ void ss32_set_keycode (sims32_t *sim, unsigned char val)
 	ser_receive (sim->serport[1], val);
 }
 
+int ss32_set_trace (sims32_t *sim, const char *fname)
+{
+	s32_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "sparc32");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	s32_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void ss32_reset (sims32_t *sim)
 {
 	s32_reset (sim->cpu);
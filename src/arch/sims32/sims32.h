@@ -74,6 +74,7 @@ void pce_dump_hex (FILE *fp, void *buf, unsigned long n,
 
 #include <lib/log.h>
 #include <lib/brkpt.h>
+#include <lib/trace.h>
 #include <lib/load.h>
 
 
@@ -92,6 +93,9 @@ typedef struct sims32_s {
 
 	bp_set_t           bps;
 
+	/* the execution trace recorder or NULL */
+	trace_t            *trc;
+
 	unsigned long long clk_cnt;
 	unsigned long      clk_div[4];
 
@@ -122,6 +126,12 @@ unsigned long long ss32_get_clkcnt (sims32_t *sim);
  *****************************************************************************/
 void ss32_reset (sims32_t *sim);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int ss32_set_trace (sims32_t *sim, const char *fname);
+
 /*****************************************************************************
  * @short Clock the simulator
  * @param n The number of clock cycles. Must not be 0.
@@ -59,6 +59,8 @@ ini_sct_t  *par_cfg = NULL;
 
 static ini_strings_t par_ini_str;
 
+static const char    *par_trace = NULL;
+
 
 static pce_option_t opts[] = {
 	{ '?', 0, "help", NULL, "Print usage information" },
@@ -71,6 +73,7 @@ static pce_option_t opts[] = {
 	{ 'r', 0, "run", NULL, "Start running immediately [no]" },
 	{ 'R', 0, "no-monitor", NULL, "Never stop running [no]" },
 	{ 't', 1, "terminal", "string", "Set the terminal device" },
+	{ 'T', 1, "trace", "string", "Record an execution trace [none]" },
 	{ 'v', 0, "verbose", NULL, "Set the log level to debug [no]" },
 	{ 'V', 0, "version", NULL, "Print version information" },
 	{  -1, 0, NULL, NULL, NULL }
@@ -278,6 +281,10 @@ int main (int argc, char *argv[])
 			run = 1;
 			break;
 
+		case 'T':
+			par_trace = optarg[0];
+			break;
+
 		case 'R':
 			nomon = 1;
 			break;
@@ -333,6 +340,14 @@ int main (int argc, char *argv[])
 
 	par_sim = v20_new (sct);
 
+	if (par_trace != NULL) {
+		if (v20_set_trace (par_sim, par_trace)) {
+			pce_log (MSG_ERR, "*** can't create trace file (%s)\n",
+				par_trace
+			);
+		}
+	}
+
 	mon_init (&par_mon);
 	mon_set_cmd_fct (&par_mon, v20_cmd, par_sim);
 	mon_set_msg_fct (&par_mon, v20_set_msg, par_sim);
@@ -270,6 +270,7 @@ void v20_set_memmap (vic20_t *sim)
 
 	e6502_set_mem_map_rd (sim->cpu, 0x0000, 0xffff, NULL);
 	e6502_set_mem_map_wr (sim->cpu, 0x0000, 0xffff, NULL);
+	e6502_set_mem_map_dirty (sim->cpu, 0x0000, 0xffff, NULL, 0);
 
 	for (i = 0; i < sim->mem->cnt; i++) {
 		blk = sim->mem->lst[i].blk;
@@ -285,6 +286,9 @@ void v20_set_memmap (vic20_t *sim)
 		}
 
 		e6502_set_mem_map_wr (sim->cpu, blk->addr1, blk->addr2, blk->data);
+		e6502_set_mem_map_dirty (sim->cpu, blk->addr1, blk->addr2,
+			mem_blk_dirty_map (blk), MEM_DIRTY_SHIFT
+		);
 	}
 }
 
@@ -307,6 +311,8 @@ vic20_t *v20_new (ini_sct_t *ini)
 
 	bps_init (&sim->bps);
 
+	sim->trc = NULL;
+
 	v20_setup_vic20 (sim, ini);
 	v20_setup_mem (sim, ini);
 	v20_setup_via (sim, ini);
@@ -341,6 +347,7 @@ void v20_del (vic20_t *sim)
 	e6522_free (&sim->via2);
 	e6522_free (&sim->via1);
 
+	trace_del (sim->trc);
 	e6502_del (sim->cpu);
 
 	mem_del (sim->mem);
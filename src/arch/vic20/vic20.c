@@ -228,6 +228,31 @@ void v20_cas_set_inp (vic20_t *sim, unsigned char val)
 	e6522_set_ca1_inp (&sim->via2, val != 0);
 }
 
+int v20_set_trace (vic20_t *sim, const char *fname)
+{
+	e6502_set_trace_fct (sim->cpu, NULL, NULL);
+
+	trace_del (sim->trc);
+
+	sim->trc = NULL;
+
+	if (fname == NULL) {
+		return (0);
+	}
+
+	sim->trc = trace_new (fname, "6502");
+
+	if (sim->trc == NULL) {
+		return (1);
+	}
+
+	e6502_set_trace_fct (sim->cpu, sim->trc, trace_exec);
+
+	pce_log_tag (MSG_INF, "TRACE:", "file=%s\n", fname);
+
+	return (0);
+}
+
 void v20_reset (vic20_t *sim)
 {
 	sim_log_deb ("vic20: reset\n");
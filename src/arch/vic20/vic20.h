@@ -39,6 +39,7 @@
 #include <drivers/video/terminal.h>
 
 #include <lib/brkpt.h>
+#include <lib/trace.h>
 
 #include <libini/libini.h>
 
@@ -52,6 +53,9 @@ typedef struct vic20_s {
 	memory_t      *mem;
 	terminal_t    *trm;
 	bp_set_t      bps;
+
+	/* the execution trace recorder or NULL */
+	trace_t     *trc;
 	vic20_video_t video;
 	e6522_t       via1;
 	e6522_t       via2;
@@ -118,6 +122,12 @@ void v20_cas_set_inp (vic20_t *sim, unsigned char val);
 
 void v20_reset (vic20_t *sim);
 
+/*!***************************************************************************
+ * @short Start or stop recording an execution trace
+ * @param fname The trace file name or NULL to stop recording
+ *****************************************************************************/
+int v20_set_trace (vic20_t *sim, const char *fname);
+
 void v20_set_keypad_mode (vic20_t *sim, int mode);
 
 void v20_stop (vic20_t *sim);
@@ -102,15 +102,20 @@ void v20_video_update_palette (vic20_video_t *vid)
 		}
 	}
 
+	if (vid->trm != NULL) {
+		for (i = 0; i < 16; i++) {
+			trm_set_palette (vid->trm, i, vid->palette + 3 * i);
+		}
+	}
+
 	vid->update_palette = 0;
 }
 
 static
 void v20_video_hsync (vic20_video_t *vid, unsigned y, unsigned w, const unsigned char *buf)
 {
-	unsigned            i;
-	unsigned char       *p;
-	const unsigned char *s;
+	unsigned      i;
+	unsigned char *p;
 
 	if (vid->framedrop > 0) {
 		return;
@@ -135,14 +140,10 @@ void v20_video_hsync (vic20_video_t *vid, unsigned y, unsigned w, const unsigned
 		v20_video_update_palette (vid);
 	}
 
-	p = vid->buf + (3 * vid->w * (y - vid->y));
+	p = vid->buf + (vid->w * (y - vid->y));
 
 	for (i = 0; i < w; i++) {
-		s = vid->palette + 3 * (buf[i] & 0x0f);
-
-		*(p++) = *(s++);
-		*(p++) = *(s++);
-		*(p++) = *(s++);
+		p[i] = buf[i] & 0x0f;
 	}
 }
 
@@ -163,7 +164,7 @@ void v20_video_vsync (vic20_video_t *vid)
 	vid->vsync_cnt += 1;
 
 	trm_set_size (vid->trm, vid->w, vid->h);
-	trm_set_lines (vid->trm, vid->buf, 0, vid->h);
+	trm_set_lines_idx (vid->trm, vid->buf, 0, vid->h);
 	trm_update (vid->trm);
 }
 
@@ -208,7 +209,7 @@ void v20_video_init (vic20_video_t *vid)
 		vid->colram[i] = 0;
 	}
 
-	for (i = 0; i < (3 * VIC20_VIDEO_BUF); i++) {
+	for (i = 0; i < VIC20_VIDEO_BUF; i++) {
 		vid->buf[i] = 0;
 	}
 
@@ -289,6 +290,7 @@ void v20_video_set_pal (vic20_video_t *vid, int val, int full)
 void v20_video_set_term (vic20_video_t *vid, terminal_t *trm)
 {
 	vid->trm = trm;
+	vid->update_palette = 1;
 
 	if (trm != NULL) {
 		trm_open (trm, vid->w, vid->h);
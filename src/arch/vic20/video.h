@@ -68,7 +68,8 @@ typedef struct {
 
 	unsigned char colram[1024];
 
-	unsigned char buf[3 * VIC20_VIDEO_BUF];
+	/* palette indices, 1 byte per pixel */
+	unsigned char buf[VIC20_VIDEO_BUF];
 } vic20_video_t;
 
 
@@ -64,6 +64,16 @@ void e8237_chn_init (e8237_chn_t *chn, e8237_t *dma)
 
 	chn->iord_ext = NULL;
 	chn->iord = NULL;
+
+	chn->memptr_ext = NULL;
+	chn->memptr = NULL;
+	chn->memdone = NULL;
+
+	chn->iord_blk_ext = NULL;
+	chn->iord_blk = NULL;
+
+	chn->iowr_blk_ext = NULL;
+	chn->iowr_blk = NULL;
 }
 
 static
@@ -227,9 +237,78 @@ unsigned char e8237_chn_get_status (e8237_chn_t *chn)
 	return (ret);
 }
 
+/*
+ * Transfer as many bytes as the device has buffered, using memcpy
+ * instead of single byte transfers.
+ */
+static
+unsigned e8237_chn_burst (e8237_chn_t *chn)
+{
+	unsigned      n, max;
+	unsigned char *ptr;
+
+	if (chn->mode & E8237_MODE_ADDRDEC) {
+		return (0);
+	}
+
+	/* stop before the address wraps around */
+	max = 0x10000 - chn->cur_addr;
+
+	if (max > ((unsigned) chn->cur_cnt + 1)) {
+		max = (unsigned) chn->cur_cnt + 1;
+	}
+
+	switch (chn->mode & E8237_MODE_TYPE) {
+	case E8237_MODE_READ:
+		if (chn->iowr_blk == NULL) {
+			return (0);
+		}
+
+		if ((ptr = chn->memptr (chn->memptr_ext, chn->cur_addr, max, 0)) == NULL) {
+			return (0);
+		}
+
+		n = chn->iowr_blk (chn->iowr_blk_ext, ptr, max);
+		break;
+
+	case E8237_MODE_WRITE:
+		if (chn->iord_blk == NULL) {
+			return (0);
+		}
+
+		if ((ptr = chn->memptr (chn->memptr_ext, chn->cur_addr, max, 1)) == NULL) {
+			return (0);
+		}
+
+		n = chn->iord_blk (chn->iord_blk_ext, ptr, max);
+
+		if ((n > 0) && (chn->memdone != NULL)) {
+			chn->memdone (chn->memptr_ext, chn->cur_addr, n);
+		}
+		break;
+
+	default:
+		return (0);
+	}
+
+	if (n == 0) {
+		return (0);
+	}
+
+	chn->cur_addr = (chn->cur_addr + n) & 0xffff;
+	chn->cur_cnt = (chn->cur_cnt - n) & 0xffff;
+
+	if (chn->cur_cnt == 0xffff) {
+		e8237_chn_tc (chn);
+	}
+
+	return (n);
+}
+
 static
 int e8237_chn_transfer (e8237_chn_t *chn)
 {
+	unsigned      n;
 	unsigned char val;
 
 	e8237_chn_set_dack (chn, 1);
@@ -238,6 +317,26 @@ int e8237_chn_transfer (e8237_chn_t *chn)
 		return (0);
 	}
 
+	if (chn->dma->burst && (chn->memptr != NULL)) {
+		n = e8237_chn_burst (chn);
+
+		if (n > 0) {
+			/* the current transfer accounts for one clock */
+			chn->dma->delay += n - 1;
+
+			if (chn->state & E8237_STATE_TC) {
+				return (1);
+			}
+
+			/* the device may not be ready for the last byte */
+			if ((chn->state & (E8237_STATE_DREQ | E8237_STATE_SREQ)) == 0) {
+				return (1);
+			}
+
+			chn->dma->delay += 1;
+		}
+	}
+
 	switch (chn->mode & E8237_MODE_TYPE) {
 	case E8237_MODE_READ:
 		if (chn->memrd != NULL) {
@@ -326,6 +425,8 @@ void e8237_init (e8237_t *dma)
 	}
 
 	dma->check = 0;
+	dma->burst = 0;
+	dma->delay = 0;
 
 	dma->cmd = 0;
 	dma->flipflop = 0;
@@ -365,6 +466,11 @@ void e8237_del (e8237_t *dma)
 }
 
 
+void e8237_set_burst (e8237_t *dma, int val)
+{
+	dma->burst = (val != 0);
+}
+
 void e8237_set_dack_fct (e8237_t *dma, unsigned chn, void *ext, void *fct)
 {
 	if (chn < 4) {
@@ -672,6 +778,7 @@ void e8237_reset (e8237_t *dma)
 	e8237_chn_reset (&dma->chn[3]);
 
 	dma->check = 0;
+	dma->delay = 0;
 
 	dma->cmd = 0;
 	dma->flipflop = 0;
@@ -732,6 +839,17 @@ void e8237_clock (e8237_t *dma, unsigned n)
 	}
 
 	while (n > 0) {
+		if (dma->delay > 0) {
+			/* still busy with a block transfer */
+			if (n <= dma->delay) {
+				dma->delay -= n;
+				return;
+			}
+
+			n -= dma->delay;
+			dma->delay = 0;
+		}
+
 		if (dma->check == 0) {
 			return;
 		}
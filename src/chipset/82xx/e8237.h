@@ -89,6 +89,23 @@ typedef struct {
 
 	void           *iord_ext;
 	unsigned char  (*iord) (void *ext);
+
+	/*
+	 * Optional block transfers. memptr returns a pointer to cnt bytes
+	 * of plain memory at addr or NULL. iord_blk and iowr_blk transfer
+	 * up to cnt bytes and return the number of bytes transferred.
+	 * memdone is called with the number of bytes that were actually
+	 * written through a pointer returned by memptr.
+	 */
+	void           *memptr_ext;
+	unsigned char  *(*memptr) (void *ext, unsigned long addr, unsigned cnt, int wr);
+	void           (*memdone) (void *ext, unsigned long addr, unsigned cnt);
+
+	void           *iord_blk_ext;
+	unsigned       (*iord_blk) (void *ext, unsigned char *buf, unsigned cnt);
+
+	void           *iowr_blk_ext;
+	unsigned       (*iowr_blk) (void *ext, const unsigned char *buf, unsigned cnt);
 } e8237_chn_t;
 
 
@@ -97,6 +114,12 @@ typedef struct e8237_s {
 
 	unsigned char check;
 
+	/* use block transfers if possible */
+	unsigned char burst;
+
+	/* clocks still owed for bytes moved by a block transfer */
+	unsigned long delay;
+
 	unsigned char cmd;
 	unsigned char flipflop;
 	unsigned      priority;
@@ -115,6 +138,15 @@ e8237_t *e8237_new (void);
 void e8237_free (e8237_t *dma);
 void e8237_del (e8237_t *dma);
 
+/*!***************************************************************************
+ * @short Enable or disable block transfers
+ *
+ * If a device has a complete block buffered, it is copied into memory
+ * in one go. The DMAC is then busy for as many clocks as the single
+ * byte transfers would have taken.
+ *****************************************************************************/
+void e8237_set_burst (e8237_t *dma, int val);
+
 void e8237_set_dack_fct (e8237_t *dma, unsigned chn, void *ext, void *fct);
 void e8237_set_tc_fct (e8237_t *dma, unsigned chn, void *ext, void *fct);
 
@@ -2057,6 +2057,38 @@ void e8272_write_data (void *ext, unsigned char val)
 	}
 }
 
+unsigned e8272_write_data_blk (void *ext, const unsigned char *buf, unsigned cnt)
+{
+	unsigned n;
+	e8272_t  *fdc = ext;
+
+	if ((fdc->accurate) || (fdc->dreq_val == 0)) {
+		return (0);
+	}
+
+	if ((fdc->set_data != cmd_write_set_data) || (fdc->msr & E8272_MSR_DIO)) {
+		return (0);
+	}
+
+	if ((fdc->buf_i + 1) >= fdc->buf_n) {
+		return (0);
+	}
+
+	n = fdc->buf_n - fdc->buf_i - 1;
+
+	if (cnt > n) {
+		cnt = n;
+	}
+
+	e8272_set_irq (fdc, 0);
+
+	memcpy (fdc->buf + fdc->buf_i, buf, cnt);
+
+	fdc->buf_i += cnt;
+
+	return (cnt);
+}
+
 static
 unsigned char e8272_read_dor (e8272_t *fdc)
 {
@@ -2091,6 +2123,38 @@ unsigned char e8272_read_data (void *ext)
 	return (0);
 }
 
+unsigned e8272_read_data_blk (void *ext, unsigned char *buf, unsigned cnt)
+{
+	unsigned n;
+	e8272_t  *fdc = ext;
+
+	if ((fdc->accurate) || (fdc->dreq_val == 0)) {
+		return (0);
+	}
+
+	if (fdc->get_data != cmd_read_get_data) {
+		return (0);
+	}
+
+	if ((fdc->buf_i + 1) >= fdc->buf_n) {
+		return (0);
+	}
+
+	n = fdc->buf_n - fdc->buf_i - 1;
+
+	if (cnt > n) {
+		cnt = n;
+	}
+
+	e8272_set_irq (fdc, 0);
+
+	memcpy (buf, fdc->buf + fdc->buf_i, cnt);
+
+	fdc->buf_i += cnt;
+
+	return (cnt);
+}
+
 unsigned char e8272_get_uint8 (void *ext, unsigned long addr)
 {
 	e8272_t *fdc = (e8272_t *)ext;
@@ -178,6 +178,16 @@ void e8272_write_data (void *fdc, unsigned char val);
 
 unsigned char e8272_read_data (void *fdc);
 
+/*!***************************************************************************
+ * @short Transfer data in a block during a DMA read or write command
+ * @return The number of bytes transferred
+ *
+ * The last byte of a sector is not transferred, it must be transferred
+ * with e8272_write_data() or e8272_read_data().
+ *****************************************************************************/
+unsigned e8272_write_data_blk (void *fdc, const unsigned char *buf, unsigned cnt);
+unsigned e8272_read_data_blk (void *fdc, unsigned char *buf, unsigned cnt);
+
 
 unsigned char e8272_get_uint8 (void *fdc, unsigned long addr);
 
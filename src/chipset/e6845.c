@@ -40,9 +40,13 @@ void e6845_init (e6845_t *crt)
 	crt->frame = 0;
 	crt->ma = 0;
 	crt->ra = 0;
+	crt->hsync_cnt = 0;
 	crt->vsync_cnt = 0;
 	crt->index = 0;
 
+	crt->clk = 0;
+	crt->clk_max = 0;
+
 	for (i = 0; i < E6845_REG_CNT; i++) {
 		crt->reg[i] = 0;
 	}
@@ -190,6 +194,8 @@ void e6845_set_pen (e6845_t *crt)
 {
 	unsigned addr;
 
+	e6845_sync (crt);
+
 	addr = (crt->ma + crt->ccol) & 0x3fff;
 
 	crt->reg[E6845_REG_LH] = (addr >> 8) & 0xff;
@@ -239,7 +245,11 @@ void e6845_set_data (e6845_t *crt, unsigned char val)
 		return;
 	}
 
+	e6845_sync (crt);
+
 	crt->reg[crt->index] = val;
+
+	crt->clk_max = 0;
 }
 
 void e6845_set_uint8 (e6845_t *crt, unsigned long addr, unsigned char val)
@@ -268,9 +278,13 @@ void e6845_reset (e6845_t *crt)
 	crt->frame = 0;
 	crt->ma = 0;
 	crt->ra = 0;
+	crt->hsync_cnt = 0;
 	crt->vsync_cnt = 0;
 	crt->index = 0;
 
+	crt->clk = 0;
+	crt->clk_max = 0;
+
 	for (i = 0; i < E6845_REG_CNT; i++) {
 		crt->reg[i] = 0;
 	}
@@ -296,9 +310,11 @@ void e6845_vsync (e6845_t *crt)
 	crt->vsync_fct (crt->vsync_ext);
 }
 
-void e6845_clock (e6845_t *crt, unsigned cnt)
+static
+void e6845_run (e6845_t *crt, unsigned long cnt)
 {
 	unsigned char hs, ht, vs, vt, va;
+	unsigned long n;
 
 	hs = crt->reg[E6845_REG_HS];
 	ht = crt->reg[E6845_REG_HT] + 1;
@@ -308,8 +324,26 @@ void e6845_clock (e6845_t *crt, unsigned cnt)
 	va = crt->reg[E6845_REG_VA];
 
 	while (cnt > 0) {
-		crt->ccol += 1;
-		cnt -= 1;
+		/* skip to the next hsync or to the end of the line */
+		n = (crt->ccol < ht) ? (ht - crt->ccol) : 1;
+
+		if ((hs > crt->ccol) && ((hs - crt->ccol) < n)) {
+			n = hs - crt->ccol;
+		}
+
+		if (n > cnt) {
+			n = cnt;
+		}
+
+		crt->ccol += n;
+		cnt -= n;
+
+		if (crt->hsync_cnt > (n - 1)) {
+			crt->hsync_cnt -= n - 1;
+		}
+		else {
+			crt->hsync_cnt = 0;
+		}
 
 		if (crt->ccol == hs) {
 			crt->hsync_cnt = crt->reg[E6845_REG_SW] & 15;
@@ -354,3 +388,31 @@ void e6845_clock (e6845_t *crt, unsigned cnt)
 		}
 	}
 }
+
+void e6845_sync (e6845_t *crt)
+{
+	unsigned long cnt;
+
+	cnt = crt->clk;
+	crt->clk = 0;
+
+	if (cnt > 0) {
+		e6845_run (crt, cnt);
+	}
+
+	/* apply the clocks at least once per frame */
+	crt->clk_max = (unsigned long) (crt->reg[E6845_REG_HT] + 1) * e6845_get_vtl (crt);
+
+	if (crt->clk_max == 0) {
+		crt->clk_max = 1;
+	}
+}
+
+void e6845_clock (e6845_t *crt, unsigned cnt)
+{
+	crt->clk += cnt;
+
+	if (crt->clk >= crt->clk_max) {
+		e6845_sync (crt);
+	}
+}
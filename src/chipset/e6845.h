@@ -59,6 +59,12 @@ typedef struct {
 	unsigned char hsync_cnt;
 	unsigned char vsync_cnt;
 
+	/* character clocks that have not been applied yet */
+	unsigned long clk;
+
+	/* the clocks are applied when clk reaches this value */
+	unsigned long clk_max;
+
 	unsigned char index;
 	unsigned char reg[E6845_REG_CNT];
 
@@ -119,6 +125,17 @@ void e6850_set_uint16 (e6845_t *crt, unsigned long addr, unsigned short val);
 
 void e6845_reset (e6845_t *crt);
 
+/*
+ * Apply all pending character clocks. This must be called before the
+ * raster position is used or before anything is changed that affects
+ * the lines that are drawn by the hsync function.
+ */
+void e6845_sync (e6845_t *crt);
+
+/*
+ * Add character clocks. The clocks are applied lazily, about once per
+ * frame or when e6845_sync() is called.
+ */
 void e6845_clock (e6845_t *crt, unsigned cnt);
 
 
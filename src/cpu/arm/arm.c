@@ -123,13 +123,23 @@ void arm_init (arm_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	c->ram_dirty = NULL;
+	c->ram_dirty_shift = 0;
+
 	c->log_ext = NULL;
 	c->log_opcode = NULL;
 	c->log_undef = NULL;
 	c->log_exception = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	arm_set_opcodes (c);
 
+	c->ic = NULL;
+	c->ic_page = NULL;
+	c->ic_vaddr = 0;
+
 	c->cpsr = 0;
 
 	c->reg_map = 0;
@@ -174,6 +184,8 @@ arm_t *arm_new (void)
 
 void arm_free (arm_t *c)
 {
+	arm_set_icache (c, 0, 0);
+
 	cp14_free (&c->copr14);
 	cp15_free (&c->copr15);
 }
@@ -206,6 +218,20 @@ void arm_set_ram (arm_t *c, unsigned char *ram, unsigned long cnt)
 {
 	c->ram = ram;
 	c->ram_cnt = cnt;
+
+	arm_icache_flush (c);
+}
+
+void arm_set_ram_dirty_map (arm_t *c, unsigned char **map, unsigned shift)
+{
+	c->ram_dirty = map;
+	c->ram_dirty_shift = shift;
+}
+
+void arm_set_trace_fct (arm_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
 }
 
 unsigned arm_get_flags (const arm_t *c, unsigned flags)
@@ -470,6 +496,7 @@ void arm_reset (arm_t *c)
 	c->clkcnt = 0;
 
 	arm_tbuf_flush (c);
+	arm_icache_flush (c);
 
 	for (i = 0; i < 16; i++) {
 		if (c->copr[i] != NULL) {
@@ -551,15 +578,50 @@ void arm_set_fiq (arm_t *c, unsigned char val)
 	c->irq_or_fiq = c->irq || c->fiq;
 }
 
+static
+void arm_trace_exec (arm_t *c, uint32_t pc)
+{
+	unsigned char buf[4];
+
+	buf[0] = (c->ir >> 24) & 0xff;
+	buf[1] = (c->ir >> 16) & 0xff;
+	buf[2] = (c->ir >> 8) & 0xff;
+	buf[3] = c->ir & 0xff;
+
+	c->trace_exec (c->trace_ext, pc, buf, 4);
+}
+
 void arm_execute (arm_t *c)
 {
+	unsigned      cond;
+	arm_opcode_f  fct;
+	arm_ic_insn_t *ins;
+
 	c->oprcnt += 1;
 
 	c->lastpc[1] = c->lastpc[0];
 	c->lastpc[0] = arm_get_pc (c);
 
-	if (arm_ifetch (c, c->lastpc[0], &c->ir)) {
-		return;
+	if (c->ic != NULL) {
+		if (arm_icache_fetch (c, c->lastpc[0], &ins)) {
+			return;
+		}
+
+		c->ir = ins->ir;
+		fct = ins->fct;
+		cond = ins->cond;
+	}
+	else {
+		if (arm_ifetch (c, c->lastpc[0], &c->ir)) {
+			return;
+		}
+
+		fct = c->opcodes[(c->ir >> 20) & 0xff];
+		cond = arm_ir_cond (c->ir);
+	}
+
+	if (c->trace_exec != NULL) {
+		arm_trace_exec (c, c->lastpc[0]);
 	}
 
 #if 0
@@ -567,12 +629,13 @@ void arm_execute (arm_t *c)
 		if (c->log_opcode (c->log_ext, c->ir)) {
 			/* nop */
 			c->ir = 0xe1a00000UL;
+			fct = c->opcodes[(c->ir >> 20) & 0xff];
 		}
 	}
 #endif
 
-	if (arm_check_cond_al (c->ir) || arm_check_cond (c, arm_ir_cond (c->ir))) {
-		c->opcodes[(c->ir >> 20) & 0xff] (c);
+	if ((cond == 0x0e) || arm_check_cond (c, cond)) {
+		fct (c);
 	}
 	else {
 		arm_set_clk (c, 4, 1);
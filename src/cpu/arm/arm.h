@@ -203,6 +203,45 @@ typedef struct {
 } arm_copr14_t;
 
 
+/*****************************************************************************
+ * pre-decoded instruction cache
+ *****************************************************************************/
+
+#define ARM_IC_PAGES 256
+#define ARM_IC_INSNS 256
+
+typedef struct {
+	/* the opcode handler or NULL if the instruction is not decoded */
+	arm_opcode_f  fct;
+	uint32_t      ir;
+	unsigned char cond;
+} arm_ic_insn_t;
+
+/*
+ * The decoded instructions of one 1K page of ram. Pages are mapped
+ * directly by their real address.
+ */
+typedef struct {
+	uint32_t      raddr;
+	int           bigendian;
+	arm_ic_insn_t insn[ARM_IC_INSNS];
+} arm_ic_page_t;
+
+typedef struct {
+	arm_ic_page_t page[ARM_IC_PAGES];
+
+	/* used for instructions that are not in ram */
+	arm_ic_insn_t tmp;
+
+	/* fetch every instruction a second time and compare */
+	char          check;
+
+	unsigned long hit;
+	unsigned long miss;
+	unsigned long check_err;
+} arm_icache_t;
+
+
 /*****************************************************************************
  * @short The ARM CPU context
  *****************************************************************************/
@@ -222,11 +261,18 @@ typedef struct arm_s {
 	unsigned char      *ram;
 	unsigned long      ram_cnt;
 
+	/* the location of the dirty page map for ram or NULL */
+	unsigned char      **ram_dirty;
+	unsigned           ram_dirty_shift;
+
 	void               *log_ext;
 	int                (*log_opcode) (void *ext, unsigned long ir);
 	void               (*log_undef) (void *ext, unsigned long ir);
 	void               (*log_exception) (void *ext, unsigned long addr);
 
+	void               *trace_ext;
+	void               (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	uint32_t           cpsr;
 
 	uint32_t           spsr;
@@ -267,6 +313,13 @@ typedef struct arm_s {
 	unsigned long long clkcnt;
 
 	arm_opcode_f       opcodes[256];
+
+	/* the instruction cache or NULL if it is disabled */
+	arm_icache_t       *ic;
+
+	/* the current cache page and its virtual address */
+	arm_ic_page_t      *ic_page;
+	uint32_t           ic_vaddr;
 } arm_t;
 
 
@@ -319,6 +372,43 @@ void arm_set_mem_fct (arm_t *c, void *ext,
 
 void arm_set_ram (arm_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short Set the dirty page map for ram
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * While *map is not NULL, the byte for each page of ram that is written
+ * directly by the cpu is set to 0xff.
+ *****************************************************************************/
+void arm_set_ram_dirty_map (arm_t *c, unsigned char **map, unsigned shift);
+
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction is executed with the
+ * instruction word, most significant byte first.
+ *****************************************************************************/
+void arm_set_trace_fct (arm_t *c, void *ext, void *fct);
+
+/*!***************************************************************************
+ * @short Enable or disable the pre-decoded instruction cache
+ * @param c      The cpu context
+ * @param enable If true, the instruction cache is enabled
+ * @param check  If true, each instruction taken from the cache is also
+ *               fetched and decoded normally and both results are compared
+ * @return Zero if successful
+ *
+ * The cache keeps decoded instructions in ram, so that straight-line
+ * code within a 1K page is neither translated nor fetched nor decoded
+ * again.
+ *****************************************************************************/
+int arm_set_icache (arm_t *c, int enable, int check);
+
+/*!***************************************************************************
+ * @short Invalidate all instructions in the instruction cache
+ *****************************************************************************/
+void arm_icache_flush (arm_t *c);
+
 
 /*!***************************************************************************
  * @short  Get CPU flags
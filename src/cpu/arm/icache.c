@@ -0,0 +1,225 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/arm/icache.c                                         *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arm.h"
+#include "internal.h"
+
+
+int arm_set_icache (arm_t *c, int enable, int check)
+{
+	arm_icache_t *ic;
+
+	c->ic_page = NULL;
+
+	if (enable == 0) {
+		free (c->ic);
+		c->ic = NULL;
+
+		return (0);
+	}
+
+	if (c->ic == NULL) {
+		if ((ic = malloc (sizeof (arm_icache_t))) == NULL) {
+			return (1);
+		}
+
+		ic->hit = 0;
+		ic->miss = 0;
+		ic->check_err = 0;
+
+		c->ic = ic;
+	}
+
+	c->ic->check = (check != 0);
+
+	arm_icache_flush (c);
+
+	return (0);
+}
+
+void arm_icache_flush (arm_t *c)
+{
+	unsigned i;
+
+	c->ic_page = NULL;
+
+	if (c->ic == NULL) {
+		return;
+	}
+
+	/* page addresses are aligned, so this never matches */
+	for (i = 0; i < ARM_IC_PAGES; i++) {
+		c->ic->page[i].raddr = 1;
+	}
+}
+
+static
+void arm_ic_decode (arm_t *c, arm_ic_insn_t *ins, uint32_t ir)
+{
+	ins->fct = c->opcodes[(ir >> 20) & 0xff];
+	ins->ir = ir;
+	ins->cond = arm_ir_cond (ir);
+}
+
+static
+uint32_t arm_ic_get_ram32 (arm_t *c, uint32_t raddr)
+{
+	uint32_t      val;
+	unsigned char *p;
+
+	p = &c->ram[raddr];
+
+	if (c->bigendian) {
+		val = (uint32_t) p[0] << 24;
+		val |= (uint32_t) p[1] << 16;
+		val |= (uint32_t) p[2] << 8;
+		val |= p[3];
+	}
+	else {
+		val = p[0];
+		val |= (uint32_t) p[1] << 8;
+		val |= (uint32_t) p[2] << 16;
+		val |= (uint32_t) p[3] << 24;
+	}
+
+	return (val);
+}
+
+/*
+ * Get the cache page for the virtual address addr. Returns 0 if
+ * successful, 1 if an exception occurred and 2 if the address is
+ * not in ram.
+ */
+static
+int arm_ic_get_page (arm_t *c, uint32_t addr, uint32_t *raddr)
+{
+	arm_ic_page_t *pg;
+
+	*raddr = addr;
+
+	if (arm_translate_exec (c, raddr, arm_is_privileged (c))) {
+		return (1);
+	}
+
+	if ((*raddr | 0x3ff) >= c->ram_cnt) {
+		return (2);
+	}
+
+	pg = &c->ic->page[(*raddr >> 10) & (ARM_IC_PAGES - 1)];
+
+	if ((pg->raddr != (*raddr & ~0x3ffUL)) || (pg->bigendian != c->bigendian)) {
+		memset (pg->insn, 0, sizeof (pg->insn));
+
+		pg->raddr = *raddr & ~0x3ffUL;
+		pg->bigendian = c->bigendian;
+	}
+
+	c->ic_page = pg;
+	c->ic_vaddr = addr & ~0x3ffUL;
+
+	return (0);
+}
+
+/*
+ * Fetch and decode the instruction a second time, the way it is done
+ * without the cache, and compare the results.
+ */
+static
+int arm_ic_check (arm_t *c, uint32_t addr, arm_ic_insn_t *ins)
+{
+	uint32_t ir;
+
+	if (arm_ifetch (c, addr, &ir)) {
+		c->ic->check_err += 1;
+
+		fprintf (stderr, "arm: icache: fetch exception at %08lX\n",
+			(unsigned long) addr
+		);
+
+		return (1);
+	}
+
+	if ((ins->ir != ir) || (ins->fct != c->opcodes[(ir >> 20) & 0xff])) {
+		c->ic->check_err += 1;
+
+		fprintf (stderr, "arm: icache: mismatch at %08lX (%08lX %08lX)\n",
+			(unsigned long) addr, (unsigned long) ins->ir, (unsigned long) ir
+		);
+
+		arm_ic_decode (c, ins, ir);
+	}
+
+	return (0);
+}
+
+int arm_icache_fetch (arm_t *c, uint32_t addr, arm_ic_insn_t **ret)
+{
+	int           r;
+	uint32_t      raddr;
+	arm_ic_insn_t *ins;
+
+	addr &= ~0x03UL;
+
+	if ((c->ic_page == NULL) || ((addr & ~0x3ffUL) != c->ic_vaddr)) {
+		r = arm_ic_get_page (c, addr, &raddr);
+
+		if (r == 1) {
+			return (1);
+		}
+		else if (r == 2) {
+			ins = &c->ic->tmp;
+
+			if (raddr < c->ram_cnt) {
+				arm_ic_decode (c, ins, arm_ic_get_ram32 (c, raddr));
+			}
+			else {
+				arm_ic_decode (c, ins, c->get_uint32 (c->mem_ext, raddr));
+			}
+
+			*ret = ins;
+
+			return (0);
+		}
+	}
+
+	ins = &c->ic_page->insn[(addr >> 2) & (ARM_IC_INSNS - 1)];
+
+	if (ins->fct == NULL) {
+		c->ic->miss += 1;
+		arm_ic_decode (c, ins, arm_ic_get_ram32 (c, c->ic_page->raddr | (addr & 0x3ff)));
+	}
+	else {
+		c->ic->hit += 1;
+	}
+
+	*ret = ins;
+
+	if (c->ic->check) {
+		return (arm_ic_check (c, addr, ins));
+	}
+
+	return (0);
+}
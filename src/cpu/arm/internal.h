@@ -38,6 +38,8 @@
  * MMU
  *****************************************************************************/
 
+int arm_translate_exec (arm_t *c, uint32_t *addr, int priv);
+
 int arm_ifetch (arm_t *c, uint32_t addr, uint32_t *val);
 
 int arm_dload8 (arm_t *c, uint32_t addr, uint8_t *val);
@@ -57,6 +59,43 @@ int arm_dstore16_t (arm_t *c, uint32_t addr, uint16_t val);
 int arm_dstore32_t (arm_t *c, uint32_t addr, uint32_t val);
 
 
+/*****************************************************************************
+ * instruction cache
+ *****************************************************************************/
+
+int arm_icache_fetch (arm_t *c, uint32_t addr, arm_ic_insn_t **ret);
+
+/*
+ * Invalidate the cached instruction at raddr after a store
+ */
+static inline
+void arm_icache_store (arm_t *c, uint32_t raddr)
+{
+	arm_ic_page_t *pg;
+
+	if (c->ic != NULL) {
+		pg = &c->ic->page[(raddr >> 10) & (ARM_IC_PAGES - 1)];
+
+		if (pg->raddr == (raddr & ~0x3ffUL)) {
+			pg->insn[(raddr >> 2) & (ARM_IC_INSNS - 1)].fct = NULL;
+		}
+	}
+}
+
+/*
+ * Mark the page containing raddr in the dirty page map after a store
+ */
+static inline
+void arm_dirty_ram (arm_t *c, uint32_t raddr)
+{
+	unsigned char *map;
+
+	if ((c->ram_dirty != NULL) && ((map = *c->ram_dirty) != NULL)) {
+		map[raddr >> c->ram_dirty_shift] = 0xff;
+	}
+}
+
+
 /*****************************************************************************
  * arm
  *****************************************************************************/
@@ -151,6 +190,9 @@ void arm_tbuf_flush (arm_t *c)
 	mmu->tbuf_exec.valid = 0;
 	mmu->tbuf_read.valid = 0;
 	mmu->tbuf_write.valid = 0;
+
+	/* the current cache page was translated with the old state */
+	c->ic_page = NULL;
 }
 
 
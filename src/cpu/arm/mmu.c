@@ -282,7 +282,6 @@ int arm_translate (arm_t *c, uint32_t *addr, uint32_t *mask,
 	return (1);
 }
 
-static
 int arm_translate_exec (arm_t *c, uint32_t *addr, int priv)
 {
 	arm_copr15_t *mmu;
@@ -622,6 +621,9 @@ int arm_dstore8 (arm_t *c, uint32_t addr, uint8_t val)
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+
+		arm_icache_store (c, addr);
+		arm_dirty_ram (c, addr);
 	}
 	else {
 		c->set_uint8 (c->mem_ext, addr, val);
@@ -655,6 +657,11 @@ int arm_dstore16 (arm_t *c, uint32_t addr, uint16_t val)
 			p[1] = (val >> 8) & 0xff;
 #endif
 		}
+
+		arm_icache_store (c, addr);
+		arm_icache_store (c, addr + 1);
+		arm_dirty_ram (c, addr);
+		arm_dirty_ram (c, addr + 1);
 	}
 	else {
 		c->set_uint16 (c->mem_ext, addr, val);
@@ -692,6 +699,11 @@ int arm_dstore32 (arm_t *c, uint32_t addr, uint32_t val)
 			p[3] = (val >> 24) & 0xff;
 #endif
 		}
+
+		arm_icache_store (c, addr);
+		arm_icache_store (c, addr + 3);
+		arm_dirty_ram (c, addr);
+		arm_dirty_ram (c, addr + 3);
 	}
 	else {
 		c->set_uint32 (c->mem_ext, addr, val);
@@ -741,6 +753,8 @@ int arm_dstore8_t (arm_t *c, uint32_t addr, uint8_t val)
 
 	c->set_uint8 (c->mem_ext, addr, val);
 
+	arm_icache_store (c, addr);
+
 	return (0);
 }
 
@@ -752,6 +766,9 @@ int arm_dstore16_t (arm_t *c, uint32_t addr, uint16_t val)
 
 	c->set_uint16 (c->mem_ext, addr, val);
 
+	arm_icache_store (c, addr);
+	arm_icache_store (c, addr + 1);
+
 	return (0);
 }
 
@@ -763,6 +780,9 @@ int arm_dstore32_t (arm_t *c, uint32_t addr, uint32_t val)
 
 	c->set_uint32 (c->mem_ext, addr, val);
 
+	arm_icache_store (c, addr);
+	arm_icache_store (c, addr + 3);
+
 	return (0);
 }
 
@@ -825,6 +845,8 @@ int arm_set_mem8 (arm_t *c, uint32_t addr, unsigned xlat, uint8_t val)
 		c->set_uint8 (c->mem_ext, addr, val);
 	}
 
+	arm_icache_store (c, addr);
+
 	return (0);
 }
 
@@ -838,6 +860,9 @@ int arm_set_mem16 (arm_t *c, uint32_t addr, unsigned xlat, uint16_t val)
 		c->set_uint16 (c->mem_ext, addr, val);
 	}
 
+	arm_icache_store (c, addr);
+	arm_icache_store (c, addr + 1);
+
 	return (0);
 }
 
@@ -851,5 +876,8 @@ int arm_set_mem32 (arm_t *c, uint32_t addr, unsigned xlat, uint32_t val)
 		c->set_uint32 (c->mem_ext, addr, val);
 	}
 
+	arm_icache_store (c, addr);
+	arm_icache_store (c, addr + 3);
+
 	return (0);
 }
@@ -55,13 +55,20 @@ void e6502_init (e6502_t *c)
 	for (i = 0; i < E6502_MAP_PAGES; i++) {
 		c->mem_map_rd[i] = NULL;
 		c->mem_map_wr[i] = NULL;
+		c->mem_map_dirty[i] = NULL;
+		c->mem_map_dirty_ofs[i] = 0;
 	}
 
+	c->mem_map_dirty_shift = 0;
+
 	c->hook_ext = NULL;
 	c->hook_all = NULL;
 	c->hook_undef = NULL;
 	c->hook_brk = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	for (i = 0; i < 256; i++) {
 		c->op[i] = e6502_opcodes[i];
 	}
@@ -129,6 +136,27 @@ void e6502_set_mem_map_wr (e6502_t *c, unsigned addr1, unsigned addr2, unsigned
 	}
 }
 
+void e6502_set_mem_map_dirty (e6502_t *c, unsigned addr1, unsigned addr2,
+	unsigned char **map, unsigned shift)
+{
+	unsigned long ofs;
+
+	addr1 &= 0xffff;
+	addr2 &= 0xffff;
+
+	c->mem_map_dirty_shift = shift;
+
+	ofs = 0;
+
+	while (addr1 < addr2) {
+		c->mem_map_dirty[addr1 >> E6502_MAP_BITS] = map;
+		c->mem_map_dirty_ofs[addr1 >> E6502_MAP_BITS] = ofs;
+
+		ofs += E6502_MAP_SIZE;
+		addr1 += E6502_MAP_SIZE;
+	}
+}
+
 unsigned e6502_get_flags (e6502_t *c)
 {
 	return (c->flags);
@@ -188,6 +216,12 @@ void e6502_set_hook_brk_fct (e6502_t *c, void *ext, void *fct)
 	c->hook_brk = fct;
 }
 
+void e6502_set_trace_fct (e6502_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 void e6502_set_ioport_fct (e6502_t *c, void *ext, void *fct)
 {
 	c->set_ioport_ext = ext;
@@ -404,6 +438,21 @@ void e6502_reset (e6502_t *c)
 	e6502_set_lpc (c, 0);
 }
 
+static
+void e6502_trace_exec (e6502_t *c, unsigned short pc)
+{
+	unsigned      i;
+	unsigned char buf[3];
+
+	buf[0] = c->inst[0];
+
+	for (i = 1; i < 3; i++) {
+		buf[i] = e6502_get_mem8 (c, (pc + i) & 0xffff);
+	}
+
+	c->trace_exec (c->trace_ext, pc, buf, 3);
+}
+
 void e6502_execute (e6502_t *c)
 {
 	unsigned short pc;
@@ -414,6 +463,10 @@ void e6502_execute (e6502_t *c)
 
 	c->inst[0] = e6502_get_mem8 (c, pc);
 
+	if (c->trace_exec != NULL) {
+		e6502_trace_exec (c, pc);
+	}
+
 #ifdef E6502_ENABLE_HOOK_ALL
 	if (c->hook_all != NULL) {
 		if (e6502_hook_all (c)) {
@@ -86,11 +86,19 @@ typedef struct e6502_t {
 	unsigned char  *mem_map_rd[E6502_MAP_PAGES];
 	unsigned char  *mem_map_wr[E6502_MAP_PAGES];
 
+	/* per write map page: the dirty page map location and offset */
+	unsigned char  **mem_map_dirty[E6502_MAP_PAGES];
+	unsigned long  mem_map_dirty_ofs[E6502_MAP_PAGES];
+	unsigned       mem_map_dirty_shift;
+
 	void           *hook_ext;
 	int            (*hook_all) (void *ext, unsigned char op);
 	int            (*hook_undef) (void *ext, unsigned char op);
 	int            (*hook_brk) (void *ext, unsigned char op);
 
+	void           *trace_ext;
+	void           (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	unsigned char  ioport[3];
 
 	unsigned char  inst[4];
@@ -161,6 +169,20 @@ unsigned char e6502_get_mem8 (e6502_t *c, unsigned short addr)
 	return (c->get_uint8 (c->mem_rd_ext, addr));
 }
 
+static inline
+void e6502_dirty_mem (e6502_t *c, unsigned short addr)
+{
+	unsigned      i;
+	unsigned char **map;
+
+	i = (addr & 0xffff) >> E6502_MAP_BITS;
+
+	if (((map = c->mem_map_dirty[i]) != NULL) && (*map != NULL)) {
+		i = (c->mem_map_dirty_ofs[i] + (addr & E6502_MAP_MASK)) >> c->mem_map_dirty_shift;
+		(*map)[i] = 0xff;
+	}
+}
+
 static inline
 void e6502_set_mem8 (e6502_t *c, unsigned short addr, unsigned char val)
 {
@@ -173,6 +195,7 @@ void e6502_set_mem8 (e6502_t *c, unsigned short addr, unsigned char val)
 
 	if ((p = c->mem_map_wr[(addr & 0xffff) >> E6502_MAP_BITS]) != NULL) {
 		p[addr & E6502_MAP_MASK] = val;
+		e6502_dirty_mem (c, addr);
 	}
 	else {
 		c->set_uint8 (c->mem_wr_ext, addr, val);
@@ -213,6 +236,19 @@ void e6502_del (e6502_t *c);
 void e6502_set_mem_map_rd (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
 void e6502_set_mem_map_wr (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
 
+/*****************************************************************************
+ * @short Set the dirty page map for a write mapped memory range
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * The range must be the same as in e6502_set_mem_map_wr(). While *map
+ * is not NULL, the byte for each page of the range that is written
+ * through the write map is set to 0xff. Pages are counted from addr1.
+ *****************************************************************************/
+void e6502_set_mem_map_dirty (e6502_t *c, unsigned addr1, unsigned addr2,
+	unsigned char **map, unsigned shift
+);
+
 /*****************************************************************************
  * @short Get the CPU flags
  *****************************************************************************/
@@ -236,6 +272,14 @@ void e6502_set_hook_all_fct (e6502_t *c, void *ext, void *fct);
 void e6502_set_hook_undef_fct (e6502_t *c, void *ext, void *fct);
 void e6502_set_hook_brk_fct (e6502_t *c, void *ext, void *fct);
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction is executed with the
+ * opcode byte and the following two bytes.
+ *****************************************************************************/
+void e6502_set_trace_fct (e6502_t *c, void *ext, void *fct);
+
 /*****************************************************************************
  * @short Set the I/O port function
  *****************************************************************************/
@@ -20,11 +20,14 @@
  *****************************************************************************/
 
 
+#include <stdio.h>
+
 #include "e68000.h"
 #include "internal.h"
 
 
-void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
+static
+void e68_cc_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
 {
 	uint16_t set = 0;
 
@@ -39,7 +42,8 @@ void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
 	c->sr |= (set & msk);
 }
 
-void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
+static
+void e68_cc_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
 {
 	uint16_t set = 0;
 
@@ -54,7 +58,8 @@ void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
 	c->sr |= (set & msk);
 }
 
-void e68_cc_set_nz_32 (e68000_t *c, uint8_t msk, uint32_t val)
+static
+void e68_cc_nz_32 (e68000_t *c, uint8_t msk, uint32_t val)
 {
 	uint16_t set = 0;
 
@@ -109,19 +114,22 @@ void e68_cc_set_add (e68000_t *c, unsigned d, unsigned s1, unsigned s2)
 	c->sr |= set;
 }
 
-void e68_cc_set_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+static
+void e68_cc_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
 	e68_set_sr_z (c, (d & 0xff) == 0);
 	e68_cc_set_add (c, d >> 7, s1 >> 7, s2 >> 7);
 }
 
-void e68_cc_set_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+static
+void e68_cc_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 {
 	e68_set_sr_z (c, (d & 0xffff) == 0);
 	e68_cc_set_add (c, d >> 15, s1 >> 15, s2 >> 15);
 }
 
-void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+static
+void e68_cc_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 {
 	e68_set_sr_z (c, (d) == 0);
 	e68_cc_set_add (c, d >> 31, s1 >> 31, s2 >> 31);
@@ -129,6 +137,10 @@ void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 
 void e68_cc_set_addx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_add (c, d >> 7, s1 >> 7, s2 >> 7);
 
 	if (d & 0xff) {
@@ -138,6 +150,10 @@ void e68_cc_set_addx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 
 void e68_cc_set_addx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_add (c, d >> 15, s1 >> 15, s2 >> 15);
 
 	if (d & 0xffff) {
@@ -147,6 +163,10 @@ void e68_cc_set_addx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 
 void e68_cc_set_addx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_add (c, d >> 31, s1 >> 31, s2 >> 31);
 
 	if (d) {
@@ -195,7 +215,8 @@ void e68_cc_set_sub (e68000_t *c, uint16_t msk, unsigned d, unsigned s1, unsigne
 	c->sr |= (set & msk);
 }
 
-void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+static
+void e68_cc_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_NZVC, d >> 7, s1 >> 7, s2 >> 7);
 
@@ -204,7 +225,8 @@ void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 	}
 }
 
-void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+static
+void e68_cc_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_NZVC, d >> 15, s1 >> 15, s2 >> 15);
 
@@ -213,7 +235,8 @@ void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 	}
 }
 
-void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+static
+void e68_cc_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_NZVC, d >> 31, s1 >> 31, s2 >> 31);
 
@@ -222,7 +245,8 @@ void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 	}
 }
 
-void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+static
+void e68_cc_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 7, s1 >> 7, s2 >> 7);
 
@@ -231,7 +255,8 @@ void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 	}
 }
 
-void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+static
+void e68_cc_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 15, s1 >> 15, s2 >> 15);
 
@@ -240,7 +265,8 @@ void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 	}
 }
 
-void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+static
+void e68_cc_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 31, s1 >> 31, s2 >> 31);
 
@@ -251,6 +277,10 @@ void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 
 void e68_cc_set_subx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 7, s1 >> 7, s2 >> 7);
 
 	if (d & 0xff) {
@@ -260,6 +290,10 @@ void e68_cc_set_subx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 
 void e68_cc_set_subx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 15, s1 >> 15, s2 >> 15);
 
 	if (d & 0xffff) {
@@ -269,9 +303,375 @@ void e68_cc_set_subx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 
 void e68_cc_set_subx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 {
+	if (c->cc_op != E68_CC_NONE) {
+		e68_cc_eval (c);
+	}
+
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 31, s1 >> 31, s2 >> 31);
 
 	if (d) {
 		c->sr &= ~E68_SR_Z;
 	}
 }
+
+
+/*
+ * Deferred condition codes
+ *
+ * Most condition codes are overwritten before they are tested. Instead of
+ * computing them after every instruction, only the operation and its
+ * operands are recorded. The condition codes are computed when the SR
+ * is read.
+ */
+
+static
+uint8_t e68_cc_get_msk (const e68000_t *c, unsigned op)
+{
+	switch (op) {
+	case E68_CC_NONE:
+		return (0);
+
+	case E68_CC_NZ_8:
+	case E68_CC_NZ_16:
+	case E68_CC_NZ_32:
+		return (c->cc_msk);
+
+	case E68_CC_CMP_8:
+	case E68_CC_CMP_16:
+	case E68_CC_CMP_32:
+		return (E68_SR_NZVC);
+	}
+
+	return (E68_SR_XNZVC);
+}
+
+/*
+ * Compute the condition codes of operation op eagerly
+ */
+static
+void e68_cc_apply (e68000_t *c, unsigned op, uint8_t msk, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	switch (op) {
+	case E68_CC_NZ_8:
+		e68_cc_nz_8 (c, msk, d);
+		break;
+
+	case E68_CC_NZ_16:
+		e68_cc_nz_16 (c, msk, d);
+		break;
+
+	case E68_CC_NZ_32:
+		e68_cc_nz_32 (c, msk, d);
+		break;
+
+	case E68_CC_ADD_8:
+		e68_cc_add_8 (c, d, s1, s2);
+		break;
+
+	case E68_CC_ADD_16:
+		e68_cc_add_16 (c, d, s1, s2);
+		break;
+
+	case E68_CC_ADD_32:
+		e68_cc_add_32 (c, d, s1, s2);
+		break;
+
+	case E68_CC_CMP_8:
+		e68_cc_cmp_8 (c, d, s1, s2);
+		break;
+
+	case E68_CC_CMP_16:
+		e68_cc_cmp_16 (c, d, s1, s2);
+		break;
+
+	case E68_CC_CMP_32:
+		e68_cc_cmp_32 (c, d, s1, s2);
+		break;
+
+	case E68_CC_SUB_8:
+		e68_cc_sub_8 (c, d, s1, s2);
+		break;
+
+	case E68_CC_SUB_16:
+		e68_cc_sub_16 (c, d, s1, s2);
+		break;
+
+	case E68_CC_SUB_32:
+		e68_cc_sub_32 (c, d, s1, s2);
+		break;
+	}
+}
+
+uint16_t e68_cc_eval (e68000_t *c)
+{
+	unsigned op;
+
+	op = c->cc_op;
+
+	c->cc_op = E68_CC_NONE;
+
+	e68_cc_apply (c, op, c->cc_msk, c->cc_d, c->cc_s1, c->cc_s2);
+
+	return (c->sr);
+}
+
+/*
+ * Compute only the X flag of a deferred addition or subtraction
+ */
+static
+void e68_cc_eval_x (e68000_t *c)
+{
+	uint32_t d, s1, s2, cy, msb;
+
+	d = c->cc_d;
+	s1 = c->cc_s1;
+	s2 = c->cc_s2;
+
+	switch (c->cc_op) {
+	case E68_CC_ADD_8:
+	case E68_CC_SUB_8:
+		msb = 0x80;
+		break;
+
+	case E68_CC_ADD_16:
+	case E68_CC_SUB_16:
+		msb = 0x8000;
+		break;
+
+	default:
+		msb = 0x80000000;
+		break;
+	}
+
+	if (c->cc_op <= E68_CC_ADD_32) {
+		cy = (s1 & s2) | (~d & s1) | (~d & s2);
+	}
+	else {
+		cy = (s1 & ~s2) | (d & ~s2) | (d & s1);
+	}
+
+	if (cy & msb) {
+		c->sr |= E68_SR_X;
+	}
+	else {
+		c->sr &= ~E68_SR_X;
+	}
+}
+
+static
+void e68_cc_record (e68000_t *c, unsigned op, uint8_t msk, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	uint8_t old;
+
+	if (c->cc_op != E68_CC_NONE) {
+		old = e68_cc_get_msk (c, c->cc_op) & ~msk;
+
+		if (old == E68_SR_X) {
+			/* CMP and the logical operations don't change X */
+			e68_cc_eval_x (c);
+		}
+		else if (old != 0) {
+			e68_cc_eval (c);
+		}
+	}
+
+	c->cc_op = op;
+	c->cc_msk = msk;
+	c->cc_d = d;
+	c->cc_s1 = s1;
+	c->cc_s2 = s2;
+}
+
+/*
+ * Defer operation op and compare the lazily computed condition codes
+ * with the condition codes that the eager path computes from the same
+ * state.
+ */
+static
+void e68_cc_check (e68000_t *c, unsigned op, uint8_t msk, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	uint16_t      sr, eager, lazy;
+	unsigned char cop;
+	uint8_t       cmsk;
+	uint32_t      cd, cs1, cs2;
+
+	sr = c->sr;
+	cop = c->cc_op;
+	cmsk = c->cc_msk;
+	cd = c->cc_d;
+	cs1 = c->cc_s1;
+	cs2 = c->cc_s2;
+
+	e68_cc_eval (c);
+	e68_cc_apply (c, op, msk, d, s1, s2);
+
+	eager = c->sr;
+
+	c->sr = sr;
+	c->cc_op = cop;
+	c->cc_msk = cmsk;
+	c->cc_d = cd;
+	c->cc_s1 = cs1;
+	c->cc_s2 = cs2;
+
+	e68_cc_record (c, op, msk, d, s1, s2);
+
+	sr = c->sr;
+	cop = c->cc_op;
+
+	lazy = e68_cc_eval (c);
+
+	c->sr = sr;
+	c->cc_op = cop;
+
+	if (lazy != eager) {
+		c->cc_check_err += 1;
+
+		fprintf (stderr,
+			"e68000: lazy cc: mismatch at %08lX op=%u (%04X %04X)\n",
+			e68_get_last_pc (c, 0), op, lazy, eager
+		);
+
+		c->sr = eager;
+		c->cc_op = E68_CC_NONE;
+	}
+}
+
+static
+void e68_cc_defer (e68000_t *c, unsigned op, uint8_t msk, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	if (c->cc_check) {
+		e68_cc_check (c, op, msk, d, s1, s2);
+	}
+	else {
+		e68_cc_record (c, op, msk, d, s1, s2);
+	}
+}
+
+void e68_set_lazy_cc (e68000_t *c, int enable, int check)
+{
+	e68_cc_eval (c);
+
+	c->lazy_cc = (enable != 0);
+	c->cc_check = (enable != 0) && (check != 0);
+}
+
+void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_NZ_8, msk, val, 0, 0);
+	}
+	else {
+		e68_cc_nz_8 (c, msk, val);
+	}
+}
+
+void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_NZ_16, msk, val, 0, 0);
+	}
+	else {
+		e68_cc_nz_16 (c, msk, val);
+	}
+}
+
+void e68_cc_set_nz_32 (e68000_t *c, uint8_t msk, uint32_t val)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_NZ_32, msk, val, 0, 0);
+	}
+	else {
+		e68_cc_nz_32 (c, msk, val);
+	}
+}
+
+void e68_cc_set_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_ADD_8, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_add_8 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_ADD_16, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_add_16 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_ADD_32, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_add_32 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_CMP_8, E68_SR_NZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_cmp_8 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_CMP_16, E68_SR_NZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_cmp_16 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_CMP_32, E68_SR_NZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_cmp_32 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_SUB_8, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_sub_8 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_SUB_16, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_sub_16 (c, d, s1, s2);
+	}
+}
+
+void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	if (c->lazy_cc) {
+		e68_cc_defer (c, E68_CC_SUB_32, E68_SR_XNZVC, d, s1, s2);
+	}
+	else {
+		e68_cc_sub_32 (c, d, s1, s2);
+	}
+}
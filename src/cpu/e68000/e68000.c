@@ -53,6 +53,24 @@ void e68_init (e68000_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	c->wmap_addr = 0;
+	c->wmap_cnt = 0;
+	c->wmap_shift = 0;
+	c->wmap = NULL;
+
+	c->ram_dirty = NULL;
+	c->ram_dirty_shift = 0;
+
+	c->idle_max = 0;
+	c->idle_cnt = 0;
+	c->idle_ok = 0;
+	c->idle_pc = 0;
+	c->idle_rom_addr = 0;
+	c->idle_rom_cnt = 0;
+	c->idle_ram_addr = 0;
+	c->idle_ram_cnt = 0;
+	c->idle_range_cnt = 0;
+
 	c->reset_ext = NULL;
 	c->reset = NULL;
 	c->reset_val = 0;
@@ -67,6 +85,9 @@ void e68_init (e68000_t *c)
 	c->log_exception = NULL;
 	c->log_mem = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	c->hook_ext = NULL;
 	c->hook = NULL;
 
@@ -97,6 +118,11 @@ void e68_init (e68000_t *c)
 
 	c->sr = E68_SR_S | E68_SR_I;
 
+	c->lazy_cc = 0;
+	c->cc_check = 0;
+	c->cc_check_err = 0;
+	c->cc_op = E68_CC_NONE;
+
 	for (i = 0; i < 8; i++) {
 		e68_set_dreg32 (c, i, 0);
 		e68_set_areg32 (c, i, 0);
@@ -176,6 +202,108 @@ void e68_set_ram (e68000_t *c, unsigned char *ram, unsigned long cnt)
 	c->ram_cnt = cnt;
 }
 
+void e68_set_wmap (e68000_t *c, unsigned long addr, unsigned long cnt,
+	unsigned shift, unsigned char *map)
+{
+	if (map == NULL) {
+		cnt = 0;
+	}
+
+	c->wmap_addr = addr;
+	c->wmap_cnt = cnt;
+	c->wmap_shift = shift;
+	c->wmap = map;
+}
+
+void e68_set_ram_dirty_map (e68000_t *c, unsigned char **map, unsigned shift)
+{
+	c->ram_dirty = map;
+	c->ram_dirty_shift = shift;
+}
+
+void e68_set_idle (e68000_t *c, unsigned cnt)
+{
+	c->idle_max = cnt;
+	c->idle_cnt = 0;
+	c->idle_ok = 0;
+}
+
+void e68_set_idle_rom (e68000_t *c, unsigned long addr, unsigned long cnt)
+{
+	c->idle_rom_addr = addr;
+	c->idle_rom_cnt = cnt;
+}
+
+void e68_set_idle_ram (e68000_t *c, unsigned long addr, unsigned long cnt)
+{
+	c->idle_ram_addr = addr;
+	c->idle_ram_cnt = cnt;
+}
+
+int e68_add_idle_range (e68000_t *c, unsigned long addr, unsigned long cnt)
+{
+	if (c->idle_range_cnt >= E68_IDLE_RANGE_MAX) {
+		return (1);
+	}
+
+	c->idle_range[2 * c->idle_range_cnt] = addr;
+	c->idle_range[2 * c->idle_range_cnt + 1] = cnt;
+	c->idle_range_cnt += 1;
+
+	return (0);
+}
+
+/*
+ * Called after a short backward branch was taken
+ */
+void e68_idle_branch (e68000_t *c)
+{
+	unsigned i;
+	uint32_t pc;
+	uint32_t reg[17];
+
+	pc = e68_get_pc (c);
+
+	for (i = 0; i < c->idle_range_cnt; i++) {
+		if ((pc - c->idle_range[2 * i]) < c->idle_range[2 * i + 1]) {
+			c->halt |= HALT_IDLE;
+			return;
+		}
+	}
+
+	if (c->idle_max == 0) {
+		return;
+	}
+
+	for (i = 0; i < 8; i++) {
+		reg[i] = c->dreg[i];
+		reg[i + 8] = c->areg[i];
+	}
+
+	reg[16] = e68_get_sr (c);
+
+	if (c->idle_ok && (pc == c->idle_pc)) {
+		if (memcmp (reg, c->idle_reg, sizeof (reg)) == 0) {
+			c->idle_cnt += 1;
+
+			if (c->idle_cnt >= c->idle_max) {
+				c->idle_cnt = 0;
+				c->halt |= HALT_IDLE;
+			}
+
+			c->idle_ok = 1;
+
+			return;
+		}
+	}
+
+	c->idle_pc = pc;
+	c->idle_cnt = 0;
+	c->idle_ok = 1;
+
+	memcpy (c->idle_reg, reg, sizeof (reg));
+}
+
 void e68_set_reset_fct (e68000_t *c, void *ext, void *fct)
 {
 	c->reset_ext = ext;
@@ -200,6 +328,12 @@ void e68_set_trap_fct (e68000_t *c, void *ext, void *fct)
 	c->trap = fct;
 }
 
+void e68_set_trace_fct (e68000_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 void e68_set_flags (e68000_t *c, unsigned flags, int set)
 {
 	if (set) {
@@ -558,6 +692,7 @@ void e68_set_sr (e68000_t *c, unsigned short val)
 	}
 
 	c->sr = val & E68_SR_MASK;
+	c->cc_op = E68_CC_NONE;
 }
 
 static
@@ -752,7 +887,7 @@ void e68_exception_format (e68000_t *c)
 
 void e68_exception_avec (e68000_t *c, unsigned level)
 {
-	c->halt &= ~HALT_STOP;
+	c->halt &= ~(HALT_STOP | HALT_IDLE);
 	if (e68_exception (c, 24 + level, 0, "AVEC") == 0) {
 		e68_set_iml (c, level & 7);
 	}
@@ -766,7 +901,7 @@ void e68_exception_trap (e68000_t *c, unsigned n)
 
 void e68_exception_intr (e68000_t *c, unsigned level, unsigned vect)
 {
-	c->halt &= ~HALT_STOP;
+	c->halt &= ~(HALT_STOP | HALT_IDLE);
 	if (e68_exception (c, vect, 0, "INTR") == 0) {
 		e68_set_iml (c, level & 7);
 	}
@@ -774,7 +909,7 @@ void e68_exception_intr (e68000_t *c, unsigned level, unsigned vect)
 
 void e68_interrupt (e68000_t *c, unsigned level)
 {
-	c->halt &= ~HALT_STOP;
+	c->halt &= ~(HALT_STOP | HALT_IDLE);
 	if ((level == 7) && (c->int_ipl != 7)) {
 		c->int_nmi = 1;
 	}
@@ -861,6 +996,41 @@ void e68_reset (e68000_t *c)
 	e68_set_reset (c, 0);
 }
 
+static
+void e68_trace_exec (e68000_t *c, uint32_t pc)
+{
+	unsigned      i;
+	uint32_t      addr;
+	uint16_t      val;
+	unsigned char buf[10];
+
+	buf[0] = (c->ir[0] >> 8) & 0xff;
+	buf[1] = c->ir[0] & 0xff;
+
+	/*
+	 * Don't use e68_get_mem16(), it would disturb the idle detection.
+	 * Only read ahead where reads have no side effects.
+	 */
+	for (i = 1; i < 5; i++) {
+		addr = pc + 2 * i;
+
+		if ((addr + 1) < c->ram_cnt) {
+			val = (c->ram[addr] << 8) | c->ram[addr + 1];
+		}
+		else if (((addr - c->idle_rom_addr) < c->idle_rom_cnt) && ((addr + 1 - c->idle_rom_addr) < c->idle_rom_cnt)) {
+			val = c->get_uint16 (c->mem_ext, addr);
+		}
+		else {
+			break;
+		}
+
+		buf[2 * i] = (val >> 8) & 0xff;
+		buf[2 * i + 1] = val & 0xff;
+	}
+
+	c->trace_exec (c->trace_ext, pc, buf, 2 * i);
+}
+
 void e68_execute (e68000_t *c)
 {
 	c->bus_error = 0;
@@ -882,10 +1052,15 @@ void e68_execute (e68000_t *c)
 #endif
 
 		c->last_pc[++c->last_pc_idx & (E68_LAST_PC_CNT - 1)] = e68_get_pc (c);
-		c->trace_sr = e68_get_sr (c);
+		/* only T is used, don't compute deferred condition codes */
+		c->trace_sr = c->sr;
 
 		c->ir[0] = c->ir[1];
 
+		if (c->trace_exec != NULL) {
+			e68_trace_exec (c, e68_get_pc (c));
+		}
+
 		c->opcodes[(c->ir[0] >> 6) & 0x3ff] (c);
 
 		c->oprcnt += 1;
@@ -895,7 +1070,7 @@ void e68_execute (e68000_t *c)
 		}
 	}
 	else {
-		e68_set_clk (c, 4);
+		e68_set_clk (c, (c->halt & HALT_IDLE) ? E68_IDLE_CLK : 4);
 
 		if (c->halt & ~HALT_NMI) {
 			return;
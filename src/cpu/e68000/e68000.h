@@ -46,6 +46,27 @@ struct e68000_s;
 
 #define E68_LAST_PC_CNT 32
 
+/* the maximum distance of a backward branch that can close an idle loop */
+#define E68_IDLE_DIST      64
+/* the clock cycles per step while the cpu is idle */
+#define E68_IDLE_CLK       32
+#define E68_IDLE_RANGE_MAX 8
+
+/* deferred condition code operations */
+#define E68_CC_NONE   0
+#define E68_CC_NZ_8   1
+#define E68_CC_NZ_16  2
+#define E68_CC_NZ_32  3
+#define E68_CC_ADD_8  4
+#define E68_CC_ADD_16 5
+#define E68_CC_ADD_32 6
+#define E68_CC_CMP_8  7
+#define E68_CC_CMP_16 8
+#define E68_CC_CMP_32 9
+#define E68_CC_SUB_8  10
+#define E68_CC_SUB_16 11
+#define E68_CC_SUB_32 12
+
 #define E68_SR_C 0x0001
 #define E68_SR_V 0x0002
 #define E68_SR_Z 0x0004
@@ -64,8 +85,11 @@ struct e68000_s;
 #define e68_get_ir_pc(c) ((c)->ir_pc)
 #define e68_get_usp(c) (((c)->supervisor ? (c)->usp : (c)->areg[7]))
 #define e68_get_ssp(c) (((c)->supervisor ? (c)->areg[7] : (c)->ssp))
-#define e68_get_sr(c) ((c)->sr & 0xffff)
-#define e68_get_ccr(c) ((c)->sr & 0xff)
+/* deferred condition codes must be computed before the SR is read */
+#define e68_get_sr(c) \
+	((((c)->cc_op != E68_CC_NONE) ? e68_cc_eval (c) : (c)->sr) & 0xffff)
+
+#define e68_get_ccr(c) (e68_get_sr (c) & 0xff)
 #define e68_get_vbr(c) ((c)->vbr)
 #define e68_get_sfc(c) ((c)->sfc)
 #define e68_get_dfc(c) ((c)->dfc)
@@ -82,15 +106,16 @@ struct e68000_s;
 #define e68_set_cacr(c, v) do { (c)->cacr = (v); } while (0)
 #define e68_set_caar(c, v) do { (c)->cacr = (v); } while (0)
 
-#define e68_get_sr_c(c) (((c)->sr & E68_SR_C) != 0)
-#define e68_get_sr_v(c) (((c)->sr & E68_SR_V) != 0)
-#define e68_get_sr_z(c) (((c)->sr & E68_SR_Z) != 0)
-#define e68_get_sr_n(c) (((c)->sr & E68_SR_N) != 0)
-#define e68_get_sr_x(c) (((c)->sr & E68_SR_X) != 0)
+#define e68_get_sr_c(c) ((e68_get_sr (c) & E68_SR_C) != 0)
+#define e68_get_sr_v(c) ((e68_get_sr (c) & E68_SR_V) != 0)
+#define e68_get_sr_z(c) ((e68_get_sr (c) & E68_SR_Z) != 0)
+#define e68_get_sr_n(c) ((e68_get_sr (c) & E68_SR_N) != 0)
+#define e68_get_sr_x(c) ((e68_get_sr (c) & E68_SR_X) != 0)
 #define e68_get_sr_s(c) (((c)->sr & E68_SR_S) != 0)
 #define e68_get_sr_t(c) (((c)->sr & E68_SR_T) != 0)
 
 #define e68_set_cc(c, m, v) do { \
+		if (((m) & 0x1f) && (c)->cc_op) e68_cc_eval (c); \
 		if (v) (c)->sr |= (m); else (c)->sr &= ~(m); \
 	} while (0)
 
@@ -122,6 +147,32 @@ typedef struct e68000_s {
 
 	unsigned char  *ram;
 	uint32_t       ram_cnt;
+
+	/* RAM writes to [wmap_addr, wmap_addr + wmap_cnt) are marked in wmap */
+	uint32_t       wmap_addr;
+	uint32_t       wmap_cnt;
+	unsigned       wmap_shift;
+	unsigned char  *wmap;
+
+	/* the location of the dirty page map for ram or NULL */
+	unsigned char  **ram_dirty;
+	unsigned       ram_dirty_shift;
+
+	/* idle loop detection, see e68_set_idle() */
+	unsigned       idle_max;
+	unsigned       idle_cnt;
+	char           idle_ok;
+	uint32_t       idle_pc;
+	uint32_t       idle_reg[17];
+
+	/* reads from these ranges have no side effects */
+	uint32_t       idle_rom_addr;
+	uint32_t       idle_rom_cnt;
+	uint32_t       idle_ram_addr;
+	uint32_t       idle_ram_cnt;
+
+	unsigned       idle_range_cnt;
+	uint32_t       idle_range[2 * E68_IDLE_RANGE_MAX];
 	int generate_buserrs;
 	int report_buserrs;
 
@@ -145,6 +196,9 @@ typedef struct e68000_s {
 	void           (*log_exception) (void *ext, unsigned tn);
 	void           (*log_mem) (void *ext, unsigned long addr, unsigned type);
 
+	void           *trace_ext;
+	void           (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	void           *nf_ext;
 	uint32_t       (*nf_get_id)(void *ext, uint32_t args);
 	int32_t        (*nf_call)(void *ext, uint32_t args);
@@ -155,6 +209,19 @@ typedef struct e68000_s {
 	uint32_t       ir_pc;
 	uint16_t       ir[3];
 	uint16_t       sr;
+
+	/* the last condition code operation, if it was deferred */
+	char           lazy_cc;
+	unsigned char  cc_op;
+	uint8_t        cc_msk;
+	uint32_t       cc_d;
+	uint32_t       cc_s1;
+	uint32_t       cc_s2;
+
+	/* compute the condition codes eagerly as well and compare */
+	char           cc_check;
+	unsigned long  cc_check_err;
+
 	uint32_t       usp;
 	uint32_t       ssp;
 	uint32_t       vbr;
@@ -175,6 +242,7 @@ typedef struct e68000_s {
 #define HALT_NMI   0x01
 #define HALT_RESET 0x02
 #define HALT_STOP  0x04
+#define HALT_IDLE  0x08
 	char           bus_error;
 	char           exception;
 
@@ -240,6 +308,19 @@ void e68_set_areg32 (e68000_t *c, unsigned reg, uint32_t val)
 	c->areg[reg & 7] = val;
 }
 
+/*
+ * A read outside of RAM and the side effect free ranges ends an idle loop
+ */
+static inline
+void e68_idle_check_read (e68000_t *c, uint32_t addr)
+{
+	if ((addr - c->idle_rom_addr) >= c->idle_rom_cnt) {
+		if ((addr - c->idle_ram_addr) >= c->idle_ram_cnt) {
+			c->idle_ok = 0;
+		}
+	}
+}
+
 static inline
 uint8_t e68_get_mem8 (e68000_t *c, uint32_t addr)
 {
@@ -253,6 +334,8 @@ uint8_t e68_get_mem8 (e68000_t *c, uint32_t addr)
 		return (c->ram[addr]);
 	}
 
+	e68_idle_check_read (c, addr);
+
 	return (c->get_uint8 (c->mem_ext, addr));
 }
 
@@ -269,6 +352,8 @@ uint16_t e68_get_mem16 (e68000_t *c, uint32_t addr)
 		return ((c->ram[addr] << 8) | c->ram[addr + 1]);
 	}
 
+	e68_idle_check_read (c, addr);
+
 	return (c->get_uint16 (c->mem_ext, addr));
 }
 
@@ -292,9 +377,31 @@ uint32_t e68_get_mem32 (e68000_t *c, uint32_t addr)
 		return (val);
 	}
 
+	e68_idle_check_read (c, addr);
+
 	return (c->get_uint32 (c->mem_ext, addr));
 }
 
+static inline
+void e68_set_wmap_addr (e68000_t *c, uint32_t addr)
+{
+	addr -= c->wmap_addr;
+
+	if (addr < c->wmap_cnt) {
+		c->wmap[addr >> c->wmap_shift] = 1;
+	}
+}
+
+static inline
+void e68_dirty_ram (e68000_t *c, uint32_t addr)
+{
+	unsigned char *map;
+
+	if ((c->ram_dirty != NULL) && ((map = *c->ram_dirty) != NULL)) {
+		map[addr >> c->ram_dirty_shift] = 0xff;
+	}
+}
+
 static inline
 void e68_set_mem8 (e68000_t *c, uint32_t addr, uint8_t val)
 {
@@ -304,8 +411,12 @@ void e68_set_mem8 (e68000_t *c, uint32_t addr, uint8_t val)
 	}
 #endif
 
+	c->idle_ok = 0;
+
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+		e68_set_wmap_addr (c, addr);
+		e68_dirty_ram (c, addr);
 	}
 	else {
 		c->set_uint8 (c->mem_ext, addr, val);
@@ -321,9 +432,15 @@ void e68_set_mem16 (e68000_t *c, uint32_t addr, uint16_t val)
 	}
 #endif
 
+	c->idle_ok = 0;
+
 	if ((addr + 1) < c->ram_cnt) {
 		c->ram[addr] = (val >> 8) & 0xff;
 		c->ram[addr + 1] = val & 0xff;
+		e68_set_wmap_addr (c, addr);
+		e68_set_wmap_addr (c, addr + 1);
+		e68_dirty_ram (c, addr);
+		e68_dirty_ram (c, addr + 1);
 	}
 	else {
 		c->set_uint16 (c->mem_ext, addr, val);
@@ -339,11 +456,17 @@ void e68_set_mem32 (e68000_t *c, uint32_t addr, uint32_t val)
 	}
 #endif
 
+	c->idle_ok = 0;
+
 	if ((addr + 3) < c->ram_cnt) {
 		c->ram[addr] = (val >> 24) & 0xff;
 		c->ram[addr + 1] = (val >> 16) & 0xff;
 		c->ram[addr + 2] = (val >> 8) & 0xff;
 		c->ram[addr + 3] = val & 0xff;
+		e68_set_wmap_addr (c, addr);
+		e68_set_wmap_addr (c, addr + 3);
+		e68_dirty_ram (c, addr);
+		e68_dirty_ram (c, addr + 3);
 	}
 	else {
 		c->set_uint32 (c->mem_ext, addr, val);
@@ -382,6 +505,66 @@ void e68_set_mem_fct (e68000_t *c, void *ext,
 
 void e68_set_ram (e68000_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short Track writes through the RAM fast path
+ * @param addr  The first tracked address
+ * @param cnt   The size of the tracked range in bytes
+ * @param shift The log2 of the number of bytes per map entry
+ * @param map   The map, with one byte per (1 << shift) bytes
+ *
+ * Writes that don't go through the RAM fast path are not marked.
+ *****************************************************************************/
+void e68_set_wmap (e68000_t *c, unsigned long addr, unsigned long cnt,
+	unsigned shift, unsigned char *map
+);
+
+/*!***************************************************************************
+ * @short Set the dirty page map for RAM
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * While *map is not NULL, the byte for each page of RAM that is written
+ * through the RAM fast path is set to 0xff.
+ *****************************************************************************/
+void e68_set_ram_dirty_map (e68000_t *c, unsigned char **map, unsigned shift);
+
+/*!***************************************************************************
+ * @short Enable idle loop detection
+ * @param cnt The number of identical loop iterations before the cpu is
+ *            considered idle, or 0 to disable detection
+ *
+ * A loop is closed by a short backward branch. It is idle if an iteration
+ * leaves all registers unchanged, doesn't write to memory and reads only
+ * RAM or the ranges set with e68_set_idle_rom() and e68_set_idle_ram().
+ * Such a loop can only be left by an interrupt, so the cpu halts until
+ * the interrupt level changes. Ranges added with e68_add_idle_range()
+ * are used even if cnt is 0.
+ *****************************************************************************/
+void e68_set_idle (e68000_t *c, unsigned cnt);
+
+/*!***************************************************************************
+ * @short Set the ROM range that can be read without side effects
+ *****************************************************************************/
+void e68_set_idle_rom (e68000_t *c, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Set the RAM range that can be read without side effects
+ *
+ * This is only needed for RAM that is not set with e68_set_ram() and is
+ * accessed through the memory functions instead.
+ *****************************************************************************/
+void e68_set_idle_ram (e68000_t *c, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Add a range of known idle loops
+ *
+ * A backward branch to an address in [addr, addr + cnt) halts the cpu
+ * until the interrupt level changes, without further checks.
+ *****************************************************************************/
+int e68_add_idle_range (e68000_t *c, unsigned long addr, unsigned long cnt);
+
+void e68_idle_branch (e68000_t *c);
+
 void e68_set_reset_fct (e68000_t *c, void *ext, void *fct);
 
 void e68_set_inta_fct (e68000_t *c, void *ext, void *fct);
@@ -390,6 +573,14 @@ void e68_set_hook_fct (e68000_t *c, void *ext, void *fct);
 
 void e68_set_trap_fct (e68000_t *c, void *ext, void *fct);
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction is executed with the
+ * opcode word and the following four words.
+ *****************************************************************************/
+void e68_set_trace_fct (e68000_t *c, void *ext, void *fct);
+
 void e68_set_flags (e68000_t *c, unsigned flags, int set);
 
 void e68_set_address_check (e68000_t *c, int check);
@@ -400,6 +591,21 @@ void e68_set_68010 (e68000_t *c);
 
 void e68_set_68020 (e68000_t *c);
 
+/*!***************************************************************************
+ * @short Compute the condition codes only when they are read
+ * @param c      The cpu context
+ * @param enable If true, the condition codes are computed lazily
+ * @param check  If true, the condition codes are also computed eagerly
+ *               after each deferred operation and both results are compared
+ *****************************************************************************/
+void e68_set_lazy_cc (e68000_t *c, int enable, int check);
+
+/*!***************************************************************************
+ * @short Compute deferred condition codes
+ * @return The status register
+ *****************************************************************************/
+uint16_t e68_cc_eval (e68000_t *c);
+
 /*!***************************************************************************
  * @short Get the number of executed instructions
  *****************************************************************************/
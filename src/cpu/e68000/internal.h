@@ -59,6 +59,7 @@ uint32_t e68_exts16 (uint32_t val)
 static inline
 void e68_set_ccr (e68000_t *c, uint8_t val)
 {
+	c->cc_op = E68_CC_NONE;
 	c->sr = (c->sr & 0xff00) | (val & 0x00ff);
 }
 
@@ -2927,6 +2927,10 @@ void e68_op_bcc (e68000_t *c, int cond)
 
 	e68_op_prefetch (c);
 	e68_set_pc (c, e68_get_ir_pc (c) - 4);
+
+	if (cond && ((c->idle_max > 0) || (c->idle_range_cnt > 0)) && (((0 - dist) - 1) < E68_IDLE_DIST)) {
+		e68_idle_branch (c);
+	}
 }
 
 /* 6000: BRA dist */
@@ -3200,7 +3204,7 @@ static void op8100_00 (e68000_t *c)
 	e68_set_cc (c, E68_SR_XC, d & 0xff00);
 
 	if (d & 0xff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 
 	e68_op_prefetch (c);
@@ -3839,15 +3843,15 @@ static void opc100_00 (e68000_t *c)
 
 	if (d >= 0xa0) {
 		d += 0x60;
-		c->sr |= (E68_SR_X | E68_SR_C);
+		e68_set_sr_xc (c, 1);
 	}
 	else {
-		c->sr &= (~E68_SR_X & ~E68_SR_C);
+		e68_set_sr_xc (c, 0);
 	}
 
 
 	if (d & 0xff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 
 	e68_set_clk (c, 6);
@@ -46,8 +46,12 @@ void e8080_init (e8080_t *c)
 	for (i = 0; i < 64; i++) {
 		c->mem_map_rd[i] = NULL;
 		c->mem_map_wr[i] = NULL;
+		c->mem_map_dirty[i] = NULL;
+		c->mem_map_dirty_ofs[i] = 0;
 	}
 
+	c->mem_map_dirty_shift = 0;
+
 	c->port_rd_ext = NULL;
 	c->port_wr_ext = NULL;
 
@@ -59,6 +63,9 @@ void e8080_init (e8080_t *c)
 	c->hook_undef = NULL;
 	c->hook_rst = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	c->delay = 0;
 	c->clkcnt = 0;
 	c->inscnt = 0;
@@ -135,6 +142,40 @@ void e8080_set_mem_map_wr (e8080_t *c, unsigned addr1, unsigned addr2, unsigned
 	e8080_set_mem_map (c->mem_map_wr, addr1, addr2, p);
 }
 
+void e8080_set_mem_map_dirty (e8080_t *c, unsigned addr1, unsigned addr2,
+	unsigned char **map, unsigned shift)
+{
+	unsigned long ofs;
+
+	c->mem_map_dirty_shift = shift;
+
+	/* partial pages are not write mapped, see e8080_set_mem_map() */
+	ofs = 0;
+
+	if (addr1 & 1023) {
+		ofs += 1024 - (addr1 & 1023);
+		c->mem_map_dirty[(addr1 >> 10) & 0x3f] = NULL;
+		addr1 = (addr1 + 1023) & ~1023U;
+	}
+
+	if ((addr2 & 1023) != 1023) {
+		c->mem_map_dirty[(addr2 >> 10) & 0x3f] = NULL;
+		addr2 = addr2 & ~1023U;
+
+		if (addr2 > 0) {
+			addr2 -= 1;
+		}
+	}
+
+	while (addr1 < addr2) {
+		c->mem_map_dirty[(addr1 >> 10) & 0x3f] = map;
+		c->mem_map_dirty_ofs[(addr1 >> 10) & 0x3f] = ofs;
+
+		ofs += 1024;
+		addr1 += 1024;
+	}
+}
+
 void e8080_set_8080 (e8080_t *c)
 {
 	c->flags &= ~E8080_FLAG_Z80;
@@ -219,6 +260,12 @@ void e8080_set_hook_rst_fct (e8080_t *c, void *ext, void *fct)
 	c->hook_rst = fct;
 }
 
+void e8080_set_trace_fct (e8080_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 unsigned char e8080_get_port8 (e8080_t *c, unsigned addr)
 {
 	if (c->get_port8 != NULL) {
@@ -444,6 +491,21 @@ void e8080_reset (e8080_t *c)
 	c->halt = 0;
 }
 
+static
+void e8080_trace_exec (e8080_t *c, unsigned short pc)
+{
+	unsigned      i;
+	unsigned char buf[4];
+
+	buf[0] = c->inst[0];
+
+	for (i = 1; i < 4; i++) {
+		buf[i] = e8080_get_mem8 (c, (pc + i) & 0xffff);
+	}
+
+	c->trace_exec (c->trace_ext, pc, buf, 4);
+}
+
 void e8080_execute (e8080_t *c)
 {
 	unsigned short pc;
@@ -457,6 +519,10 @@ void e8080_execute (e8080_t *c)
 
 	c->inst[0] = e8080_get_mem8 (c, pc);
 
+	if (c->trace_exec != NULL) {
+		e8080_trace_exec (c, pc);
+	}
+
 #ifdef E8080_ENABLE_HOOK_ALL
 	if (c->hook_all != NULL) {
 		if (e8080_hook_all (c)) {
@@ -75,6 +75,11 @@ typedef struct e8080_t {
 	unsigned char  *mem_map_rd[64];
 	unsigned char  *mem_map_wr[64];
 
+	/* per write map page: the dirty page map location and offset */
+	unsigned char  **mem_map_dirty[64];
+	unsigned long  mem_map_dirty_ofs[64];
+	unsigned       mem_map_dirty_shift;
+
 	void           *port_rd_ext;
 	void           *port_wr_ext;
 
@@ -86,6 +91,9 @@ typedef struct e8080_t {
 	int            (*hook_undef) (void *ext, unsigned char op);
 	int            (*hook_rst) (void *ext, unsigned char op);
 
+	void           *trace_ext;
+	void           (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	unsigned char  inst[4];
 
 	e8080_opcode_f op[256];
@@ -178,6 +186,20 @@ unsigned char e8080_get_mem8 (e8080_t *c, unsigned short addr)
 	return (c->get_uint8 (c->mem_rd_ext, addr));
 }
 
+static inline
+void e8080_dirty_mem (e8080_t *c, unsigned short addr)
+{
+	unsigned      i;
+	unsigned char **map;
+
+	i = (addr >> 10) & 0x3f;
+
+	if (((map = c->mem_map_dirty[i]) != NULL) && (*map != NULL)) {
+		i = (c->mem_map_dirty_ofs[i] + (addr & 0x3ff)) >> c->mem_map_dirty_shift;
+		(*map)[i] = 0xff;
+	}
+}
+
 static inline
 void e8080_set_mem8 (e8080_t *c, unsigned short addr, unsigned char val)
 {
@@ -187,6 +209,7 @@ void e8080_set_mem8 (e8080_t *c, unsigned short addr, unsigned char val)
 
 	if (p != NULL) {
 		p[addr & 0x3ff] = val;
+		e8080_dirty_mem (c, addr);
 	}
 	else {
 		c->set_uint8 (c->mem_wr_ext, addr, val);
@@ -235,6 +258,19 @@ void e8080_del (e8080_t *c);
 void e8080_set_mem_map_rd (e8080_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
 void e8080_set_mem_map_wr (e8080_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
 
+/*****************************************************************************
+ * @short Set the dirty page map for a write mapped memory range
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * The range must be the same as in e8080_set_mem_map_wr(). While *map
+ * is not NULL, the byte for each page of the range that is written
+ * through the write map is set to 0xff. Pages are counted from addr1.
+ *****************************************************************************/
+void e8080_set_mem_map_dirty (e8080_t *c, unsigned addr1, unsigned addr2,
+	unsigned char **map, unsigned shift
+);
+
 void e8080_set_8080 (e8080_t *c);
 void e8080_set_z80 (e8080_t *c);
 
@@ -260,6 +296,14 @@ void e8080_set_hook_all_fct (e8080_t *c, void *ext, void *fct);
 void e8080_set_hook_undef_fct (e8080_t *c, void *ext, void *fct);
 void e8080_set_hook_rst_fct (e8080_t *c, void *ext, void *fct);
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction is executed with the
+ * opcode byte and the following three bytes.
+ *****************************************************************************/
+void e8080_set_trace_fct (e8080_t *c, void *ext, void *fct);
+
 unsigned char e8080_get_port8 (e8080_t *c, unsigned addr);
 void e8080_set_port8 (e8080_t *c, unsigned addr, unsigned char val);
 
@@ -51,6 +51,7 @@ void e86_init (e8086_t *c)
 	c->mem_get_uint16 = e86_get_mem_uint16;
 	c->mem_set_uint8 = e86_set_mem_uint8;
 	c->mem_set_uint16 = e86_set_mem_uint16;
+	c->mem_set_blk = NULL;
 
 	c->prt = NULL;
 	c->prt_get_uint8 = e86_get_mem_uint8;
@@ -61,6 +62,9 @@ void e86_init (e8086_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	c->ram_dirty = NULL;
+	c->ram_dirty_shift = 0;
+
 	c->addr_mask = 0xfffff;
 
 	c->inta_ext = NULL;
@@ -78,6 +82,9 @@ void e86_init (e8086_t *c)
 	c->trap_ext = NULL;
 	c->trap = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	c->pq_size = 4;
 	c->pq_fill = 6;
 
@@ -92,6 +99,11 @@ void e86_init (e8086_t *c)
 
 	c->reset_flags = 0;
 
+	c->lazy_flags = 0;
+	c->lazy_op = E86_LAZY_NONE;
+	c->lazy_check = 0;
+	c->lazy_check_err = 0;
+
 	for (i = 0; i < 256; i++) {
 		c->op[i] = e86_opcodes[i];
 	}
@@ -212,12 +224,24 @@ void e86_set_trap_fct (e8086_t *c, void *ext, void *fct)
 	c->trap = fct;
 }
 
+void e86_set_trace_fct (e8086_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 void e86_set_ram (e8086_t *c, unsigned char *ram, unsigned long cnt)
 {
 	c->ram = ram;
 	c->ram_cnt = cnt;
 }
 
+void e86_set_ram_dirty_map (e8086_t *c, unsigned char **map, unsigned shift)
+{
+	c->ram_dirty = map;
+	c->ram_dirty_shift = shift;
+}
+
 void e86_set_mem (e8086_t *c, void *mem,
 	e86_get_uint8_f get8, e86_set_uint8_f set8,
 	e86_get_uint16_f get16, e86_set_uint16_f set16)
@@ -229,6 +253,11 @@ void e86_set_mem (e8086_t *c, void *mem,
 	c->mem_set_uint16 = set16;
 }
 
+void e86_set_mem_blk (e8086_t *c, e86_set_blk_f set)
+{
+	c->mem_set_blk = set;
+}
+
 void e86_set_prt (e8086_t *c, void *prt,
 	e86_get_uint8_f get8, e86_set_uint8_f set8,
 	e86_get_uint16_f get16, e86_set_uint16_f set16)
@@ -392,7 +421,7 @@ void e86_trap (e8086_t *c, unsigned n)
 	e86_set_cs (c, e86_get_mem16 (c, 0, ofs + 2));
 	c->flg &= ~(E86_FLG_I | E86_FLG_T);
 
-	c->save_flags = e86_get_flags (c);
+	c->save_flags = c->flg;
 
 	e86_pq_init (c);
 }
@@ -503,7 +532,8 @@ void e86_execute (e8086_t *c)
 		c->cur_ip = c->ip;
 	}
 
-	c->save_flags = e86_get_flags (c);
+	/* only I and T are used, don't compute lazy flags */
+	c->save_flags = c->flg;
 
 	irq = c->irq;
 
@@ -516,6 +546,13 @@ void e86_execute (e8086_t *c)
 			c->op_stat (c->op_ext, c->pq[0], c->pq[1]);
 		}
 
+		if (c->trace_exec != NULL) {
+			c->trace_exec (c->trace_ext,
+				((unsigned long) e86_get_cs (c) << 16) | e86_get_ip (c),
+				c->pq, c->pq_fill
+			);
+		}
+
 		cnt = c->op[c->pq[0]] (c);
 
 		if (cnt > 0) {
@@ -533,7 +570,7 @@ void e86_execute (e8086_t *c)
 		c->state &= ~E86_STATE_HALT;
 		e86_trap (c, 1);
 	}
-	else if (irq && c->irq && (c->save_flags & e86_get_flags (c) & E86_FLG_I)) {
+	else if (irq && c->irq && (c->save_flags & c->flg & E86_FLG_I)) {
 		e86_irq_ack (c);
 	}
 }
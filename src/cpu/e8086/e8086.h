@@ -48,6 +48,29 @@
 #define E86_FLG_D 0x0400
 #define E86_FLG_O 0x0800
 
+/* the flags that are set by arithmetic instructions */
+#define E86_FLG_ARITH (E86_FLG_C | E86_FLG_P | E86_FLG_A | E86_FLG_Z | E86_FLG_S | E86_FLG_O)
+
+/* pending lazy flag operations */
+#define E86_LAZY_NONE   0
+#define E86_LAZY_SZP_8  1
+#define E86_LAZY_SZP_16 2
+#define E86_LAZY_LOG_8  3
+#define E86_LAZY_LOG_16 4
+#define E86_LAZY_ADD_8  5
+#define E86_LAZY_ADD_16 6
+#define E86_LAZY_ADC_8  7
+#define E86_LAZY_ADC_16 8
+#define E86_LAZY_SUB_8  9
+#define E86_LAZY_SUB_16 10
+#define E86_LAZY_SBB_8  11
+#define E86_LAZY_SBB_16 12
+#define E86_LAZY_INC_8  13
+#define E86_LAZY_INC_16 14
+#define E86_LAZY_DEC_8  15
+#define E86_LAZY_DEC_16 16
+#define E86_LAZY_CNT    17
+
 /* 16 bit register values */
 #define E86_REG_AX 0
 #define E86_REG_CX 1
@@ -94,6 +117,7 @@ typedef unsigned char (*e86_get_uint8_f) (memory_t *mem, unsigned long addr);
 typedef unsigned short (*e86_get_uint16_f) (memory_t *mem, unsigned long addr);
 typedef void (*e86_set_uint8_f) (memory_t *mem, unsigned long addr, unsigned char val);
 typedef void (*e86_set_uint16_f) (memory_t *mem, unsigned long addr, unsigned short val);
+typedef unsigned long (*e86_set_blk_f) (memory_t *mem, unsigned long addr, const unsigned char *buf, unsigned long cnt);
 
 typedef unsigned (*e86_opcode_f) (struct e8086_t *c);
 
@@ -106,6 +130,17 @@ typedef struct e8086_t {
 	unsigned short   ip;
 	unsigned short   flg;
 
+	/* the last flag setting operation, if the flags are computed lazily */
+	char             lazy_flags;
+	unsigned char    lazy_op;
+	unsigned short   lazy_s1;
+	unsigned short   lazy_s2;
+	unsigned short   lazy_s3;
+
+	/* compute the flags eagerly as well and compare */
+	char             lazy_check;
+	unsigned long    lazy_check_err;
+
 	unsigned short   save_flags;
 
 	void             *mem;
@@ -114,6 +149,9 @@ typedef struct e8086_t {
 	e86_get_uint16_f mem_get_uint16;
 	e86_set_uint16_f mem_set_uint16;
 
+	/* write several bytes outside of ram, may be NULL */
+	e86_set_blk_f    mem_set_blk;
+
 	void             *prt;
 	e86_get_uint8_f  prt_get_uint8;
 	e86_set_uint8_f  prt_set_uint8;
@@ -123,6 +161,10 @@ typedef struct e8086_t {
 	unsigned char    *ram;
 	unsigned long    ram_cnt;
 
+	/* the location of the dirty page map for ram or NULL */
+	unsigned char    **ram_dirty;
+	unsigned         ram_dirty_shift;
+
 	unsigned long    addr_mask;
 
 	void             *inta_ext;
@@ -140,6 +182,9 @@ typedef struct e8086_t {
 	void             *trap_ext;
 	int              (*trap) (void *ext, unsigned n);
 
+	void             *trace_ext;
+	void             (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	unsigned short   cur_ip;
 
 	unsigned         pq_size;
@@ -260,23 +305,30 @@ typedef struct e8086_t {
 #define e86_set_ip(cpu, val) do { (cpu)->ip = (val) & 0xffff; } while (0)
 
 
-#define e86_get_flags(cpu) ((cpu)->flg)
-#define e86_get_f(cpu, f) (((cpu)->flg & (f)) != 0)
-#define e86_get_cf(cpu) (((cpu)->flg & E86_FLG_C) != 0)
-#define e86_get_pf(cpu) (((cpu)->flg & E86_FLG_P) != 0)
-#define e86_get_af(cpu) (((cpu)->flg & E86_FLG_A) != 0)
-#define e86_get_zf(cpu) (((cpu)->flg & E86_FLG_Z) != 0)
-#define e86_get_of(cpu) (((cpu)->flg & E86_FLG_O) != 0)
-#define e86_get_sf(cpu) (((cpu)->flg & E86_FLG_S) != 0)
+/* the arithmetic flags must be computed before they can be accessed */
+#define e86_get_flags(cpu) \
+	(((cpu)->lazy_op != E86_LAZY_NONE) ? e86_flg_eval (cpu) : (cpu)->flg)
+
+#define e86_get_f(cpu, f) ((e86_get_flags (cpu) & (f)) != 0)
+#define e86_get_cf(cpu) ((e86_get_flags (cpu) & E86_FLG_C) != 0)
+#define e86_get_pf(cpu) ((e86_get_flags (cpu) & E86_FLG_P) != 0)
+#define e86_get_af(cpu) ((e86_get_flags (cpu) & E86_FLG_A) != 0)
+#define e86_get_zf(cpu) ((e86_get_flags (cpu) & E86_FLG_Z) != 0)
+#define e86_get_of(cpu) ((e86_get_flags (cpu) & E86_FLG_O) != 0)
+#define e86_get_sf(cpu) ((e86_get_flags (cpu) & E86_FLG_S) != 0)
 #define e86_get_df(cpu) (((cpu)->flg & E86_FLG_D) != 0)
 #define e86_get_if(cpu) (((cpu)->flg & E86_FLG_I) != 0)
 #define e86_get_tf(cpu) (((cpu)->flg & E86_FLG_T) != 0)
 
 
-#define e86_set_flags(c, v) do { (c)->flg = (v) & 0xffffU; } while (0)
+#define e86_set_flags(c, v) \
+	do { (c)->flg = (v) & 0xffffU; (c)->lazy_op = E86_LAZY_NONE; } while (0)
 
 #define e86_set_f(c, f, v) \
-	do { if (v) (c)->flg |= (f); else (c)->flg &= ~(f); } while (0)
+	do { \
+		if (((f) & E86_FLG_ARITH) && (c)->lazy_op) e86_flg_eval (c); \
+		if (v) (c)->flg |= (f); else (c)->flg &= ~(f); \
+	} while (0)
 
 #define e86_set_cf(c, v) e86_set_f (c, E86_FLG_C, v)
 #define e86_set_pf(c, v) e86_set_f (c, E86_FLG_P, v)
@@ -297,6 +349,25 @@ typedef struct e8086_t {
 	((((seg) & 0xffffUL) << 4) + ((ofs) & 0xffff))
 
 
+static inline
+void e86_dirty_ram (e8086_t *c, unsigned long addr, unsigned long cnt)
+{
+	unsigned char *map;
+	unsigned long i, n;
+
+	if ((c->ram_dirty == NULL) || ((map = *c->ram_dirty) == NULL)) {
+		return;
+	}
+
+	i = addr >> c->ram_dirty_shift;
+	n = (addr + cnt - 1) >> c->ram_dirty_shift;
+
+	while (i <= n) {
+		map[i] = 0xff;
+		i += 1;
+	}
+}
+
 static inline
 unsigned char e86_get_mem8 (e8086_t *c, unsigned short seg, unsigned short ofs)
 {
@@ -311,6 +382,7 @@ void e86_set_mem8 (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+		e86_dirty_ram (c, addr, 1);
 	}
 	else {
 		c->mem_set_uint8 (c->mem, addr, val);
@@ -338,6 +410,7 @@ void e86_set_mem16 (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned
 	if ((addr + 1) < c->ram_cnt) {
 		c->ram[addr] = val & 0xff;
 		c->ram[addr + 1] = (val >> 8) & 0xff;
+		e86_dirty_ram (c, addr, 2);
 	}
 	else {
 		c->mem_set_uint16 (c->mem, addr, val);
@@ -388,6 +461,21 @@ void e86_set_pq_size (e8086_t *c, unsigned size);
  *****************************************************************************/
 void e86_set_options (e8086_t *c, unsigned opt, int set);
 
+/*!***************************************************************************
+ * @short Compute the arithmetic flags only when they are read
+ * @param c      The cpu context
+ * @param enable If true, the flags are computed lazily
+ * @param check  If true, the flags are also computed eagerly after each
+ *               flag setting operation and both results are compared
+ *****************************************************************************/
+void e86_set_lazy_flags (e8086_t *c, int enable, int check);
+
+/*!***************************************************************************
+ * @short Compute pending lazy flags
+ * @return The flags register
+ *****************************************************************************/
+unsigned short e86_flg_eval (e8086_t *c);
+
 void e86_set_addr_mask (e8086_t *c, unsigned long msk);
 unsigned long e86_get_addr_mask (e8086_t *c);
 
@@ -397,13 +485,42 @@ void e86_set_hook_fct (e8086_t *c, void *ext, void *fct);
 
 void e86_set_trap_fct (e8086_t *c, void *ext, void *fct);
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction (and each prefix) is
+ * executed with CS in the upper and IP in the lower 16 bits of addr
+ * and the contents of the prefetch queue as opcode bytes.
+ *****************************************************************************/
+void e86_set_trace_fct (e8086_t *c, void *ext, void *fct);
+
 void e86_set_ram (e8086_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short Set the dirty page map for ram
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * While *map is not NULL, the byte for each page of ram that is written
+ * directly by the CPU is set to 0xff.
+ *****************************************************************************/
+void e86_set_ram_dirty_map (e8086_t *c, unsigned char **map, unsigned shift);
+
 void e86_set_mem (e8086_t *c, void *mem,
 	e86_get_uint8_f get8, e86_set_uint8_f set8,
 	e86_get_uint16_f get16, e86_set_uint16_f set16
 );
 
+/*!***************************************************************************
+ * @short Set the block write function
+ * @param set The function or NULL
+ *
+ * The function is used by REP MOVS and REP STOS to write to memory
+ * outside of ram. It must write at least one byte and return the
+ * number of bytes written, like mem_set_blk().
+ *****************************************************************************/
+void e86_set_mem_blk (e8086_t *c, e86_set_blk_f set);
+
 void e86_set_prt (e8086_t *c, void *prt,
 	e86_get_uint8_f get8, e86_set_uint8_f set8,
 	e86_get_uint16_f get16, e86_set_uint16_f set16
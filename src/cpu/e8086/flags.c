@@ -23,6 +23,8 @@
 #include "e8086.h"
 #include "internal.h"
 
+#include <stdio.h>
+
 
 static
 char parity[256] = {
@@ -49,7 +51,8 @@ char parity[256] = {
  * Flags functions
  *************************************************************************/
 
-void e86_set_flg_szp_8 (e8086_t *c, unsigned char val)
+static
+void e86_flg_szp_8 (e8086_t *c, unsigned char val)
 {
 	unsigned short set;
 
@@ -72,7 +75,8 @@ void e86_set_flg_szp_8 (e8086_t *c, unsigned char val)
 	c->flg |= set;
 }
 
-void e86_set_flg_szp_16 (e8086_t *c, unsigned short val)
+static
+void e86_flg_szp_16 (e8086_t *c, unsigned short val)
 {
 	unsigned short set;
 
@@ -93,26 +97,29 @@ void e86_set_flg_szp_16 (e8086_t *c, unsigned short val)
 	c->flg |= set;
 }
 
-void e86_set_flg_log_8 (e8086_t *c, unsigned char val)
+static
+void e86_flg_log_8 (e8086_t *c, unsigned char val)
 {
-	e86_set_flg_szp_8 (c, val);
+	e86_flg_szp_8 (c, val);
 
 	c->flg &= ~(E86_FLG_C | E86_FLG_O);
 }
 
-void e86_set_flg_log_16 (e8086_t *c, unsigned short val)
+static
+void e86_flg_log_16 (e8086_t *c, unsigned short val)
 {
-	e86_set_flg_szp_16 (c, val);
+	e86_flg_szp_16 (c, val);
 
 	c->flg &= ~(E86_FLG_C | E86_FLG_O);
 }
 
-void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+static
+void e86_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
 {
 	unsigned short set;
 	unsigned short dst;
 
-	e86_set_flg_szp_8 (c, s1 + s2);
+	e86_flg_szp_8 (c, s1 + s2);
 
 	set = 0;
 
@@ -134,12 +141,13 @@ void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
 	c->flg |= set;
 }
 
-void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+static
+void e86_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
 {
 	unsigned short set;
 	unsigned long  dst;
 
-	e86_set_flg_szp_16 (c, s1 + s2);
+	e86_flg_szp_16 (c, s1 + s2);
 
 	set = 0;
 
@@ -161,12 +169,13 @@ void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
 	c->flg |= set;
 }
 
-void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+static
+void e86_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
 {
 	unsigned short set;
 	unsigned short dst;
 
-	e86_set_flg_szp_8 (c, s1 + s2 + s3);
+	e86_flg_szp_8 (c, s1 + s2 + s3);
 
 	set = 0;
 
@@ -188,12 +197,13 @@ void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned
 	c->flg |= set;
 }
 
-void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+static
+void e86_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
 {
 	unsigned short set;
 	unsigned long  dst;
 
-	e86_set_flg_szp_16 (c, s1 + s2 + s3);
+	e86_flg_szp_16 (c, s1 + s2 + s3);
 
 	set = 0;
 
@@ -215,12 +225,13 @@ void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsig
 	c->flg |= set;
 }
 
-void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+static
+void e86_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
 {
 	unsigned short set;
 	unsigned short dst;
 
-	e86_set_flg_szp_8 (c, s1 - s2 - s3);
+	e86_flg_szp_8 (c, s1 - s2 - s3);
 
 	set = 0;
 
@@ -242,12 +253,13 @@ void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned
 	c->flg |= set;
 }
 
-void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+static
+void e86_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
 {
 	unsigned short set;
 	unsigned long  dst;
 
-	e86_set_flg_szp_16 (c, s1 - s2 - s3);
+	e86_flg_szp_16 (c, s1 - s2 - s3);
 
 	set = 0;
 
@@ -269,12 +281,13 @@ void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsig
 	c->flg |= set;
 }
 
-void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+static
+void e86_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
 {
 	unsigned short set;
 	unsigned short dst;
 
-	e86_set_flg_szp_8 (c, s1 - s2);
+	e86_flg_szp_8 (c, s1 - s2);
 
 	set = 0;
 
@@ -296,12 +309,13 @@ void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
 	c->flg |= set;
 }
 
-void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+static
+void e86_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
 {
 	unsigned short set;
 	unsigned long  dst;
 
-	e86_set_flg_szp_16 (c, s1 - s2);
+	e86_flg_szp_16 (c, s1 - s2);
 
 	set = 0;
 
@@ -322,3 +336,432 @@ void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
 	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
 	c->flg |= set;
 }
+
+
+/*************************************************************************
+ * Lazy flags
+ *
+ * Instead of computing the arithmetic flags after every instruction,
+ * only the operation and its operands are recorded. The flags are
+ * computed when they are actually read. Since most flag results are
+ * overwritten by the next instruction, this saves a lot of work.
+ *************************************************************************/
+
+/* the flags that are computed by each lazy operation */
+static
+unsigned short e86_lazy_flg[E86_LAZY_CNT] = {
+	0,
+	E86_FLG_S | E86_FLG_Z | E86_FLG_P,
+	E86_FLG_S | E86_FLG_Z | E86_FLG_P,
+	E86_FLG_S | E86_FLG_Z | E86_FLG_P | E86_FLG_C | E86_FLG_O,
+	E86_FLG_S | E86_FLG_Z | E86_FLG_P | E86_FLG_C | E86_FLG_O,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH,
+	E86_FLG_ARITH
+};
+
+/*
+ * Compute the flags of operation op eagerly
+ */
+static
+void e86_flg_apply (e8086_t *c, unsigned op, unsigned s1, unsigned s2, unsigned s3)
+{
+	switch (op) {
+	case E86_LAZY_SZP_8:
+		e86_flg_szp_8 (c, s1);
+		break;
+
+	case E86_LAZY_SZP_16:
+		e86_flg_szp_16 (c, s1);
+		break;
+
+	case E86_LAZY_LOG_8:
+		e86_flg_log_8 (c, s1);
+		break;
+
+	case E86_LAZY_LOG_16:
+		e86_flg_log_16 (c, s1);
+		break;
+
+	case E86_LAZY_ADD_8:
+		e86_flg_add_8 (c, s1, s2);
+		break;
+
+	case E86_LAZY_ADD_16:
+		e86_flg_add_16 (c, s1, s2);
+		break;
+
+	case E86_LAZY_ADC_8:
+		e86_flg_adc_8 (c, s1, s2, s3);
+		break;
+
+	case E86_LAZY_ADC_16:
+		e86_flg_adc_16 (c, s1, s2, s3);
+		break;
+
+	case E86_LAZY_SUB_8:
+		e86_flg_sub_8 (c, s1, s2);
+		break;
+
+	case E86_LAZY_SUB_16:
+		e86_flg_sub_16 (c, s1, s2);
+		break;
+
+	case E86_LAZY_SBB_8:
+		e86_flg_sbb_8 (c, s1, s2, s3);
+		break;
+
+	case E86_LAZY_SBB_16:
+		e86_flg_sbb_16 (c, s1, s2, s3);
+		break;
+
+	case E86_LAZY_INC_8:
+		e86_flg_add_8 (c, s1, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | s3;
+		break;
+
+	case E86_LAZY_INC_16:
+		e86_flg_add_16 (c, s1, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | s3;
+		break;
+
+	case E86_LAZY_DEC_8:
+		e86_flg_sub_8 (c, s1, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | s3;
+		break;
+
+	case E86_LAZY_DEC_16:
+		e86_flg_sub_16 (c, s1, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | s3;
+		break;
+	}
+}
+
+unsigned short e86_flg_eval (e8086_t *c)
+{
+	unsigned op;
+
+	op = c->lazy_op;
+
+	c->lazy_op = E86_LAZY_NONE;
+
+	e86_flg_apply (c, op, c->lazy_s1, c->lazy_s2, c->lazy_s3);
+
+	return (c->flg);
+}
+
+static
+void e86_flg_record (e8086_t *c, unsigned op, unsigned s1, unsigned s2, unsigned s3)
+{
+	/*
+	 * The pending operation can only be dropped if the new one
+	 * overwrites all the flags it would have set.
+	 */
+	if (e86_lazy_flg[c->lazy_op] & ~e86_lazy_flg[op]) {
+		e86_flg_eval (c);
+	}
+
+	c->lazy_op = op;
+	c->lazy_s1 = s1;
+	c->lazy_s2 = s2;
+	c->lazy_s3 = s3;
+}
+
+/*
+ * Defer operation op and compare the lazily computed flags with the
+ * flags that the eager path computes from the same state.
+ */
+static
+void e86_flg_check (e8086_t *c, unsigned op, unsigned s1, unsigned s2, unsigned s3)
+{
+	unsigned char  lop;
+	unsigned short flg, ls1, ls2, ls3;
+	unsigned short eager, lazy;
+
+	flg = c->flg;
+	lop = c->lazy_op;
+	ls1 = c->lazy_s1;
+	ls2 = c->lazy_s2;
+	ls3 = c->lazy_s3;
+
+	e86_flg_eval (c);
+
+	switch (op) {
+	case E86_LAZY_INC_8:
+	case E86_LAZY_INC_16:
+	case E86_LAZY_DEC_8:
+	case E86_LAZY_DEC_16:
+		/* the carry flag that was passed in was computed lazily */
+		e86_flg_apply (c, op, s1, s2, c->flg & E86_FLG_C);
+		break;
+
+	default:
+		e86_flg_apply (c, op, s1, s2, s3);
+		break;
+	}
+
+	eager = c->flg;
+
+	c->flg = flg;
+	c->lazy_op = lop;
+	c->lazy_s1 = ls1;
+	c->lazy_s2 = ls2;
+	c->lazy_s3 = ls3;
+
+	e86_flg_record (c, op, s1, s2, s3);
+
+	flg = c->flg;
+	lop = c->lazy_op;
+
+	lazy = e86_flg_eval (c);
+
+	c->flg = flg;
+	c->lazy_op = lop;
+
+	if (lazy != eager) {
+		c->lazy_check_err += 1;
+
+		fprintf (stderr,
+			"e8086: lazy flags: mismatch at %04X:%04X op=%u (%04X %04X)\n",
+			c->sreg[E86_REG_CS], c->cur_ip, op, lazy, eager
+		);
+
+		c->flg = eager;
+		c->lazy_op = E86_LAZY_NONE;
+	}
+}
+
+static
+void e86_flg_defer (e8086_t *c, unsigned op, unsigned s1, unsigned s2, unsigned s3)
+{
+	if (c->lazy_check) {
+		e86_flg_check (c, op, s1, s2, s3);
+	}
+	else {
+		e86_flg_record (c, op, s1, s2, s3);
+	}
+}
+
+/*
+ * Get the carry flag without computing the other flags, if possible.
+ * INC and DEC preserve it.
+ */
+static
+unsigned short e86_flg_get_c (e8086_t *c)
+{
+	switch (c->lazy_op) {
+	case E86_LAZY_NONE:
+	case E86_LAZY_SZP_8:
+	case E86_LAZY_SZP_16:
+		return (c->flg & E86_FLG_C);
+
+	case E86_LAZY_LOG_8:
+	case E86_LAZY_LOG_16:
+		return (0);
+
+	case E86_LAZY_INC_8:
+	case E86_LAZY_INC_16:
+	case E86_LAZY_DEC_8:
+	case E86_LAZY_DEC_16:
+		return (c->lazy_s3);
+	}
+
+	return (e86_flg_eval (c) & E86_FLG_C);
+}
+
+void e86_set_lazy_flags (e8086_t *c, int enable, int check)
+{
+	e86_flg_eval (c);
+
+	c->lazy_flags = (enable != 0);
+	c->lazy_check = (enable != 0) && (check != 0);
+}
+
+void e86_set_flg_szp_8 (e8086_t *c, unsigned char val)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SZP_8, val, 0, 0);
+	}
+	else {
+		e86_flg_szp_8 (c, val);
+	}
+}
+
+void e86_set_flg_szp_16 (e8086_t *c, unsigned short val)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SZP_16, val, 0, 0);
+	}
+	else {
+		e86_flg_szp_16 (c, val);
+	}
+}
+
+void e86_set_flg_log_8 (e8086_t *c, unsigned char val)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_LOG_8, val, 0, 0);
+	}
+	else {
+		e86_flg_log_8 (c, val);
+	}
+}
+
+void e86_set_flg_log_16 (e8086_t *c, unsigned short val)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_LOG_16, val, 0, 0);
+	}
+	else {
+		e86_flg_log_16 (c, val);
+	}
+}
+
+void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_ADD_8, s1, s2, 0);
+	}
+	else {
+		e86_flg_add_8 (c, s1, s2);
+	}
+}
+
+void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_ADD_16, s1, s2, 0);
+	}
+	else {
+		e86_flg_add_16 (c, s1, s2);
+	}
+}
+
+void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_ADC_8, s1, s2, s3);
+	}
+	else {
+		e86_flg_adc_8 (c, s1, s2, s3);
+	}
+}
+
+void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_ADC_16, s1, s2, s3);
+	}
+	else {
+		e86_flg_adc_16 (c, s1, s2, s3);
+	}
+}
+
+void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SBB_8, s1, s2, s3);
+	}
+	else {
+		e86_flg_sbb_8 (c, s1, s2, s3);
+	}
+}
+
+void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SBB_16, s1, s2, s3);
+	}
+	else {
+		e86_flg_sbb_16 (c, s1, s2, s3);
+	}
+}
+
+void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SUB_8, s1, s2, 0);
+	}
+	else {
+		e86_flg_sub_8 (c, s1, s2);
+	}
+}
+
+void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+{
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_SUB_16, s1, s2, 0);
+	}
+	else {
+		e86_flg_sub_16 (c, s1, s2);
+	}
+}
+
+void e86_set_flg_inc_8 (e8086_t *c, unsigned char val)
+{
+	unsigned short cf;
+
+	cf = e86_flg_get_c (c);
+
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_INC_8, val, 0, cf);
+	}
+	else {
+		e86_flg_add_8 (c, val, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | cf;
+	}
+}
+
+void e86_set_flg_inc_16 (e8086_t *c, unsigned short val)
+{
+	unsigned short cf;
+
+	cf = e86_flg_get_c (c);
+
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_INC_16, val, 0, cf);
+	}
+	else {
+		e86_flg_add_16 (c, val, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | cf;
+	}
+}
+
+void e86_set_flg_dec_8 (e8086_t *c, unsigned char val)
+{
+	unsigned short cf;
+
+	cf = e86_flg_get_c (c);
+
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_DEC_8, val, 0, cf);
+	}
+	else {
+		e86_flg_sub_8 (c, val, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | cf;
+	}
+}
+
+void e86_set_flg_dec_16 (e8086_t *c, unsigned short val)
+{
+	unsigned short cf;
+
+	cf = e86_flg_get_c (c);
+
+	if (c->lazy_flags) {
+		e86_flg_defer (c, E86_LAZY_DEC_16, val, 0, cf);
+	}
+	else {
+		e86_flg_sub_16 (c, val, 1);
+		c->flg = (c->flg & ~E86_FLG_C) | cf;
+	}
+}
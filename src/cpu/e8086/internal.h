@@ -92,6 +92,22 @@ void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned
 void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3);
 void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2);
 void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2);
+void e86_set_flg_inc_8 (e8086_t *c, unsigned char val);
+void e86_set_flg_inc_16 (e8086_t *c, unsigned short val);
+void e86_set_flg_dec_8 (e8086_t *c, unsigned char val);
+void e86_set_flg_dec_16 (e8086_t *c, unsigned short val);
+
+
+/*
+ * Execute a chunk of iterations of a REP string instruction. size is
+ * the element size in bytes and clk the number of clocks per iteration.
+ * The return value is used as the opcode handler's return value.
+ */
+unsigned e86_rep_movs (e8086_t *c, unsigned size, unsigned clk);
+unsigned e86_rep_cmps (e8086_t *c, unsigned size, unsigned clk);
+unsigned e86_rep_stos (e8086_t *c, unsigned size, unsigned clk);
+unsigned e86_rep_lods (e8086_t *c, unsigned size, unsigned clk);
+unsigned e86_rep_scas (e8086_t *c, unsigned size, unsigned clk);
 
 
 #endif
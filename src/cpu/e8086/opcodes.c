@@ -1125,10 +1125,10 @@ unsigned op_37 (e8086_t *c)
 	if (((al & 0x0f) > 9) || e86_get_af (c)) {
 		al += 6;
 		ah += 1;
-		c->flg |= (E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 1);
 	}
 	else {
-		c->flg &= ~(E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 0);
 	}
 
 	e86_set_ax (c, ((ah & 0xff) << 8) | (al & 0x0f));
@@ -1258,10 +1258,10 @@ unsigned op_3f (e8086_t *c)
 	if (((al & 0x0f) > 9) || e86_get_af (c)) {
 		al -= 6;
 		ah -= 1;
-		c->flg |= (E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 1);
 	}
 	else {
-		c->flg &= ~(E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 0);
 	}
 
 	e86_set_ax (c, ((ah & 0xff) << 8) | (al & 0x0f));
@@ -1276,16 +1276,13 @@ static
 unsigned op_40 (e8086_t *c)
 {
 	unsigned       r;
-	unsigned short cf;
 	unsigned long  s;
 
 	r = c->pq[0] & 7;
 	s = c->dreg[r];
 	c->dreg[r] = (s + 1) & 0xffff;
 
-	cf = c->flg;
-	e86_set_flg_add_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_inc_16 (c, s);
 
 	e86_set_clk (c, 3);
 
@@ -1297,16 +1294,13 @@ static
 unsigned op_48 (e8086_t *c)
 {
 	unsigned       r;
-	unsigned short cf;
 	unsigned long  s;
 
 	r = c->pq[0] & 7;
 	s = c->dreg[r];
 	c->dreg[r] = (s - 1) & 0xffff;
 
-	cf = c->flg;
-	e86_set_flg_sub_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_dec_16 (c, s);
 
 	e86_set_clk (c, 3);
 
@@ -2435,10 +2429,10 @@ static
 unsigned op_9c (e8086_t *c)
 {
 	if (c->cpu & E86_CPU_FLAGS286) {
-		e86_push (c, c->flg & 0x0fd5);
+		e86_push (c, e86_get_flags (c) & 0x0fd5);
 	}
 	else {
-		e86_push (c, (c->flg & 0x0fd5) | 0xf002);
+		e86_push (c, (e86_get_flags (c) & 0x0fd5) | 0xf002);
 	}
 
 	e86_set_clk (c, 10);
@@ -2450,7 +2444,7 @@ unsigned op_9c (e8086_t *c)
 static
 unsigned op_9d (e8086_t *c)
 {
-	c->flg = (e86_pop (c) & 0x0fd5) | 0xf002;
+	e86_set_flags (c, (e86_pop (c) & 0x0fd5) | 0xf002);
 	e86_set_clk (c, 8);
 
 	return (1);
@@ -2460,9 +2454,7 @@ unsigned op_9d (e8086_t *c)
 static
 unsigned op_9e (e8086_t *c)
 {
-	c->flg &= 0xff00;
-	c->flg |= e86_get_ah (c) & 0xd5;
-	c->flg |= 0x02;
+	e86_set_flags (c, (e86_get_flags (c) & 0xff00) | (e86_get_ah (c) & 0xd5) | 0x02);
 
 	e86_set_clk (c, 4);
 
@@ -2473,7 +2465,7 @@ unsigned op_9e (e8086_t *c)
 static
 unsigned op_9f (e8086_t *c)
 {
-	e86_set_ah (c, (c->flg & 0xd5) | 0x02);
+	e86_set_ah (c, (e86_get_flags (c) & 0xd5) | 0x02);
 	e86_set_clk (c, 4);
 
 	return (1);
@@ -2554,35 +2546,16 @@ unsigned op_a4 (e8086_t *c)
 	inc = e86_get_df (c) ? 0xffff : 0x0001;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			val = e86_get_mem8 (c, seg1, e86_get_si (c));
-			e86_set_mem8 (c, seg2, e86_get_di (c), val);
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 18);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_movs (c, 1, 18));
 	}
-	else {
-		val = e86_get_mem8 (c, seg1, e86_get_si (c));
-		e86_set_mem8 (c, seg2, e86_get_di (c), val);
 
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_di (c, e86_get_di (c) + inc);
+	val = e86_get_mem8 (c, seg1, e86_get_si (c));
+	e86_set_mem8 (c, seg2, e86_get_di (c), val);
 
-		e86_set_clk (c, 18);
-	}
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_di (c, e86_get_di (c) + inc);
+
+	e86_set_clk (c, 18);
 
 	return (1);
 }
@@ -2600,35 +2573,16 @@ unsigned op_a5 (e8086_t *c)
 	inc = e86_get_df (c) ? 0xfffe : 0x0002;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			val = e86_get_mem16 (c, seg1, e86_get_si (c));
-			e86_set_mem16 (c, seg2, e86_get_di (c), val);
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 18);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_movs (c, 2, 18));
 	}
-	else {
-		val = e86_get_mem16 (c, seg1, e86_get_si (c));
-		e86_set_mem16 (c, seg2, e86_get_di (c), val);
 
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_di (c, e86_get_di (c) + inc);
+	val = e86_get_mem16 (c, seg1, e86_get_si (c));
+	e86_set_mem16 (c, seg2, e86_get_di (c), val);
 
-		e86_set_clk (c, 18);
-	}
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_di (c, e86_get_di (c) + inc);
+
+	e86_set_clk (c, 18);
 
 	return (1);
 }
@@ -2640,7 +2594,6 @@ unsigned op_a6 (e8086_t *c)
 	unsigned short s1, s2;
 	unsigned short seg1, seg2;
 	unsigned short inc;
-	int            z;
 
 	seg1 = e86_get_seg (c, E86_REG_DS);
 	seg2 = e86_get_es (c);
@@ -2648,41 +2601,18 @@ unsigned op_a6 (e8086_t *c)
 	inc = e86_get_df (c) ? 0xffff : 0x0001;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_mem8 (c, seg1, e86_get_si (c));
-			s2 = e86_get_mem8 (c, seg2, e86_get_di (c));
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-
-			e86_set_flg_sub_8 (c, s1, s2);
-		}
-
-		e86_set_clk (c, 22);
-
-		z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
-
-		if ((e86_get_cx (c) == 0) || (e86_get_zf (c) != z)) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_cmps (c, 1, 22));
 	}
-	else {
-		s1 = e86_get_mem8 (c, seg1, e86_get_si (c));
-		s2 = e86_get_mem8 (c, seg2, e86_get_di (c));
 
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_di (c, e86_get_di (c) + inc);
+	s1 = e86_get_mem8 (c, seg1, e86_get_si (c));
+	s2 = e86_get_mem8 (c, seg2, e86_get_di (c));
 
-		e86_set_flg_sub_8 (c, s1, s2);
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_di (c, e86_get_di (c) + inc);
 
-		e86_set_clk (c, 22);
-	}
+	e86_set_flg_sub_8 (c, s1, s2);
+
+	e86_set_clk (c, 22);
 
 	return (1);
 }
@@ -2694,7 +2624,6 @@ unsigned op_a7 (e8086_t *c)
 	unsigned long  s1, s2;
 	unsigned short seg1, seg2;
 	unsigned short inc;
-	int            z;
 
 	seg1 = e86_get_seg (c, E86_REG_DS);
 	seg2 = e86_get_es (c);
@@ -2702,41 +2631,18 @@ unsigned op_a7 (e8086_t *c)
 	inc = e86_get_df (c) ? 0xfffe : 0x0002;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_mem16 (c, seg1, e86_get_si (c));
-			s2 = e86_get_mem16 (c, seg2, e86_get_di (c));
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-
-			e86_set_flg_sub_16 (c, s1, s2);
-		}
-
-		e86_set_clk (c, 22);
-
-		z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
-
-		if ((e86_get_cx (c) == 0) || (e86_get_zf (c) != z)) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_cmps (c, 2, 22));
 	}
-	else {
-		s1 = e86_get_mem16 (c, seg1, e86_get_si (c));
-		s2 = e86_get_mem16 (c, seg2, e86_get_di (c));
 
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_di (c, e86_get_di (c) + inc);
+	s1 = e86_get_mem16 (c, seg1, e86_get_si (c));
+	s2 = e86_get_mem16 (c, seg2, e86_get_di (c));
 
-		e86_set_flg_sub_16 (c, s1, s2);
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_di (c, e86_get_di (c) + inc);
 
-		e86_set_clk (c, 22);
-	}
+	e86_set_flg_sub_16 (c, s1, s2);
+
+	e86_set_clk (c, 22);
 
 	return (1);
 }
@@ -2782,30 +2688,13 @@ unsigned op_aa (e8086_t *c)
 	inc = e86_get_df (c) ? 0xffff : 0x0001;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			e86_set_mem8 (c, seg, e86_get_di (c), e86_get_al (c));
-
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 11);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_stos (c, 1, 11));
 	}
-	else {
-		e86_set_mem8 (c, seg, e86_get_di (c), e86_get_al (c));
-		e86_set_di (c, e86_get_di (c) + inc);
 
-		e86_set_clk (c, 11);
-	}
+	e86_set_mem8 (c, seg, e86_get_di (c), e86_get_al (c));
+	e86_set_di (c, e86_get_di (c) + inc);
+
+	e86_set_clk (c, 11);
 
 	return (1);
 }
@@ -2821,30 +2710,13 @@ unsigned op_ab (e8086_t *c)
 	inc = e86_get_df (c) ? 0xfffe : 0x0002;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			e86_set_mem16 (c, seg, e86_get_di (c), e86_get_ax (c));
-
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 11);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_stos (c, 2, 11));
 	}
-	else {
-		e86_set_mem16 (c, seg, e86_get_di (c), e86_get_ax (c));
-		e86_set_di (c, e86_get_di (c) + inc);
 
-		e86_set_clk (c, 11);
-	}
+	e86_set_mem16 (c, seg, e86_get_di (c), e86_get_ax (c));
+	e86_set_di (c, e86_get_di (c) + inc);
+
+	e86_set_clk (c, 11);
 
 	return (1);
 }
@@ -2860,29 +2732,13 @@ unsigned op_ac (e8086_t *c)
 	inc = e86_get_df (c) ? 0xffff : 0x0001;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			e86_set_al (c, e86_get_mem8 (c, seg, e86_get_si (c)));
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 12);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
-	}
-	else {
-		e86_set_al (c, e86_get_mem8 (c, seg, e86_get_si (c)));
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_clk (c, 12);
+		return (e86_rep_lods (c, 1, 12));
 	}
 
+	e86_set_al (c, e86_get_mem8 (c, seg, e86_get_si (c)));
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_clk (c, 12);
+
 	return (1);
 }
 
@@ -2897,29 +2753,13 @@ unsigned op_ad (e8086_t *c)
 	inc = e86_get_df (c) ? 0xfffe : 0x0002;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			e86_set_ax (c, e86_get_mem16 (c, seg, e86_get_si (c)));
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-		}
-
-		e86_set_clk (c, 12);
-
-		if (e86_get_cx (c) == 0) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
-	}
-	else {
-		e86_set_ax (c, e86_get_mem16 (c, seg, e86_get_si (c)));
-		e86_set_si (c, e86_get_si (c) + inc);
-		e86_set_clk (c, 12);
+		return (e86_rep_lods (c, 2, 12));
 	}
 
+	e86_set_ax (c, e86_get_mem16 (c, seg, e86_get_si (c)));
+	e86_set_si (c, e86_get_si (c) + inc);
+	e86_set_clk (c, 12);
+
 	return (1);
 }
 
@@ -2930,44 +2770,21 @@ unsigned op_ae (e8086_t *c)
 	unsigned short s1, s2;
 	unsigned short seg;
 	unsigned short inc;
-	int            z;
 
 	seg = e86_get_es (c);
 	inc = e86_get_df (c) ? 0xffff : 0x0001;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_al (c);
-			s2 = e86_get_mem8 (c, seg, e86_get_di (c));
-
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-
-			e86_set_flg_sub_8 (c, s1, s2);
-		}
-
-		e86_set_clk (c, 15);
-
-		z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
-
-		if ((e86_get_cx (c) == 0) || (e86_get_zf (c) != z)) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_scas (c, 1, 15));
 	}
-	else {
-		s1 = e86_get_al (c);
-		s2 = e86_get_mem8 (c, seg, e86_get_di (c));
 
-		e86_set_di (c, e86_get_di (c) + inc);
+	s1 = e86_get_al (c);
+	s2 = e86_get_mem8 (c, seg, e86_get_di (c));
 
-		e86_set_flg_sub_8 (c, s1, s2);
-		e86_set_clk (c, 15);
-	}
+	e86_set_di (c, e86_get_di (c) + inc);
+
+	e86_set_flg_sub_8 (c, s1, s2);
+	e86_set_clk (c, 15);
 
 	return (1);
 }
@@ -2979,44 +2796,21 @@ unsigned op_af (e8086_t *c)
 	unsigned long  s1, s2;
 	unsigned short seg;
 	unsigned short inc;
-	int            z;
 
 	seg = e86_get_es (c);
 	inc = e86_get_df (c) ? 0xfffe : 0x0002;
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
-		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_ax (c);
-			s2 = e86_get_mem16 (c, seg, e86_get_di (c));
-
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
-
-			e86_set_flg_sub_16 (c, s1, s2);
-		}
-
-		e86_set_clk (c, 15);
-
-		z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
-
-		if ((e86_get_cx (c) == 0) || (e86_get_zf (c) != z)) {
-			c->prefix &= ~E86_PREFIX_KEEP;
-			return (1);
-		}
-
-		c->prefix |= E86_PREFIX_KEEP;
-
-		return (0);
+		return (e86_rep_scas (c, 2, 15));
 	}
-	else {
-		s1 = e86_get_ax (c);
-		s2 = e86_get_mem16 (c, seg, e86_get_di (c));
 
-		e86_set_di (c, e86_get_di (c) + inc);
+	s1 = e86_get_ax (c);
+	s2 = e86_get_mem16 (c, seg, e86_get_di (c));
+
+	e86_set_di (c, e86_get_di (c) + inc);
 
-		e86_set_flg_sub_16 (c, s1, s2);
-		e86_set_clk (c, 15);
-	}
+	e86_set_flg_sub_16 (c, s1, s2);
+	e86_set_clk (c, 15);
 
 	return (1);
 }
@@ -3367,7 +3161,7 @@ unsigned op_cf (e8086_t *c)
 {
 	e86_set_ip (c, e86_pop (c));
 	e86_set_cs (c, e86_pop (c));
-	c->flg = e86_pop (c);
+	e86_set_flags (c, e86_pop (c));
 
 	e86_pq_init (c);
 
@@ -4008,7 +3802,7 @@ unsigned op_f4 (e8086_t *c)
 static
 unsigned op_f5 (e8086_t *c)
 {
-	c->flg ^= E86_FLG_C;
+	e86_set_cf (c, !e86_get_cf (c));
 	e86_set_clk (c, 2);
 
 	return (1);
@@ -4471,7 +4265,6 @@ unsigned op_fe (e8086_t *c)
 {
 	unsigned       xop;
 	unsigned short d, s;
-	unsigned short cf;
 
 	xop = (c->pq[1] >> 3) & 7;
 
@@ -4484,9 +4277,7 @@ unsigned op_fe (e8086_t *c)
 
 			e86_set_ea8 (c, d);
 
-			cf = c->flg;
-			e86_set_flg_add_8 (c, s, 1);
-			c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+			e86_set_flg_inc_8 (c, s);
 
 			e86_set_clk_ea (c, 3, 15);
 
@@ -4500,9 +4291,7 @@ unsigned op_fe (e8086_t *c)
 
 			e86_set_ea8 (c, d);
 
-			cf = c->flg;
-			e86_set_flg_sub_8 (c, s, 1);
-			c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+			e86_set_flg_dec_8 (c, s);
 
 			e86_set_clk_ea (c, 3, 15);
 
@@ -4520,7 +4309,6 @@ static
 unsigned op_ff_00 (e8086_t *c)
 {
 	unsigned long  s, d;
-	unsigned short cf;
 
 	e86_get_ea_ptr (c, c->pq + 1);
 
@@ -4529,9 +4317,7 @@ unsigned op_ff_00 (e8086_t *c)
 
 	e86_set_ea16 (c, d);
 
-	cf = c->flg;
-	e86_set_flg_add_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_inc_16 (c, s);
 
 	e86_set_clk_ea (c, 3, 15);
 
@@ -4543,7 +4329,6 @@ static
 unsigned op_ff_01 (e8086_t *c)
 {
 	unsigned long  s, d;
-	unsigned short cf;
 
 	e86_get_ea_ptr (c, c->pq + 1);
 
@@ -4552,9 +4337,7 @@ unsigned op_ff_01 (e8086_t *c)
 
 	e86_set_ea16 (c, d);
 
-	cf = c->flg;
-	e86_set_flg_sub_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_dec_16 (c, s);
 
 	e86_set_clk_ea (c, 3, 15);
 
@@ -0,0 +1,602 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e8086/rep.c                                          *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include "e8086.h"
+#include "internal.h"
+
+#include <string.h>
+
+
+/*
+ * The maximum number of clocks that are spent in one chunk of a
+ * REP string instruction. Interrupts are only taken between chunks.
+ */
+#define E86_REP_CLK 1024
+
+
+static inline
+unsigned e86_rep_get_mem (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned size)
+{
+	if (size == 1) {
+		return (e86_get_mem8 (c, seg, ofs));
+	}
+
+	return (e86_get_mem16 (c, seg, ofs));
+}
+
+static inline
+void e86_rep_set_mem (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned size, unsigned val)
+{
+	if (size == 1) {
+		e86_set_mem8 (c, seg, ofs, val);
+	}
+	else {
+		e86_set_mem16 (c, seg, ofs, val);
+	}
+}
+
+static inline
+unsigned e86_rep_get_ram_val (const unsigned char *p, unsigned size)
+{
+	if (size == 1) {
+		return (p[0]);
+	}
+
+	return (p[0] | (p[1] << 8));
+}
+
+static inline
+void e86_rep_set_flg_sub (e8086_t *c, unsigned s1, unsigned s2, unsigned size)
+{
+	if (size == 1) {
+		e86_set_flg_sub_8 (c, s1, s2);
+	}
+	else {
+		e86_set_flg_sub_16 (c, s1, s2);
+	}
+}
+
+/*
+ * Get the number of iterations of a REP string instruction that are
+ * executed at once. Each iteration takes clk clocks.
+ */
+static
+unsigned e86_rep_get_cnt (e8086_t *c, unsigned clk)
+{
+	unsigned cnt, max;
+
+	cnt = e86_get_cx (c);
+
+	if (cnt <= 1) {
+		return (cnt);
+	}
+
+	/* the hooks and the trap flag see every iteration */
+	if ((c->op_stat != NULL) || (c->trace_exec != NULL)) {
+		return (1);
+	}
+
+	if (c->save_flags & E86_FLG_T) {
+		return (1);
+	}
+
+	/* a pending interrupt is taken after the next iteration */
+	if (c->irq && e86_get_if (c)) {
+		return (1);
+	}
+
+	/* e86_execute() adds 10 clocks to each but the last iteration */
+	max = E86_REP_CLK / (clk + 10);
+
+	return ((cnt < max) ? cnt : max);
+}
+
+/*
+ * Finish cnt iterations of a REP string instruction. If done is false,
+ * the instruction will be executed again.
+ */
+static
+unsigned e86_rep_done (e8086_t *c, unsigned cnt, unsigned clk, int done)
+{
+	if (cnt > 1) {
+		/* account for the e86_execute() calls that were saved */
+		c->opcnt += cnt - 1;
+		e86_set_clk (c, (cnt - 1) * (clk + 10));
+	}
+
+	e86_set_clk (c, clk);
+
+	if (done) {
+		c->prefix &= ~E86_PREFIX_KEEP;
+		return (1);
+	}
+
+	c->prefix |= E86_PREFIX_KEEP;
+
+	return (0);
+}
+
+/*
+ * Get the linear address of the lowest byte of cnt elements of size
+ * bytes, starting at seg:ofs in the direction given by DF. Returns
+ * non-zero if the elements wrap around at the end of the segment or
+ * of the address space.
+ */
+static
+int e86_rep_get_lin (e8086_t *c, unsigned short seg, unsigned short ofs,
+	unsigned cnt, unsigned size, unsigned long *lin)
+{
+	unsigned long n, o;
+
+	n = (unsigned long) cnt * size;
+	o = ofs;
+
+	if (e86_get_df (c)) {
+		if ((o + size) < n) {
+			return (1);
+		}
+
+		o = o + size - n;
+	}
+	else if ((o + n) > 0x10000) {
+		return (1);
+	}
+
+	*lin = e86_get_linear (seg, o) & c->addr_mask;
+
+	if ((*lin + n - 1) > c->addr_mask) {
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Get a pointer to the lowest byte of cnt elements in ram or NULL
+ * if they are not all in ram.
+ */
+static
+unsigned char *e86_rep_get_ram (e8086_t *c, unsigned short seg, unsigned short ofs,
+	unsigned cnt, unsigned size)
+{
+	unsigned long lin;
+
+	if (e86_rep_get_lin (c, seg, ofs, cnt, size, &lin)) {
+		return (NULL);
+	}
+
+	if ((lin + (unsigned long) cnt * size) > c->ram_cnt) {
+		return (NULL);
+	}
+
+	return (c->ram + lin);
+}
+
+static
+void e86_rep_set_blk (e8086_t *c, unsigned long addr, const unsigned char *buf, unsigned long cnt)
+{
+	unsigned long n;
+
+	while (cnt > 0) {
+		n = c->mem_set_blk (c->mem, addr, buf, cnt);
+
+		addr += n;
+		buf += n;
+		cnt -= n;
+	}
+}
+
+/*
+ * Check if the bulk path can write outside of ram with mem_set_blk()
+ */
+static
+int e86_rep_use_blk (e8086_t *c, unsigned short seg, unsigned short ofs,
+	unsigned cnt, unsigned size, unsigned long *lin)
+{
+	if ((c->mem_set_blk == NULL) || e86_get_df (c)) {
+		return (0);
+	}
+
+	if (e86_rep_get_lin (c, seg, ofs, cnt, size, lin)) {
+		return (0);
+	}
+
+	return (1);
+}
+
+/*
+ * Check if copying n bytes from src to dst element by element in the
+ * direction given by DF gives the same result as memmove(). This is
+ * the case if no element is read after it was written.
+ */
+static
+int e86_rep_can_move (e8086_t *c, unsigned long src, unsigned long dst, unsigned long n)
+{
+	if (e86_get_df (c)) {
+		return ((dst >= src) || ((dst + n) <= src));
+	}
+
+	return ((dst <= src) || (dst >= (src + n)));
+}
+
+unsigned e86_rep_movs (e8086_t *c, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned short seg1, seg2, si, di, inc;
+	unsigned long  n, lin;
+	unsigned char  *src, *dst;
+	int            bulk;
+
+	seg1 = e86_get_seg (c, E86_REG_DS);
+	seg2 = e86_get_es (c);
+	si = e86_get_si (c);
+	di = e86_get_di (c);
+	inc = e86_get_df (c) ? (0x10000 - size) : size;
+
+	cnt = e86_rep_get_cnt (c, clk);
+	n = (unsigned long) cnt * size;
+
+	bulk = 0;
+
+	if (cnt > 1) {
+		src = e86_rep_get_ram (c, seg1, si, cnt, size);
+		dst = e86_rep_get_ram (c, seg2, di, cnt, size);
+
+		if ((src != NULL) && (dst != NULL)) {
+			if (e86_rep_can_move (c, src - c->ram, dst - c->ram, n)) {
+				memmove (dst, src, n);
+				e86_dirty_ram (c, dst - c->ram, n);
+				bulk = 1;
+			}
+		}
+		else if ((src != NULL) && e86_rep_use_blk (c, seg2, di, cnt, size, &lin)) {
+			if (e86_rep_can_move (c, src - c->ram, lin, n)) {
+				e86_rep_set_blk (c, lin, src, n);
+				bulk = 1;
+			}
+		}
+	}
+
+	if (bulk) {
+		si += cnt * inc;
+		di += cnt * inc;
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			e86_rep_set_mem (c, seg2, di, size, e86_rep_get_mem (c, seg1, si, size));
+
+			si += inc;
+			di += inc;
+
+			if (c->irq && e86_get_if (c)) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+	}
+
+	e86_set_si (c, si);
+	e86_set_di (c, di);
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	return (e86_rep_done (c, cnt, clk, e86_get_cx (c) == 0));
+}
+
+unsigned e86_rep_stos (e8086_t *c, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned short seg, di, inc;
+	unsigned       val;
+	unsigned long  j, n, lin;
+	unsigned char  *dst;
+	unsigned char  buf[256];
+	int            bulk;
+
+	seg = e86_get_es (c);
+	di = e86_get_di (c);
+	inc = e86_get_df (c) ? (0x10000 - size) : size;
+	val = (size == 1) ? e86_get_al (c) : e86_get_ax (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+
+	bulk = 0;
+
+	if (cnt > 1) {
+		if ((dst = e86_rep_get_ram (c, seg, di, cnt, size)) == NULL) {
+			if (((unsigned long) cnt * size) > sizeof (buf)) {
+				cnt = sizeof (buf) / size;
+			}
+
+			if (e86_rep_use_blk (c, seg, di, cnt, size, &lin)) {
+				dst = buf;
+			}
+		}
+
+		if (dst != NULL) {
+			n = (unsigned long) cnt * size;
+
+			if ((size == 1) || ((val & 0xff) == (val >> 8))) {
+				memset (dst, val & 0xff, n);
+			}
+			else {
+				for (j = 0; j < n; j += 2) {
+					dst[j] = val & 0xff;
+					dst[j + 1] = (val >> 8) & 0xff;
+				}
+			}
+
+			if (dst == buf) {
+				e86_rep_set_blk (c, lin, buf, n);
+			}
+			else {
+				e86_dirty_ram (c, dst - c->ram, n);
+			}
+
+			bulk = 1;
+		}
+	}
+
+	if (bulk) {
+		di += cnt * inc;
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			e86_rep_set_mem (c, seg, di, size, val);
+
+			di += inc;
+
+			if (c->irq && e86_get_if (c)) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+	}
+
+	e86_set_di (c, di);
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	return (e86_rep_done (c, cnt, clk, e86_get_cx (c) == 0));
+}
+
+unsigned e86_rep_lods (e8086_t *c, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned short seg, si, inc;
+	unsigned       val;
+	unsigned char  *src;
+
+	seg = e86_get_seg (c, E86_REG_DS);
+	si = e86_get_si (c);
+	inc = e86_get_df (c) ? (0x10000 - size) : size;
+
+	cnt = e86_rep_get_cnt (c, clk);
+
+	src = NULL;
+
+	if (cnt > 1) {
+		src = e86_rep_get_ram (c, seg, si, cnt, size);
+	}
+
+	if (src != NULL) {
+		/* only the last element is kept */
+		if (e86_get_df (c) == 0) {
+			src += (unsigned long) (cnt - 1) * size;
+		}
+
+		val = e86_rep_get_ram_val (src, size);
+
+		si += cnt * inc;
+	}
+	else {
+		val = (size == 1) ? e86_get_al (c) : e86_get_ax (c);
+
+		for (i = 0; i < cnt; i++) {
+			val = e86_rep_get_mem (c, seg, si, size);
+
+			si += inc;
+
+			if (c->irq && e86_get_if (c)) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+	}
+
+	if (size == 1) {
+		e86_set_al (c, val);
+	}
+	else {
+		e86_set_ax (c, val);
+	}
+
+	e86_set_si (c, si);
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	return (e86_rep_done (c, cnt, clk, e86_get_cx (c) == 0));
+}
+
+unsigned e86_rep_cmps (e8086_t *c, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned short seg1, seg2, si, di, inc;
+	unsigned       s1, s2;
+	unsigned long  ofs;
+	unsigned char  *src, *dst;
+	int            z;
+
+	seg1 = e86_get_seg (c, E86_REG_DS);
+	seg2 = e86_get_es (c);
+	si = e86_get_si (c);
+	di = e86_get_di (c);
+	inc = e86_get_df (c) ? (0x10000 - size) : size;
+	z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
+
+	cnt = e86_rep_get_cnt (c, clk);
+
+	src = NULL;
+	dst = NULL;
+
+	if (cnt > 1) {
+		src = e86_rep_get_ram (c, seg1, si, cnt, size);
+		dst = e86_rep_get_ram (c, seg2, di, cnt, size);
+	}
+
+	if ((src != NULL) && (dst != NULL)) {
+		s1 = 0;
+		s2 = 0;
+
+		for (i = 0; i < cnt; i++) {
+			if (e86_get_df (c)) {
+				ofs = (unsigned long) (cnt - i - 1) * size;
+			}
+			else {
+				ofs = (unsigned long) i * size;
+			}
+
+			s1 = e86_rep_get_ram_val (src + ofs, size);
+			s2 = e86_rep_get_ram_val (dst + ofs, size);
+
+			if ((s1 == s2) != z) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+
+		si += cnt * inc;
+		di += cnt * inc;
+
+		e86_rep_set_flg_sub (c, s1, s2, size);
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			s1 = e86_rep_get_mem (c, seg1, si, size);
+			s2 = e86_rep_get_mem (c, seg2, di, size);
+
+			si += inc;
+			di += inc;
+
+			e86_rep_set_flg_sub (c, s1, s2, size);
+
+			if ((s1 == s2) != z) {
+				i += 1;
+				break;
+			}
+
+			if (c->irq && e86_get_if (c)) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+	}
+
+	e86_set_si (c, si);
+	e86_set_di (c, di);
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	return (e86_rep_done (c, cnt, clk, (e86_get_cx (c) == 0) || (e86_get_zf (c) != z)));
+}
+
+unsigned e86_rep_scas (e8086_t *c, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned short seg, di, inc;
+	unsigned       s1, s2;
+	unsigned long  ofs;
+	unsigned char  *dst;
+	int            z;
+
+	seg = e86_get_es (c);
+	di = e86_get_di (c);
+	inc = e86_get_df (c) ? (0x10000 - size) : size;
+	z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
+	s1 = (size == 1) ? e86_get_al (c) : e86_get_ax (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+
+	dst = NULL;
+
+	if (cnt > 1) {
+		dst = e86_rep_get_ram (c, seg, di, cnt, size);
+	}
+
+	if (dst != NULL) {
+		s2 = 0;
+
+		for (i = 0; i < cnt; i++) {
+			if (e86_get_df (c)) {
+				ofs = (unsigned long) (cnt - i - 1) * size;
+			}
+			else {
+				ofs = (unsigned long) i * size;
+			}
+
+			s2 = e86_rep_get_ram_val (dst + ofs, size);
+
+			if ((s1 == s2) != z) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+
+		di += cnt * inc;
+
+		e86_rep_set_flg_sub (c, s1, s2, size);
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			s2 = e86_rep_get_mem (c, seg, di, size);
+
+			di += inc;
+
+			e86_rep_set_flg_sub (c, s1, s2, size);
+
+			if ((s1 == s2) != z) {
+				i += 1;
+				break;
+			}
+
+			if (c->irq && e86_get_if (c)) {
+				i += 1;
+				break;
+			}
+		}
+
+		cnt = i;
+	}
+
+	e86_set_di (c, di);
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	return (e86_rep_done (c, cnt, clk, (e86_get_cx (c) == 0) || (e86_get_zf (c) != z)));
+}
@@ -0,0 +1,419 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/ppc405/bcache.c                                      *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ppc405.h"
+#include "internal.h"
+
+
+static
+void p405_bc_free_pages (p405_bcache_t *bc)
+{
+	free (bc->code);
+	free (bc->gen);
+
+	bc->code = NULL;
+	bc->gen = NULL;
+	bc->page_cnt = 0;
+}
+
+/*
+ * Allocate the page maps. Only complete 1K pages of ram are cached.
+ */
+static
+int p405_bc_alloc_pages (p405_t *c)
+{
+	unsigned long cnt;
+	p405_bcache_t *bc;
+
+	bc = c->bc;
+
+	p405_bc_free_pages (bc);
+
+	cnt = c->ram_cnt >> 10;
+
+	if (cnt == 0) {
+		return (0);
+	}
+
+	bc->code = calloc (cnt, 1);
+	bc->gen = calloc (cnt, sizeof (uint32_t));
+
+	if ((bc->code == NULL) || (bc->gen == NULL)) {
+		p405_bc_free_pages (bc);
+		return (1);
+	}
+
+	bc->page_cnt = cnt;
+
+	return (0);
+}
+
+int p405_set_bcache (p405_t *c, int enable, int check)
+{
+	p405_bcache_t *bc;
+
+	c->bc_blk = NULL;
+
+	if (enable == 0) {
+		if (c->bc != NULL) {
+			p405_bc_free_pages (c->bc);
+			free (c->bc);
+			c->bc = NULL;
+		}
+
+		return (0);
+	}
+
+	if (c->bc == NULL) {
+		if ((bc = malloc (sizeof (p405_bcache_t))) == NULL) {
+			return (1);
+		}
+
+		bc->code = NULL;
+		bc->gen = NULL;
+		bc->page_cnt = 0;
+
+		bc->hit = 0;
+		bc->miss = 0;
+		bc->check_err = 0;
+
+		c->bc = bc;
+	}
+
+	c->bc->check = (check != 0);
+
+	if (p405_bc_alloc_pages (c)) {
+		p405_set_bcache (c, 0, 0);
+		return (1);
+	}
+
+	p405_bcache_flush (c);
+
+	return (0);
+}
+
+void p405_bcache_flush (p405_t *c)
+{
+	unsigned      i;
+	p405_bcache_t *bc;
+
+	c->bc_blk = NULL;
+
+	if ((bc = c->bc) == NULL) {
+		return;
+	}
+
+	for (i = 0; i < P405_BC_BLOCKS; i++) {
+		bc->blk[i].cnt = 0;
+	}
+
+	if (bc->code != NULL) {
+		memset (bc->code, 0, bc->page_cnt);
+	}
+}
+
+void p405_bcache_invalidate (p405_t *c, uint32_t raddr)
+{
+	uint32_t      page;
+	p405_bcache_t *bc;
+
+	bc = c->bc;
+	page = raddr >> 10;
+
+	if (page >= bc->page_cnt) {
+		return;
+	}
+
+	bc->code[page] = 0;
+	bc->gen[page] += 1;
+
+	if (c->bc_blk != NULL) {
+		if ((c->bc_blk->raddr >> 10) == page) {
+			c->bc_blk = NULL;
+		}
+	}
+}
+
+void p405_bcache_icbi (p405_t *c, uint32_t ea)
+{
+	int e;
+
+	if (c->bc == NULL) {
+		return;
+	}
+
+	if (p405_translate (c, &ea, &e, P405_XLAT_CPU)) {
+		p405_bcache_flush (c);
+		return;
+	}
+
+	p405_bcache_store (c, ea);
+}
+
+/*
+ * Check if an instruction must be the last one in a block. These are
+ * the branches and all instructions that may change the address
+ * translation, the memory map or the instruction cache.
+ */
+static
+int p405_bc_is_last (p405_t *c, uint32_t ir)
+{
+	unsigned sprf, sprn;
+
+	if (p405_get_opcode_fct (c, ir) == p405_op_undefined) {
+		return (1);
+	}
+
+	switch ((ir >> 26) & 0x3f) {
+	case 0x10: /* bc */
+	case 0x11: /* sc */
+	case 0x12: /* b */
+		return (1);
+
+	case 0x13:
+		switch ((ir >> 1) & 0x3ff) {
+		case 0x000: /* mcrf */
+		case 0x021: /* crnor */
+		case 0x081: /* crandc */
+		case 0x0c1: /* crxor */
+		case 0x0e1: /* crnand */
+		case 0x101: /* crand */
+		case 0x121: /* creqv */
+		case 0x1a1: /* crorc */
+		case 0x1c1: /* cror */
+			return (0);
+		}
+
+		return (1);
+
+	case 0x1f:
+		switch ((ir >> 1) & 0x3ff) {
+		case 0x083: /* wrtee */
+		case 0x092: /* mtmsr */
+		case 0x0a3: /* wrteei */
+		case 0x143: /* mfdcr */
+		case 0x172: /* tlbia */
+		case 0x1c3: /* mtdcr */
+		case 0x1c6: /* dccci */
+		case 0x3c6: /* iccci */
+		case 0x3d2: /* tlbwe */
+		case 0x3d6: /* icbi */
+			return (1);
+
+		case 0x1d3: /* mtspr */
+			sprf = (ir >> 11) & 0x3ff;
+			sprn = ((sprf & 0x1f) << 5) | ((sprf >> 5) & 0x1f);
+
+			switch (sprn) {
+			case P405_SPRN_CTR:
+			case P405_SPRN_LR:
+			case P405_SPRN_XER:
+				return (0);
+			}
+
+			return (1);
+		}
+
+		return (0);
+	}
+
+	return (0);
+}
+
+static
+void p405_bc_build (p405_t *c, p405_bc_blk_t *blk, uint32_t raddr, int e)
+{
+	uint32_t      ir;
+	unsigned char *mem;
+
+	blk->cnt = 0;
+
+	while (blk->cnt < P405_BC_INSNS) {
+		mem = &c->ram[raddr];
+
+		if (e) {
+			ir = (mem[3] << 24) | (mem[2] << 16) | (mem[1] << 8) | mem[0];
+		}
+		else {
+			ir = (mem[0] << 24) | (mem[1] << 16) | (mem[2] << 8) | mem[3];
+		}
+
+		blk->insn[blk->cnt].ir = ir;
+		blk->insn[blk->cnt].fct = p405_get_opcode_fct (c, ir);
+		blk->cnt += 1;
+
+		if (p405_bc_is_last (c, ir)) {
+			break;
+		}
+
+		raddr += 4;
+
+		if ((raddr & 0x3ff) == 0) {
+			break;
+		}
+	}
+}
+
+/*
+ * Get the block for the current pc. Returns 0 if successful, 1 if an
+ * exception occurred and 2 if the address can't be cached.
+ */
+static
+int p405_bc_get_blk (p405_t *c, p405_bc_blk_t **ret)
+{
+	int           e;
+	uint32_t      raddr, page, key;
+	p405_bcache_t *bc;
+	p405_bc_blk_t *blk;
+
+	bc = c->bc;
+	raddr = c->pc;
+
+	if (p405_translate_exec (c, &raddr, &e)) {
+		return (1);
+	}
+
+	raddr &= ~0x03UL;
+	page = raddr >> 10;
+
+	if (page >= bc->page_cnt) {
+		return (2);
+	}
+
+	key = (p405_get_msr (c) & (P405_MSR_IR | P405_MSR_PR)) | (e != 0);
+
+	blk = &bc->blk[((raddr >> 2) ^ (raddr >> 13)) & (P405_BC_BLOCKS - 1)];
+
+	if ((blk->cnt > 0) && (blk->raddr == raddr) && (blk->key == key)) {
+		if (blk->gen == bc->gen[page]) {
+			bc->hit += 1;
+			*ret = blk;
+			return (0);
+		}
+	}
+
+	bc->miss += 1;
+
+	blk->raddr = raddr;
+	blk->key = key;
+	blk->gen = bc->gen[page];
+
+	p405_bc_build (c, blk, raddr, e);
+
+	bc->code[page] = 1;
+
+	*ret = blk;
+
+	return (0);
+}
+
+/*
+ * Fetch and decode the instruction a second time, the way it is done
+ * without the block cache, and compare the results.
+ */
+static
+int p405_bc_check (p405_t *c, p405_opcode_f *fct)
+{
+	uint32_t ir;
+
+	ir = c->ir;
+
+	if (p405_ifetch (c, c->pc, &c->ir)) {
+		c->bc->check_err += 1;
+		c->bc_blk = NULL;
+
+		fprintf (stderr, "ppc405: block cache: fetch exception at %08lX\n",
+			(unsigned long) c->pc
+		);
+
+		return (1);
+	}
+
+	if ((c->ir != ir) || (*fct != p405_get_opcode_fct (c, c->ir))) {
+		c->bc->check_err += 1;
+		c->bc_blk = NULL;
+
+		fprintf (stderr, "ppc405: block cache: mismatch at %08lX (%08lX %08lX)\n",
+			(unsigned long) c->pc, (unsigned long) ir, (unsigned long) c->ir
+		);
+
+		*fct = p405_get_opcode_fct (c, c->ir);
+	}
+
+	return (0);
+}
+
+int p405_bcache_fetch (p405_t *c, p405_opcode_f *fct)
+{
+	int            r;
+	p405_bc_blk_t  *blk;
+	p405_bc_insn_t *ins;
+
+	blk = c->bc_blk;
+
+	if ((blk == NULL) || (c->pc != c->bc_pc)) {
+		r = p405_bc_get_blk (c, &blk);
+
+		if (r == 1) {
+			c->bc_blk = NULL;
+			return (1);
+		}
+		else if (r == 2) {
+			c->bc_blk = NULL;
+
+			if (p405_ifetch (c, c->pc, &c->ir)) {
+				return (1);
+			}
+
+			*fct = p405_get_opcode_fct (c, c->ir);
+
+			return (0);
+		}
+
+		c->bc_idx = 0;
+	}
+
+	ins = &blk->insn[c->bc_idx];
+
+	c->bc_idx += 1;
+
+	if (c->bc_idx < blk->cnt) {
+		c->bc_blk = blk;
+		c->bc_pc = c->pc + 4;
+	}
+	else {
+		c->bc_blk = NULL;
+	}
+
+	c->ir = ins->ir;
+	*fct = ins->fct;
+
+	if (c->bc->check) {
+		return (p405_bc_check (c, fct));
+	}
+
+	return (0);
+}
@@ -51,6 +51,8 @@ uint32_t p405_get_tlb_entry_tid (p405_t *c, unsigned idx);
 
 void p405_tlb_invalidate_all (p405_t *c);
 
+int p405_translate_exec (p405_t *c, uint32_t *ea, int *e);
+
 int p405_ifetch (p405_t *c, uint32_t addr, uint32_t *val);
 
 int p405_dload8 (p405_t *c, uint32_t addr, uint8_t *val);
@@ -62,6 +64,41 @@ int p405_dstore16 (p405_t *c, uint32_t addr, uint16_t val);
 int p405_dstore32 (p405_t *c, uint32_t addr, uint32_t val);
 
 
+/*****************************************************************************
+ * block cache
+ *****************************************************************************/
+
+int p405_bcache_fetch (p405_t *c, p405_opcode_f *fct);
+void p405_bcache_invalidate (p405_t *c, uint32_t raddr);
+void p405_bcache_icbi (p405_t *c, uint32_t ea);
+
+/*
+ * Invalidate the blocks in the page containing raddr after a store
+ */
+static inline
+void p405_bcache_store (p405_t *c, uint32_t raddr)
+{
+	if (c->bc != NULL) {
+		if (((raddr >> 10) < c->bc->page_cnt) && c->bc->code[raddr >> 10]) {
+			p405_bcache_invalidate (c, raddr);
+		}
+	}
+}
+
+/*
+ * Mark the page containing raddr in the dirty page map after a store
+ */
+static inline
+void p405_dirty_ram (p405_t *c, uint32_t raddr)
+{
+	unsigned char *map;
+
+	if ((c->ram_dirty != NULL) && ((map = *c->ram_dirty) != NULL)) {
+		map[raddr >> c->ram_dirty_shift] = 0xff;
+	}
+}
+
+
 /*****************************************************************************
  * PPC
  *****************************************************************************/
@@ -158,6 +195,23 @@ void p405_set_opcode1f (p405_t *c);
 void p405_set_opcodes (p405_t *c);
 
 
+static inline
+p405_opcode_f p405_get_opcode_fct (p405_t *c, uint32_t ir)
+{
+	unsigned op;
+
+	op = (ir >> 26) & 0x3f;
+
+	if (op == 0x1f) {
+		return (c->opcodes.op1f[(ir >> 1) & 0x3ff]);
+	}
+	else if (op == 0x13) {
+		return (c->opcodes.op13[(ir >> 1) & 0x3ff]);
+	}
+
+	return (c->opcodes.op[op]);
+}
+
 static inline
 int p405_check_reserved (p405_t *c, uint32_t res)
 {
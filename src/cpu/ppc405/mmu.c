@@ -67,6 +67,9 @@ void p405_tbuf_clear (p405_t *c)
 	c->tlb.tbuf_exec = NULL;
 	c->tlb.tbuf_read = NULL;
 	c->tlb.tbuf_write = NULL;
+
+	/* the current block was translated with the old state */
+	c->bc_blk = NULL;
 }
 
 static inline
@@ -624,6 +627,9 @@ int p405_dstore8 (p405_t *c, uint32_t addr, uint8_t val)
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+
+		p405_bcache_store (c, addr);
+		p405_dirty_ram (c, addr);
 	}
 	else if (c->set_uint8 != NULL) {
 		c->set_uint8 (c->mem_ext, addr, val);
@@ -672,6 +678,11 @@ int p405_dstore16 (p405_t *c, uint32_t addr, uint16_t val)
 			mem[0] = (val >> 8) & 0xff;
 			mem[1] = val & 0xff;
 		}
+
+		p405_bcache_store (c, addr);
+		p405_bcache_store (c, addr + 1);
+		p405_dirty_ram (c, addr);
+		p405_dirty_ram (c, addr + 1);
 	}
 	else if (c->set_uint16 != NULL) {
 		if (e) {
@@ -735,6 +746,11 @@ int p405_dstore32 (p405_t *c, uint32_t addr, uint32_t val)
 			mem[2] = (val >> 8) & 0xff;
 			mem[3] = val & 0xff;
 		}
+
+		p405_bcache_store (c, addr);
+		p405_bcache_store (c, addr + 3);
+		p405_dirty_ram (c, addr);
+		p405_dirty_ram (c, addr + 3);
 	}
 	else if (c->set_uint32 != NULL) {
 		if (e) {
@@ -810,6 +826,7 @@ int p405_set_xlat8 (p405_t *c, uint32_t addr, unsigned xlat, uint8_t val)
 	}
 
 	p405_set_mem8 (c, addr, val);
+	p405_bcache_store (c, addr);
 
 	return (0);
 }
@@ -827,6 +844,7 @@ int p405_set_xlat16 (p405_t *c, uint32_t addr, unsigned xlat, uint16_t val)
 	}
 
 	p405_set_mem16 (c, addr, val);
+	p405_bcache_store (c, addr);
 
 	return (0);
 }
@@ -844,6 +862,7 @@ int p405_set_xlat32 (p405_t *c, uint32_t addr, unsigned xlat, uint32_t val)
 	}
 
 	p405_set_mem32 (c, addr, val);
+	p405_bcache_store (c, addr);
 
 	return (0);
 }
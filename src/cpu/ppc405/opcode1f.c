@@ -2379,6 +2379,8 @@ void op_1f_3c6 (p405_t *c)
 		return;
 	}
 
+	p405_bcache_flush (c);
+
 	p405_set_clk (c, 4, 1);
 }
 
@@ -2446,10 +2448,18 @@ void op_1f_3d2 (p405_t *c)
 static
 void op_1f_3d6 (p405_t *c)
 {
+	uint32_t ea;
+
 	if (p405_check_reserved (c, 0x03e00001UL)) {
 		return;
 	}
 
+	if (p405_get_ea (c, &ea, 1, 0)) {
+		return;
+	}
+
+	p405_bcache_icbi (c, ea);
+
 	p405_set_clk (c, 4, 1);
 }
 
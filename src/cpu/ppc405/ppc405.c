@@ -49,6 +49,9 @@ void p405_init (p405_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	c->ram_dirty = NULL;
+	c->ram_dirty_shift = 0;
+
 	c->dcr_ext = NULL;
 	c->get_dcr = NULL;
 	c->set_dcr = NULL;
@@ -64,12 +67,23 @@ void p405_init (p405_t *c)
 	c->log_undef = NULL;
 	c->log_mem = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
+	c->bc = NULL;
+	c->bc_blk = NULL;
+	c->bc_idx = 0;
+	c->bc_pc = 0;
+
 	p405_set_opcodes (c);
 	p405_tlb_init (&c->tlb);
 
 	c->pvr = P405_PVR_405GP;
 
 	c->timer_extra_clock = 0;
+
+	c->tb_pend = 0;
+	c->tb_next = 0;
 }
 
 p405_t *p405_new (void)
@@ -87,6 +101,7 @@ p405_t *p405_new (void)
 
 void p405_free (p405_t *c)
 {
+	p405_set_bcache (c, 0, 0);
 }
 
 void p405_del (p405_t *c)
@@ -117,6 +132,16 @@ void p405_set_ram (p405_t *c, unsigned char *ram, unsigned long cnt)
 {
 	c->ram = ram;
 	c->ram_cnt = cnt;
+
+	if (c->bc != NULL) {
+		p405_set_bcache (c, 1, c->bc->check);
+	}
+}
+
+void p405_set_ram_dirty_map (p405_t *c, unsigned char **map, unsigned shift)
+{
+	c->ram_dirty = map;
+	c->ram_dirty_shift = shift;
 }
 
 void p405_set_dcr_fct (p405_t *c, void *ext, void *get, void *set)
@@ -138,6 +163,12 @@ void p405_set_trap_fct (p405_t *c, void *ext, void *fct)
 	c->trap = fct;
 }
 
+void p405_set_trace_fct (p405_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 
 unsigned long p405_get_opcnt (p405_t *c)
 {
@@ -297,6 +328,8 @@ int p405_set_reg (p405_t *c, const char *reg, unsigned long val)
 {
 	unsigned idx;
 
+	c->bc_blk = NULL;
+
 	if (reg[0] == '%') {
 		reg += 1;
 	}
@@ -422,12 +455,99 @@ void p405_update_interrupt (p405_t *c)
 	c->interrupt |= val;
 }
 
+/*
+ * Get the number of time base clocks until the next fit event. The fit
+ * fires when the fit_mask bit in tbl changes from 0 to 1.
+ */
+static
+uint32_t p405_get_fit_clock (const p405_t *c)
+{
+	uint32_t msk, n;
+
+	msk = c->fit_mask;
+
+	n = (msk - (c->tbl & (2 * msk - 1))) & (2 * msk - 1);
+
+	if (n == 0) {
+		n = 2 * msk;
+	}
+
+	return (n);
+}
+
+/*
+ * Get the number of time base clocks until the next pit or fit event.
+ */
+static
+void p405_tb_set_next (p405_t *c)
+{
+	uint32_t n;
+
+	n = p405_get_fit_clock (c);
+
+	if ((c->pit[0] > 0) && (c->pit[0] < n)) {
+		n = c->pit[0];
+	}
+
+	c->tb_next = n;
+}
+
+uint32_t p405_get_tbl (p405_t *c)
+{
+	p405_clock_tb (c, 0);
+
+	return (c->tbl);
+}
+
+uint32_t p405_get_tbu (p405_t *c)
+{
+	p405_clock_tb (c, 0);
+
+	return (c->tbu);
+}
+
+uint32_t p405_get_pit (p405_t *c, unsigned n)
+{
+	p405_clock_tb (c, 0);
+
+	return (c->pit[n & 1]);
+}
+
+void p405_set_tbl (p405_t *c, uint32_t val)
+{
+	p405_clock_tb (c, 0);
+
+	c->tbl = val;
+
+	p405_tb_set_next (c);
+}
+
+void p405_set_tbu (p405_t *c, uint32_t val)
+{
+	p405_clock_tb (c, 0);
+
+	c->tbu = val;
+}
+
+void p405_set_pit (p405_t *c, unsigned n, uint32_t val)
+{
+	p405_clock_tb (c, 0);
+
+	c->pit[n & 1] = val;
+
+	p405_tb_set_next (c);
+}
+
 void p405_set_tcr (p405_t *c, uint32_t val)
 {
+	p405_clock_tb (c, 0);
+
 	c->tcr = val;
 
 	c->fit_mask = 0x100UL << ((val >> 22) & 0x0c);
 
+	p405_tb_set_next (c);
+
 	p405_update_interrupt (c);
 }
 
@@ -722,15 +842,46 @@ void p405_reset (p405_t *c)
 
 	c->timer_extra_clock = 0;
 
+	c->tb_pend = 0;
+	p405_tb_set_next (c);
+
 	p405_tlb_init (&c->tlb);
+
+	p405_bcache_flush (c);
+}
+
+static
+void p405_trace_exec (p405_t *c, uint32_t pc)
+{
+	unsigned char buf[4];
+
+	buf[0] = (c->ir >> 24) & 0xff;
+	buf[1] = (c->ir >> 16) & 0xff;
+	buf[2] = (c->ir >> 8) & 0xff;
+	buf[3] = c->ir & 0xff;
+
+	c->trace_exec (c->trace_ext, pc, buf, 4);
 }
 
 void p405_execute (p405_t *c)
 {
-	unsigned op;
+	p405_opcode_f fct;
 
-	if (p405_ifetch (c, c->pc, &c->ir)) {
-		return;
+	if (c->bc != NULL) {
+		if (p405_bcache_fetch (c, &fct)) {
+			return;
+		}
+	}
+	else {
+		if (p405_ifetch (c, c->pc, &c->ir)) {
+			return;
+		}
+
+		fct = p405_get_opcode_fct (c, c->ir);
+	}
+
+	if (c->trace_exec != NULL) {
+		p405_trace_exec (c, c->pc);
 	}
 
 #ifdef P405_LOG_OPCODE
@@ -739,16 +890,7 @@ void p405_execute (p405_t *c)
 	}
 #endif
 
-	op = (c->ir >> 26) & 0x3f;
-
-	if (op == 0x1f) {
-		op = (c->ir >> 1) & 0x3ff;
-
-		c->opcodes.op1f[op] (c);
-	}
-	else {
-		c->opcodes.op[op] (c);
-	}
+	fct (c);
 
 	c->opcnt += 1;
 
@@ -767,9 +909,17 @@ void p405_execute (p405_t *c)
 
 void p405_clock_tb (p405_t *c, unsigned long n)
 {
-	uint32_t old;
+	int fit;
+
+	n += c->tb_pend;
+
+	c->tb_pend = 0;
+
+	if (n == 0) {
+		return;
+	}
 
-	old = c->tbl;
+	fit = (n >= p405_get_fit_clock (c));
 
 	c->tbl = (c->tbl + n) & 0xffffffff;
 
@@ -795,9 +945,11 @@ void p405_clock_tb (p405_t *c, unsigned long n)
 		}
 	}
 
-	if (~old & c->tbl & c->fit_mask) {
+	if (fit) {
 		p405_set_tsr (c, p405_get_tsr (c) | P405_TSR_FIS);
 	}
+
+	p405_tb_set_next (c);
 }
 
 void p405_clock (p405_t *c, unsigned long n)
@@ -821,7 +973,11 @@ void p405_clock (p405_t *c, unsigned long n)
 		tbclk = c->timer_extra_clock >> 16;
 		c->timer_extra_clock -= tbclk;
 
-		p405_clock_tb (c, c->delay + tbclk);
+		c->tb_pend += c->delay + tbclk;
+
+		if (c->tb_pend >= c->tb_next) {
+			p405_clock_tb (c, 0);
+		}
 
 		c->delay = 0;
 
@@ -830,7 +986,11 @@ void p405_clock (p405_t *c, unsigned long n)
 
 	if (n > 0) {
 		c->clkcnt += n;
-		p405_clock_tb (c, n);
+		c->tb_pend += n;
+
+		if (c->tb_pend >= c->tb_next) {
+			p405_clock_tb (c, 0);
+		}
 
 		c->delay -= n;
 	}
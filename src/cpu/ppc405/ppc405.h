@@ -270,12 +270,9 @@ typedef struct {
 #define p405_get_msr_dr(c) (((c)->msr & P405_MSR_DR) != 0)
 #define p405_get_pc(c) ((c)->pc)
 #define p405_get_pid(c) ((c)->pid)
-#define p405_get_pit(c, n) ((c)->pit[(n) & 0x01])
 #define p405_get_pvr(c) ((c)->pvr)
 #define p405_get_sprg(c, n) ((c)->sprg[(n) & 0x07])
 #define p405_get_srr(c, n) ((c)->srr[(n) & 0x03])
-#define p405_get_tbl(c) ((c)->tbl)
-#define p405_get_tbu(c) ((c)->tbu)
 #define p405_get_tcr(c) ((c)->tcr)
 #define p405_get_tsr(c) ((c)->tsr)
 #define p405_get_xer(c) ((c)->xer)
@@ -313,12 +310,9 @@ typedef struct {
 #define p405_set_msr_dr(c, v) p405_set_msr_bits (c, P405_MSR_DR, v)
 #define p405_set_pc(c, v) do { (c)->pc = (v); } while (0)
 #define p405_set_pid(c, v) do { (c)->pid = (v) & 0xff; } while (0)
-#define p405_set_pit(c, n, v) do { (c)->pit[(n) & 0x01] = (v); } while (0)
 #define p405_set_pvr(c, v) do { (c)->pvr = (v); } while (0)
 #define p405_set_sprg(c, n, v) do { (c)->sprg[(n) & 0x07] = (v); } while (0)
 #define p405_set_srr(c, n, v) do { (c)->srr[(n) & 0x03] = (v); } while (0)
-#define p405_set_tbl(c, v) do { (c)->tbl = (v); } while (0)
-#define p405_set_tbu(c, v) do { (c)->tbu = (v); } while (0)
 #define p405_set_xer(c, v) do { (c)->xer = (v); } while (0)
 #define p405_set_xer_bits(c, bits, v) p405_set_bits ((c)->xer, bits, v)
 #define p405_set_xer_so(c, v) p405_set_xer_bits (c, P405_XER_SO, v)
@@ -345,6 +339,51 @@ typedef struct {
 } p405_opcode_map_t;
 
 
+/*****************************************************************************
+ * block cache
+ *****************************************************************************/
+
+#define P405_BC_BLOCKS 4096
+#define P405_BC_INSNS  32
+
+typedef struct {
+	p405_opcode_f fct;
+	uint32_t      ir;
+} p405_bc_insn_t;
+
+/*
+ * A pre-decoded basic block. It starts at a real address and ends
+ * with a branch, with an instruction that changes the translation
+ * state, at a 1K page boundary or after P405_BC_INSNS instructions.
+ */
+typedef struct {
+	uint32_t       raddr;
+	uint32_t       key;
+	uint32_t       gen;
+	unsigned       cnt;
+	p405_bc_insn_t insn[P405_BC_INSNS];
+} p405_bc_blk_t;
+
+typedef struct {
+	p405_bc_blk_t blk[P405_BC_BLOCKS];
+
+	/* per 1K page of ram: the page contains blocks */
+	unsigned char *code;
+
+	/* per 1K page of ram: incremented when the page is modified */
+	uint32_t      *gen;
+
+	unsigned long page_cnt;
+
+	/* fetch every instruction a second time and compare */
+	char          check;
+
+	unsigned long hit;
+	unsigned long miss;
+	unsigned long check_err;
+} p405_bcache_t;
+
+
 typedef struct p405_s {
 	void               *mem_ext;
 
@@ -359,6 +398,10 @@ typedef struct p405_s {
 	unsigned char      *ram;
 	unsigned long      ram_cnt;
 
+	/* the location of the dirty page map for ram or NULL */
+	unsigned char      **ram_dirty;
+	unsigned           ram_dirty_shift;
+
 	void               *dcr_ext;
 	p405_get_uint32_f  get_dcr;
 	p405_set_uint32_f  set_dcr;
@@ -375,6 +418,9 @@ typedef struct p405_s {
 	void (*log_mem) (void *ext, unsigned mode,
 		unsigned long raddr, unsigned long vaddr, unsigned long val);
 
+	void               *trace_ext;
+	void               (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	uint32_t           pc;
 	uint32_t           gpr[32];
 
@@ -418,12 +464,26 @@ typedef struct p405_s {
 
 	unsigned long      timer_extra_clock;
 
+	/* time base clocks that have not been applied to tbl, tbu and pit */
+	unsigned long      tb_pend;
+
+	/* the number of time base clocks until the next pit or fit event */
+	unsigned long      tb_next;
+
 	unsigned long      delay;
 
 	unsigned long      opcnt;
 	unsigned long long clkcnt;
 
 	p405_opcode_map_t  opcodes;
+
+	/* the block cache or NULL if it is disabled */
+	p405_bcache_t      *bc;
+
+	/* the current block, the next index and the expected pc */
+	p405_bc_blk_t      *bc_blk;
+	unsigned           bc_idx;
+	uint32_t           bc_pc;
 } p405_t;
 
 
@@ -511,6 +571,16 @@ void p405_set_mem_fct (p405_t *c, void *ext,
 
 void p405_set_ram (p405_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short Set the dirty page map for ram
+ * @param map   The location of the map pointer or NULL
+ * @param shift The page size is (1 << shift) bytes
+ *
+ * While *map is not NULL, the byte for each page of ram that is written
+ * directly by the cpu is set to 0xff.
+ *****************************************************************************/
+void p405_set_ram_dirty_map (p405_t *c, unsigned char **map, unsigned shift);
+
 /*!***************************************************************************
  * @short Set the DCR access functions
  * @param c The cpu context
@@ -529,6 +599,34 @@ void p405_set_hook_fct (p405_t *c, void *ext, void *fct);
  *****************************************************************************/
 void p405_set_trap_fct (p405_t *c, void *ext, void *fct);
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ * @param c The cpu context
+ *
+ * The hook is called before each instruction is executed with the
+ * instruction word, most significant byte first.
+ *****************************************************************************/
+void p405_set_trace_fct (p405_t *c, void *ext, void *fct);
+
+/*!***************************************************************************
+ * @short Enable or disable the block cache
+ * @param c      The cpu context
+ * @param enable If true, the block cache is enabled
+ * @param check  If true, each instruction taken from the cache is also
+ *               fetched and decoded normally and both results are compared
+ * @return Zero if successful
+ *
+ * The block cache keeps pre-decoded basic blocks of instructions in ram,
+ * so that instructions inside a block are neither translated nor fetched
+ * nor decoded again.
+ *****************************************************************************/
+int p405_set_bcache (p405_t *c, int enable, int check);
+
+/*!***************************************************************************
+ * @short Invalidate all blocks in the block cache
+ *****************************************************************************/
+void p405_bcache_flush (p405_t *c);
+
 
 /*!***************************************************************************
  * @short Get the number of executed instructions
@@ -550,6 +648,20 @@ int p405_get_reg (p405_t *c, const char *reg, unsigned long *val);
 int p405_set_reg (p405_t *c, const char *reg, unsigned long val);
 
 
+/*!***************************************************************************
+ * @short Access the time base and the pit
+ *
+ * The time base and the pit are updated lazily. These functions apply
+ * all pending time base clocks before accessing the registers.
+ *****************************************************************************/
+uint32_t p405_get_tbl (p405_t *c);
+uint32_t p405_get_tbu (p405_t *c);
+uint32_t p405_get_pit (p405_t *c, unsigned n);
+
+void p405_set_tbl (p405_t *c, uint32_t val);
+void p405_set_tbu (p405_t *c, uint32_t val);
+void p405_set_pit (p405_t *c, unsigned n, uint32_t val);
+
 void p405_set_tcr (p405_t *c, uint32_t val);
 void p405_set_tsr (p405_t *c, uint32_t val);
 
@@ -597,7 +709,12 @@ void p405_add_timer_clock (p405_t *c, unsigned long cnt);
 
 void p405_reset (p405_t *c);
 void p405_execute (p405_t *c);
+
+/*!***************************************************************************
+ * @short Advance the time base, the pit and the fit by n clocks
+ *****************************************************************************/
 void p405_clock_tb (p405_t *c, unsigned long n);
+
 void p405_clock (p405_t *c, unsigned long n);
 
 
@@ -45,6 +45,9 @@ void s32_init (sparc32_t *c)
 	c->log_undef = NULL;
 	c->log_exception = NULL;
 
+	c->trace_ext = NULL;
+	c->trace_exec = NULL;
+
 	s32_set_opcodes (c);
 
 	c->nwindows = 4;
@@ -97,6 +100,12 @@ void s32_set_mem_fct (sparc32_t *c, void *ext,
 	c->set_uint32 = set32;
 }
 
+void s32_set_trace_fct (sparc32_t *c, void *ext, void *fct)
+{
+	c->trace_ext = ext;
+	c->trace_exec = fct;
+}
+
 void s32_set_nwindows (sparc32_t *c, unsigned n)
 {
 	if (n < 2) {
@@ -412,12 +421,29 @@ void s32_interrupt (sparc32_t *c, unsigned char val)
 	c->interrupt = (val != 0);
 }
 
+static
+void s32_trace_exec (sparc32_t *c, uint32_t pc)
+{
+	unsigned char buf[4];
+
+	buf[0] = (c->ir >> 24) & 0xff;
+	buf[1] = (c->ir >> 16) & 0xff;
+	buf[2] = (c->ir >> 8) & 0xff;
+	buf[3] = c->ir & 0xff;
+
+	c->trace_exec (c->trace_ext, pc, buf, 4);
+}
+
 void s32_execute (sparc32_t *c)
 {
 	if (s32_ifetch (c, c->pc, c->asi_text, &c->ir)) {
 		return;
 	}
 
+	if (c->trace_exec != NULL) {
+		s32_trace_exec (c, c->pc);
+	}
+
 	if (c->log_opcode != NULL) {
 		c->log_opcode (c->log_ext, c->ir);
 	}
@@ -157,6 +157,9 @@ typedef struct sparc32_s {
 	void               (*log_undef) (void *ext, unsigned long ir);
 	void               (*log_exception) (void *ext, unsigned tn);
 
+	void               *trace_ext;
+	void               (*trace_exec) (void *ext, unsigned long addr, const unsigned char *op, unsigned cnt);
+
 	uint32_t           reg[32];
 	uint32_t           pc;
 	uint32_t           npc;
@@ -225,6 +228,14 @@ void s32_set_mem_fct (sparc32_t *c, void *ext,
 	void *set8, void *set16, void *set32
 );
 
+/*!***************************************************************************
+ * @short Set the execution trace hook
+ *
+ * The hook is called before each instruction is executed with the
+ * instruction word, most significant byte first.
+ *****************************************************************************/
+void s32_set_trace_fct (sparc32_t *c, void *ext, void *fct);
+
 /*!***************************************************************************
  * @short Set the number of register windows
  * @param c The sparc32 context struct
@@ -1451,6 +1451,62 @@ void hdc_write_data (void *ext, unsigned char val)
 	}
 }
 
+static
+unsigned hdc_get_blk_cnt (hdc_t *hdc, unsigned cnt)
+{
+	unsigned n;
+
+	if ((hdc->status & HDC_STATUS_REQ) == 0) {
+		return (0);
+	}
+
+	if ((hdc->status & HDC_STATUS_CMD) || (hdc->dreq_val == 0)) {
+		return (0);
+	}
+
+	if ((hdc->buf_idx + 1) >= hdc->buf_cnt) {
+		return (0);
+	}
+
+	n = hdc->buf_cnt - hdc->buf_idx - 1;
+
+	return ((cnt < n) ? cnt : n);
+}
+
+unsigned hdc_read_data_blk (void *ext, unsigned char *buf, unsigned cnt)
+{
+	hdc_t *hdc = ext;
+
+	if ((hdc->status & HDC_STATUS_INP) == 0) {
+		return (0);
+	}
+
+	cnt = hdc_get_blk_cnt (hdc, cnt);
+
+	memcpy (buf, hdc->buf + hdc->buf_idx, cnt);
+
+	hdc->buf_idx += cnt;
+
+	return (cnt);
+}
+
+unsigned hdc_write_data_blk (void *ext, const unsigned char *buf, unsigned cnt)
+{
+	hdc_t *hdc = ext;
+
+	if (hdc->status & HDC_STATUS_INP) {
+		return (0);
+	}
+
+	cnt = hdc_get_blk_cnt (hdc, cnt);
+
+	memcpy (hdc->buf + hdc->buf_idx, buf, cnt);
+
+	hdc->buf_idx += cnt;
+
+	return (cnt);
+}
+
 static
 unsigned char hdc_get_uint8 (void *ext, unsigned long addr)
 {
@@ -90,6 +90,16 @@ typedef struct hdc_t {
 
 unsigned char hdc_read_data (void *hdc);
 void hdc_write_data (void *hdc, unsigned char val);
+
+/*!***************************************************************************
+ * @short Transfer sector data in a block
+ * @return The number of bytes transferred
+ *
+ * The last byte of the buffer is not transferred, it must be transferred
+ * with hdc_read_data() or hdc_write_data().
+ *****************************************************************************/
+unsigned hdc_read_data_blk (void *hdc, unsigned char *buf, unsigned cnt);
+unsigned hdc_write_data_blk (void *hdc, const unsigned char *buf, unsigned cnt);
 void hdc_set_tc (hdc_t *hdc, unsigned char val);
 
 hdc_t *hdc_new (unsigned long addr);
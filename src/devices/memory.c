@@ -20,11 +20,23 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
 #include <string.h>
 
 #include "memory.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+
+#ifdef HAVE_PTHREAD_H
+/* protects the reference counts of shared block data */
+static pthread_mutex_t mem_share_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 
 int mem_blk_init (mem_blk_t *blk, unsigned long base, unsigned long size, int alloc)
 {
@@ -44,6 +56,7 @@ int mem_blk_init (mem_blk_t *blk, unsigned long base, unsigned long size, int al
 	blk->set_uint8 = NULL;
 	blk->set_uint16 = NULL;
 	blk->set_uint32 = NULL;
+	blk->set_blk = NULL;
 
 	blk->ext = blk;
 
@@ -54,6 +67,11 @@ int mem_blk_init (mem_blk_t *blk, unsigned long base, unsigned long size, int al
 	blk->addr2 = base + size - 1;
 	blk->size = size;
 
+	blk->dirty = NULL;
+	blk->dirty_used = 0;
+
+	blk->data_ref = NULL;
+
 	return (0);
 }
 
@@ -74,12 +92,70 @@ mem_blk_t *mem_blk_new (unsigned long base, unsigned long size, int alloc)
 	return (blk);
 }
 
+static
+void mem_share_lock_acquire (void)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&mem_share_lock);
+#endif
+}
+
+static
+void mem_share_lock_release (void)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&mem_share_lock);
+#endif
+}
+
+/*
+ * Drop the reference to shared data. Returns true if it was the last
+ * reference and the data must be freed.
+ */
+static
+int mem_blk_data_unref (mem_blk_t *blk)
+{
+	int r;
+
+	mem_share_lock_acquire ();
+
+	*blk->data_ref -= 1;
+
+	r = (*blk->data_ref == 0);
+
+	mem_share_lock_release ();
+
+	if (r) {
+		free (blk->data_ref);
+	}
+
+	blk->data_ref = NULL;
+
+	return (r);
+}
+
+static
+void mem_blk_data_free (mem_blk_t *blk)
+{
+	if (blk->data_ref != NULL) {
+		if (mem_blk_data_unref (blk) == 0) {
+			return;
+		}
+	}
+
+	if (blk->data_del) {
+		free (blk->data);
+	}
+}
+
 void mem_blk_free (mem_blk_t *blk)
 {
 	if (blk != NULL) {
-		if (blk->data_del) {
-			free (blk->data);
-		}
+		mem_blk_data_free (blk);
+
+		free (blk->dirty);
+		blk->dirty = NULL;
+		blk->dirty_used = 0;
 	}
 }
 
@@ -105,6 +181,12 @@ mem_blk_t *mem_blk_clone (const mem_blk_t *blk)
 	ret->data_del = 0;
 	ret->active = 1;
 
+	/* the clone does not share the dirty page consumers */
+	ret->dirty = NULL;
+	ret->dirty_used = 0;
+
+	ret->data_ref = NULL;
+
 	return (ret);
 }
 
@@ -159,6 +241,11 @@ void mem_blk_set_fset (mem_blk_t *blk, void *ext, mem_set_uint8_f s8, mem_set_ui
 	mem_blk_fix_fct (blk);
 }
 
+void mem_blk_set_fblk (mem_blk_t *blk, mem_set_blk_f fct)
+{
+	blk->set_blk = fct;
+}
+
 void mem_blk_set_fct (mem_blk_t *blk, void *ext,
 	mem_get_uint8_f g8, mem_get_uint16_f g16, mem_get_uint32_f g32,
 	mem_set_uint8_f s8, mem_set_uint16_f s16, mem_set_uint32_f s32)
@@ -185,6 +272,10 @@ void mem_blk_clear (mem_blk_t *blk, unsigned char val)
 {
 	if (blk->data != NULL) {
 		memset (blk->data, val, blk->size);
+
+		if (blk->dirty != NULL) {
+			mem_blk_dirty_set (blk, 0, blk->size);
+		}
 	}
 }
 
@@ -195,12 +286,87 @@ unsigned char *mem_blk_get_data (mem_blk_t *blk)
 
 void mem_blk_set_data (mem_blk_t *blk, void *data, int del)
 {
-	if (blk->data_del) {
+	mem_blk_data_free (blk);
+
+	blk->data = data;
+	blk->data_del = (data != NULL) && del;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, 0, blk->size);
+	}
+}
+
+int mem_blk_share (mem_blk_t *blk, mem_blk_t *src)
+{
+	unsigned *ref;
+
+	if ((blk->data == NULL) || (src->data == NULL) || (blk->data == src->data)) {
+		return (1);
+	}
+
+	if ((blk->readonly == 0) || (src->readonly == 0)) {
+		return (1);
+	}
+
+	if ((blk->data_del == 0) || (src->data_del == 0)) {
+		return (1);
+	}
+
+	if ((blk->get_uint8 != NULL) || (src->get_uint8 != NULL)) {
+		return (1);
+	}
+
+	if (blk->size != src->size) {
+		return (1);
+	}
+
+	if (memcmp (blk->data, src->data, blk->size) != 0) {
+		return (1);
+	}
+
+	if (src->data_ref == NULL) {
+		if ((ref = malloc (sizeof (unsigned))) == NULL) {
+			return (1);
+		}
+
+		*ref = 1;
+
+		src->data_ref = ref;
+	}
+
+	mem_blk_data_free (blk);
+
+	mem_share_lock_acquire ();
+	*src->data_ref += 1;
+	mem_share_lock_release ();
+
+	blk->data = src->data;
+	blk->data_ref = src->data_ref;
+
+	return (0);
+}
+
+/*
+ * Give the block a private copy of its data before it is changed
+ */
+static
+int mem_blk_unshare (mem_blk_t *blk)
+{
+	unsigned char *data;
+
+	if ((data = malloc (blk->size + 16)) == NULL) {
+		return (1);
+	}
+
+	memcpy (data, blk->data, blk->size);
+
+	if (mem_blk_data_unref (blk)) {
 		free (blk->data);
 	}
 
 	blk->data = data;
-	blk->data_del = (data != NULL) && del;
+
+	return (0);
 }
 
 int mem_blk_get_active (mem_blk_t *blk)
@@ -239,10 +405,185 @@ unsigned long mem_blk_get_size (const mem_blk_t *blk)
 	return (blk->size);
 }
 
+static
+unsigned long mem_blk_dirty_pages (const mem_blk_t *blk)
+{
+	return ((blk->size + MEM_DIRTY_SIZE - 1) >> MEM_DIRTY_SHIFT);
+}
+
+/*
+ * Allocate the dirty page map with all pages dirty. If this fails, the
+ * map is NULL and all pages are reported as dirty.
+ */
+static
+int mem_blk_dirty_alloc (mem_blk_t *blk)
+{
+	unsigned long cnt;
+
+	free (blk->dirty);
+
+	/* one extra entry for accesses that straddle the end of the block */
+	cnt = mem_blk_dirty_pages (blk) + 1;
+
+	if ((blk->dirty = malloc (cnt)) == NULL) {
+		return (1);
+	}
+
+	memset (blk->dirty, 0xff, cnt);
+
+	return (0);
+}
+
 void mem_blk_set_size (mem_blk_t *blk, unsigned long size)
 {
 	blk->size = size;
 	blk->addr2 = blk->addr1 + size - 1;
+
+	if (blk->dirty_used) {
+		mem_blk_dirty_alloc (blk);
+	}
+}
+
+int mem_blk_dirty_add (mem_blk_t *blk)
+{
+	int           id;
+	unsigned long i, cnt;
+
+	if (blk->data == NULL) {
+		return (-1);
+	}
+
+	for (id = 0; id < MEM_DIRTY_MAX; id++) {
+		if ((blk->dirty_used & (1U << id)) == 0) {
+			break;
+		}
+	}
+
+	if (id >= MEM_DIRTY_MAX) {
+		return (-1);
+	}
+
+	if (blk->dirty == NULL) {
+		if (mem_blk_dirty_alloc (blk)) {
+			return (-1);
+		}
+	}
+	else {
+		cnt = mem_blk_dirty_pages (blk);
+
+		for (i = 0; i < cnt; i++) {
+			blk->dirty[i] |= 1U << id;
+		}
+	}
+
+	blk->dirty_used |= 1U << id;
+
+	return (id);
+}
+
+void mem_blk_dirty_rmv (mem_blk_t *blk, int id)
+{
+	if ((id < 0) || (id >= MEM_DIRTY_MAX)) {
+		return;
+	}
+
+	blk->dirty_used &= ~(1U << id);
+
+	if (blk->dirty_used == 0) {
+		free (blk->dirty);
+		blk->dirty = NULL;
+	}
+}
+
+void mem_blk_dirty_set (mem_blk_t *blk, unsigned long addr, unsigned long cnt)
+{
+	unsigned long i, n;
+
+	if ((blk->dirty == NULL) || (cnt == 0)) {
+		return;
+	}
+
+	i = addr >> MEM_DIRTY_SHIFT;
+	n = (addr + cnt - 1) >> MEM_DIRTY_SHIFT;
+
+	while (i <= n) {
+		blk->dirty[i] = 0xff;
+		i += 1;
+	}
+}
+
+int mem_blk_dirty_get (mem_blk_t *blk, int id, unsigned long addr, unsigned long cnt)
+{
+	int           r;
+	unsigned char msk;
+	unsigned long i, n;
+
+	if ((cnt == 0) || (addr >= blk->size)) {
+		return (0);
+	}
+
+	if (blk->dirty == NULL) {
+		return (1);
+	}
+
+	if (cnt > (blk->size - addr)) {
+		cnt = blk->size - addr;
+	}
+
+	msk = 1U << id;
+
+	i = addr >> MEM_DIRTY_SHIFT;
+	n = (addr + cnt - 1) >> MEM_DIRTY_SHIFT;
+
+	r = 0;
+
+	while (i <= n) {
+		if (blk->dirty[i] & msk) {
+			blk->dirty[i] &= ~msk;
+			r = 1;
+		}
+
+		i += 1;
+	}
+
+	return (r);
+}
+
+int mem_blk_dirty_next (mem_blk_t *blk, int id, unsigned long *addr)
+{
+	unsigned char msk;
+	unsigned long i, cnt;
+
+	if (*addr >= blk->size) {
+		return (0);
+	}
+
+	i = *addr >> MEM_DIRTY_SHIFT;
+
+	if (blk->dirty == NULL) {
+		*addr = i << MEM_DIRTY_SHIFT;
+		return (1);
+	}
+
+	cnt = mem_blk_dirty_pages (blk);
+	msk = 1U << id;
+
+	while (i < cnt) {
+		if (blk->dirty[i] & msk) {
+			blk->dirty[i] &= ~msk;
+			*addr = i << MEM_DIRTY_SHIFT;
+			return (1);
+		}
+
+		i += 1;
+	}
+
+	return (0);
+}
+
+unsigned char **mem_blk_dirty_map (mem_blk_t *blk)
+{
+	return (&blk->dirty);
 }
 
 
@@ -348,6 +689,10 @@ unsigned long buf_get_uint32_le (const void *buf, unsigned long addr)
 void mem_blk_set_uint8 (mem_blk_t *blk, unsigned long addr, unsigned char val)
 {
 	blk->data[addr] = val;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, addr, 1);
+	}
 }
 
 void mem_blk_set_uint8_null (void *ext, unsigned long addr, unsigned char val)
@@ -358,12 +703,20 @@ void mem_blk_set_uint16_be (mem_blk_t *blk, unsigned long addr, unsigned short v
 {
 	blk->data[addr] = (val >> 8) & 0xff;
 	blk->data[addr + 1] = val & 0xff;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, addr, 2);
+	}
 }
 
 void mem_blk_set_uint16_le (mem_blk_t *blk, unsigned long addr, unsigned short val)
 {
 	blk->data[addr] = val & 0xff;
 	blk->data[addr + 1] = (val >> 8) & 0xff;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, addr, 2);
+	}
 }
 
 void mem_blk_set_uint16_null (void *ext, unsigned long addr, unsigned short val)
@@ -376,6 +729,10 @@ void mem_blk_set_uint32_be (mem_blk_t *blk, unsigned long addr, unsigned long va
 	blk->data[addr + 1] = (val >> 16) & 0xff;
 	blk->data[addr + 2] = (val >> 8) & 0xff;
 	blk->data[addr + 3] = val & 0xff;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, addr, 4);
+	}
 }
 
 void mem_blk_set_uint32_le (mem_blk_t *blk, unsigned long addr, unsigned long val)
@@ -384,6 +741,10 @@ void mem_blk_set_uint32_le (mem_blk_t *blk, unsigned long addr, unsigned long va
 	blk->data[addr + 1] = (val >> 8) & 0xff;
 	blk->data[addr + 2] = (val >> 16) & 0xff;
 	blk->data[addr + 3] = (val >> 24) & 0xff;
+
+	if (blk->dirty != NULL) {
+		mem_blk_dirty_set (blk, addr, 4);
+	}
 }
 
 void mem_blk_set_uint32_null (void *ext, unsigned long addr, unsigned long val)
@@ -631,6 +992,28 @@ void mem_rmv_all (memory_t *mem)
 	mem_init_last (mem);
 }
 
+void mem_share_rom (memory_t *mem, memory_t *src)
+{
+	unsigned  i, j;
+	mem_blk_t *blk, *tmp;
+
+	for (i = 0; i < mem->cnt; i++) {
+		blk = mem->lst[i].blk;
+
+		if ((blk->readonly == 0) || (blk->data_ref != NULL)) {
+			continue;
+		}
+
+		for (j = 0; j < src->cnt; j++) {
+			tmp = src->lst[j].blk;
+
+			if ((tmp->addr1 == blk->addr1) && (mem_blk_share (blk, tmp) == 0)) {
+				break;
+			}
+		}
+	}
+}
+
 void mem_move_to_front (memory_t *mem, unsigned long addr)
 {
 	unsigned  i;
@@ -899,7 +1282,17 @@ void mem_set_uint8_rw (memory_t *mem, unsigned long addr, unsigned char val)
 			blk->set_uint8 (blk->ext, addr, val);
 		}
 		else {
+			if ((blk->data_ref != NULL) && (blk->data[addr] != val)) {
+				if (mem_blk_unshare (blk)) {
+					return;
+				}
+			}
+
 			blk->data[addr] = val;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 1);
+			}
 		}
 	}
 	else if (mem->set_uint8 != NULL) {
@@ -926,6 +1319,10 @@ void mem_set_uint8 (memory_t *mem, unsigned long addr, unsigned char val)
 		}
 		else {
 			blk->data[addr] = val;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 1);
+			}
 		}
 	}
 	else if (mem->set_uint8 != NULL) {
@@ -959,6 +1356,10 @@ void mem_set_uint16_be (memory_t *mem, unsigned long addr, unsigned short val)
 		else {
 			blk->data[addr] = (val >> 8) & 0xff;
 			blk->data[addr + 1] = val & 0xff;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 2);
+			}
 		}
 	}
 	else if (mem->set_uint16 != NULL) {
@@ -992,6 +1393,10 @@ void mem_set_uint16_le (memory_t *mem, unsigned long addr, unsigned short val)
 		else {
 			blk->data[addr] = val & 0xff;
 			blk->data[addr + 1] = (val >> 8) & 0xff;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 2);
+			}
 		}
 	}
 	else if (mem->set_uint16 != NULL) {
@@ -1029,6 +1434,10 @@ void mem_set_uint32_be (memory_t *mem, unsigned long addr, unsigned long val)
 			blk->data[addr + 1] = (val >> 16) & 0xff;
 			blk->data[addr + 2] = (val >> 8) & 0xff;
 			blk->data[addr + 3] = val & 0xff;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 4);
+			}
 		}
 	}
 	else if (mem->set_uint32 != NULL) {
@@ -1066,9 +1475,68 @@ void mem_set_uint32_le (memory_t *mem, unsigned long addr, unsigned long val)
 			blk->data[addr + 1] = (val >> 8) & 0xff;
 			blk->data[addr + 2] = (val >> 16) & 0xff;
 			blk->data[addr + 3] = (val >> 24) & 0xff;
+
+			if (blk->dirty != NULL) {
+				mem_blk_dirty_set (blk, addr, 4);
+			}
 		}
 	}
 	else if (mem->set_uint32 != NULL) {
 		mem->set_uint32 (mem->ext, addr, val);
 	}
 }
+
+unsigned long mem_set_blk (memory_t *mem, unsigned long addr, const unsigned char *buf, unsigned long cnt)
+{
+	unsigned long i;
+	mem_blk_t     *blk;
+
+	if (cnt == 0) {
+		return (0);
+	}
+
+	if (mem->addr_translate != mem_def_translate) {
+		/* consecutive addresses might not be translated consecutively */
+		mem_set_uint8 (mem, addr, buf[0]);
+		return (1);
+	}
+
+	addr = mem->addr_translate (mem, addr);
+	blk = mem_get_blk_inline (mem, addr, 2);
+
+	if (blk == NULL) {
+		if (mem->set_uint8 != NULL) {
+			mem->set_uint8 (mem->ext, addr, buf[0]);
+		}
+
+		return (1);
+	}
+
+	if (cnt > (blk->addr2 - addr + 1)) {
+		cnt = blk->addr2 - addr + 1;
+	}
+
+	if (blk->readonly) {
+		return (cnt);
+	}
+
+	addr -= blk->addr1;
+
+	if (blk->set_blk != NULL) {
+		blk->set_blk (blk->ext, addr, buf, cnt);
+	}
+	else if (blk->set_uint8 != NULL) {
+		for (i = 0; i < cnt; i++) {
+			blk->set_uint8 (blk->ext, addr + i, buf[i]);
+		}
+	}
+	else {
+		memcpy (blk->data + addr, buf, cnt);
+
+		if (blk->dirty != NULL) {
+			mem_blk_dirty_set (blk, addr, cnt);
+		}
+	}
+
+	return (cnt);
+}
@@ -29,6 +29,13 @@
 
 #define MEM_LAST_CNT 4
 
+/* The dirty page size is (1 << MEM_DIRTY_SHIFT) bytes */
+#define MEM_DIRTY_SHIFT 12
+#define MEM_DIRTY_SIZE  (1UL << MEM_DIRTY_SHIFT)
+
+/* The maximum number of dirty page map consumers */
+#define MEM_DIRTY_MAX   8
+
 
 typedef unsigned char (*mem_get_uint8_f) (void *blk, unsigned long addr);
 typedef unsigned short (*mem_get_uint16_f) (void *blk, unsigned long addr);
@@ -38,6 +45,8 @@ typedef void (*mem_set_uint8_f) (void *blk, unsigned long addr, unsigned char va
 typedef void (*mem_set_uint16_f) (void *blk, unsigned long addr, unsigned short val);
 typedef void (*mem_set_uint32_f) (void *blk, unsigned long addr, unsigned long val);
 
+typedef void (*mem_set_blk_f) (void *blk, unsigned long addr, const unsigned char *buf, unsigned long cnt);
+
 
 /*!***************************************************************************
  * @short The memory block structure
@@ -52,6 +61,9 @@ typedef struct {
 	mem_set_uint16_f set_uint16;
 	mem_set_uint32_f set_uint32;
 
+	/* Optionally used by mem_set_blk() instead of set_uint8(). */
+	mem_set_blk_f    set_blk;
+
 	/* The transparant parameter for get_*() and set_*(). */
 	void             *ext;
 
@@ -72,6 +84,16 @@ typedef struct {
 
 	/* The actual memory or NULL if get_* and set_* are used */
 	unsigned char    *data;
+
+	/*
+	 * The dirty page map, one byte per page and one bit per consumer.
+	 * This is NULL if no consumer is registered.
+	 */
+	unsigned char    *dirty;
+	unsigned char    dirty_used;
+
+	/* The reference count if data is shared with other blocks, or NULL */
+	unsigned         *data_ref;
 } mem_blk_t;
 
 
@@ -147,6 +169,16 @@ void mem_blk_set_fct (mem_blk_t *blk, void *ext,
 );
 void mem_blk_set_ext (mem_blk_t *blk, void *ext);
 
+/*!***************************************************************************
+ * @short Set the block write function
+ * @param blk The memory block
+ * @param fct The function that writes several bytes at once or NULL
+ *
+ * The function is called by mem_set_blk() with addresses relative to
+ * the block start and with the ext parameter set by mem_blk_set_fset().
+ *****************************************************************************/
+void mem_blk_set_fblk (mem_blk_t *blk, mem_set_blk_f fct);
+
 /*!***************************************************************************
  * @short Clear a memory block
  * @param blk The memory block
@@ -158,6 +190,19 @@ unsigned char *mem_blk_get_data (mem_blk_t *blk);
 
 void mem_blk_set_data (mem_blk_t *blk, void *data, int del);
 
+/*!***************************************************************************
+ * @short  Share the data of another read-only block
+ * @param  blk The memory block
+ * @param  src The block whose data is shared
+ * @return Zero if the data is now shared, nonzero otherwise
+ *
+ * Both blocks must be read-only, own their data and have the same size
+ * and contents. The data of blk is freed. The shared data is freed with
+ * the last block that uses it. mem_set_uint8_rw() gives a block a
+ * private copy before it changes the data.
+ *****************************************************************************/
+int mem_blk_share (mem_blk_t *blk, mem_blk_t *src);
+
 int mem_blk_get_active (mem_blk_t *blk);
 
 void mem_blk_set_active (mem_blk_t *blk, int val);
@@ -199,6 +244,74 @@ unsigned long mem_blk_get_size (const mem_blk_t *blk);
 
 void mem_blk_set_size (mem_blk_t *blk, unsigned long size);
 
+/*!***************************************************************************
+ * @short  Register a dirty page map consumer
+ * @param  blk The memory block
+ * @return The consumer index or -1 on error
+ *
+ * Dirty pages are only tracked for blocks with backing store and only
+ * while at least one consumer is registered. Every consumer sees all
+ * writes and clears its own dirty bits. Initially all pages are dirty
+ * for a new consumer.
+ *****************************************************************************/
+int mem_blk_dirty_add (mem_blk_t *blk);
+
+/*!***************************************************************************
+ * @short Unregister a dirty page map consumer
+ * @param blk The memory block
+ * @param id  The consumer index returned by mem_blk_dirty_add()
+ *
+ * The dirty page map is freed when the last consumer is removed.
+ *****************************************************************************/
+void mem_blk_dirty_rmv (mem_blk_t *blk, int id);
+
+/*!***************************************************************************
+ * @short Mark a range of bytes as written
+ * @param blk  The memory block
+ * @param addr The address of the first byte, relative to the block start
+ * @param cnt  The number of bytes
+ *
+ * This must be called by code that modifies the block data directly.
+ *****************************************************************************/
+void mem_blk_dirty_set (mem_blk_t *blk, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short  Check if a range of bytes was written
+ * @param  blk  The memory block
+ * @param  id   The consumer index
+ * @param  addr The address of the first byte, relative to the block start
+ * @param  cnt  The number of bytes
+ * @return True if any page in the range is dirty for consumer id
+ *
+ * The dirty bits of consumer id are cleared for all pages in the range.
+ *****************************************************************************/
+int mem_blk_dirty_get (mem_blk_t *blk, int id, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short  Get the next dirty page
+ * @param  blk  The memory block
+ * @param  id   The consumer index
+ * @param  addr The address at which to start searching, relative to the
+ *              block start. Set to the address of the dirty page.
+ * @return True if a dirty page was found
+ *
+ * The dirty bit of consumer id is cleared for the page that is returned.
+ * To collect all dirty pages, start at 0 and add MEM_DIRTY_SIZE to the
+ * returned address before the next call.
+ *****************************************************************************/
+int mem_blk_dirty_next (mem_blk_t *blk, int id, unsigned long *addr);
+
+/*!***************************************************************************
+ * @short  Get the location of the dirty page map
+ * @param  blk The memory block
+ * @return A pointer to the dirty page map pointer
+ *
+ * This is used by CPU cores that write the block data directly. The map
+ * pointer is NULL while no consumer is registered and may change when a
+ * consumer is added or removed.
+ *****************************************************************************/
+unsigned char **mem_blk_dirty_map (mem_blk_t *blk);
+
 
 void buf_set_uint8 (void *buf, unsigned long addr, unsigned char val);
 void buf_set_uint16_be (void *buf, unsigned long addr, unsigned short val);
@@ -296,6 +409,16 @@ void mem_rmv_blk (memory_t *mem, const mem_blk_t *blk);
  *****************************************************************************/
 void mem_rmv_all (memory_t *mem);
 
+/*!***************************************************************************
+ * @short Share read-only blocks with another memory structure
+ * @param mem The memory structure whose blocks are changed
+ * @param src The memory structure of another instance
+ *
+ * Each read-only block in mem that has the same address, size and
+ * contents as a block in src uses the data of that block afterwards.
+ *****************************************************************************/
+void mem_share_rom (memory_t *mem, memory_t *src);
+
 /*!***************************************************************************
  * @short Move a memory block to the front of the list
  * @param mem   The memory structure
@@ -332,5 +455,18 @@ void mem_set_uint16_le (memory_t *mem, unsigned long addr, unsigned short val);
 void mem_set_uint32_be (memory_t *mem, unsigned long addr, unsigned long val);
 void mem_set_uint32_le (memory_t *mem, unsigned long addr, unsigned long val);
 
+/*!***************************************************************************
+ * @short  Write several bytes
+ * @param  mem  The memory structure
+ * @param  addr The address of the first byte
+ * @param  buf  The bytes
+ * @param  cnt  The number of bytes in buf
+ * @return The number of bytes written, at least 1 if cnt > 0
+ *
+ * The bytes are written in ascending order. Writing stops at the end
+ * of the memory block that contains addr.
+ *****************************************************************************/
+unsigned long mem_set_blk (memory_t *mem, unsigned long addr, const unsigned char *buf, unsigned long cnt);
+
 
 #endif
@@ -0,0 +1,996 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/devices/ne2000.c                                         *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+#include "ne2000.h"
+
+#include <drivers/options.h>
+
+#ifndef PCE_HOST_WINDOWS
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#ifdef PCE_ENABLE_TUN
+#include <lib/tun.h>
+#endif
+
+
+#define NE_CR_STP  0x01
+#define NE_CR_STA  0x02
+#define NE_CR_TXP  0x04
+#define NE_CR_RD   0x38
+
+#define NE_ISR_PRX 0x01
+#define NE_ISR_PTX 0x02
+#define NE_ISR_OVW 0x10
+#define NE_ISR_RDC 0x40
+#define NE_ISR_RST 0x80
+
+#define NE_RCR_AB  0x04
+#define NE_RCR_AM  0x08
+#define NE_RCR_PRO 0x10
+#define NE_RCR_MON 0x20
+
+#define NE_TCR_LB  0x06
+
+/* the maximum number of packets received per clock call */
+#define NE_RX_BURST 16
+
+
+static unsigned char ne2000_def_mac[6] = {
+	0x02, 0x50, 0x43, 0x45, 0x00, 0x01
+};
+
+
+static
+void ne2000_set_irq (ne2000_t *ne)
+{
+	unsigned char val;
+
+	val = (ne->isr & ne->imr & 0x7f) != 0;
+
+	if (ne->irq_val != val) {
+		ne->irq_val = val;
+
+		if (ne->irq != NULL) {
+			ne->irq (ne->irq_ext, val);
+		}
+	}
+}
+
+static
+unsigned char ne2000_mem_get (ne2000_t *ne, unsigned addr)
+{
+	if (addr < 32) {
+		return (ne->prom[addr]);
+	}
+
+	if ((addr >= NE2000_RAM_BASE) && (addr < (NE2000_RAM_BASE + NE2000_RAM_SIZE))) {
+		return (ne->ram->data[addr - NE2000_RAM_BASE]);
+	}
+
+	return (0xff);
+}
+
+static
+void ne2000_mem_set (ne2000_t *ne, unsigned addr, unsigned char val)
+{
+	if ((addr >= NE2000_RAM_BASE) && (addr < (NE2000_RAM_BASE + NE2000_RAM_SIZE))) {
+		ne->ram->data[addr - NE2000_RAM_BASE] = val;
+	}
+}
+
+/*
+ * The multicast filter index is the upper 6 bits of the CRC of the
+ * destination address.
+ */
+static
+unsigned ne2000_mcast_index (const unsigned char *addr)
+{
+	unsigned      i, j;
+	unsigned      bit;
+	unsigned long crc;
+	unsigned char val;
+
+	crc = 0xffffffff;
+
+	for (i = 0; i < 6; i++) {
+		val = addr[i];
+
+		for (j = 0; j < 8; j++) {
+			bit = ((crc >> 31) ^ val) & 1;
+
+			crc = (crc << 1) & 0xffffffff;
+
+			if (bit) {
+				crc ^= 0x04c11db7;
+			}
+
+			val >>= 1;
+		}
+	}
+
+	return ((crc >> 26) & 0x3f);
+}
+
+static
+int ne2000_accept (ne2000_t *ne, const unsigned char *buf)
+{
+	unsigned idx;
+
+	if (ne->rcr & NE_RCR_PRO) {
+		return (1);
+	}
+
+	if (buf[0] & 0x01) {
+		if (memcmp (buf, "\xff\xff\xff\xff\xff\xff", 6) == 0) {
+			return ((ne->rcr & NE_RCR_AB) != 0);
+		}
+
+		if ((ne->rcr & NE_RCR_AM) == 0) {
+			return (0);
+		}
+
+		idx = ne2000_mcast_index (buf);
+
+		return ((ne->mar[idx >> 3] >> (idx & 7)) & 1);
+	}
+
+	return (memcmp (buf, ne->par, 6) == 0);
+}
+
+/*
+ * Store a packet in the receive ring
+ */
+static
+int ne2000_receive (ne2000_t *ne, const unsigned char *buf, unsigned cnt)
+{
+	unsigned      i;
+	unsigned      len, pages, ring, avail, next;
+	unsigned      addr;
+	unsigned char hdr[4];
+
+	if ((ne->cr & NE_CR_STP) || ((ne->cr & NE_CR_STA) == 0)) {
+		return (1);
+	}
+
+	if ((cnt < 6) || (ne->rcr & NE_RCR_MON)) {
+		return (1);
+	}
+
+	if (ne2000_accept (ne, buf) == 0) {
+		return (1);
+	}
+
+	if ((ne->pstart >= ne->pstop) || (ne->pstop > 0x80)) {
+		return (1);
+	}
+
+	len = (cnt < 60) ? 60 : cnt;
+
+	pages = (len + 4 + 255) >> 8;
+	ring = ne->pstop - ne->pstart;
+
+	if (ne->bnry > ne->curr) {
+		avail = ne->bnry - ne->curr;
+	}
+	else {
+		avail = ring - (ne->curr - ne->bnry);
+	}
+
+	if (pages >= avail) {
+		/* the ring is full, drop the packet */
+		ne->drop_cnt += 1;
+
+		if (ne->cntr[2] < 0xc0) {
+			ne->cntr[2] += 1;
+		}
+
+		return (1);
+	}
+
+	next = ne->curr + pages;
+
+	if (next >= ne->pstop) {
+		next -= ring;
+	}
+
+	ne->rsr = 0x01 | ((buf[0] & 0x01) ? 0x20 : 0x00);
+
+	hdr[0] = ne->rsr;
+	hdr[1] = next;
+	hdr[2] = (len + 4) & 0xff;
+	hdr[3] = ((len + 4) >> 8) & 0xff;
+
+	addr = (unsigned) ne->curr << 8;
+
+	for (i = 0; i < (len + 4); i++) {
+		if (i < 4) {
+			ne2000_mem_set (ne, addr, hdr[i]);
+		}
+		else if ((i - 4) < cnt) {
+			ne2000_mem_set (ne, addr, buf[i - 4]);
+		}
+		else {
+			ne2000_mem_set (ne, addr, 0);
+		}
+
+		addr += 1;
+
+		if ((addr >> 8) >= ne->pstop) {
+			addr = (unsigned) ne->pstart << 8;
+		}
+	}
+
+	ne->curr = next;
+
+	ne->isr |= NE_ISR_PRX;
+
+	ne2000_set_irq (ne);
+
+	return (0);
+}
+
+static
+void ne2000_send (ne2000_t *ne, const unsigned char *buf, unsigned cnt)
+{
+#ifndef PCE_HOST_WINDOWS
+	struct sockaddr_un addr;
+
+	if (ne->fd < 0) {
+		return;
+	}
+
+	if (ne->peer_name != NULL) {
+		memset (&addr, 0, sizeof (addr));
+		addr.sun_family = AF_UNIX;
+		strncpy (addr.sun_path, ne->peer_name, sizeof (addr.sun_path) - 1);
+
+		/* the peer may not exist yet */
+		sendto (ne->fd, buf, cnt, 0, (struct sockaddr *) &addr, sizeof (addr));
+	}
+	else if (write (ne->fd, buf, cnt) != (ssize_t) cnt) {
+		ne->drop_cnt += 1;
+	}
+#endif
+}
+
+static
+void ne2000_transmit (ne2000_t *ne)
+{
+	unsigned      i, cnt;
+	unsigned      addr;
+	unsigned char buf[NE2000_PKT_MAX];
+
+	cnt = ne->tbcr;
+
+	if (cnt > NE2000_PKT_MAX) {
+		cnt = NE2000_PKT_MAX;
+	}
+
+	addr = (unsigned) ne->tpsr << 8;
+
+	for (i = 0; i < cnt; i++) {
+		buf[i] = ne2000_mem_get (ne, addr + i);
+	}
+
+	if (ne->tcr & NE_TCR_LB) {
+		ne2000_receive (ne, buf, cnt);
+	}
+	else {
+		ne2000_send (ne, buf, cnt);
+	}
+
+	ne->tx_cnt += 1;
+
+	ne->tsr = 0x01;
+	ne->cr &= ~NE_CR_TXP;
+	ne->isr |= NE_ISR_PTX;
+
+	ne2000_set_irq (ne);
+}
+
+static
+void ne2000_set_cr (ne2000_t *ne, unsigned char val)
+{
+	unsigned addr;
+
+	ne->cr = val;
+
+	if (val & NE_CR_STP) {
+		ne->isr |= NE_ISR_RST;
+	}
+	else if (val & NE_CR_STA) {
+		ne->isr &= ~NE_ISR_RST;
+	}
+
+	switch (val & NE_CR_RD) {
+	case 0x08:
+	case 0x10:
+		if (ne->rbcr == 0) {
+			ne->isr |= NE_ISR_RDC;
+		}
+		break;
+
+	case 0x18:
+		/* send packet: read the next packet from the ring */
+		addr = (unsigned) ne->bnry << 8;
+		ne->rsar = addr;
+		ne->rbcr = ne2000_mem_get (ne, addr + 2);
+		ne->rbcr |= ne2000_mem_get (ne, addr + 3) << 8;
+		break;
+	}
+
+	if ((val & NE_CR_TXP) && (val & NE_CR_STA) && !(val & NE_CR_STP)) {
+		ne2000_transmit (ne);
+	}
+
+	ne2000_set_irq (ne);
+}
+
+static
+void ne2000_dma_done (ne2000_t *ne)
+{
+	ne->rsar += 1;
+
+	if ((ne->rsar >> 8) == ne->pstop) {
+		ne->rsar = (unsigned) ne->pstart << 8;
+	}
+
+	if (ne->rbcr > 0) {
+		ne->rbcr -= 1;
+
+		if (ne->rbcr == 0) {
+			ne->isr |= NE_ISR_RDC;
+			ne2000_set_irq (ne);
+		}
+	}
+}
+
+static
+unsigned char ne2000_get_data (ne2000_t *ne)
+{
+	unsigned char val;
+
+	val = ne2000_mem_get (ne, ne->rsar);
+
+	ne2000_dma_done (ne);
+
+	return (val);
+}
+
+static
+void ne2000_set_data (ne2000_t *ne, unsigned char val)
+{
+	ne2000_mem_set (ne, ne->rsar, val);
+
+	ne2000_dma_done (ne);
+}
+
+static
+unsigned char ne2000_get_reg_0 (ne2000_t *ne, unsigned reg)
+{
+	unsigned char val;
+
+	switch (reg) {
+	case 0x01:
+		return (ne->rsar & 0xff);
+
+	case 0x02:
+		return ((ne->rsar >> 8) & 0xff);
+
+	case 0x03:
+		return (ne->bnry);
+
+	case 0x04:
+		return (ne->tsr);
+
+	case 0x05:
+		return (ne->ncr);
+
+	case 0x06:
+		return (0);
+
+	case 0x07:
+		return (ne->isr);
+
+	case 0x08:
+		return (ne->rsar & 0xff);
+
+	case 0x09:
+		return ((ne->rsar >> 8) & 0xff);
+
+	case 0x0c:
+		return (ne->rsr);
+
+	case 0x0d:
+	case 0x0e:
+	case 0x0f:
+		val = ne->cntr[reg - 0x0d];
+		ne->cntr[reg - 0x0d] = 0;
+		return (val);
+	}
+
+	return (0xff);
+}
+
+static
+unsigned char ne2000_get_reg_2 (ne2000_t *ne, unsigned reg)
+{
+	switch (reg) {
+	case 0x01:
+		return (ne->pstart);
+
+	case 0x02:
+		return (ne->pstop);
+
+	case 0x04:
+		return (ne->tpsr);
+
+	case 0x0c:
+		return (ne->rcr);
+
+	case 0x0d:
+		return (ne->tcr);
+
+	case 0x0e:
+		return (ne->dcr);
+
+	case 0x0f:
+		return (ne->imr);
+	}
+
+	return (0xff);
+}
+
+static
+unsigned char ne2000_get_uint8 (ne2000_t *ne, unsigned long addr)
+{
+	unsigned reg;
+
+	addr &= 0x1f;
+
+	if (addr >= 0x18) {
+		ne2000_reset (ne);
+		return (0);
+	}
+
+	if (addr >= 0x10) {
+		return (ne2000_get_data (ne));
+	}
+
+	reg = addr & 0x0f;
+
+	if (reg == 0) {
+		return (ne->cr);
+	}
+
+	switch ((ne->cr >> 6) & 3) {
+	case 0:
+		return (ne2000_get_reg_0 (ne, reg));
+
+	case 1:
+		if (reg < 7) {
+			return (ne->par[reg - 1]);
+		}
+		else if (reg == 7) {
+			return (ne->curr);
+		}
+
+		return (ne->mar[reg - 8]);
+
+	case 2:
+		return (ne2000_get_reg_2 (ne, reg));
+	}
+
+	return (0xff);
+}
+
+static
+void ne2000_set_reg_0 (ne2000_t *ne, unsigned reg, unsigned char val)
+{
+	switch (reg) {
+	case 0x01:
+		ne->pstart = val;
+		break;
+
+	case 0x02:
+		ne->pstop = val;
+		break;
+
+	case 0x03:
+		ne->bnry = val;
+		break;
+
+	case 0x04:
+		ne->tpsr = val;
+		break;
+
+	case 0x05:
+		ne->tbcr = (ne->tbcr & 0xff00) | val;
+		break;
+
+	case 0x06:
+		ne->tbcr = (ne->tbcr & 0x00ff) | (val << 8);
+		break;
+
+	case 0x07:
+		ne->isr &= ~(val & 0x7f);
+		ne2000_set_irq (ne);
+		break;
+
+	case 0x08:
+		ne->rsar = (ne->rsar & 0xff00) | val;
+		break;
+
+	case 0x09:
+		ne->rsar = (ne->rsar & 0x00ff) | (val << 8);
+		break;
+
+	case 0x0a:
+		ne->rbcr = (ne->rbcr & 0xff00) | val;
+		break;
+
+	case 0x0b:
+		ne->rbcr = (ne->rbcr & 0x00ff) | (val << 8);
+		break;
+
+	case 0x0c:
+		ne->rcr = val;
+		break;
+
+	case 0x0d:
+		ne->tcr = val;
+		break;
+
+	case 0x0e:
+		ne->dcr = val;
+		break;
+
+	case 0x0f:
+		ne->imr = val;
+		ne2000_set_irq (ne);
+		break;
+	}
+}
+
+static
+void ne2000_set_uint8 (ne2000_t *ne, unsigned long addr, unsigned char val)
+{
+	unsigned reg;
+
+	addr &= 0x1f;
+
+	if (addr >= 0x18) {
+		return;
+	}
+
+	if (addr >= 0x10) {
+		ne2000_set_data (ne, val);
+		return;
+	}
+
+	reg = addr & 0x0f;
+
+	if (reg == 0) {
+		ne2000_set_cr (ne, val);
+		return;
+	}
+
+	switch ((ne->cr >> 6) & 3) {
+	case 0:
+		ne2000_set_reg_0 (ne, reg, val);
+		break;
+
+	case 1:
+		if (reg < 7) {
+			ne->par[reg - 1] = val;
+		}
+		else if (reg == 7) {
+			ne->curr = val;
+		}
+		else {
+			ne->mar[reg - 8] = val;
+		}
+		break;
+	}
+}
+
+/*
+ * Only the data port transfers a word. Other registers are accessed as
+ * two bytes, and the high byte of a word access at 0x0f or 0x1f, which
+ * would reach the data port or lie outside of the ports, is dropped.
+ */
+static
+int ne2000_hi_byte_valid (unsigned long addr)
+{
+	addr = (addr + 1) & 0x1f;
+
+	return ((addr != 0x10) && (addr != 0x00));
+}
+
+static
+unsigned short ne2000_get_uint16 (ne2000_t *ne, unsigned long addr)
+{
+	unsigned short val;
+
+	addr &= 0x1f;
+
+	if (addr == 0x10) {
+		val = ne2000_get_uint8 (ne, addr);
+		val |= ne2000_get_uint8 (ne, addr) << 8;
+	}
+	else {
+		val = ne2000_get_uint8 (ne, addr);
+
+		if (ne2000_hi_byte_valid (addr)) {
+			val |= ne2000_get_uint8 (ne, addr + 1) << 8;
+		}
+		else {
+			val |= 0xff00;
+		}
+	}
+
+	return (val);
+}
+
+static
+void ne2000_set_uint16 (ne2000_t *ne, unsigned long addr, unsigned short val)
+{
+	addr &= 0x1f;
+
+	if (addr == 0x10) {
+		ne2000_set_uint8 (ne, addr, val & 0xff);
+		ne2000_set_uint8 (ne, addr, (val >> 8) & 0xff);
+	}
+	else {
+		ne2000_set_uint8 (ne, addr, val & 0xff);
+
+		if (ne2000_hi_byte_valid (addr)) {
+			ne2000_set_uint8 (ne, addr + 1, (val >> 8) & 0xff);
+		}
+	}
+}
+
+static
+void ne2000_close (ne2000_t *ne)
+{
+#ifndef PCE_HOST_WINDOWS
+	if (ne->fd >= 0) {
+		chr_io_free (&ne->io);
+		close (ne->fd);
+		ne->fd = -1;
+	}
+
+	if (ne->sock_name != NULL) {
+		unlink (ne->sock_name);
+	}
+#endif
+
+	free (ne->sock_name);
+	free (ne->peer_name);
+
+	ne->sock_name = NULL;
+	ne->peer_name = NULL;
+}
+
+void ne2000_init (ne2000_t *ne, unsigned long addr)
+{
+	mem_blk_init (&ne->port, addr, 0x20, 0);
+	ne->port.ext = ne;
+	ne->port.get_uint8 = (mem_get_uint8_f) ne2000_get_uint8;
+	ne->port.set_uint8 = (mem_set_uint8_f) ne2000_set_uint8;
+	ne->port.get_uint16 = (mem_get_uint16_f) ne2000_get_uint16;
+	ne->port.set_uint16 = (mem_set_uint16_f) ne2000_set_uint16;
+
+	ne->ram = mem_blk_new (NE2000_RAM_BASE, NE2000_RAM_SIZE, 1);
+
+	if (ne->ram != NULL) {
+		mem_blk_clear (ne->ram, 0x00);
+	}
+
+	ne->fd = -1;
+#ifndef PCE_HOST_WINDOWS
+	chr_io_init (&ne->io, -1, 0);
+#endif
+	ne->sock_name = NULL;
+	ne->peer_name = NULL;
+
+	ne->tx_cnt = 0;
+	ne->rx_cnt = 0;
+	ne->drop_cnt = 0;
+
+	ne->irq_val = 0;
+	ne->irq_ext = NULL;
+	ne->irq = NULL;
+
+	ne->dcr = 0;
+
+	memset (ne->par, 0, 6);
+	memset (ne->mar, 0, 8);
+
+	ne2000_set_mac (ne, ne2000_def_mac);
+
+	ne2000_reset (ne);
+}
+
+ne2000_t *ne2000_new (unsigned long addr)
+{
+	ne2000_t *ne;
+
+	ne = malloc (sizeof (ne2000_t));
+
+	if (ne == NULL) {
+		return (NULL);
+	}
+
+	ne2000_init (ne, addr);
+
+	if (ne->ram == NULL) {
+		free (ne);
+		return (NULL);
+	}
+
+	return (ne);
+}
+
+void ne2000_free (ne2000_t *ne)
+{
+	ne2000_close (ne);
+
+	mem_blk_del (ne->ram);
+	mem_blk_free (&ne->port);
+}
+
+void ne2000_del (ne2000_t *ne)
+{
+	if (ne != NULL) {
+		ne2000_free (ne);
+		free (ne);
+	}
+}
+
+mem_blk_t *ne2000_get_reg (ne2000_t *ne)
+{
+	return (&ne->port);
+}
+
+void ne2000_set_irq_fct (ne2000_t *ne, void *ext, void *fct)
+{
+	ne->irq_ext = ext;
+	ne->irq = fct;
+}
+
+void ne2000_set_mac (ne2000_t *ne, const unsigned char *mac)
+{
+	unsigned i;
+
+	memcpy (ne->mac, mac, 6);
+
+	/* each PROM byte appears twice in the remote DMA address space */
+	for (i = 0; i < 16; i++) {
+		ne->prom[2 * i] = (i < 6) ? mac[i] : 0x00;
+		ne->prom[2 * i + 1] = ne->prom[2 * i];
+	}
+
+	/* the NE2000 signature */
+	ne->prom[28] = 0x57;
+	ne->prom[29] = 0x57;
+	ne->prom[30] = 0x57;
+	ne->prom[31] = 0x57;
+}
+
+int ne2000_set_mac_str (ne2000_t *ne, const char *str)
+{
+	unsigned      i, v;
+	unsigned char mac[6];
+
+	for (i = 0; i < 6; i++) {
+		if (sscanf (str, "%2x", &v) != 1) {
+			return (1);
+		}
+
+		mac[i] = v;
+
+		while ((*str != 0) && (*str != ':') && (*str != '-')) {
+			str += 1;
+		}
+
+		if (*str != 0) {
+			str += 1;
+		}
+		else if (i < 5) {
+			return (1);
+		}
+	}
+
+	ne2000_set_mac (ne, mac);
+
+	return (0);
+}
+
+#ifndef PCE_HOST_WINDOWS
+
+static
+int ne2000_open_tap (ne2000_t *ne, const char *driver)
+{
+#ifdef PCE_ENABLE_TUN
+	char *name;
+
+	name = drv_get_option (driver, "if");
+
+	if (name == NULL) {
+		return (1);
+	}
+
+	ne->fd = tap_open (name);
+
+	free (name);
+
+	if (ne->fd < 0) {
+		return (1);
+	}
+
+	return (0);
+#else
+	return (1);
+#endif
+}
+
+static
+int ne2000_open_socket (ne2000_t *ne, const char *driver)
+{
+	struct sockaddr_un addr;
+
+	ne->sock_name = drv_get_option (driver, "path");
+	ne->peer_name = drv_get_option (driver, "peer");
+
+	if ((ne->sock_name == NULL) || (ne->peer_name == NULL)) {
+		return (1);
+	}
+
+	if (strlen (ne->sock_name) >= sizeof (addr.sun_path)) {
+		return (1);
+	}
+
+	ne->fd = socket (AF_UNIX, SOCK_DGRAM, 0);
+
+	if (ne->fd < 0) {
+		return (1);
+	}
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, ne->sock_name);
+
+	unlink (ne->sock_name);
+
+	if (bind (ne->fd, (struct sockaddr *) &addr, sizeof (addr))) {
+		return (1);
+	}
+
+	return (0);
+}
+
+#endif
+
+int ne2000_set_driver (ne2000_t *ne, const char *driver)
+{
+	int r;
+
+	ne2000_close (ne);
+
+	if (driver == NULL) {
+		return (0);
+	}
+
+#ifndef PCE_HOST_WINDOWS
+	if (strncmp (driver, "tap", 3) == 0) {
+		r = ne2000_open_tap (ne, driver);
+	}
+	else if (strncmp (driver, "socket", 6) == 0) {
+		r = ne2000_open_socket (ne, driver);
+	}
+	else {
+		r = 1;
+	}
+
+	if (r == 0) {
+		/* packets are read directly, only track readiness */
+		chr_io_init (&ne->io, ne->fd, CHR_IO_RAW | CHR_IO_NONBLOCK);
+	}
+#else
+	r = 1;
+#endif
+
+	if (r) {
+		ne2000_close (ne);
+	}
+
+	return (r);
+}
+
+void ne2000_reset (ne2000_t *ne)
+{
+	ne->cr = NE_CR_STP | 0x20;
+	ne->isr = NE_ISR_RST;
+	ne->imr = 0;
+	ne->rcr = 0;
+	ne->tcr = 0;
+	ne->tsr = 0;
+	ne->rsr = 0;
+	ne->ncr = 0;
+
+	ne->pstart = 0x46;
+	ne->pstop = 0x80;
+	ne->bnry = 0x46;
+	ne->curr = 0x47;
+	ne->tpsr = 0x40;
+
+	ne->tbcr = 0;
+	ne->rsar = 0;
+	ne->rbcr = 0;
+
+	ne->cntr[0] = 0;
+	ne->cntr[1] = 0;
+	ne->cntr[2] = 0;
+
+	ne2000_set_irq (ne);
+}
+
+void ne2000_clock (ne2000_t *ne, unsigned long cnt)
+{
+#ifndef PCE_HOST_WINDOWS
+	unsigned i;
+	ssize_t  r;
+
+	if (ne->fd < 0) {
+		return;
+	}
+
+	for (i = 0; i < NE_RX_BURST; i++) {
+		if (chr_io_ready (&ne->io, CHR_IO_IN) == 0) {
+			break;
+		}
+
+		r = read (ne->fd, ne->buf, NE2000_PKT_MAX);
+
+		if (r <= 0) {
+			chr_io_clear (&ne->io, CHR_IO_IN);
+			break;
+		}
+
+		ne->rx_cnt += 1;
+
+		ne2000_receive (ne, ne->buf, r);
+	}
+#endif
+}
@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/devices/ne2000.h                                         *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_DEVICES_NE2000_H
+#define PCE_DEVICES_NE2000_H 1
+
+
+#include <devices/memory.h>
+
+#include <drivers/char/char-io.h>
+
+
+/* the on-board buffer memory in the remote DMA address space */
+#define NE2000_RAM_BASE 0x4000
+#define NE2000_RAM_SIZE 0x4000
+
+#define NE2000_PKT_MAX  1536
+
+
+typedef struct ne2000_t {
+	mem_blk_t     port;
+
+	/* the packet buffer, including the receive ring */
+	mem_blk_t     *ram;
+
+	unsigned char prom[32];
+	unsigned char mac[6];
+
+	unsigned char cr;
+	unsigned char isr;
+	unsigned char imr;
+	unsigned char dcr;
+	unsigned char rcr;
+	unsigned char tcr;
+	unsigned char tsr;
+	unsigned char rsr;
+	unsigned char ncr;
+
+	unsigned char pstart;
+	unsigned char pstop;
+	unsigned char bnry;
+	unsigned char curr;
+	unsigned char tpsr;
+
+	unsigned short tbcr;
+
+	unsigned short rsar;
+	unsigned short rbcr;
+
+	unsigned char par[6];
+	unsigned char mar[8];
+
+	unsigned char cntr[3];
+
+	/* the host side: -1 if not connected */
+	int           fd;
+	chr_io_t      io;
+	char          *sock_name;
+	char          *peer_name;
+
+	unsigned long tx_cnt;
+	unsigned long rx_cnt;
+	unsigned long drop_cnt;
+
+	unsigned char irq_val;
+	void          *irq_ext;
+	void          (*irq) (void *ext, unsigned char val);
+
+	unsigned char buf[NE2000_PKT_MAX];
+} ne2000_t;
+
+
+void ne2000_init (ne2000_t *ne, unsigned long addr);
+ne2000_t *ne2000_new (unsigned long addr);
+void ne2000_free (ne2000_t *ne);
+void ne2000_del (ne2000_t *ne);
+
+mem_blk_t *ne2000_get_reg (ne2000_t *ne);
+
+void ne2000_set_irq_fct (ne2000_t *ne, void *ext, void *fct);
+
+void ne2000_set_mac (ne2000_t *ne, const unsigned char *mac);
+
+/*!***************************************************************************
+ * @short Set the MAC address from a string of the form "xx:xx:xx:xx:xx:xx"
+ *****************************************************************************/
+int ne2000_set_mac_str (ne2000_t *ne, const char *str);
+
+/*!***************************************************************************
+ * @short Connect the adapter to the host
+ *
+ * Supported drivers are:
+ *   tap:if=<interface>
+ *   socket:path=<socket>:peer=<socket>
+ *
+ * The socket driver exchanges one packet per datagram over a Unix domain
+ * socket. Two instances can be connected by swapping path and peer.
+ *****************************************************************************/
+int ne2000_set_driver (ne2000_t *ne, const char *driver);
+
+void ne2000_reset (ne2000_t *ne);
+
+void ne2000_clock (ne2000_t *ne, unsigned long cnt);
+
+
+#endif
@@ -853,6 +853,7 @@ unsigned char cga_get_status (cga_t *cga)
 	unsigned char val;
 
 	pce_video_clock1 (&cga->video, 0);
+	e6845_sync (&cga->crtc);
 
 	val = cga->reg[CGA_STATUS];
 	val |= (CGA_STATUS_VSYNC | CGA_STATUS_SYNC);
@@ -880,6 +881,7 @@ static
 void cga_set_pen_set (cga_t *cga, unsigned char val)
 {
 	pce_video_clock1 (&cga->video, 0);
+	e6845_sync (&cga->crtc);
 	cga->reg[CGA_STATUS] |= CGA_STATUS_PEN;
 	e6845_set_pen (&cga->crtc);
 }
@@ -923,6 +925,9 @@ static
 void cga_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	cga_t *cga = (cga_t *)ext;
+
+	e6845_sync (&cga->crtc);
+
 	switch (addr) {
 	case CGA_CRTC_INDEX:
 	case CGA_CRTC_INDEX0:
@@ -991,6 +996,9 @@ static
 void cga_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	cga_t *cga = (cga_t *)ext;
+
+	e6845_sync (&cga->crtc);
+
 	cga->mem[addr & 0x3fff] = val;
 	cga->mod_cnt = 2;
 }
@@ -999,11 +1007,40 @@ static
 void cga_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 {
 	cga_t *cga = (cga_t *)ext;
+
+	e6845_sync (&cga->crtc);
+
 	cga->mem[(addr + 0) & 0x3fff] = val & 0xff;
 	cga->mem[(addr + 1) & 0x3fff] = (val >> 8) & 0xff;
 	cga->mod_cnt = 2;
 }
 
+static
+void cga_mem_set_blk (void *ext, unsigned long addr, const unsigned char *buf, unsigned long cnt)
+{
+	unsigned long n;
+	cga_t         *cga = (cga_t *)ext;
+
+	e6845_sync (&cga->crtc);
+
+	while (cnt > 0) {
+		addr &= 0x3fff;
+		n = 0x4000 - addr;
+
+		if (n > cnt) {
+			n = cnt;
+		}
+
+		memcpy (cga->mem + addr, buf, n);
+
+		addr += n;
+		buf += n;
+		cnt -= n;
+	}
+
+	cga->mod_cnt = 2;
+}
+
 static
 int cga_set_msg (cga_t *cga, const char *msg, const char *val)
 {
@@ -1112,6 +1149,8 @@ void cga_print_info (cga_t *cga, FILE *fp)
 	crt = &cga->crtc;
 	reg = cga->reg;
 
+	e6845_sync (crt);
+
 	status = cga_get_status (cga);
 
 	base = e6845_get_start_address (crt);
@@ -1209,6 +1248,7 @@ void cga_init (cga_t *cga, unsigned long io, unsigned long addr)
 	cga->memblk = mem_blk_new (addr, 16384, 1);
 	mem_blk_set_fget (cga->memblk, cga, cga_mem_get_uint8, cga_mem_get_uint16, NULL);
 	mem_blk_set_fset (cga->memblk, cga, cga_mem_set_uint8, cga_mem_set_uint16, NULL);
+	mem_blk_set_fblk (cga->memblk, cga_mem_set_blk);
 	mem_blk_clear (cga->memblk, 0x00);
 	cga->mem = mem_blk_get_data (cga->memblk);
 	mem_blk_set_size (cga->memblk, 32768);
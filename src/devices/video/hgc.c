@@ -380,6 +380,7 @@ unsigned char hgc_get_status (hgc_t *hgc)
 	unsigned char val;
 
 	pce_video_clock1 (&hgc->video, 0);
+	e6845_sync (&hgc->crtc);
 
 	val = hgc->reg[HGC_STATUS];
 	val &= ~(HGC_STATUS_VSYNC | HGC_STATUS_HSYNC | HGC_STATUS_VIDEO);
@@ -417,6 +418,7 @@ static
 void hgc_set_pen_set (hgc_t *hgc, unsigned char val)
 {
 	pce_video_clock1 (&hgc->video, 0);
+	e6845_sync (&hgc->crtc);
 	hgc->reg[HGC_STATUS] |= HGC_STATUS_PEN;
 	e6845_set_pen (&hgc->crtc);
 }
@@ -498,6 +500,9 @@ static
 void hgc_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	hgc_t *hgc = (hgc_t *)ext;
+
+	e6845_sync (&hgc->crtc);
+
 	switch (addr) {
 	case HGC_CRTC_INDEX:
 		e6845_set_index (&hgc->crtc, val);
@@ -564,6 +569,9 @@ static
 void hgc_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	hgc_t *hgc = (hgc_t *)ext;
+
+	e6845_sync (&hgc->crtc);
+
 	hgc->mem[addr & 0xffff] = val;
 	hgc->mod_cnt = 2;
 }
@@ -572,6 +580,9 @@ static
 void hgc_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 {
 	hgc_t *hgc = (hgc_t *)ext;
+
+	e6845_sync (&hgc->crtc);
+
 	hgc->mem[(addr + 0) & 0xffff] = val & 0xff;
 	hgc->mem[(addr + 1) & 0xffff] = (val >> 8) & 0xff;
 	hgc->mod_cnt = 2;
@@ -608,6 +619,8 @@ void hgc_print_info (hgc_t *hgc, FILE *fp)
 	e6845_t       *crt;
 
 	crt = &hgc->crtc;
+
+	e6845_sync (crt);
 	reg = hgc->reg;
 
 	status = hgc_get_status (hgc);
@@ -300,6 +300,7 @@ unsigned char mda_get_status (mda_t *mda)
 	unsigned char val;
 
 	pce_video_clock1 (&mda->video, 0);
+	e6845_sync (&mda->crtc);
 
 	val = mda->reg[MDA_STATUS] | 0xf0;
 	val &= ~(MDA_STATUS_HSYNC | MDA_STATUS_VIDEO);
@@ -355,6 +356,9 @@ static
 void mda_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	mda_t *mda = (mda_t *)ext;
+
+	e6845_sync (&mda->crtc);
+
 	switch (addr) {
 	case MDA_CRTC_INDEX:
 		e6845_set_index (&mda->crtc, val);
@@ -405,6 +409,9 @@ static
 void mda_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	mda_t *mda = (mda_t *)ext;
+
+	e6845_sync (&mda->crtc);
+
 	mda->mem[addr & 0x0fff] = val;
 	mda->mod_cnt = 2;
 }
@@ -413,6 +420,9 @@ static
 void mda_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 {
 	mda_t *mda = (mda_t *)ext;
+
+	e6845_sync (&mda->crtc);
+
 	mda->mem[(addr + 0) & 0x0fff] = val & 0xff;
 	mda->mem[(addr + 1) & 0x0fff] = (val >> 8) & 0xff;
 	mda->mod_cnt = 2;
@@ -448,6 +458,8 @@ void mda_print_info (mda_t *mda, FILE *fp)
 	e6845_t       *crt;
 
 	crt = &mda->crtc;
+
+	e6845_sync (crt);
 	reg = mda->reg;
 
 	status = mda_get_status (mda);
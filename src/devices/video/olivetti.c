@@ -506,6 +506,7 @@ unsigned char m24_get_status (m24_t *m24)
 	unsigned char val;
 
 	pce_video_clock1 (&m24->video, 0);
+	e6845_sync (&m24->crtc);
 
 	val = m24->reg[M24_STATUS];
 	val |= (M24_STATUS_VSYNC | M24_STATUS_SYNC);
@@ -576,6 +577,9 @@ static
 void m24_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	m24_t *m24 = (m24_t *)ext;
+
+	e6845_sync (&m24->crtc);
+
 	switch (addr) {
 	case M24_CRTC_INDEX:
 	case M24_CRTC_INDEX0:
@@ -667,6 +671,9 @@ static
 void m24_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	m24_t *m24 = (m24_t *)ext;
+
+	e6845_sync (&m24->crtc);
+
 	m24->mem[addr & 0x7fff] = val;
 	m24->mod_cnt = 2;
 }
@@ -675,6 +682,9 @@ static
 void m24_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 {
 	m24_t *m24 = (m24_t *)ext;
+
+	e6845_sync (&m24->crtc);
+
 	m24->mem[(addr + 0) & 0x7fff] = val & 0xff;
 	m24->mem[(addr + 1) & 0x7fff] = (val >> 8) & 0xff;
 	m24->mod_cnt = 2;
@@ -710,6 +720,8 @@ void m24_print_info (m24_t *m24, FILE *fp)
 	e6845_t       *crt;
 
 	crt = &m24->crtc;
+
+	e6845_sync (crt);
 	reg = m24->reg;
 
 	status = m24_get_status (m24);
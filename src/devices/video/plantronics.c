@@ -568,6 +568,7 @@ unsigned char pla_get_status (plantronics_t *pla)
 	unsigned char val;
 
 	pce_video_clock1 (&pla->video, 0);
+	e6845_sync (&pla->crtc);
 
 	val = pla->reg[PLA_STATUS];
 	val |= (PLA_STATUS_VSYNC | PLA_STATUS_SYNC);
@@ -655,6 +656,9 @@ static
 void pla_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	plantronics_t *pla = (plantronics_t *)ext;
+
+	e6845_sync (&pla->crtc);
+
 	switch (addr) {
 	case PLA_CRTC_INDEX:
 	case PLA_CRTC_INDEX0:
@@ -726,6 +730,9 @@ static
 void pla_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	plantronics_t *pla = (plantronics_t *)ext;
+
+	e6845_sync (&pla->crtc);
+
 	if (pla_alternate_plane (pla)) {
 		addr ^= 0x4000;
 	}
@@ -740,6 +747,9 @@ static
 void pla_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 {
 	plantronics_t *pla = (plantronics_t *)ext;
+
+	e6845_sync (&pla->crtc);
+
 	if (pla_alternate_plane (pla)) {
 		addr ^= 0x4000;
 	}
@@ -823,6 +833,8 @@ void pla_print_info (plantronics_t *pla, FILE *fp)
 	e6845_t       *crt;
 
 	crt = &pla->crtc;
+
+	e6845_sync (crt);
 	reg = pla->reg;
 
 	status = pla_get_status (pla);
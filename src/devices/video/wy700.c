@@ -823,6 +823,7 @@ unsigned char wy700_get_status (wy700_t *wy)
 	unsigned char val;
 
 	pce_video_clock1 (&wy->video, 0);
+	e6845_sync (&wy->crtc);
 
 	val = wy->reg[WY700_STATUS];
 
@@ -931,6 +932,9 @@ static
 void wy700_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	wy700_t *wy = (wy700_t *)ext;
+
+	e6845_sync (&wy->crtc);
+
 	switch (addr) {
 	case WY700_CRTC_INDEX:
 	case WY700_CRTC_INDEX0:
@@ -1021,6 +1025,9 @@ static
 void wy700_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 {
 	wy700_t *wy = (wy700_t *)ext;
+
+	e6845_sync (&wy->crtc);
+
 	addr &= 0x1ffff;
 
 	if (addr <= 0xffff) {
@@ -1075,6 +1082,8 @@ void wy700_print_info (wy700_t *wy, FILE *fp)
 
 	crt = &wy->crtc;
 
+	e6845_sync (crt);
+
 	status = wy700_get_status (wy);
 
 	base = e6845_get_start_address (crt);
@@ -24,9 +24,27 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
-#define COW_MAGIC 0x434f5720
+
+#define COW_MAGIC   0x434f5720
+#define COW_JMAGIC  0x434f574a
+
+/* the bitmap is written back in chunks of this size */
+#define COW_CHUNK   512
+
+/* write back the bitmap after this many bitmap updates */
+#define COW_WB_MAX  256
+
+/* write back the bitmap at most this many seconds after an update */
+#define COW_WB_TIME 5
+
+/* the number of blocks that are copied at once in a commit */
+#define COW_COPY    128
 
 /*
  * COW image file format
@@ -35,9 +53,29 @@
  * 8   4  block count
  * 12  4  bitmap start
  * 16  4  data start
+ *
+ * Bitmap journal, between the bitmap and the data area. Images
+ * that have no room for it there are written without a journal.
+ * 0   4  magic (COWJ)
+ * 4   4  chunk count
+ * 8   4  checksum
+ * 12  n  chunks (4 bytes chunk index, COW_CHUNK bytes bitmap data)
  */
 
 
+/*
+ * Flush the file and wait until it has reached the disk
+ */
+static
+void cow_sync (disk_cow_t *cow)
+{
+	fflush (cow->fp);
+
+#ifdef HAVE_FSYNC
+	fsync (fileno (cow->fp));
+#endif
+}
+
 static
 int cow_read_bitmap (disk_cow_t *cow)
 {
@@ -55,74 +93,332 @@ int cow_write_bitmap (disk_cow_t *cow)
 		return (1);
 	}
 
+	cow_sync (cow);
+
+	return (0);
+}
+
+static
+uint32_t cow_get_chunk_cnt (const disk_cow_t *cow)
+{
+	return ((cow->bitmap_size + COW_CHUNK - 1) / COW_CHUNK);
+}
+
+static
+uint32_t cow_get_chunk_size (const disk_cow_t *cow, uint32_t idx)
+{
+	uint32_t n;
+
+	n = cow->bitmap_size - COW_CHUNK * idx;
+
+	return ((n < COW_CHUNK) ? n : COW_CHUNK);
+}
+
+static
+uint32_t cow_get_checksum (const unsigned char *buf, uint32_t cnt)
+{
+	uint32_t i, v;
+
+	v = 0;
+
+	for (i = 0; i < cnt; i++) {
+		v = ((v << 5) | (v >> 27)) ^ buf[i];
+	}
+
+	return (v & 0xffffffff);
+}
+
+static
+int cow_clear_journal (disk_cow_t *cow)
+{
+	unsigned char buf[4];
+
+	if (cow->journal_offset == 0) {
+		return (0);
+	}
+
+	dsk_set_uint32_be (buf, 0, 0);
+
+	if (dsk_write (cow->fp, buf, cow->journal_offset, 4)) {
+		return (1);
+	}
+
 	fflush (cow->fp);
 
 	return (0);
 }
 
 /*
- * - check if block blk is copied, return true if so.
- * - check how many blocks, starting at blk have the same status
- *   and return that number in cnt.
- * - cnt on output <= cnt on input.
+ * Write the dirty bitmap chunks to the journal
  */
 static
-int cow_get_block (disk_cow_t *cow, uint32_t blk, uint32_t *cnt)
+int cow_write_journal (disk_cow_t *cow)
 {
-	int           r;
-	uint32_t      i, n;
-	unsigned char m, v;
+	uint32_t      i, j, n, cnt;
+	unsigned char *buf, *p;
 
-	i = blk / 8;
-	n = *cnt;
-	m = 0x80 >> (blk & 7);
+	cnt = 12 + cow->bitmap_dirty_cnt * (4 + COW_CHUNK);
 
-	r = (cow->bitmap[i] & m) != 0;
+	if ((buf = malloc (cnt)) == NULL) {
+		return (1);
+	}
 
-	*cnt = 1;
+	p = buf + 12;
+	n = cow_get_chunk_cnt (cow);
 
-	if (n <= 1) {
-		return (r);
+	for (i = 0; i < n; i++) {
+		if (cow->bitmap_dirty[i]) {
+			j = cow_get_chunk_size (cow, i);
+
+			dsk_set_uint32_be (p, 0, i);
+			memset (p + 4, 0, COW_CHUNK);
+			memcpy (p + 4, cow->bitmap + COW_CHUNK * i, j);
+
+			p += 4 + COW_CHUNK;
+		}
 	}
 
-	n = n - 1;
-	v = r ? 0xff : 0x00;
+	dsk_set_uint32_be (buf, 0, COW_JMAGIC);
+	dsk_set_uint32_be (buf, 4, cow->bitmap_dirty_cnt);
+	dsk_set_uint32_be (buf, 8, cow_get_checksum (buf + 12, cnt - 12));
 
-	/* i, m refer to first data block */
+	if (dsk_write (cow->fp, buf, cow->journal_offset, cnt)) {
+		free (buf);
+		return (1);
+	}
 
-	while (n > 0) {
-		if (m == 0x01) {
-			i += 1;
-			m = 0x80;
-
-			/* skip runs of 8 blocks */
-			while ((n >= 8) && (cow->bitmap[i] == v)) {
-				i += 1;
-				n -= 8;
-				*cnt += 8;
-			}
+	free (buf);
+
+	return (0);
+}
 
-			if (n == 0) {
-				return (r);
+/*
+ * Write the dirty bitmap chunks back to the file. The chunks are
+ * written to the journal first, so that a torn bitmap write can be
+ * repaired when the image is opened again. The data blocks, the
+ * journal and the bitmap each reach the disk before the next step.
+ */
+static
+int cow_flush_bitmap (disk_cow_t *cow)
+{
+	uint32_t i, j, n;
+
+	cow->bitmap_wr_cnt = 0;
+
+	if (cow->bitmap_dirty_cnt == 0) {
+		return (0);
+	}
+
+	cow_sync (cow);
+
+	if (cow->journal_offset != 0) {
+		if (cow_write_journal (cow)) {
+			return (1);
+		}
+
+		cow_sync (cow);
+	}
+
+	n = cow_get_chunk_cnt (cow);
+
+	for (i = 0; i < n; i++) {
+		if (cow->bitmap_dirty[i]) {
+			j = COW_CHUNK * i;
+
+			if (dsk_write (cow->fp, cow->bitmap + j, cow->bitmap_offset + j, cow_get_chunk_size (cow, i))) {
+				return (1);
 			}
+
+			cow->bitmap_dirty[i] = 0;
 		}
-		else {
-			m = m >> 1;
+	}
+
+	cow->bitmap_dirty_cnt = 0;
+
+	cow_sync (cow);
+
+	if (cow_clear_journal (cow)) {
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Replay the bitmap journal if the last write back was interrupted.
+ */
+static
+int cow_replay_journal (disk_cow_t *cow)
+{
+	uint32_t      i, n, idx, cnt;
+	unsigned char hdr[12];
+	unsigned char *buf, *p;
+
+	if (cow->journal_offset == 0) {
+		return (0);
+	}
+
+	if (dsk_read (cow->fp, hdr, cow->journal_offset, 12)) {
+		return (1);
+	}
+
+	if (dsk_get_uint32_be (hdr, 0) != COW_JMAGIC) {
+		return (0);
+	}
+
+	n = dsk_get_uint32_be (hdr, 4);
+
+	if ((n == 0) || (n > cow_get_chunk_cnt (cow))) {
+		return (cow_clear_journal (cow));
+	}
+
+	cnt = n * (4 + COW_CHUNK);
+
+	if ((buf = malloc (cnt)) == NULL) {
+		return (1);
+	}
+
+	if (dsk_read (cow->fp, buf, cow->journal_offset + 12, cnt)) {
+		free (buf);
+		return (1);
+	}
+
+	if (cow_get_checksum (buf, cnt) != dsk_get_uint32_be (hdr, 8)) {
+		/* the journal itself is incomplete, the bitmap is intact */
+		free (buf);
+		return (cow_clear_journal (cow));
+	}
+
+	p = buf;
+
+	for (i = 0; i < n; i++) {
+		idx = dsk_get_uint32_be (p, 0);
+
+		if ((COW_CHUNK * idx) < cow->bitmap_size) {
+			memcpy (cow->bitmap + COW_CHUNK * idx, p + 4, cow_get_chunk_size (cow, idx));
 		}
 
-		if (((cow->bitmap[i] & m) != 0) != r) {
-			return (r);
+		p += 4 + COW_CHUNK;
+	}
+
+	free (buf);
+
+	if (cow_write_bitmap (cow)) {
+		return (1);
+	}
+
+	return (cow_clear_journal (cow));
+}
+
+/*
+ * Get 64 bits of the bitmap, the first block in the most significant bit
+ */
+static
+uint64_t cow_get_word (const unsigned char *map, uint32_t idx)
+{
+	const unsigned char *p;
+
+	p = map + 8 * idx;
+
+	return (((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48) |
+		((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32) |
+		((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16) |
+		((uint64_t) p[6] << 8) | (uint64_t) p[7]
+	);
+}
+
+/*
+ * Count the leading zero bits in v, which must not be 0
+ */
+static
+unsigned cow_clz64 (uint64_t v)
+{
+#ifdef __GNUC__
+	return (__builtin_clzll (v));
+#else
+	unsigned n;
+
+	n = 0;
+
+	while ((v >> 56) == 0) {
+		v <<= 8;
+		n += 8;
+	}
+
+	while ((v >> 63) == 0) {
+		v <<= 1;
+		n += 1;
+	}
+
+	return (n);
+#endif
+}
+
+/*
+ * Find the first block in [blk, end) whose bit in map is not val.
+ * Returns end if there is no such block.
+ */
+static
+uint32_t cow_find_bit (const unsigned char *map, uint32_t blk, uint32_t end, int val)
+{
+	uint32_t idx;
+	uint64_t inv, w;
+
+	inv = val ? ~(uint64_t) 0 : 0;
+
+	while (blk < end) {
+		idx = blk >> 6;
+
+		w = (cow_get_word (map, idx) ^ inv) & (~(uint64_t) 0 >> (blk & 63));
+
+		if (w != 0) {
+			blk = 64 * idx + cow_clz64 (w);
+
+			return ((blk < end) ? blk : end);
 		}
 
-		n -= 1;
-		*cnt += 1;
+		blk = 64 * (idx + 1);
+	}
+
+	return (end);
+}
+
+/*
+ * - check if block blk is copied, return true if so.
+ * - check how many blocks, starting at blk have the same status
+ *   and return that number in cnt.
+ * - cnt on output <= cnt on input.
+ */
+static
+int cow_get_block (disk_cow_t *cow, uint32_t blk, uint32_t *cnt)
+{
+	int      r;
+	uint32_t n;
+
+	n = *cnt;
+
+	if (n > (cow->dsk.blocks - blk)) {
+		n = cow->dsk.blocks - blk;
+	}
+
+	r = (cow->bitmap[blk >> 3] & (0x80 >> (blk & 7))) != 0;
+
+	if (n <= 1) {
+		*cnt = 1;
+		return (r);
 	}
 
+	*cnt = cow_find_bit (cow->bitmap, blk + 1, blk + n, r) - blk;
+
 	return (r);
 }
 
+/*
+ * Set or clear the bits for cnt blocks starting at blk. The bitmap is
+ * only changed in memory, it is written back by cow_flush_bitmap().
+ */
 static
-int cow_set_block (disk_cow_t *cow, uint32_t blk, uint32_t cnt, int val)
+void cow_set_block (disk_cow_t *cow, uint32_t blk, uint32_t cnt, int val)
 {
 	uint32_t      i, i0, i1;
 	unsigned char m0, m1;
@@ -163,9 +459,35 @@ int cow_set_block (disk_cow_t *cow, uint32_t blk, uint32_t cnt, int val)
 		}
 	}
 
-	i1 = i1 - i0 + 1;
+	if (cow->bitmap_dirty_cnt == 0) {
+		cow->bitmap_wr_time = time (NULL);
+	}
+
+	for (i = i0 / COW_CHUNK; i <= (i1 / COW_CHUNK); i++) {
+		if (cow->bitmap_dirty[i] == 0) {
+			cow->bitmap_dirty[i] = 1;
+			cow->bitmap_dirty_cnt += 1;
+		}
+	}
+
+	cow->bitmap_wr_cnt += 1;
+}
+
+/*
+ * Check if the bitmap should be written back
+ */
+static
+int cow_check_flush (disk_cow_t *cow)
+{
+	if (cow->bitmap_dirty_cnt == 0) {
+		return (0);
+	}
+
+	if (cow->bitmap_wr_cnt >= COW_WB_MAX) {
+		return (1);
+	}
 
-	if (dsk_write (cow->fp, cow->bitmap + i0, cow->bitmap_offset + i0, i1)) {
+	if ((time (NULL) - cow->bitmap_wr_time) >= COW_WB_TIME) {
 		return (1);
 	}
 
@@ -207,6 +529,12 @@ int dsk_cow_read (disk_t *dsk, void *buf, uint32_t i, uint32_t n)
 		ofs += 512 * cnt;
 	}
 
+	if (cow_check_flush (cow)) {
+		if (cow_flush_bitmap (cow)) {
+			return (1);
+		}
+	}
+
 	return (0);
 }
 
@@ -247,22 +575,27 @@ int dsk_cow_write (disk_t *dsk, const void *buf, uint32_t i, uint32_t n)
 		ofs += 512 * cnt;
 	}
 
+	if (cow_check_flush (cow)) {
+		if (cow_flush_bitmap (cow)) {
+			return (1);
+		}
+	}
+
 	fflush (cow->fp);
 
 	return (0);
 }
 
 static
-int cow_commit_block (disk_cow_t *cow, uint32_t blk, unsigned cnt)
+int cow_commit_block (disk_cow_t *cow, uint32_t blk, uint32_t cnt, unsigned char *buf)
 {
-	unsigned      i, n;
-	uint64_t      ofs;
-	unsigned char buf[8 * 512];
+	uint32_t n;
+	uint64_t ofs;
 
 	ofs = cow->data_offset + 512 * (uint64_t) blk;
 
 	while (cnt > 0) {
-		n = (cnt <= 8) ? cnt : 8;
+		n = (cnt <= COW_COPY) ? cnt : COW_COPY;
 
 		if (dsk_read (cow->fp, buf, ofs, 512 * n)) {
 			return (1);
@@ -272,17 +605,31 @@ int cow_commit_block (disk_cow_t *cow, uint32_t blk, unsigned cnt)
 			return (1);
 		}
 
-		memset (buf, 0, 512 * n);
+		blk += n;
+		ofs += 512 * n;
+		cnt -= n;
+	}
+
+	return (0);
+}
+
+static
+int cow_clear_data (disk_cow_t *cow, uint32_t blk, uint32_t cnt, unsigned char *buf)
+{
+	uint32_t n;
+	uint64_t ofs;
+
+	ofs = cow->data_offset + 512 * (uint64_t) blk;
+
+	memset (buf, 0, 512 * COW_COPY);
+
+	while (cnt > 0) {
+		n = (cnt <= COW_COPY) ? cnt : COW_COPY;
 
 		if (dsk_write (cow->fp, buf, ofs, 512 * n)) {
 			return (1);
 		}
 
-		for (i = 0; i < n; i++) {
-			cow->bitmap[(blk + i) >> 3] &= ~(0x80 >> ((blk + i) & 7));
-		}
-
-		blk += n;
 		ofs += 512 * n;
 		cnt -= n;
 	}
@@ -290,56 +637,92 @@ int cow_commit_block (disk_cow_t *cow, uint32_t blk, unsigned cnt)
 	return (0);
 }
 
+/*
+ * Copy all modified blocks to the original disk. Runs of modified
+ * blocks are copied in one piece. The copied blocks are cleared in the
+ * cow file only after the new bitmap has been written.
+ */
 static
 int dsk_cow_commit (disk_t *dsk)
 {
 	int           r;
-	unsigned      k;
-	uint32_t      i, n;
-	uint32_t      blk;
-	unsigned char msk;
+	uint32_t      i, blk, end, cnt;
+	unsigned char *buf, *map;
 	disk_cow_t    *cow;
 
 	cow = dsk->ext;
 
-	r = 0;
-	n = 0;
+	if ((buf = malloc (512 * COW_COPY)) == NULL) {
+		return (1);
+	}
 
-	for (i = 0; i < cow->bitmap_size; i++) {
-		msk = cow->bitmap[i];
-		blk = 8 * i;
+	if ((map = malloc (cow->bitmap_size + 8)) == NULL) {
+		free (buf);
+		return (1);
+	}
 
-		while (msk != 0) {
-			while ((msk & 0x80) == 0) {
-				msk = (msk << 1) & 0xff;
-				blk += 1;
-			}
+	memcpy (map, cow->bitmap, cow->bitmap_size + 8);
 
-			k = 0;
-			while (msk & 0x80) {
-				k += 1;
-				msk = (msk << 1) & 0xff;
-			}
+	r = 0;
+	cnt = 0;
+	blk = 0;
 
-			if (cow_commit_block (cow, blk, k) == 0) {
-				n += k;
-			}
-			else {
-				r = 1;
-			}
+	while (1) {
+		blk = cow_find_bit (cow->bitmap, blk, cow->dsk.blocks, 0);
 
-			blk += k;
+		if (blk >= cow->dsk.blocks) {
+			break;
 		}
+
+		end = cow_find_bit (cow->bitmap, blk, cow->dsk.blocks, 1);
+
+		if (cow_commit_block (cow, blk, end - blk, buf) == 0) {
+			cow_set_block (cow, blk, end - blk, 0);
+			cnt += end - blk;
+		}
+		else {
+			r = 1;
+		}
+
+		blk = end;
 	}
 
-	if (n > 0) {
-		if (cow_write_bitmap (cow)) {
+	if (cnt > 0) {
+		if (cow_flush_bitmap (cow)) {
+			free (map);
+			free (buf);
 			return (1);
 		}
+
+		/* the blocks that were committed */
+		for (i = 0; i < cow->bitmap_size; i++) {
+			map[i] &= ~cow->bitmap[i];
+		}
+
+		blk = 0;
+
+		while (1) {
+			blk = cow_find_bit (map, blk, cow->dsk.blocks, 0);
+
+			if (blk >= cow->dsk.blocks) {
+				break;
+			}
+
+			end = cow_find_bit (map, blk, cow->dsk.blocks, 1);
+
+			if (cow_clear_data (cow, blk, end - blk, buf)) {
+				r = 1;
+			}
+
+			blk = end;
+		}
 	}
 
 	fflush (cow->fp);
 
+	free (map);
+	free (buf);
+
 	return (r);
 }
 
@@ -366,14 +749,33 @@ void dsk_cow_del (disk_t *dsk)
 
 	cow = dsk->ext;
 
+	cow_flush_bitmap (cow);
+
 	dsk_del (cow->orig);
 
 	fclose (cow->fp);
 
+	free (cow->bitmap_dirty);
 	free (cow->bitmap);
 	free (cow);
 }
 
+/*
+ * Get the journal size and offset. The journal is placed after the
+ * bitmap, if there is room for it before the data area.
+ */
+static
+uint64_t cow_get_journal_size (const disk_cow_t *cow)
+{
+	return (12 + (uint64_t) cow_get_chunk_cnt (cow) * (4 + COW_CHUNK));
+}
+
+static
+uint64_t cow_get_journal_offset (const disk_cow_t *cow)
+{
+	return ((cow->bitmap_offset + cow->bitmap_size + 511) & ~(uint64_t) 511);
+}
+
 static
 int dsk_cow_create (disk_cow_t *cow)
 {
@@ -381,7 +783,9 @@ int dsk_cow_create (disk_cow_t *cow)
 
 	cow->bitmap_size = (cow->dsk.blocks + 7) / 8;
 	cow->bitmap_offset = 20;
-	cow->data_offset = (20 + cow->bitmap_size + 511) & (~511UL);
+	cow->journal_offset = cow_get_journal_offset (cow);
+	cow->data_offset = cow->journal_offset + cow_get_journal_size (cow);
+	cow->data_offset = (cow->data_offset + 511) & ~(uint64_t) 511;
 
 	dsk_set_uint32_be (buf, 0, COW_MAGIC);
 	dsk_set_uint32_be (buf, 4, 0);
@@ -395,6 +799,10 @@ int dsk_cow_create (disk_cow_t *cow)
 
 	memset (cow->bitmap, 0, cow->bitmap_size);
 
+	if (cow_clear_journal (cow)) {
+		return (1);
+	}
+
 	if (cow_write_bitmap (cow)) {
 		return (1);
 	}
@@ -425,11 +833,20 @@ int dsk_cow_open (disk_cow_t *cow)
 
 	cow->bitmap_offset = dsk_get_uint32_be (buf, 12);
 	cow->data_offset = dsk_get_uint32_be (buf, 16);
+	cow->journal_offset = cow_get_journal_offset (cow);
+
+	if ((cow->journal_offset + cow_get_journal_size (cow)) > cow->data_offset) {
+		cow->journal_offset = 0;
+	}
 
 	if (cow_read_bitmap (cow)) {
 		return (1);
 	}
 
+	if (cow_replay_journal (cow)) {
+		return (1);
+	}
+
 	return (0);
 }
 
@@ -483,13 +900,27 @@ disk_t *dsk_cow_new (disk_t *dsk, const char *fname)
 	cow->orig = dsk;
 
 	cow->bitmap_size = (cow->dsk.blocks + 7) / 8;
-	cow->bitmap = (unsigned char *) malloc (cow->bitmap_size);
+
+	/* padded for 64 bit accesses */
+	cow->bitmap = (unsigned char *) calloc (cow->bitmap_size + 8, 1);
 	if (cow->bitmap == NULL) {
 		free (cow);
 		return (NULL);
 	}
 
+	cow->bitmap_dirty = calloc ((cow->bitmap_size + COW_CHUNK - 1) / COW_CHUNK + 1, 1);
+	if (cow->bitmap_dirty == NULL) {
+		free (cow->bitmap);
+		free (cow);
+		return (NULL);
+	}
+
+	cow->bitmap_dirty_cnt = 0;
+	cow->bitmap_wr_cnt = 0;
+	cow->bitmap_wr_time = 0;
+
 	if (dsk_cow_open_file (cow, fname)) {
+		free (cow->bitmap_dirty);
 		free (cow->bitmap);
 		free (cow);
 		return (NULL);
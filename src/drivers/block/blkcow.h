@@ -30,6 +30,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <time.h>
 
 
 /*!***************************************************************************
@@ -47,6 +48,19 @@ typedef struct {
 
 	unsigned char *bitmap;
 	uint32_t      bitmap_size;
+
+	/* one flag per COW_CHUNK bytes of the bitmap */
+	unsigned char *bitmap_dirty;
+	uint32_t      bitmap_dirty_cnt;
+
+	/* bitmap updates since the last write back */
+	unsigned      bitmap_wr_cnt;
+
+	/* the time of the first bitmap update since the last write back */
+	time_t        bitmap_wr_time;
+
+	/* 0 if the image has no journal */
+	uint64_t      journal_offset;
 } disk_cow_t;
 
 
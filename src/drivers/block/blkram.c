@@ -25,6 +25,83 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+/*
+ * Map an anonymous zero-filled area and place a private mapping of
+ * the image file over its beginning. Neither is touched until the
+ * guest accesses it.
+ */
+static
+int dsk_ram_map (disk_ram_t *ram, const char *fname)
+{
+#if defined (HAVE_SYS_MMAN_H) && defined (MAP_ANONYMOUS)
+	int         fd;
+	size_t      size, fsize;
+	void        *p;
+	struct stat st;
+
+	size = 512 * (size_t) ram->dsk.blocks;
+
+	if ((size == 0) || ((size / 512) != ram->dsk.blocks)) {
+		return (1);
+	}
+
+	p = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (p == MAP_FAILED) {
+		return (1);
+	}
+
+	if (fname != NULL) {
+		fd = open (fname, O_RDONLY);
+
+		if (fd < 0) {
+			munmap (p, size);
+			return (1);
+		}
+
+		if (fstat (fd, &st) || !S_ISREG (st.st_mode)) {
+			close (fd);
+			munmap (p, size);
+			return (1);
+		}
+
+		fsize = ((uint64_t) st.st_size < size) ? (size_t) st.st_size : size;
+
+		if (fsize > 0) {
+			if (mmap (p, fsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+				close (fd);
+				munmap (p, size);
+				return (1);
+			}
+		}
+
+		close (fd);
+	}
+
+	ram->data = p;
+	ram->mapped = 1;
+
+	return (0);
+#else
+	return (1);
+#endif
+}
+
+static
+void dsk_ram_unmap (disk_ram_t *ram)
+{
+#ifdef HAVE_SYS_MMAN_H
+	munmap (ram->data, 512 * (size_t) ram->dsk.blocks);
+#endif
+}
 
 static
 int dsk_ram_load (disk_ram_t *ram, const char *fname)
@@ -87,7 +164,13 @@ void dsk_ram_del (disk_t *dsk)
 
 	ram = dsk->ext;
 
-	free (ram->data);
+	if (ram->mapped) {
+		dsk_ram_unmap (ram);
+	}
+	else {
+		free (ram->data);
+	}
+
 	free (ram);
 }
 
@@ -110,6 +193,16 @@ disk_t *dsk_ram_open (const char *fname, uint32_t n, uint32_t c, uint32_t h, uin
 	ram->dsk.read = dsk_ram_read;
 	ram->dsk.write = dsk_ram_write;
 
+	ram->mapped = 0;
+
+	if (dsk_ram_map (ram, fname) == 0) {
+		if (fname != NULL) {
+			dsk_set_fname (&ram->dsk, fname);
+		}
+
+		return (&ram->dsk);
+	}
+
 	ram->data = malloc (512 * ram->dsk.blocks);
 	if (ram->data == NULL) {
 		free (ram);
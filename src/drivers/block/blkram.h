@@ -39,9 +39,19 @@ typedef struct {
 	disk_t        dsk;
 
 	unsigned char *data;
+
+	/* data is a private mapping instead of allocated memory */
+	char          mapped;
 } disk_ram_t;
 
 
+/*!***************************************************************************
+ * @short Create a ram disk
+ * @param fname The initial disk contents or NULL
+ *
+ * If possible, the image file is mapped copy-on-write, so that only the
+ * blocks that are actually used are read and writes never reach the file.
+ *****************************************************************************/
 disk_t *dsk_ram_open (const char *fname, uint32_t n, uint32_t c, uint32_t h, uint32_t s, int ro);
 
 
@@ -23,7 +23,121 @@
 #include "blkraw.h"
 
 #include <stdlib.h>
+#include <string.h>
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+
+static
+int dsk_img_pread (disk_img_t *img, void *buf, uint64_t ofs, uint64_t cnt)
+{
+#ifdef HAVE_PREAD
+	ssize_t       r;
+	unsigned char *p;
+
+	p = buf;
+
+	while (cnt > 0) {
+		r = pread (fileno (img->fp), p, cnt, ofs);
+
+		if (r < 0) {
+			return (1);
+		}
+
+		if (r == 0) {
+			/* past the end of the file */
+			memset (p, 0, cnt);
+			break;
+		}
+
+		p += r;
+		ofs += r;
+		cnt -= r;
+	}
+
+	return (0);
+#else
+	return (dsk_read (img->fp, buf, ofs, cnt));
+#endif
+}
+
+static
+int dsk_img_pwrite (disk_img_t *img, const void *buf, uint64_t ofs, uint64_t cnt)
+{
+#ifdef HAVE_PWRITE
+	ssize_t             r;
+	const unsigned char *p;
+
+	p = buf;
+
+	while (cnt > 0) {
+		r = pwrite (fileno (img->fp), p, cnt, ofs);
+
+		if (r <= 0) {
+			return (1);
+		}
+
+		p += r;
+		ofs += r;
+		cnt -= r;
+	}
+
+	return (0);
+#else
+	int r;
+
+	r = dsk_write (img->fp, buf, ofs, cnt);
+
+	/* make the data visible through the mapping */
+	fflush (img->fp);
+
+	return (r);
+#endif
+}
+
+static
+void dsk_img_map (disk_img_t *img, uint64_t size)
+{
+#ifdef HAVE_SYS_MMAN_H
+	void *p;
+
+	if ((size == 0) || ((size_t) size != size)) {
+		return;
+	}
+
+	/*
+	 * A shared mapping lets all instances that use the same base
+	 * image share the page cache.
+	 */
+	p = mmap (NULL, size, PROT_READ, MAP_SHARED, fileno (img->fp), 0);
+
+	if (p == MAP_FAILED) {
+		return;
+	}
+
+	img->map = p;
+	img->map_size = size;
+#endif
+}
+
+static
+void dsk_img_unmap (disk_img_t *img)
+{
+#ifdef HAVE_SYS_MMAN_H
+	if (img->map != NULL) {
+		munmap (img->map, img->map_size);
+	}
+#endif
+
+	img->map = NULL;
+	img->map_size = 0;
+}
 
 static
 int dsk_img_read (disk_t *dsk, void *buf, uint32_t i, uint32_t n)
@@ -40,7 +154,12 @@ int dsk_img_read (disk_t *dsk, void *buf, uint32_t i, uint32_t n)
 	ofs = img->start + 512 * (uint64_t) i;
 	cnt = 512 * (uint64_t) n;
 
-	if (dsk_read (img->fp, buf, ofs, cnt)) {
+	if ((img->map != NULL) && ((ofs + cnt) <= img->map_size)) {
+		memcpy (buf, img->map + ofs, cnt);
+		return (0);
+	}
+
+	if (dsk_img_pread (img, buf, ofs, cnt)) {
 		return (1);
 	}
 
@@ -66,12 +185,10 @@ int dsk_img_write (disk_t *dsk, const void *buf, uint32_t i, uint32_t n)
 	ofs = img->start + 512 * (uint64_t) i;
 	cnt = 512 * (uint64_t) n;
 
-	if (dsk_write (img->fp, buf, ofs, cnt)) {
+	if (dsk_img_pwrite (img, buf, ofs, cnt)) {
 		return (1);
 	}
 
-	fflush (img->fp);
-
 	return (0);
 }
 
@@ -82,6 +199,8 @@ void dsk_img_del (disk_t *dsk)
 
 	img = dsk->ext;
 
+	dsk_img_unmap (img);
+
 	fclose (img->fp);
 	free (img);
 }
@@ -111,23 +230,26 @@ disk_t *dsk_img_open_size (FILE *fp, uint32_t n, uint64_t ofs, int ro)
 
 	img->fp = fp;
 
+	img->map = NULL;
+	img->map_size = 0;
+
 	return (&img->dsk);
 }
 
 disk_t *dsk_img_open_fp (FILE *fp, uint64_t ofs, int ro)
 {
-	uint64_t cnt;
+	uint64_t size, cnt;
 	disk_t   *dsk;
 
-	if (dsk_get_filesize (fp, &cnt)) {
+	if (dsk_get_filesize (fp, &size)) {
 		return (NULL);
 	}
 
-	if (cnt <= ofs) {
+	if (size <= ofs) {
 		return (NULL);
 	}
 
-	cnt = (cnt - ofs) / 512;
+	cnt = (size - ofs) / 512;
 
 	if (cnt == 0) {
 		return (NULL);
@@ -139,6 +261,10 @@ disk_t *dsk_img_open_fp (FILE *fp, uint64_t ofs, int ro)
 		return (NULL);
 	}
 
+	if (ro) {
+		dsk_img_map (dsk->ext, size);
+	}
+
 	dsk_guess_geometry (dsk);
 
 	return (dsk);
@@ -36,11 +36,15 @@
  * @short The image file disk structure
  *****************************************************************************/
 typedef struct {
-	disk_t   dsk;
+	disk_t        dsk;
 
-	FILE     *fp;
+	FILE          *fp;
 
-	uint64_t start;
+	uint64_t      start;
+
+	/* a shared read-only mapping of the entire file, or NULL */
+	unsigned char *map;
+	uint64_t      map_size;
 } disk_img_t;
 
 
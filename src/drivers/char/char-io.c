@@ -0,0 +1,774 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/drivers/char/char-io.c                                   *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#ifdef PCE_HOST_LINUX
+#include <sys/epoll.h>
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <drivers/char/char-io.h>
+
+
+#define CHR_IO_EVENTS 64
+
+
+/*
+ * The reactor of one owner. Each emulated machine has its own, so that
+ * machines running on different threads never touch each other's file
+ * descriptors. A reactor is only used by one thread at a time.
+ */
+typedef struct chr_io_grp_t {
+	struct chr_io_grp_t *next;
+
+	void                *owner;
+
+	chr_io_t            *list;
+	unsigned long       last;
+	int                 force;
+
+	/* the time of the current iteration, set by chr_io_poll() */
+	char                clock;
+	unsigned long       now;
+
+#ifdef PCE_HOST_LINUX
+	int                 epfd;
+#else
+	unsigned            pfd_max;
+	struct pollfd       *pfd;
+#endif
+} chr_io_grp_t;
+
+
+static chr_io_grp_t chr_io_dflt = {
+	NULL, NULL, NULL, 0, 1, 0, 0,
+#ifdef PCE_HOST_LINUX
+	-1
+#else
+	0, NULL
+#endif
+};
+
+/* protects the list of reactors */
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t chr_io_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  chr_io_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   chr_io_key;
+#else
+static chr_io_grp_t    *chr_io_cur = &chr_io_dflt;
+#endif
+
+
+static
+unsigned long chr_io_get_us (void)
+{
+#ifdef PCE_HOST_LINUX
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return (1000000UL * (unsigned long) ts.tv_sec + ts.tv_nsec / 1000);
+#else
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+
+	return (1000000UL * (unsigned long) tv.tv_sec + tv.tv_usec);
+#endif
+}
+
+static
+int chr_io_set_nonblock (int fd)
+{
+	int fl;
+
+	fl = fcntl (fd, F_GETFL);
+
+	if (fl == -1) {
+		return (1);
+	}
+
+	if (fcntl (fd, F_SETFL, fl | O_NONBLOCK) == -1) {
+		return (1);
+	}
+
+	return (0);
+}
+
+#ifdef HAVE_PTHREAD_H
+static
+void chr_io_key_init (void)
+{
+	pthread_key_create (&chr_io_key, NULL);
+}
+#endif
+
+/*
+ * Get the reactor of the current thread
+ */
+static
+chr_io_grp_t *chr_io_get_grp (void)
+{
+#ifdef HAVE_PTHREAD_H
+	chr_io_grp_t *grp;
+
+	pthread_once (&chr_io_once, chr_io_key_init);
+
+	grp = pthread_getspecific (chr_io_key);
+
+	return ((grp != NULL) ? grp : &chr_io_dflt);
+#else
+	return (chr_io_cur);
+#endif
+}
+
+void chr_io_set_owner (void *owner)
+{
+	chr_io_grp_t *grp;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&chr_io_lock);
+#endif
+
+	grp = &chr_io_dflt;
+
+	while ((grp != NULL) && (grp->owner != owner)) {
+		grp = grp->next;
+	}
+
+	if (grp == NULL) {
+		grp = malloc (sizeof (chr_io_grp_t));
+
+		if (grp == NULL) {
+			grp = &chr_io_dflt;
+		}
+		else {
+			grp->owner = owner;
+			grp->list = NULL;
+			grp->last = 0;
+			grp->force = 1;
+			grp->clock = 0;
+			grp->now = 0;
+#ifdef PCE_HOST_LINUX
+			grp->epfd = -1;
+#else
+			grp->pfd_max = 0;
+			grp->pfd = NULL;
+#endif
+
+			grp->next = chr_io_dflt.next;
+			chr_io_dflt.next = grp;
+		}
+	}
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&chr_io_lock);
+
+	pthread_once (&chr_io_once, chr_io_key_init);
+	pthread_setspecific (chr_io_key, grp);
+#else
+	chr_io_cur = grp;
+#endif
+}
+
+void chr_io_del_owner (void *owner)
+{
+	chr_io_grp_t *grp, *tmp;
+	chr_io_t     *io, *next;
+
+	if (owner == NULL) {
+		return;
+	}
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&chr_io_lock);
+#endif
+
+	tmp = &chr_io_dflt;
+
+	while ((tmp->next != NULL) && (tmp->next->owner != owner)) {
+		tmp = tmp->next;
+	}
+
+	grp = tmp->next;
+
+	if (grp != NULL) {
+		tmp->next = grp->next;
+	}
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&chr_io_lock);
+#endif
+
+	if (grp == NULL) {
+		return;
+	}
+
+	if (chr_io_get_grp() == grp) {
+#ifdef HAVE_PTHREAD_H
+		pthread_setspecific (chr_io_key, NULL);
+#else
+		chr_io_cur = &chr_io_dflt;
+#endif
+	}
+
+	/* file descriptors that are still registered are always ready */
+	io = grp->list;
+
+	while (io != NULL) {
+		next = io->next;
+
+		if (io->out_cnt > 0) {
+			io->ready |= CHR_IO_OUT;
+			chr_io_flush (io);
+		}
+
+		io->grp = NULL;
+		io->always = 1;
+		io->ready = CHR_IO_IN | CHR_IO_OUT;
+		io->next = NULL;
+
+		io = next;
+	}
+
+#ifdef PCE_HOST_LINUX
+	if (grp->epfd >= 0) {
+		close (grp->epfd);
+	}
+#else
+	free (grp->pfd);
+#endif
+
+	free (grp);
+}
+
+#ifdef PCE_HOST_LINUX
+
+static
+int chr_io_watch (chr_io_grp_t *grp, chr_io_t *io)
+{
+	struct epoll_event evt;
+
+	if (grp->epfd < 0) {
+		grp->epfd = epoll_create (16);
+
+		if (grp->epfd < 0) {
+			return (1);
+		}
+	}
+
+	evt.events = EPOLLIN | EPOLLOUT;
+	evt.data.ptr = io;
+
+	if (epoll_ctl (grp->epfd, EPOLL_CTL_ADD, io->fd, &evt)) {
+		return (1);
+	}
+
+	return (0);
+}
+
+static
+void chr_io_unwatch (chr_io_grp_t *grp, chr_io_t *io)
+{
+	struct epoll_event evt;
+
+	if (grp->epfd >= 0) {
+		epoll_ctl (grp->epfd, EPOLL_CTL_DEL, io->fd, &evt);
+	}
+}
+
+static
+void chr_io_check (chr_io_grp_t *grp)
+{
+	int                i, n;
+	unsigned           val;
+	chr_io_t           *io;
+	struct epoll_event evt[CHR_IO_EVENTS];
+
+	if (grp->epfd < 0) {
+		return;
+	}
+
+	n = epoll_wait (grp->epfd, evt, CHR_IO_EVENTS, 0);
+
+	for (i = 0; i < n; i++) {
+		io = evt[i].data.ptr;
+
+		val = 0;
+
+		if (evt[i].events & EPOLLIN) {
+			val |= CHR_IO_IN;
+		}
+
+		if (evt[i].events & EPOLLOUT) {
+			val |= CHR_IO_OUT;
+		}
+
+		if (evt[i].events & (EPOLLHUP | EPOLLERR)) {
+			val |= CHR_IO_IN | CHR_IO_HUP;
+		}
+
+		io->ready = val;
+	}
+}
+
+#else
+
+static
+int chr_io_watch (chr_io_grp_t *grp, chr_io_t *io)
+{
+	unsigned      cnt;
+	chr_io_t      *tmp;
+	struct pollfd *pfd;
+
+	cnt = 1;
+	tmp = grp->list;
+
+	while (tmp != NULL) {
+		cnt += 1;
+		tmp = tmp->next;
+	}
+
+	if (cnt > grp->pfd_max) {
+		pfd = realloc (grp->pfd, cnt * sizeof (struct pollfd));
+
+		if (pfd == NULL) {
+			return (1);
+		}
+
+		grp->pfd = pfd;
+		grp->pfd_max = cnt;
+	}
+
+	return (0);
+}
+
+static
+void chr_io_unwatch (chr_io_grp_t *grp, chr_io_t *io)
+{
+}
+
+static
+void chr_io_check (chr_io_grp_t *grp)
+{
+	unsigned      i, n;
+	unsigned      val;
+	chr_io_t      *io;
+	struct pollfd *pfd;
+
+	n = 0;
+	io = grp->list;
+	pfd = grp->pfd;
+
+	while ((io != NULL) && (n < grp->pfd_max)) {
+		if (io->always == 0) {
+			pfd[n].fd = io->fd;
+			pfd[n].events = POLLIN | POLLOUT;
+			pfd[n].revents = 0;
+			n += 1;
+		}
+
+		io = io->next;
+	}
+
+	if (n == 0) {
+		return;
+	}
+
+	if (poll (pfd, n, 0) <= 0) {
+		return;
+	}
+
+	i = 0;
+	io = grp->list;
+
+	while ((io != NULL) && (i < n)) {
+		if (io->always == 0) {
+			val = 0;
+
+			if (pfd[i].revents & POLLIN) {
+				val |= CHR_IO_IN;
+			}
+
+			if (pfd[i].revents & POLLOUT) {
+				val |= CHR_IO_OUT;
+			}
+
+			if (pfd[i].revents & (POLLHUP | POLLERR)) {
+				val |= CHR_IO_IN | CHR_IO_HUP;
+			}
+
+			io->ready = val;
+
+			i += 1;
+		}
+
+		io = io->next;
+	}
+}
+
+#endif
+
+int chr_io_init (chr_io_t *io, int fd, unsigned flags)
+{
+	chr_io_grp_t *grp;
+
+	io->next = NULL;
+	io->grp = NULL;
+
+	io->fd = fd;
+	io->flags = flags;
+
+	io->always = 0;
+	io->ready = 0;
+
+	io->inp_idx = 0;
+	io->inp_cnt = 0;
+
+	io->out_cnt = 0;
+
+	if (fd < 0) {
+		return (1);
+	}
+
+	if (flags & CHR_IO_NONBLOCK) {
+		chr_io_set_nonblock (fd);
+	}
+
+	grp = chr_io_get_grp();
+
+	if (chr_io_watch (grp, io)) {
+		/* regular files can't be watched but are always ready */
+		io->always = 1;
+		io->ready = CHR_IO_IN | CHR_IO_OUT;
+	}
+
+	io->grp = grp;
+
+	io->next = grp->list;
+	grp->list = io;
+
+	grp->force = 1;
+
+	return (0);
+}
+
+void chr_io_free (chr_io_t *io)
+{
+	chr_io_grp_t *grp;
+	chr_io_t     *tmp;
+
+	if (io->fd < 0) {
+		return;
+	}
+
+	grp = io->grp;
+
+	if (io->out_cnt > 0) {
+		io->ready |= CHR_IO_OUT;
+		chr_io_flush (io);
+	}
+
+	/* the reactor is NULL if it was deleted by chr_io_del_owner() */
+	if (grp != NULL) {
+		if (io->always == 0) {
+			chr_io_unwatch (grp, io);
+		}
+
+		if (grp->list == io) {
+			grp->list = io->next;
+		}
+		else {
+			tmp = grp->list;
+
+			while ((tmp != NULL) && (tmp->next != io)) {
+				tmp = tmp->next;
+			}
+
+			if (tmp != NULL) {
+				tmp->next = io->next;
+			}
+		}
+	}
+
+	io->next = NULL;
+	io->grp = NULL;
+	io->fd = -1;
+	io->ready = 0;
+}
+
+static
+void chr_io_poll_grp (chr_io_grp_t *grp)
+{
+	chr_io_t *io;
+
+	if (grp == NULL) {
+		return;
+	}
+
+	/* reactors that are never polled read the clock on every check */
+	if (grp->clock == 0) {
+		grp->now = chr_io_get_us();
+	}
+
+	if ((grp->force == 0) && ((grp->now - grp->last) < CHR_IO_INTERVAL)) {
+		return;
+	}
+
+	grp->last = grp->now;
+	grp->force = 0;
+
+	io = grp->list;
+
+	while (io != NULL) {
+		if (io->always == 0) {
+			io->ready = 0;
+		}
+
+		io = io->next;
+	}
+
+	chr_io_check (grp);
+
+	io = grp->list;
+
+	while (io != NULL) {
+		if (io->out_cnt > 0) {
+			chr_io_flush (io);
+		}
+
+		io = io->next;
+	}
+}
+
+void chr_io_poll (void)
+{
+	chr_io_grp_t *grp;
+
+	grp = chr_io_get_grp();
+
+	grp->clock = 1;
+	grp->now = chr_io_get_us();
+
+	chr_io_poll_grp (grp);
+}
+
+int chr_io_ready (chr_io_t *io, unsigned msk)
+{
+	chr_io_poll_grp (io->grp);
+
+	return ((io->ready & msk) != 0);
+}
+
+void chr_io_clear (chr_io_t *io, unsigned msk)
+{
+	if (io->always) {
+		msk &= ~(CHR_IO_IN | CHR_IO_OUT);
+	}
+
+	io->ready &= ~msk;
+}
+
+int chr_io_wait (chr_io_t *io, unsigned long us)
+{
+	int           r;
+	struct pollfd pfd;
+
+	if (io->fd < 0) {
+		return (-1);
+	}
+
+	if (io->ready & CHR_IO_HUP) {
+		return (-1);
+	}
+
+	if ((io->inp_cnt > 0) || (io->ready & CHR_IO_IN)) {
+		return (0);
+	}
+
+	pfd.fd = io->fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	r = poll (&pfd, 1, (us + 999) / 1000);
+
+	if (r <= 0) {
+		return (1);
+	}
+
+	if (pfd.revents & POLLIN) {
+		io->ready |= CHR_IO_IN;
+		return (0);
+	}
+
+	if (pfd.revents & (POLLHUP | POLLERR)) {
+		io->ready |= CHR_IO_HUP;
+	}
+
+	return (-1);
+}
+
+static
+int chr_io_fill (chr_io_t *io)
+{
+	ssize_t r;
+
+	if ((io->ready & CHR_IO_IN) == 0) {
+		return (1);
+	}
+
+	r = read (io->fd, io->inp, CHR_IO_BUF);
+
+	if (r > 0) {
+		io->inp_idx = 0;
+		io->inp_cnt = r;
+
+		/*
+		 * A blocking file descriptor is read only once per check,
+		 * a short read means it has been drained.
+		 */
+		if (((io->flags & CHR_IO_NONBLOCK) == 0) || (r < CHR_IO_BUF)) {
+			chr_io_clear (io, CHR_IO_IN);
+		}
+
+		return (0);
+	}
+
+	chr_io_clear (io, CHR_IO_IN);
+
+	if (r == 0) {
+		io->ready |= CHR_IO_HUP;
+	}
+	else if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+		io->ready |= CHR_IO_HUP;
+	}
+
+	return (1);
+}
+
+unsigned chr_io_read (chr_io_t *io, void *buf, unsigned cnt)
+{
+	if (io->fd < 0) {
+		return (0);
+	}
+
+	chr_io_poll_grp (io->grp);
+
+	if (io->inp_cnt == 0) {
+		if (chr_io_fill (io)) {
+			return (0);
+		}
+	}
+
+	if (cnt > io->inp_cnt) {
+		cnt = io->inp_cnt;
+	}
+
+	memcpy (buf, io->inp + io->inp_idx, cnt);
+
+	io->inp_idx += cnt;
+	io->inp_cnt -= cnt;
+
+	return (cnt);
+}
+
+unsigned chr_io_write (chr_io_t *io, const void *buf, unsigned cnt)
+{
+	unsigned n;
+
+	if (io->fd < 0) {
+		return (0);
+	}
+
+	chr_io_poll_grp (io->grp);
+
+	if (io->out_cnt >= CHR_IO_BUF) {
+		chr_io_flush (io);
+	}
+
+	n = CHR_IO_BUF - io->out_cnt;
+
+	if (cnt > n) {
+		cnt = n;
+	}
+
+	memcpy (io->out + io->out_cnt, buf, cnt);
+
+	io->out_cnt += cnt;
+
+	if (io->out_cnt >= CHR_IO_BUF) {
+		chr_io_flush (io);
+	}
+
+	return (cnt);
+}
+
+int chr_io_flush (chr_io_t *io)
+{
+	ssize_t r;
+
+	if (io->out_cnt == 0) {
+		return (0);
+	}
+
+	if ((io->ready & CHR_IO_OUT) == 0) {
+		return (1);
+	}
+
+	r = write (io->fd, io->out, io->out_cnt);
+
+	if (r < 0) {
+		chr_io_clear (io, CHR_IO_OUT);
+
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+			/* the output can't be delivered, drop it */
+			io->ready |= CHR_IO_HUP;
+			io->out_cnt = 0;
+		}
+
+		return (1);
+	}
+
+	if ((unsigned) r < io->out_cnt) {
+		memmove (io->out, io->out + r, io->out_cnt - r);
+		chr_io_clear (io, CHR_IO_OUT);
+	}
+
+	io->out_cnt -= r;
+
+	return (io->out_cnt > 0);
+}
@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/drivers/char/char-io.h                                   *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_DRIVERS_CHAR_IO_H
+#define PCE_DRIVERS_CHAR_IO_H 1
+
+
+#define CHR_IO_IN  0x01
+#define CHR_IO_OUT 0x02
+#define CHR_IO_HUP 0x04
+
+/* the file descriptor is owned by the driver and can be non-blocking */
+#define CHR_IO_NONBLOCK 0x01
+
+/* don't buffer data, only track readiness */
+#define CHR_IO_RAW      0x02
+
+#define CHR_IO_BUF 4096
+
+/* the minimum time between two checks of all file descriptors */
+#define CHR_IO_INTERVAL 1000
+
+
+/*!***************************************************************************
+ * @short A file descriptor watched by an I/O reactor
+ *
+ * Each owner (see chr_io_set_owner()) has its own reactor. All file
+ * descriptors registered with a reactor are checked together by a single
+ * system call at most once every CHR_IO_INTERVAL microseconds. In
+ * between, drivers only look at the ready flags, which costs nothing.
+ * Reads and writes are batched through the inp and out buffers.
+ *****************************************************************************/
+typedef struct chr_io_t {
+	struct chr_io_t *next;
+
+	/* the reactor this file descriptor is registered with */
+	struct chr_io_grp_t *grp;
+
+	int             fd;
+	unsigned        flags;
+
+	/* epoll can't watch this file descriptor, it is always ready */
+	char            always;
+
+	/* CHR_IO_IN, CHR_IO_OUT and CHR_IO_HUP */
+	unsigned        ready;
+
+	unsigned        inp_idx;
+	unsigned        inp_cnt;
+	unsigned char   inp[CHR_IO_BUF];
+
+	unsigned        out_cnt;
+	unsigned char   out[CHR_IO_BUF];
+} chr_io_t;
+
+
+/*!***************************************************************************
+ * @short Select the reactor used by the current thread
+ * @param owner An opaque pointer identifying the owner, usually the
+ *              emulated machine. NULL selects the default reactor.
+ *
+ * File descriptors registered by chr_io_init() are added to the reactor
+ * of the current owner. A machine that runs on a thread pool must set
+ * itself as the owner before it is created and before each time slice.
+ *****************************************************************************/
+void chr_io_set_owner (void *owner);
+
+/*!***************************************************************************
+ * @short Delete the reactor of an owner
+ *
+ * The epoll file descriptor and the reactor are freed. File descriptors
+ * that are still registered are detached from it and are always ready
+ * from then on. A thread that used the reactor falls back to the
+ * default reactor.
+ *****************************************************************************/
+void chr_io_del_owner (void *owner);
+
+/*!***************************************************************************
+ * @short Register a file descriptor with the current reactor
+ *****************************************************************************/
+int chr_io_init (chr_io_t *io, int fd, unsigned flags);
+
+/*!***************************************************************************
+ * @short Unregister a file descriptor
+ *
+ * Pending output is written before the file descriptor is removed. The
+ * file descriptor itself is not closed.
+ *****************************************************************************/
+void chr_io_free (chr_io_t *io);
+
+/*!***************************************************************************
+ * @short Check all file descriptors of the current reactor if the
+ *        interval has passed
+ *
+ * The time is read once here and cached for the readiness checks until
+ * the next call, so a machine should call this once per iteration of
+ * its main loop. Reactors that are never polled read the time on every
+ * readiness check instead.
+ *****************************************************************************/
+void chr_io_poll (void);
+
+/*!***************************************************************************
+ * @short Check if any of the conditions in msk are true
+ *****************************************************************************/
+int chr_io_ready (chr_io_t *io, unsigned msk);
+
+/*!***************************************************************************
+ * @short Clear ready flags after a read or write returned EAGAIN
+ *****************************************************************************/
+void chr_io_clear (chr_io_t *io, unsigned msk);
+
+/*!***************************************************************************
+ * @short Block until input is available
+ * @param us The maximum time to wait in microseconds
+ * @return 0 if input is available, 1 on timeout and -1 if waiting is
+ *         not possible
+ *****************************************************************************/
+int chr_io_wait (chr_io_t *io, unsigned long us);
+
+/*!***************************************************************************
+ * @short Read buffered data
+ * @return The number of bytes read
+ *
+ * If the other side has closed the connection, CHR_IO_HUP is set.
+ *****************************************************************************/
+unsigned chr_io_read (chr_io_t *io, void *buf, unsigned cnt);
+
+/*!***************************************************************************
+ * @short Queue data for writing
+ * @return The number of bytes accepted
+ *****************************************************************************/
+unsigned chr_io_write (chr_io_t *io, const void *buf, unsigned cnt);
+
+/*!***************************************************************************
+ * @short Write pending output
+ *****************************************************************************/
+int chr_io_flush (chr_io_t *io);
+
+
+#endif
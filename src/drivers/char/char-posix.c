@@ -26,39 +26,33 @@
 #include <limits.h>
 
 #include <fcntl.h>
-#include <poll.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-posix.h>
 
 
 static
-int chr_posix_check_fd (int fd, int rd, int wr)
+void chr_posix_init_io (char_posix_t *drv)
 {
-	int           r;
-	struct pollfd pfd[1];
+	unsigned flags;
 
-	if (fd < 0) {
-		return (1);
+	if (drv->fd_read >= 0) {
+		flags = (drv->fd_read > 2) ? CHR_IO_NONBLOCK : 0;
+		chr_io_init (&drv->io_read, drv->fd_read, flags);
 	}
 
-	pfd[0].fd = fd;
-	pfd[0].events = (rd ? POLLIN : 0) | (wr ? POLLOUT : 0);
-
-	r = poll (pfd, 1, 0);
-
-	if (r < 0) {
-		return (1);
+	if (drv->fd_write == drv->fd_read) {
+		/* a file descriptor can only be registered once */
+		drv->io_wr = &drv->io_read;
 	}
-
-	if ((pfd[0].revents & (POLLIN | POLLOUT)) == 0) {
-		return (1);
+	else if (drv->fd_write >= 0) {
+		flags = (drv->fd_write > 2) ? CHR_IO_NONBLOCK : 0;
+		chr_io_init (&drv->io_write, drv->fd_write, flags);
 	}
-
-	return (0);
 }
 
 static
@@ -68,6 +62,9 @@ void chr_posix_close (char_drv_t *cdrv)
 
 	drv = cdrv->ext;
 
+	chr_io_free (&drv->io_write);
+	chr_io_free (&drv->io_read);
+
 	if (drv->fd_write > 2) {
 		close (drv->fd_write);
 	}
@@ -95,7 +92,6 @@ static
 unsigned chr_posix_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 {
 	char_posix_t *drv;
-	ssize_t      r;
 
 	drv = cdrv->ext;
 
@@ -103,30 +99,27 @@ unsigned chr_posix_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 		return (0);
 	}
 
-	if (chr_posix_check_fd (drv->fd_read, 1, 0)) {
-		return (0);
-	}
+	return (chr_io_read (&drv->io_read, buf, cnt));
+}
 
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
+static
+int chr_posix_wait (char_drv_t *cdrv, unsigned long us)
+{
+	char_posix_t *drv;
 
-	r = read (drv->fd_read, buf, cnt);
+	drv = cdrv->ext;
 
-	if (r <= 0) {
-		return (0);
+	if (drv->fd_read < 0) {
+		return (-1);
 	}
 
-	return (r);
+	return (chr_io_wait (&drv->io_read, us));
 }
 
 static
 unsigned chr_posix_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 {
 	char_posix_t *drv;
-	ssize_t      r;
 
 	drv = cdrv->ext;
 
@@ -134,23 +127,7 @@ unsigned chr_posix_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 		return (cnt);
 	}
 
-	if (chr_posix_check_fd (drv->fd_write, 0, 1)) {
-		return (0);
-	}
-
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
-
-	r = write (drv->fd_write, buf, cnt);
-
-	if (r <= 0) {
-		return (0);
-	}
-
-	return (r);
+	return (chr_io_write (drv->io_wr, buf, cnt));
 }
 
 static
@@ -161,6 +138,7 @@ int chr_posix_init (char_posix_t *drv, const char *name)
 	drv->cdrv.close = chr_posix_close;
 	drv->cdrv.read = chr_posix_read;
 	drv->cdrv.write = chr_posix_write;
+	drv->cdrv.wait = chr_posix_wait;
 
 	drv->name = NULL;
 	drv->name_read = NULL;
@@ -169,6 +147,10 @@ int chr_posix_init (char_posix_t *drv, const char *name)
 	drv->fd_read = -1;
 	drv->fd_write = -1;
 
+	drv->io_read.fd = -1;
+	drv->io_write.fd = -1;
+	drv->io_wr = &drv->io_write;
+
 	drv->name = drv_get_option (name, "file");
 
 	if (drv->name == NULL) {
@@ -240,6 +222,8 @@ int chr_posix_init (char_posix_t *drv, const char *name)
 		}
 	}
 
+	chr_posix_init_io (drv);
+
 	return (0);
 }
 
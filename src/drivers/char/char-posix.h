@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 
 typedef struct {
@@ -38,6 +39,10 @@ typedef struct {
 
 	int        fd_read;
 	int        fd_write;
+
+	chr_io_t   io_read;
+	chr_io_t   io_write;
+	chr_io_t   *io_wr;
 } char_posix_t;
 
 
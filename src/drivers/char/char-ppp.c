@@ -32,6 +32,7 @@
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-ppp.h>
 
 
@@ -302,7 +303,7 @@ void tun_receive (char_ppp_t *drv)
 		return;
 	}
 
-	if (tun_check_packet (drv->tun_fd) == 0) {
+	if (chr_io_ready (&drv->tun_io, CHR_IO_IN) == 0) {
 		return;
 	}
 
@@ -315,6 +316,7 @@ void tun_receive (char_ppp_t *drv)
 	cnt = pk->cnt - pk->idx;
 
 	if (tun_get_packet (drv->tun_fd, pk->data + pk->idx, &cnt)) {
+		chr_io_clear (&drv->tun_io, CHR_IO_IN);
 		ppp_packet_free (drv, pk);
 		return;
 	}
@@ -1498,6 +1500,7 @@ void chr_ppp_close (char_drv_t *cdrv)
 	drv = cdrv->ext;
 
 	if (drv->tun_fd >= 0) {
+		chr_io_free (&drv->tun_io);
 		tun_close (drv->tun_fd);
 	}
 
@@ -1686,6 +1689,8 @@ int chr_ppp_init (char_ppp_t *drv, const char *name)
 		return (1);
 	}
 
+	chr_io_init (&drv->tun_io, drv->tun_fd, CHR_IO_RAW | CHR_IO_NONBLOCK);
+
 	if (chr_ppp_get_option_ip (name, "host-ip", drv->ip_local)) {
 		drv->ip_local[0] = 192;
 		drv->ip_local[0] = 168;
@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 #define PPP_MAX_MTU 4096
 
@@ -112,6 +113,7 @@ typedef struct char_ppp_s {
 
 	char           *tun_name;
 	int            tun_fd;
+	chr_io_t       tun_io;
 } char_ppp_t;
 
 
@@ -33,6 +33,7 @@
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-pty.h>
 
 
@@ -52,6 +53,8 @@ void chr_pty_close (char_drv_t *cdrv)
 		free (drv->ptsname);
 	}
 
+	chr_io_free (&drv->io);
+
 	if (drv->fd >= 0) {
 		close (drv->fd);
 	}
@@ -63,7 +66,6 @@ static
 unsigned chr_pty_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 {
 	char_pty_t *drv;
-	ssize_t    r;
 
 	drv = cdrv->ext;
 
@@ -71,26 +73,28 @@ unsigned chr_pty_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 		return (0);
 	}
 
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
+	/* a hangup only means that the slave side is not open */
+	return (chr_io_read (&drv->io, buf, cnt));
+}
 
-	r = read (drv->fd, buf, cnt);
+static
+int chr_pty_wait (char_drv_t *cdrv, unsigned long us)
+{
+	char_pty_t *drv;
 
-	if (r <= 0) {
-		return (0);
+	drv = cdrv->ext;
+
+	if (drv->fd < 0) {
+		return (-1);
 	}
 
-	return (r);
+	return (chr_io_wait (&drv->io, us));
 }
 
 static
 unsigned chr_pty_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 {
 	char_pty_t *drv;
-	ssize_t    r;
 
 	drv = cdrv->ext;
 
@@ -98,19 +102,7 @@ unsigned chr_pty_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 		return (cnt);
 	}
 
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
-
-	r = write (drv->fd, buf, cnt);
-
-	if (r <= 0) {
-		return (0);
-	}
-
-	return (r);
+	return (chr_io_write (&drv->io, buf, cnt));
 }
 
 static
@@ -143,24 +135,6 @@ int chr_pty_init_pt (char_pty_t *drv, int fd)
 	return (0);
 }
 
-static
-int chr_pty_set_nonblock (int fd)
-{
-	long fl;
-
-	fl = fcntl (fd, F_GETFD);
-
-	if (fl == -1) {
-		return (1);
-	}
-
-	if (fcntl (fd, F_SETFL, fl | O_NONBLOCK) == -1) {
-		return (1);
-	}
-
-	return (0);
-}
-
 static
 int chr_pty_disable_echo (int fd)
 {
@@ -190,9 +164,12 @@ int chr_pty_init (char_pty_t *drv, const char *name)
 	drv->cdrv.close = chr_pty_close;
 	drv->cdrv.read = chr_pty_read;
 	drv->cdrv.write = chr_pty_write;
+	drv->cdrv.wait = chr_pty_wait;
 
 	drv->ptsname = NULL;
 
+	drv->io.fd = -1;
+
 	drv->symlink = drv_get_option (name, "symlink");
 
 	drv->fd = posix_openpt (O_RDWR | O_NOCTTY);
@@ -205,9 +182,10 @@ int chr_pty_init (char_pty_t *drv, const char *name)
 		return (1);
 	}
 
-	chr_pty_set_nonblock (drv->fd);
 	chr_pty_disable_echo (drv->fd);
 
+	chr_io_init (&drv->io, drv->fd, CHR_IO_NONBLOCK);
+
 	if (drv->symlink != NULL) {
 		if (symlink (drv->ptsname, drv->symlink)) {
 			fprintf (stderr,
@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 
 typedef struct char_pty_t {
@@ -34,6 +35,8 @@ typedef struct char_pty_t {
 
 	int        fd;
 
+	chr_io_t   io;
+
 	char       *ptsname;
 	char       *symlink;
 } char_pty_t;
@@ -32,6 +32,7 @@
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-slip.h>
 
 
@@ -60,13 +61,14 @@ int slip_receive_packet (char_slip_t *drv)
 		return (1);
 	}
 
-	if (tun_check_packet (drv->tun_fd) == 0) {
+	if (chr_io_ready (&drv->tun_io, CHR_IO_IN) == 0) {
 		return (1);
 	}
 
 	n = SLIP_BUF_MAX;
 
 	if (tun_get_packet (drv->tun_fd, tmp, &n)) {
+		chr_io_clear (&drv->tun_io, CHR_IO_IN);
 		return (1);
 	}
 
@@ -133,6 +135,7 @@ void chr_slip_close (char_drv_t *cdrv)
 	drv = cdrv->ext;
 
 	if (drv->tun_fd >= 0) {
+		chr_io_free (&drv->tun_io);
 		tun_close (drv->tun_fd);
 	}
 
@@ -265,6 +268,8 @@ int chr_slip_init (char_slip_t *drv, const char *name)
 		return (1);
 	}
 
+	chr_io_init (&drv->tun_io, drv->tun_fd, CHR_IO_RAW | CHR_IO_NONBLOCK);
+
 	return (0);
 }
 
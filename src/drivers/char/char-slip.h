@@ -25,6 +25,7 @@
 
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 
 #define SLIP_BUF_MAX 4096
@@ -35,6 +36,7 @@ typedef struct char_slip_t {
 
 	char          *tun_name;
 	int           tun_fd;
+	chr_io_t      tun_io;
 
 	unsigned      out_cnt;
 	char          out_esc;
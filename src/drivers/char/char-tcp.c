@@ -26,12 +26,12 @@
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-tcp.h>
 
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netdb.h>
-#include <poll.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -68,39 +68,6 @@ enum {
 };
 
 
-static
-unsigned tcp_get_state (int fd, int t)
-{
-	int           r;
-	unsigned      val;
-	struct pollfd pfd[1];
-
-	pfd[0].fd = fd;
-	pfd[0].events = POLLIN | POLLOUT;
-
-	r = poll (pfd, 1, t);
-
-	if (r < 0) {
-		return (0);
-	}
-
-	val = 0;
-
-	if (pfd[0].revents & POLLHUP) {
-		val |= 4;
-	}
-
-	if (pfd[0].revents & POLLOUT) {
-		val |= 2;
-	}
-
-	if (pfd[0].revents & POLLIN) {
-		val |= 1;
-	}
-
-	return (val);
-}
-
 static
 int tcp_set_nodelay (int fd, int val)
 {
@@ -252,7 +219,7 @@ void telnet_send_request (char_tcp_t *drv, unsigned char option, unsigned char v
 	buf[1] = verb;
 	buf[2] = option;
 
-	write(drv->fd, buf, 3);
+	chr_io_write (&drv->io, buf, 3);
 }
 
 static
@@ -403,17 +370,20 @@ ssize_t telnet_write (char_tcp_t *drv, const void *buf, unsigned cnt)
 	}
 
 	if (i == 0) {
+		if ((drv->io.out_cnt + 2) > CHR_IO_BUF) {
+			chr_io_flush (&drv->io);
+			return (0);
+		}
+
 		iac[0] = TELNET_IAC;
 		iac[1] = TELNET_IAC;
 
-		r = write (drv->fd, iac, 2);
+		chr_io_write (&drv->io, iac, 2);
 
-		if (r == 2) {
-			r = 1;
-		}
+		r = 1;
 	}
 	else {
-		r = write (drv->fd, buf, i);
+		r = chr_io_write (&drv->io, buf, i);
 	}
 
 	return (r);
@@ -425,6 +395,8 @@ void chr_tcp_init_connection (char_tcp_t *drv)
 {
 	tcp_set_nodelay (drv->fd, 1);
 
+	chr_io_init (&drv->io, drv->fd, CHR_IO_NONBLOCK);
+
 	drv->telnet_state = CHAR_TCP_DATA;
 
 	if (drv->telnet && drv->telnetinit) {
@@ -446,6 +418,9 @@ void chr_tcp_close (char_drv_t *cdrv)
 	fprintf (stderr, "char-tcp: close\n");
 #endif
 
+	chr_io_free (&drv->io);
+	chr_io_free (&drv->listen_io);
+
 	if (drv->fd >= 0) {
 		close (drv->fd);
 	}
@@ -468,10 +443,12 @@ int chr_tcp_accept (char_tcp_t *drv)
 		return (1);
 	}
 
-	if ((tcp_get_state (drv->listen_fd, 0) & 1) == 0) {
+	if (chr_io_ready (&drv->listen_io, CHR_IO_IN) == 0) {
 		return (1);
 	}
 
+	chr_io_clear (&drv->listen_io, CHR_IO_IN);
+
 	drv->fd = tcp_accept (drv->listen_fd);
 
 	if (drv->fd < 0) {
@@ -494,6 +471,8 @@ void chr_tcp_shutdown (char_tcp_t *drv)
 	fprintf (stderr, "char-tcp: shutdown\n");
 #endif
 
+	chr_io_free (&drv->io);
+
 	close (drv->fd);
 
 	drv->fd = -1;
@@ -503,8 +482,7 @@ static
 unsigned chr_tcp_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 {
 	char_tcp_t *drv;
-	ssize_t    r;
-	unsigned   st;
+	unsigned   r;
 
 	drv = cdrv->ext;
 
@@ -512,27 +490,13 @@ unsigned chr_tcp_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 		return (0);
 	}
 
-	st = tcp_get_state (drv->fd, 0);
+	r = chr_io_read (&drv->io, buf, cnt);
 
-	if (st & 4) {
-		chr_tcp_shutdown (drv);
-		return (0);
-	}
-
-	if ((st & 1) == 0) {
-		return (0);
-	}
-
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
-
-	r = read (drv->fd, buf, cnt);
+	if (r == 0) {
+		if (drv->io.ready & CHR_IO_HUP) {
+			chr_tcp_shutdown (drv);
+		}
 
-	if (r <= 0) {
-		chr_tcp_shutdown (drv);
 		return (0);
 	}
 
@@ -548,7 +512,6 @@ unsigned chr_tcp_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 {
 	char_tcp_t *drv;
 	ssize_t    r;
-	unsigned   st;
 
 	drv = cdrv->ext;
 
@@ -556,33 +519,16 @@ unsigned chr_tcp_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 		return (cnt);
 	}
 
-	st = tcp_get_state (drv->fd, 0);
-
-	if (st & 4) {
+	if (drv->io.ready & CHR_IO_HUP) {
 		chr_tcp_shutdown (drv);
 		return (cnt);
 	}
 
-	if ((st & 2) == 0) {
-		return (0);
-	}
-
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
-
 	if (drv->telnet) {
 		r = telnet_write (drv, buf, cnt);
 	}
 	else {
-		r = write (drv->fd, buf, cnt);
-	}
-
-	if (r <= 0) {
-		chr_tcp_shutdown (drv);
-		return (cnt);
+		r = chr_io_write (&drv->io, buf, cnt);
 	}
 
 	return (r);
@@ -634,6 +580,9 @@ int chr_tcp_init (char_tcp_t *drv, const char *name)
 	drv->listen_fd = -1;
 	drv->fd = -1;
 
+	drv->listen_io.fd = -1;
+	drv->io.fd = -1;
+
 	drv->ctl = PCE_CHAR_DSR;
 
 	drv->host = drv_get_option (name, "host");
@@ -676,6 +625,8 @@ int chr_tcp_init (char_tcp_t *drv, const char *name)
 		if (drv->listen_fd < 0) {
 			return (1);
 		}
+
+		chr_io_init (&drv->listen_io, drv->listen_fd, CHR_IO_RAW);
 	}
 
 	return (0);
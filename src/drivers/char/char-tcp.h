@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 
 typedef struct char_tcp_t {
@@ -43,6 +44,9 @@ typedef struct char_tcp_t {
 	int        listen_fd;
 	int        fd;
 
+	chr_io_t   listen_io;
+	chr_io_t   io;
+
 	unsigned   ctl;
 
 	unsigned   telnet_state;
@@ -20,16 +20,12 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
-#include <limits.h>
 
 #include <fcntl.h>
 #include <sys/ioctl.h>
-#if defined(HAVE_POLL_H)
-#include <poll.h>
-#elif defined(HAVE_SYS_POLL_H)
-#include <sys/poll.h>
-#endif
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <termios.h>
@@ -37,38 +33,10 @@
 
 #include <drivers/options.h>
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 #include <drivers/char/char-tios.h>
 
 
-/*
- * Check if file descriptor fd is readable and/or writeable
- */
-static
-int chr_tios_check_fd (int fd, int rd, int wr)
-{
-	int           r;
-	struct pollfd pfd[1];
-
-	if (fd < 0) {
-		return (0);
-	}
-
-	pfd[0].fd = fd;
-	pfd[0].events = (rd ? POLLIN : 0) | (wr ? POLLOUT : 0);
-
-	r = poll (pfd, 1, 0);
-
-	if (r < 0) {
-		return (0);
-	}
-
-	if ((pfd[0].revents & (POLLIN | POLLOUT)) == 0) {
-		return (0);
-	}
-
-	return (1);
-}
-
 static
 void chr_tios_close (char_drv_t *cdrv)
 {
@@ -80,6 +48,8 @@ void chr_tios_close (char_drv_t *cdrv)
 		free (drv->fname);
 	}
 
+	chr_io_free (&drv->io);
+
 	if (drv->fd >= 0) {
 		close (drv->fd);
 	}
@@ -91,34 +61,34 @@ static
 unsigned chr_tios_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 {
 	char_tios_t *drv;
-	ssize_t     r;
 
 	drv = cdrv->ext;
 
-	if (chr_tios_check_fd (drv->fd, 1, 0) == 0) {
+	if (drv->fd < 0) {
 		return (0);
 	}
 
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
+	return (chr_io_read (&drv->io, buf, cnt));
+}
 
-	r = read (drv->fd, buf, cnt);
+static
+int chr_tios_wait (char_drv_t *cdrv, unsigned long us)
+{
+	char_tios_t *drv;
 
-	if (r <= 0) {
-		return (0);
+	drv = cdrv->ext;
+
+	if (drv->fd < 0) {
+		return (-1);
 	}
 
-	return (r);
+	return (chr_io_wait (&drv->io, us));
 }
 
 static
 unsigned chr_tios_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 {
 	char_tios_t *drv;
-	ssize_t      r;
 
 	drv = cdrv->ext;
 
@@ -126,23 +96,7 @@ unsigned chr_tios_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 		return (cnt);
 	}
 
-	if (chr_tios_check_fd (drv->fd, 0, 1) == 0) {
-		return (0);
-	}
-
-#if UINT_MAX > SSIZE_MAX
-	if (cnt > SSIZE_MAX) {
-		cnt = SSIZE_MAX;
-	}
-#endif
-
-	r = write (drv->fd, buf, cnt);
-
-	if (r <= 0) {
-		return (0);
-	}
-
-	return (r);
+	return (chr_io_write (&drv->io, buf, cnt));
 }
 
 static
@@ -383,12 +337,15 @@ int chr_tios_init (char_tios_t *drv, const char *name)
 	drv->cdrv.close = chr_tios_close;
 	drv->cdrv.read = chr_tios_read;
 	drv->cdrv.write = chr_tios_write;
+	drv->cdrv.wait = chr_tios_wait;
 	drv->cdrv.get_ctl = chr_tios_get_ctl;
 	drv->cdrv.set_ctl = chr_tios_set_ctl;
 	drv->cdrv.set_params = chr_tios_set_params;
 
 	drv->fd = -1;
 
+	drv->io.fd = -1;
+
 	drv->fname = drv_get_option (name, "file");
 
 	if (drv->fname != NULL) {
@@ -399,6 +356,8 @@ int chr_tios_init (char_tios_t *drv, const char *name)
 		}
 
 		chr_tios_set_params (&drv->cdrv, 9600, 8, 0, 1);
+
+		chr_io_init (&drv->io, drv->fd, CHR_IO_NONBLOCK);
 	}
 
 	return (0);
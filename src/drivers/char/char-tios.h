@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <drivers/char/char.h>
+#include <drivers/char/char-io.h>
 
 
 typedef struct char_tios_t {
@@ -35,6 +36,8 @@ typedef struct char_tios_t {
 	char       *fname;
 
 	int        fd;
+
+	chr_io_t   io;
 } char_tios_t;
 
 
@@ -272,6 +272,7 @@ void chr_init (char_drv_t *cdrv, void *ext)
 
 	cdrv->read = NULL;
 	cdrv->write = NULL;
+	cdrv->wait = NULL;
 
 	cdrv->get_ctl = NULL;
 	cdrv->set_ctl = NULL;
@@ -461,6 +462,15 @@ unsigned chr_read (char_drv_t *cdrv, void *buf, unsigned cnt)
 	return (ret);
 }
 
+int chr_wait (char_drv_t *cdrv, unsigned long us)
+{
+	if ((cdrv == NULL) || (cdrv->wait == NULL)) {
+		return (-1);
+	}
+
+	return (cdrv->wait (cdrv, us));
+}
+
 unsigned chr_write (char_drv_t *cdrv, const void *buf, unsigned cnt)
 {
 	unsigned ret;
@@ -62,6 +62,8 @@ typedef struct char_drv_t {
 	unsigned (*read) (struct char_drv_t *cdrv, void *buf, unsigned cnt);
 	unsigned (*write) (struct char_drv_t *cdrv, const void *buf, unsigned cnt);
 
+	int (*wait) (struct char_drv_t *cdrv, unsigned long us);
+
 	int (*get_ctl) (struct char_drv_t *cdrv, unsigned *ctl);
 	int (*set_ctl) (struct char_drv_t *cdrv, unsigned ctl);
 
@@ -85,6 +87,14 @@ int chr_register_default (void);
 unsigned chr_read (char_drv_t *cdrv, void *buf, unsigned cnt);
 unsigned chr_write (char_drv_t *cdrv, const void *buf, unsigned cnt);
 
+/*!***************************************************************************
+ * @short Block until input is available
+ * @param us The maximum time to wait in microseconds
+ * @return 0 if input is available, 1 on timeout and -1 if the driver
+ *         does not support waiting
+ *****************************************************************************/
+int chr_wait (char_drv_t *cdrv, unsigned long us);
+
 int chr_get_ctl (char_drv_t *cdrv, unsigned *ctl);
 int chr_set_ctl (char_drv_t *cdrv, unsigned ctl);
 
@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -29,6 +31,10 @@
 #include "pfi-io.h"
 #include "pfi-pfi.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PFI_MAGIC_PFI  0x50464920
 #define PFI_MAGIC_TEXT 0x54455854
@@ -54,40 +60,57 @@ typedef struct {
 } pfi_load_t;
 
 
+static uint32_t       pfi_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t pfi_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           pfi_crc_ok = 0;
+#endif
+
+
+static
+void pfi_crc_init (void)
+{
+	unsigned i, j;
+	uint32_t reg;
+
+	for (i = 0; i < 256; i++) {
+		reg = (uint32_t) i << 24;
+
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PFI_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
+			}
+		}
+
+		pfi_crc_tab[i] = reg;
+	}
+}
+
 static
 uint32_t pfi_crc (uint32_t crc, const void *buf, unsigned cnt)
 {
-	unsigned            i, j;
 	unsigned            val;
-	uint32_t            reg;
 	const unsigned char *src;
-	static int          tab_ok = 0;
-	static uint32_t     tab[256];
-
-	if (tab_ok == 0) {
-		for (i = 0; i < 256; i++) {
-			reg = (uint32_t) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (reg & 0x80000000) {
-					reg = (reg << 1) ^ PFI_CRC_POLY;
-				}
-				else {
-					reg = reg << 1;
-				}
-			}
-
-			tab[i] = reg;
-		}
 
-		tab_ok = 1;
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&pfi_crc_once, pfi_crc_init);
+#else
+	if (pfi_crc_ok == 0) {
+		pfi_crc_init ();
+		pfi_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt > 0) {
 		val = (crc >> 24) ^ *(src++);
-		crc = (crc << 8) ^ tab[val & 0xff];
+		crc = (crc << 8) ^ pfi_crc_tab[val & 0xff];
 		cnt -= 1;
 	}
 
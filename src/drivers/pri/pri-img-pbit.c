@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -28,6 +30,10 @@
 #include "pri-img.h"
 #include "pri-img-pbit.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PBIT_CHUNK_PBIT 0x50424954
 #define PBIT_CHUNK_TEXT 0x54455854
@@ -38,40 +44,57 @@
 #define PBIT_CRC_POLY   0x1edc6f41
 
 
+static unsigned long  pbit_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t pbit_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           pbit_crc_ok = 0;
+#endif
+
+
 static
-unsigned long pbit_crc (unsigned long crc, const void *buf, unsigned cnt)
+void pbit_crc_init (void)
 {
-	unsigned             i, j;
-	unsigned             val;
-	unsigned long        reg;
-	const unsigned char  *src;
-	static int           tab_ok = 0;
-	static unsigned long tab[256];
-
-	if (tab_ok == 0) {
-		for (i = 0; i < 256; i++) {
-			reg = (unsigned long) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (reg & 0x80000000) {
-					reg = (reg << 1) ^ PBIT_CRC_POLY;
-				}
-				else {
-					reg = reg << 1;
-				}
-			}
+	unsigned      i, j;
+	unsigned long reg;
+
+	for (i = 0; i < 256; i++) {
+		reg = (unsigned long) i << 24;
 
-			tab[i] = reg;
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PBIT_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
+			}
 		}
 
-		tab_ok = 1;
+		pbit_crc_tab[i] = reg;
+	}
+}
+
+static
+unsigned long pbit_crc (unsigned long crc, const void *buf, unsigned cnt)
+{
+	unsigned            val;
+	const unsigned char *src;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&pbit_crc_once, pbit_crc_init);
+#else
+	if (pbit_crc_ok == 0) {
+		pbit_crc_init ();
+		pbit_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt > 0) {
 		val = (crc >> 24) ^ *(src++);
-		crc = (crc << 8) ^ tab[val & 0xff];
+		crc = (crc << 8) ^ pbit_crc_tab[val & 0xff];
 		cnt -= 1;
 	}
 
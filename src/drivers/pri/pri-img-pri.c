@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -28,6 +30,10 @@
 #include "pri-img.h"
 #include "pri-img-pri.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PRI_CHUNK_PRI  0x50524920
 #define PRI_CHUNK_TEXT 0x54455854
@@ -41,40 +47,57 @@
 #define PRI_CRC_POLY   0x1edc6f41
 
 
+static unsigned long  pri_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t pri_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           pri_crc_ok = 0;
+#endif
+
+
 static
-unsigned long pri_crc (unsigned long crc, const void *buf, unsigned cnt)
+void pri_crc_init (void)
 {
-	unsigned             i, j;
-	unsigned             val;
-	unsigned long        reg;
-	const unsigned char  *src;
-	static int           tab_ok = 0;
-	static unsigned long tab[256];
-
-	if (tab_ok == 0) {
-		for (i = 0; i < 256; i++) {
-			reg = (unsigned long) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (reg & 0x80000000) {
-					reg = (reg << 1) ^ PRI_CRC_POLY;
-				}
-				else {
-					reg = reg << 1;
-				}
-			}
+	unsigned      i, j;
+	unsigned long reg;
 
-			tab[i] = reg;
+	for (i = 0; i < 256; i++) {
+		reg = (unsigned long) i << 24;
+
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PRI_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
+			}
 		}
 
-		tab_ok = 1;
+		pri_crc_tab[i] = reg;
+	}
+}
+
+static
+unsigned long pri_crc (unsigned long crc, const void *buf, unsigned cnt)
+{
+	unsigned            val;
+	const unsigned char *src;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&pri_crc_once, pri_crc_init);
+#else
+	if (pri_crc_ok == 0) {
+		pri_crc_init ();
+		pri_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt > 0) {
 		val = (crc >> 24) ^ *(src++);
-		crc = (crc << 8) ^ tab[val & 0xff];
+		crc = (crc << 8) ^ pri_crc_tab[val & 0xff];
 		cnt -= 1;
 	}
 
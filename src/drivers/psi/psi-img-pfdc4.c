@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -27,6 +29,10 @@
 #include "psi.h"
 #include "psi-io.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PFDC4_FLAG_CRC_ID     0x0001
 #define PFDC4_FLAG_CRC_DATA   0x0002
@@ -45,40 +51,57 @@
 #define PFDC4_CRC_POLY        0x1edc6f41
 
 
+static unsigned long  pfdc4_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t pfdc4_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           pfdc4_crc_ok = 0;
+#endif
+
+
 static
-unsigned long pfdc4_crc (unsigned long crc, const void *buf, unsigned cnt)
+void pfdc4_crc_init (void)
 {
-	unsigned             i, j;
-	unsigned             val;
-	unsigned long        reg;
-	const unsigned char  *src;
-	static int           tab_ok = 0;
-	static unsigned long tab[256];
-
-	if (tab_ok == 0) {
-		for (i = 0; i < 256; i++) {
-			reg = (unsigned long) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (reg & 0x80000000) {
-					reg = (reg << 1) ^ PFDC4_CRC_POLY;
-				}
-				else {
-					reg = reg << 1;
-				}
-			}
+	unsigned      i, j;
+	unsigned long reg;
+
+	for (i = 0; i < 256; i++) {
+		reg = (unsigned long) i << 24;
 
-			tab[i] = reg;
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PFDC4_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
+			}
 		}
 
-		tab_ok = 1;
+		pfdc4_crc_tab[i] = reg;
+	}
+}
+
+static
+unsigned long pfdc4_crc (unsigned long crc, const void *buf, unsigned cnt)
+{
+	unsigned            val;
+	const unsigned char *src;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&pfdc4_crc_once, pfdc4_crc_init);
+#else
+	if (pfdc4_crc_ok == 0) {
+		pfdc4_crc_init ();
+		pfdc4_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt > 0) {
 		val = (crc >> 24) ^ *(src++);
-		crc = (crc << 8) ^ tab[val & 0xff];
+		crc = (crc << 8) ^ pfdc4_crc_tab[val & 0xff];
 		cnt -= 1;
 	}
 
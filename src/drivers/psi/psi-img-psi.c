@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -27,6 +29,10 @@
 #include "psi.h"
 #include "psi-io.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PSI_CHUNK_PSI  0x50534920
 #define PSI_CHUNK_TEXT 0x54455854
@@ -70,40 +76,57 @@
 #define PSI_MACG_NO_DAM   4
 
 
+static unsigned long  psi_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t psi_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           psi_crc_ok = 0;
+#endif
+
+
 static
-unsigned long psi_crc (unsigned long crc, const void *buf, unsigned cnt)
+void psi_crc_init (void)
 {
-	unsigned             i, j;
-	unsigned             val;
-	unsigned long        reg;
-	const unsigned char  *src;
-	static int           tab_ok = 0;
-	static unsigned long tab[256];
-
-	if (tab_ok == 0) {
-		for (i = 0; i < 256; i++) {
-			reg = (unsigned long) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (reg & 0x80000000) {
-					reg = (reg << 1) ^ PSI_CRC_POLY;
-				}
-				else {
-					reg = reg << 1;
-				}
-			}
+	unsigned      i, j;
+	unsigned long reg;
+
+	for (i = 0; i < 256; i++) {
+		reg = (unsigned long) i << 24;
 
-			tab[i] = reg;
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PSI_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
+			}
 		}
 
-		tab_ok = 1;
+		psi_crc_tab[i] = reg;
+	}
+}
+
+static
+unsigned long psi_crc (unsigned long crc, const void *buf, unsigned cnt)
+{
+	unsigned            val;
+	const unsigned char *src;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&psi_crc_once, psi_crc_init);
+#else
+	if (psi_crc_ok == 0) {
+		psi_crc_init ();
+		psi_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt > 0) {
 		val = (crc >> 24) ^ *(src++);
-		crc = (crc << 8) ^ tab[val & 0xff];
+		crc = (crc << 8) ^ psi_crc_tab[val & 0xff];
 		cnt -= 1;
 	}
 
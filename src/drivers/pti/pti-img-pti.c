@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -29,6 +31,10 @@
 #include "pti-io.h"
 #include "pti-img-pti.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 #define PTI_MAGIC_PTI  0x50544920
 #define PTI_MAGIC_TEXT 0x54455854
@@ -52,36 +58,55 @@ typedef struct {
 } pti_load_t;
 
 
+static uint32_t       pti_crc_tab[256];
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t pti_crc_once = PTHREAD_ONCE_INIT;
+#else
+static char           pti_crc_ok = 0;
+#endif
+
+
 static
-uint32_t pti_crc (uint32_t crc, const void *buf, unsigned cnt)
+void pti_crc_init (void)
 {
-	const unsigned char *src;
-	static char         tab_ok = 0;
-	static uint32_t     tab[256];
-
-	if (tab_ok == 0) {
-		unsigned i, j;
-
-		for (i = 0; i < 256; i++) {
-			tab[i] = (uint32_t) i << 24;
-
-			for (j = 0; j < 8; j++) {
-				if (tab[i] & 0x80000000) {
-					tab[i] = (tab[i] << 1) ^ PTI_CRC_POLY;
-				}
-				else {
-					tab[i] = tab[i] << 1;
-				}
+	unsigned i, j;
+	uint32_t reg;
+
+	for (i = 0; i < 256; i++) {
+		reg = (uint32_t) i << 24;
+
+		for (j = 0; j < 8; j++) {
+			if (reg & 0x80000000) {
+				reg = (reg << 1) ^ PTI_CRC_POLY;
+			}
+			else {
+				reg = reg << 1;
 			}
 		}
 
-		tab_ok = 1;
+		pti_crc_tab[i] = reg;
+	}
+}
+
+static
+uint32_t pti_crc (uint32_t crc, const void *buf, unsigned cnt)
+{
+	const unsigned char *src;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&pti_crc_once, pti_crc_init);
+#else
+	if (pti_crc_ok == 0) {
+		pti_crc_init ();
+		pti_crc_ok = 1;
 	}
+#endif
 
 	src = buf;
 
 	while (cnt-- > 0) {
-		crc = (crc << 8) ^ tab[((crc >> 24) ^ *(src++)) & 0xff];
+		crc = (crc << 8) ^ pti_crc_tab[((crc >> 24) ^ *(src++)) & 0xff];
 	}
 
 	return (crc & 0xffffffff);
@@ -30,6 +30,9 @@
 
 #define SND_IIR_MUL 8192
 
+/* the maximum number of channels that are filtered together */
+#define SND_IIR_CHN 16
+
 
 void snd_iir2_init (sound_iir2_t *iir)
 {
@@ -38,22 +41,18 @@ void snd_iir2_init (sound_iir2_t *iir)
 	for (i = 0; i < 3; i++) {
 		iir->a[i] = 0;
 		iir->b[i] = 0;
-		iir->x[i] = 0;
-		iir->y[i] = 0;
 	}
 
 	iir->a[0] = SND_IIR_MUL;
+
+	iir->s[0] = 0;
+	iir->s[1] = 0;
 }
 
 void snd_iir2_reset (sound_iir2_t *iir)
 {
-	iir->x[0] = 0;
-	iir->x[1] = 0;
-	iir->x[2] = 0;
-
-	iir->y[0] = 0;
-	iir->y[1] = 0;
-	iir->y[2] = 0;
+	iir->s[0] = 0;
+	iir->s[1] = 0;
 }
 
 void snd_iir2_set_lowpass (sound_iir2_t *iir, unsigned long freq, unsigned long srate)
@@ -82,48 +81,120 @@ void snd_iir2_set_lowpass (sound_iir2_t *iir, unsigned long freq, unsigned long
 	iir->b[2] = (long) (SND_IIR_MUL * (om * (om - sqrt(2.0)) + 1.0) / b0);
 }
 
+static inline
+uint16_t snd_iir2_get_smp (long v, uint16_t sig)
+{
+	v += 32768;
+
+	if (v < 0) {
+		v = 0;
+	}
+	else if (v > 65535) {
+		v = 0xffff;
+	}
+
+	return (((uint16_t) v) ^ sig);
+}
+
+/*
+ * With integer coefficients and samples, the transposed direct form
+ * gives exactly the same results as the direct form:
+ *
+ *   y[n] = (a0 * x[n] + s0) / MUL
+ *   s0   = a1 * x[n] - b1 * y[n] + s1
+ *   s1   = a2 * x[n] - b2 * y[n]
+ */
 void snd_iir2_filter (sound_iir2_t *iir, uint16_t *dst, const uint16_t *src,
 	unsigned cnt, unsigned ofs, int sign)
 {
-	long     v;
+	long     a0, a1, a2, b1, b2;
+	long     x, y, s0, s1;
 	uint16_t sig;
 
 	sig = sign ? 0x8000 : 0;
 
+	a0 = iir->a[0];
+	a1 = iir->a[1];
+	a2 = iir->a[2];
+	b1 = iir->b[1];
+	b2 = iir->b[2];
+
+	s0 = iir->s[0];
+	s1 = iir->s[1];
+
 	while (cnt > 0) {
-		v = *src ^ sig;
-		v -= 32768;
+		x = (long) (*src ^ sig) - 32768;
 
-		iir->x[2] = iir->x[1];
-		iir->x[1] = iir->x[0];
-		iir->x[0] = v;
+		y = (a0 * x + s0) / SND_IIR_MUL;
 
-		iir->y[2] = iir->y[1];
-		iir->y[1] = iir->y[0];
+		s0 = a1 * x - b1 * y + s1;
+		s1 = a2 * x - b2 * y;
 
-		iir->y[0] = iir->a[0] * iir->x[0];
-		iir->y[0] += iir->a[1] * iir->x[1] + iir->a[2] * iir->x[2];
-		iir->y[0] -= iir->b[1] * iir->y[1] + iir->b[2] * iir->y[2];
+		*dst = snd_iir2_get_smp (y, sig);
 
-		iir->y[0] = iir->y[0] / SND_IIR_MUL;
+		src += ofs;
+		dst += ofs;
+		cnt -= 1;
+	}
 
-		v = iir->y[0];
-		v += 32768;
+	iir->s[0] = s0;
+	iir->s[1] = s1;
+}
 
-		if (v < 0) {
-			v = 0;
-		}
-		else if (v > 65535) {
-			v = 0xffff;
+/*
+ * The recurrence is serial within a channel. For stereo 4096 frame
+ * blocks (gcc 12 -O2, x86-64) this runs as fast as one strided pass
+ * per channel, it only saves the extra passes over the buffer.
+ */
+void snd_iir2_filter_chn (sound_iir2_t *iir, unsigned chn,
+	uint16_t *dst, const uint16_t *src, unsigned cnt, int sign)
+{
+	unsigned i, j;
+	long     a0[SND_IIR_CHN], a1[SND_IIR_CHN], a2[SND_IIR_CHN];
+	long     b1[SND_IIR_CHN], b2[SND_IIR_CHN];
+	long     s0[SND_IIR_CHN], s1[SND_IIR_CHN];
+	long     x, y;
+	uint16_t sig;
+
+	if ((chn == 1) || (chn > SND_IIR_CHN)) {
+		for (i = 0; i < chn; i++) {
+			snd_iir2_filter (iir + i, dst + i, src + i, cnt, chn, sign);
 		}
-		else {
-			v &= 0xffff;
+
+		return;
+	}
+
+	sig = sign ? 0x8000 : 0;
+
+	for (i = 0; i < chn; i++) {
+		a0[i] = iir[i].a[0];
+		a1[i] = iir[i].a[1];
+		a2[i] = iir[i].a[2];
+		b1[i] = iir[i].b[1];
+		b2[i] = iir[i].b[2];
+
+		s0[i] = iir[i].s[0];
+		s1[i] = iir[i].s[1];
+	}
+
+	for (j = 0; j < cnt; j++) {
+		for (i = 0; i < chn; i++) {
+			x = (long) (src[i] ^ sig) - 32768;
+
+			y = (a0[i] * x + s0[i]) / SND_IIR_MUL;
+
+			s0[i] = a1[i] * x - b1[i] * y + s1[i];
+			s1[i] = a2[i] * x - b2[i] * y;
+
+			dst[i] = snd_iir2_get_smp (y, sig);
 		}
 
-		*dst = ((uint16_t) v) ^ sig;
+		src += chn;
+		dst += chn;
+	}
 
-		src += ofs;
-		dst += ofs;
-		cnt -= 1;
+	for (i = 0; i < chn; i++) {
+		iir[i].s[0] = s0[i];
+		iir[i].s[1] = s1[i];
 	}
 }
@@ -29,12 +29,14 @@
 
 /*!***************************************************************************
  * @short A second order IIR filter
+ *
+ * The filter is computed in transposed direct form II, s holds the
+ * two state variables.
  *****************************************************************************/
 typedef struct {
 	long a[3];
 	long b[3];
-	long x[3];
-	long y[3];
+	long s[2];
 } sound_iir2_t;
 
 
@@ -71,5 +73,22 @@ void snd_iir2_filter (sound_iir2_t *iir,
 	uint16_t *dst, const uint16_t *src, unsigned cnt, unsigned ofs, int sign
 );
 
+/*!***************************************************************************
+ * @short Filter interleaved samples with one IIR2 filter per channel
+ * @param iir   An array of chn filters
+ * @param chn   The number of channels
+ * @param dst   The destination buffer
+ * @param src   The source buffer
+ * @param cnt   The frame count
+ * @param sign  The sample signedness in both src and dst
+ *
+ * The total number of samples in src and dst is (chn * cnt). All
+ * channels of a frame are filtered together. The source and destination
+ * buffer can be the same.
+ *****************************************************************************/
+void snd_iir2_filter_chn (sound_iir2_t *iir, unsigned chn,
+	uint16_t *dst, const uint16_t *src, unsigned cnt, int sign
+);
+
 
 #endif
@@ -0,0 +1,332 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/drivers/sound/mixer.c                                    *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdlib.h>
+
+#include <drivers/sound/filter.h>
+#include <drivers/sound/mixer.h>
+#include <drivers/sound/sound.h>
+
+
+void snd_mix_init (sound_mix_t *mix, unsigned long clock)
+{
+	unsigned i;
+
+	mix->drv = NULL;
+
+	mix->channels = 1;
+	mix->srate = 44100;
+
+	mix->clock = clock;
+
+	mix->lowpass_freq = 0;
+
+	for (i = 0; i < SND_CHN_MAX; i++) {
+		snd_iir2_init (&mix->iir[i]);
+	}
+
+	mix->playing = 0;
+
+	mix->src_cnt = 0;
+
+	for (i = 0; i < SND_MIX_SRC_MAX; i++) {
+		mix->src_val[i] = 0;
+	}
+
+	mix->val = 0;
+
+	mix->clk = 0;
+	mix->idle_clk = 0;
+
+	mix->rem = 0;
+	mix->acc = 0;
+	mix->acc_cnt = 0;
+
+	mix->buf_cnt = 0;
+}
+
+static void snd_mix_stop (sound_mix_t *mix);
+
+void snd_mix_free (sound_mix_t *mix)
+{
+	snd_mix_stop (mix);
+
+	if (mix->drv != NULL) {
+		snd_close (mix->drv);
+		mix->drv = NULL;
+	}
+}
+
+sound_mix_t *snd_mix_new (unsigned long clock)
+{
+	sound_mix_t *mix;
+
+	if ((mix = malloc (sizeof (sound_mix_t))) == NULL) {
+		return (NULL);
+	}
+
+	snd_mix_init (mix, clock);
+
+	return (mix);
+}
+
+void snd_mix_del (sound_mix_t *mix)
+{
+	if (mix != NULL) {
+		snd_mix_free (mix);
+		free (mix);
+	}
+}
+
+int snd_mix_set_driver (sound_mix_t *mix, const char *driver,
+	unsigned chn, unsigned long srate)
+{
+	snd_mix_free (mix);
+
+	if ((chn < 1) || (chn > SND_CHN_MAX) || (srate == 0)) {
+		return (1);
+	}
+
+	if ((mix->drv = snd_open (driver)) == NULL) {
+		return (1);
+	}
+
+	mix->channels = chn;
+	mix->srate = srate;
+
+	if (snd_set_params (mix->drv, chn, srate, 1)) {
+		snd_close (mix->drv);
+		mix->drv = NULL;
+		return (1);
+	}
+
+	snd_mix_set_lowpass (mix, mix->lowpass_freq);
+
+	return (0);
+}
+
+int snd_mix_have_driver (const sound_mix_t *mix)
+{
+	return (mix->drv != NULL);
+}
+
+void snd_mix_set_lowpass (sound_mix_t *mix, unsigned long freq)
+{
+	unsigned i;
+
+	mix->lowpass_freq = freq;
+
+	for (i = 0; i < SND_CHN_MAX; i++) {
+		snd_iir2_set_lowpass (&mix->iir[i], freq, mix->srate);
+	}
+}
+
+int snd_mix_add_src (sound_mix_t *mix)
+{
+	if (mix->src_cnt >= SND_MIX_SRC_MAX) {
+		return (-1);
+	}
+
+	mix->src_val[mix->src_cnt] = 0;
+	mix->src_cnt += 1;
+
+	return (mix->src_cnt - 1);
+}
+
+/*
+ * Filter the buffered samples and send them to the sound driver
+ */
+static
+void snd_mix_play (sound_mix_t *mix)
+{
+	if (mix->buf_cnt == 0) {
+		return;
+	}
+
+	if (mix->lowpass_freq > 0) {
+		snd_iir2_filter_chn (mix->iir, mix->channels, mix->buf, mix->buf,
+			mix->buf_cnt, 1
+		);
+	}
+
+	snd_write (mix->drv, mix->buf, mix->buf_cnt);
+
+	mix->buf_cnt = 0;
+}
+
+static
+void snd_mix_put (sound_mix_t *mix, long val, unsigned long cnt)
+{
+	unsigned i;
+	uint16_t smp, *buf;
+
+	if (val < -32768) {
+		val = -32768;
+	}
+	else if (val > 32767) {
+		val = 32767;
+	}
+
+	smp = (uint16_t) val & 0xffff;
+
+	while (cnt > 0) {
+		buf = mix->buf + mix->channels * mix->buf_cnt;
+
+		for (i = 0; i < mix->channels; i++) {
+			buf[i] = smp;
+		}
+
+		mix->buf_cnt += 1;
+
+		if (mix->buf_cnt >= SND_MIX_BUF) {
+			snd_mix_play (mix);
+		}
+
+		cnt -= 1;
+	}
+}
+
+static
+void snd_mix_start (sound_mix_t *mix, unsigned long clk)
+{
+	mix->playing = 1;
+
+	mix->clk = clk;
+	mix->idle_clk = 0;
+
+	mix->rem = 0;
+	mix->acc = 0;
+	mix->acc_cnt = 0;
+
+	/* Fill the sound buffer a bit so we don't underrun immediately */
+	snd_mix_put (mix, 0, mix->srate / 8);
+}
+
+static
+void snd_mix_stop (sound_mix_t *mix)
+{
+	unsigned i;
+
+	if (mix->playing == 0) {
+		return;
+	}
+
+	mix->playing = 0;
+
+	snd_mix_play (mix);
+
+	for (i = 0; i < SND_CHN_MAX; i++) {
+		snd_iir2_reset (&mix->iir[i]);
+	}
+}
+
+/*
+ * Render cnt input clocks at the current level. Each output sample is
+ * the average level over its duration.
+ */
+static
+void snd_mix_render (sound_mix_t *mix, unsigned long cnt)
+{
+	unsigned long n;
+
+	while (cnt > 0) {
+		/* the input clocks until the current output sample is complete */
+		n = (mix->clock - mix->rem + mix->srate - 1) / mix->srate;
+
+		if (n > cnt) {
+			mix->acc += mix->val * (long) cnt;
+			mix->acc_cnt += cnt;
+			mix->rem += cnt * mix->srate;
+			return;
+		}
+
+		mix->rem += n * mix->srate;
+		mix->rem -= mix->clock;
+		cnt -= n;
+
+		if (mix->acc_cnt == 0) {
+			snd_mix_put (mix, mix->val, 1);
+		}
+		else {
+			mix->acc += mix->val * (long) n;
+			mix->acc_cnt += n;
+
+			snd_mix_put (mix, mix->acc / (long) mix->acc_cnt, 1);
+
+			mix->acc = 0;
+			mix->acc_cnt = 0;
+		}
+	}
+}
+
+void snd_mix_clock (sound_mix_t *mix, unsigned long clk)
+{
+	unsigned long cnt;
+
+	if (mix->playing == 0) {
+		mix->clk = clk;
+		return;
+	}
+
+	cnt = clk - mix->clk;
+
+	/* ignore times in the past */
+	if (cnt & 0x80000000) {
+		return;
+	}
+
+	mix->clk = clk;
+
+	snd_mix_render (mix, cnt);
+
+	mix->idle_clk += cnt;
+
+	if (mix->idle_clk > (2 * mix->clock)) {
+		snd_mix_stop (mix);
+	}
+}
+
+void snd_mix_set_val (sound_mix_t *mix, unsigned src, unsigned long clk, long val)
+{
+	if ((mix->drv == NULL) || (src >= mix->src_cnt)) {
+		return;
+	}
+
+	if (mix->src_val[src] == val) {
+		return;
+	}
+
+	if (mix->playing) {
+		snd_mix_clock (mix, clk);
+	}
+
+	mix->val += val - mix->src_val[src];
+	mix->src_val[src] = val;
+
+	mix->idle_clk = 0;
+
+	if (mix->playing == 0) {
+		snd_mix_start (mix, clk);
+	}
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/drivers/sound/mixer.h                                    *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_DRIVERS_SOUND_MIXER_H
+#define PCE_DRIVERS_SOUND_MIXER_H 1
+
+
+#include <stdint.h>
+
+#include <drivers/sound/filter.h>
+#include <drivers/sound/sound.h>
+
+
+#define SND_MIX_SRC_MAX 8
+#define SND_MIX_BUF     1024
+
+
+/*!***************************************************************************
+ * @short The sound mixer context
+ *
+ * The mixer collects the output levels of several sound sources. Each
+ * level change is tagged with the time at which it occurs, in clocks of
+ * the emulated machine. The mixer renders the sum of all sources at the
+ * host sample rate, filters it in blocks and writes it to a single sound
+ * driver.
+ *****************************************************************************/
+typedef struct {
+	sound_drv_t   *drv;
+
+	unsigned      channels;
+	unsigned long srate;
+
+	/* the input clock frequency */
+	unsigned long clock;
+
+	unsigned long lowpass_freq;
+	sound_iir2_t  iir[SND_CHN_MAX];
+
+	char          playing;
+
+	unsigned      src_cnt;
+	long          src_val[SND_MIX_SRC_MAX];
+
+	/* the sum of all source levels */
+	long          val;
+
+	/* the time up to which the output has been rendered */
+	unsigned long clk;
+
+	/* the input clocks since the last level change */
+	unsigned long idle_clk;
+
+	/* the position within the current output sample */
+	unsigned long rem;
+	long          acc;
+	unsigned long acc_cnt;
+
+	unsigned      buf_cnt;
+	uint16_t      buf[SND_MIX_BUF * SND_CHN_MAX];
+} sound_mix_t;
+
+
+void snd_mix_init (sound_mix_t *mix, unsigned long clock);
+void snd_mix_free (sound_mix_t *mix);
+
+sound_mix_t *snd_mix_new (unsigned long clock);
+void snd_mix_del (sound_mix_t *mix);
+
+/*!***************************************************************************
+ * @short Open the sound driver
+ * @param driver  The sound driver name
+ * @param chn     The number of output channels
+ * @param srate   The output sample rate in Herz
+ *
+ * All sources are mixed into every output channel.
+ *****************************************************************************/
+int snd_mix_set_driver (sound_mix_t *mix, const char *driver,
+	unsigned chn, unsigned long srate
+);
+
+/*!***************************************************************************
+ * @short Check if the sound driver has been opened
+ *****************************************************************************/
+int snd_mix_have_driver (const sound_mix_t *mix);
+
+/*!***************************************************************************
+ * @short Set the low-pass filter cut-off frequency
+ * @param freq  The cut-off frequency in Herz or 0 to disable the filter
+ *
+ * The filter is applied once per block to the mixed output.
+ *****************************************************************************/
+void snd_mix_set_lowpass (sound_mix_t *mix, unsigned long freq);
+
+/*!***************************************************************************
+ * @short Add a sound source
+ * @return The source index or -1 on error
+ *
+ * The initial level of the new source is 0.
+ *****************************************************************************/
+int snd_mix_add_src (sound_mix_t *mix);
+
+/*!***************************************************************************
+ * @short Set the output level of a sound source
+ * @param src  The source index as returned by snd_mix_add_src()
+ * @param clk  The time of the level change in input clocks
+ * @param val  The new level in the range [-32768...32767]
+ *
+ * The time must not be earlier than the time of the last call to
+ * snd_mix_set_val() or snd_mix_clock().
+ *****************************************************************************/
+void snd_mix_set_val (sound_mix_t *mix, unsigned src, unsigned long clk, long val);
+
+/*!***************************************************************************
+ * @short Render the output up to a point in time
+ * @param clk  The current time in input clocks
+ *
+ * This function should be called periodically. Output stops if no
+ * source level changes for two seconds.
+ *****************************************************************************/
+void snd_mix_clock (sound_mix_t *mix, unsigned long clk);
+
+
+#endif
@@ -36,138 +36,164 @@
 #endif
 
 
-static
-sound_sdl_buf_t *snd_sdl_buf_new (sound_sdl_t *drv, unsigned size)
-{
-	unsigned char   *tmp;
-	sound_sdl_buf_t *buf;
+/* the maximum resampling correction (16.16), about 0.5 percent */
+#define SND_SDL_STEP_MAX 328
 
-	if (drv->free != NULL) {
-		buf = drv->free;
-		drv->free = drv->free->next;
-	}
-	else {
-		if (drv->buf_cnt > 32) {
-			return (NULL);
-		}
+#define SND_SDL_SAMPLES 1024
 
-		buf = malloc (sizeof (sound_sdl_buf_t));
 
-		if (buf == NULL) {
-			return (NULL);
-		}
+#if defined (__GNUC__)
+#define snd_sdl_load(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define snd_sdl_store(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#else
+#define snd_sdl_load(p) (*(volatile unsigned long *) (p))
+#define snd_sdl_store(p, v) (*(volatile unsigned long *) (p) = (v))
+#endif
+
 
-		buf->max = 0;
-		buf->data = NULL;
+static
+void snd_sdl_close (sound_drv_t *sdrv)
+{
+	sound_sdl_t *drv;
 
-		drv->buf_cnt += 1;
+	drv = sdrv->ext;
+
+	if (drv->is_open) {
+		SDL_CloseAudio();
 	}
 
-	buf->next = NULL;
+	if (drv->sem != NULL) {
+		SDL_DestroySemaphore (drv->sem);
+	}
 
-	buf->idx = 0;
-	buf->cnt = 0;
+	free (drv->ring);
 
-	if (buf->max < size) {
-		tmp = realloc (buf->data, size);
+	snd_free (sdrv);
 
-		if (tmp == NULL) {
-			free (buf->data);
-			free (buf);
+	free (drv);
+}
 
-			drv->buf_cnt -= 1;
+/*
+ * Adjust the resampling step so that the buffer fill level converges
+ * to drv->target.
+ */
+static
+void snd_sdl_adjust_step (sound_sdl_t *drv, unsigned long fill)
+{
+	long corr;
 
-			return (NULL);
-		}
+	drv->fill = (7 * drv->fill + fill) / 8;
 
-		buf->max = size;
-		buf->data = tmp;
+	if (drv->sync) {
+		drv->step = 0x10000;
+		return;
 	}
 
-	return (buf);
+	corr = ((long) drv->fill - (long) drv->target) * SND_SDL_STEP_MAX;
+	corr /= (long) drv->target;
+
+	if (corr > SND_SDL_STEP_MAX) {
+		corr = SND_SDL_STEP_MAX;
+	}
+	else if (corr < -SND_SDL_STEP_MAX) {
+		corr = -SND_SDL_STEP_MAX;
+	}
+
+	drv->step = 0x10000 + corr;
 }
 
+/*
+ * Wait until the audio callback has consumed some frames
+ */
 static
-void snd_sdl_buf_free_list (sound_sdl_buf_t *buf)
+int snd_sdl_wait (sound_sdl_t *drv)
 {
-	sound_sdl_buf_t *tmp;
-
-	while (buf != NULL) {
-		tmp = buf;
-		buf = buf->next;
+	if (drv->is_paused) {
+		SDL_PauseAudio (0);
+		drv->is_paused = 0;
+	}
 
-		free (tmp->data);
-		free (tmp);
+	if (SDL_SemWaitTimeout (drv->sem, 250) != 0) {
+		return (1);
 	}
 
+	return (0);
 }
 
 static
-void snd_sdl_close (sound_drv_t *sdrv)
+int snd_sdl_write (sound_drv_t *sdrv, const uint16_t *buf, unsigned cnt)
 {
-	sound_sdl_t *drv;
+	unsigned      i, c, chn;
+	unsigned long wr, rd, avail, limit;
+	int           cur, sig;
+	int16_t       *dst;
+	sound_sdl_t   *drv;
 
 	drv = sdrv->ext;
 
-	if (drv->is_open) {
-		SDL_CloseAudio();
+	if (drv->ring == NULL) {
+		return (1);
 	}
 
-	snd_sdl_buf_free_list (drv->head);
-	snd_sdl_buf_free_list (drv->free);
+	chn = drv->channels;
+	sig = sdrv->sample_sign ? 0x8000 : 0x0000;
+	limit = drv->sync ? drv->target : drv->ring_size;
 
-	snd_free (sdrv);
+	wr = drv->wr;
+	rd = snd_sdl_load (&drv->rd);
 
-	free (drv);
-}
+	snd_sdl_adjust_step (drv, wr - rd);
 
-static
-int snd_sdl_write (sound_drv_t *sdrv, const uint16_t *buf, unsigned cnt)
-{
-	int             sign;
-	unsigned long   bcnt, scnt;
-	sound_sdl_buf_t *bbuf;
-	sound_sdl_t     *drv;
-
-	drv = sdrv->ext;
+	avail = limit - (wr - rd);
 
-	scnt = (unsigned long) sdrv->channels * (unsigned long) cnt;
-	bcnt = 2 * scnt;
+	for (i = 0; i < cnt; i++) {
+		while (drv->phase < 0x10000) {
+			if (avail == 0) {
+				snd_sdl_store (&drv->wr, wr);
 
-	SDL_LockAudio();
-	bbuf = snd_sdl_buf_new (drv, bcnt);
-	SDL_UnlockAudio();
+				if (drv->sync && (snd_sdl_wait (drv) == 0)) {
+					rd = snd_sdl_load (&drv->rd);
+					avail = limit - (wr - rd);
+					continue;
+				}
 
-	if (bbuf == NULL) {
 #if DEBUG_SND_SDL >= 1
-		fprintf (stderr, "snd-sdl: buffer overrun\n");
+				fprintf (stderr, "snd-sdl: buffer overrun\n");
 #endif
-		return (1);
-	}
+				drv->phase = 0x10000;
+				break;
+			}
 
-	sign = (sdrv->sample_sign != drv->sign);
+			dst = drv->ring + chn * (wr & drv->ring_mask);
 
-	snd_set_buf (bbuf->data, buf, scnt, sign, drv->big_endian);
+			for (c = 0; c < chn; c++) {
+				cur = (int) (buf[c] ^ sig) - 0x8000;
+				cur = cur - drv->last[c];
+				dst[c] = drv->last[c] + ((cur * (long) drv->phase) >> 16);
+			}
 
-	bbuf->idx = 0;
-	bbuf->cnt = bcnt;
+			wr += 1;
+			avail -= 1;
 
-	SDL_LockAudio();
+			drv->phase += drv->step;
+		}
 
-	if (drv->tail == NULL) {
-		drv->head = bbuf;
-	}
-	else {
-		drv->tail->next = bbuf;
-	}
+		drv->phase -= 0x10000;
 
-	drv->tail = bbuf;
+		for (c = 0; c < chn; c++) {
+			drv->last[c] = (int) (buf[c] ^ sig) - 0x8000;
+		}
 
-	SDL_UnlockAudio();
+		buf += chn;
+	}
+
+	snd_sdl_store (&drv->wr, wr);
 
 	if (drv->is_paused) {
-		SDL_PauseAudio (0);
-		drv->is_paused = 0;
+		if ((wr - rd) >= drv->target) {
+			SDL_PauseAudio (0);
+			drv->is_paused = 0;
+		}
 	}
 
 	return (0);
@@ -176,54 +202,112 @@ int snd_sdl_write (sound_drv_t *sdrv, const uint16_t *buf, unsigned cnt)
 static
 void snd_sdl_callback (void *user, Uint8 *buf, int cnt)
 {
-	int             n;
-	sound_sdl_t     *drv;
-	sound_sdl_buf_t *src;
+	unsigned long n, wr, rd, idx, fsize;
+	sound_sdl_t   *drv;
 
 	drv = user;
 
-	if (drv->head == NULL) {
-		SDL_PauseAudio (1);
-		drv->is_paused = 1;
-		return;
+	fsize = 2 * drv->channels;
+
+	wr = snd_sdl_load (&drv->wr);
+	rd = drv->rd;
+
+	if (drv->refill && ((wr - rd) < drv->target)) {
+		memset (buf, 0, cnt);
+		cnt = 0;
+	}
+	else {
+		drv->refill = 0;
 	}
 
 	while (cnt > 0) {
-		if (drv->head == NULL) {
+		n = wr - rd;
+
+		if (n == 0) {
 #if DEBUG_SND_SDL >= 1
 			fprintf (stderr, "snd-sdl: buffer underrun\n");
 #endif
 			memset (buf, 0, cnt);
-			return;
+			drv->refill = 1;
+			break;
 		}
 
-		src = drv->head;
+		idx = rd & drv->ring_mask;
 
-		n = src->cnt - src->idx;
+		if (n > (drv->ring_size - idx)) {
+			n = drv->ring_size - idx;
+		}
 
-		if (n <= cnt) {
-			memcpy (buf, src->data + src->idx, n);
+		if (n > (cnt / fsize)) {
+			n = cnt / fsize;
+		}
 
-			buf += n;
-			cnt -= n;
+		if (n == 0) {
+			memset (buf, 0, cnt);
+			break;
+		}
 
-			drv->head = src->next;
+		memcpy (buf, drv->ring + drv->channels * idx, n * fsize);
 
-			if (drv->head == NULL) {
-				drv->tail = NULL;
-			}
+		buf += n * fsize;
+		cnt -= n * fsize;
+		rd += n;
+	}
 
-			src->next = drv->free;
-			drv->free = src;
-		}
-		else {
-			memcpy (buf, src->data + src->idx, cnt);
-			src->idx += cnt;
-			cnt = 0;
-		}
+	snd_sdl_store (&drv->rd, rd);
+
+	if (SDL_SemValue (drv->sem) == 0) {
+		SDL_SemPost (drv->sem);
 	}
 }
 
+/*
+ * Allocate the ring buffer for the current parameters
+ */
+static
+int snd_sdl_ring_init (sound_sdl_t *drv, unsigned chn, unsigned long srate)
+{
+	unsigned long size, target;
+
+	target = (srate * drv->latency) / 1000;
+
+	if (target < (2 * SND_SDL_SAMPLES)) {
+		target = 2 * SND_SDL_SAMPLES;
+	}
+
+	size = 1;
+
+	while (size < (4 * target)) {
+		size *= 2;
+	}
+
+	free (drv->ring);
+
+	drv->ring = malloc (size * chn * sizeof (int16_t));
+
+	if (drv->ring == NULL) {
+		return (1);
+	}
+
+	drv->channels = chn;
+	drv->ring_size = size;
+	drv->ring_mask = size - 1;
+
+	drv->wr = 0;
+	drv->rd = 0;
+	drv->refill = 0;
+
+	drv->target = target;
+	drv->fill = target;
+
+	drv->step = 0x10000;
+	drv->phase = 0;
+
+	memset (drv->last, 0, sizeof (drv->last));
+
+	return (0);
+}
+
 static
 int snd_sdl_set_params (sound_drv_t *sdrv, unsigned chn, unsigned long srate, int sign)
 {
@@ -247,10 +331,14 @@ int snd_sdl_set_params (sound_drv_t *sdrv, unsigned chn, unsigned long srate, in
 		drv->is_open = 0;
 	}
 
+	if (snd_sdl_ring_init (drv, chn, srate)) {
+		return (1);
+	}
+
 	req.freq = srate;
-	req.format = AUDIO_S16LSB;
+	req.format = AUDIO_S16SYS;
 	req.channels = chn;
-	req.samples = 1024;
+	req.samples = SND_SDL_SAMPLES;
 	req.callback = snd_sdl_callback;
 	req.userdata = drv;
 
@@ -266,8 +354,19 @@ int snd_sdl_set_params (sound_drv_t *sdrv, unsigned chn, unsigned long srate, in
 	drv->is_open = 1;
 	drv->is_paused = 1;
 
-	drv->sign = 1;
-	drv->big_endian = 0;
+	return (0);
+}
+
+static
+int snd_sdl_set_opts (sound_drv_t *sdrv, unsigned opts, int val)
+{
+	sound_sdl_t *drv;
+
+	drv = sdrv->ext;
+
+	if (opts & SND_OPT_NONBLOCK) {
+		drv->sync = (val == 0);
+	}
 
 	return (0);
 }
@@ -280,15 +379,35 @@ int snd_sdl_init (sound_sdl_t *drv, const char *name)
 	drv->sdrv.close = snd_sdl_close;
 	drv->sdrv.write = snd_sdl_write;
 	drv->sdrv.set_params = snd_sdl_set_params;
+	drv->sdrv.set_opts = snd_sdl_set_opts;
 
 	drv->is_open = 0;
 	drv->is_paused = 1;
 
-	drv->buf_cnt = 0;
+	drv->sync = drv_get_option_bool (name, "sync", 0);
+	drv->latency = drv_get_option_uint (name, "latency", 100);
+
+	drv->channels = 0;
 
-	drv->head = NULL;
-	drv->tail = NULL;
-	drv->free = NULL;
+	drv->ring_size = 0;
+	drv->ring_mask = 0;
+	drv->ring = NULL;
+
+	drv->wr = 0;
+	drv->rd = 0;
+	drv->refill = 0;
+
+	drv->target = 0;
+	drv->fill = 0;
+
+	drv->step = 0x10000;
+	drv->phase = 0;
+
+	drv->sem = SDL_CreateSemaphore (0);
+
+	if (drv->sem == NULL) {
+		return (1);
+	}
 
 	return (0);
 }
@@ -26,29 +26,54 @@
 
 #include <drivers/sound/sound.h>
 
+#include <SDL.h>
 
-typedef struct sound_sdl_buf_t {
-	struct sound_sdl_buf_t *next;
-	unsigned               idx;
-	unsigned               cnt;
-	unsigned               max;
-	unsigned char          *data;
-} sound_sdl_buf_t;
 
+/*
+ * The sample ring buffer is shared between snd_sdl_write() and the
+ * SDL audio callback. There is exactly one producer and one consumer,
+ * so no locking is needed: the producer only advances wr and the
+ * consumer only advances rd. Both are free running frame counters.
+ */
 typedef struct sound_sdl_t {
-	sound_drv_t sdrv;
+	sound_drv_t   sdrv;
 
-	char        is_open;
-	char        is_paused;
+	char          is_open;
+	char          is_paused;
 
-	int         sign;
-	int         big_endian;
+	/* block in snd_sdl_write() instead of dropping samples */
+	char          sync;
 
-	unsigned        buf_cnt;
+	/* the requested buffer fill level in milliseconds */
+	unsigned long latency;
 
-	sound_sdl_buf_t *head;
-	sound_sdl_buf_t *tail;
-	sound_sdl_buf_t *free;
+	unsigned      channels;
+
+	unsigned long ring_size;
+	unsigned long ring_mask;
+	int16_t       *ring;
+
+	unsigned long wr;
+	unsigned long rd;
+
+	/*
+	 * The ring buffer ran dry. Only used by the audio callback, which
+	 * plays silence until the buffer is filled to target again.
+	 */
+	char          refill;
+
+	/* the target buffer fill level in frames */
+	unsigned long target;
+
+	/* the smoothed buffer fill level in frames */
+	unsigned long fill;
+
+	/* the resampler input step per output frame (16.16) */
+	unsigned long step;
+	unsigned long phase;
+	int           last[SND_CHN_MAX];
+
+	SDL_sem       *sem;
 } sound_sdl_t;
 
 
@@ -70,6 +70,13 @@ void trm_init (terminal_t *trm, void *ext)
 	trm->buf = NULL;
 	trm->term_bpp = 3;
 
+	trm->ibuf_cnt = 0;
+	trm->ibuf = NULL;
+
+	memset (trm->pal, 0, sizeof (trm->pal));
+
+	trm->remap = 1;
+
 	trm->scale = 1;
 
 	trm->aspect_x = 4;
@@ -101,6 +108,7 @@ void trm_free (terminal_t *trm)
 	trm_close (trm);
 
 	free (trm->buf);
+	free (trm->ibuf);
 	free (trm->scale_buf);
 }
 
@@ -316,6 +324,11 @@ void trm_set_size (terminal_t *trm, unsigned w, unsigned h)
 		trm->buf_cnt = 0;
 		trm->buf = NULL;
 
+		free (trm->ibuf);
+
+		trm->ibuf_cnt = 0;
+		trm->ibuf = NULL;
+
 		trm->w = 0;
 		trm->h = 0;
 
@@ -343,6 +356,10 @@ void trm_set_size (terminal_t *trm, unsigned w, unsigned h)
 	trm->w = w;
 	trm->h = h;
 
+	/* clear the indexed buffer on the next trm_set_lines_idx() */
+	trm->ibuf_cnt = 0;
+	trm->remap = 1;
+
 	trm->update_x = 0;
 	trm->update_y = 0;
 	trm->update_w = w;
@@ -381,6 +398,8 @@ void trm_set_pixel (terminal_t *trm, unsigned x, unsigned y, const unsigned char
 	buf[1] = col[1];
 	buf[2] = col[2];
 
+	trm->remap = 1;
+
 	if (trm->update_w == 0) {
 		trm->update_x = x;
 		trm->update_w = 1;
@@ -412,12 +431,45 @@ void trm_set_pixel (terminal_t *trm, unsigned x, unsigned y, const unsigned char
 	}
 }
 
+/*
+ * Add full lines to the update rectangle
+ */
+static
+void trm_set_update_lines (terminal_t *trm, unsigned y, unsigned cnt)
+{
+	trm->update_x = 0;
+	trm->update_w = trm->w;
+
+	if (trm->update_h == 0) {
+		trm->update_y = y;
+		trm->update_h = cnt;
+	}
+	else {
+		if (y < trm->update_y) {
+			trm->update_h += trm->update_y - y;
+			trm->update_y = y;
+		}
+
+		if ((y + cnt) > (trm->update_y + trm->update_h)) {
+			trm->update_h = (y + cnt) - trm->update_y;
+		}
+	}
+}
+
 void trm_set_lines (terminal_t *trm, const void *buf, unsigned y, unsigned cnt)
 {
 	unsigned long       w3, tmp;
 	const unsigned char *src;
 	unsigned char       *dst;
 
+	if (y >= trm->h) {
+		return;
+	}
+
+	if (cnt > (trm->h - y)) {
+		cnt = trm->h - y;
+	}
+
 	w3 = trm->term_bpp * trm->w;
 
 	src = buf;
@@ -452,22 +504,131 @@ void trm_set_lines (terminal_t *trm, const void *buf, unsigned y, unsigned cnt)
 
 	memcpy (dst, src, w3 * cnt);
 
-	trm->update_x = 0;
-	trm->update_w = trm->w;
+	trm->remap = 1;
 
-	if (trm->update_h == 0) {
-		trm->update_y = y;
-		trm->update_h = cnt;
+	trm_set_update_lines (trm, y, cnt);
+}
+
+void trm_set_palette (terminal_t *trm, unsigned idx, const unsigned char *col)
+{
+	unsigned char *p;
+
+	p = trm->pal[idx & 0xff];
+
+	if ((p[0] == col[0]) && (p[1] == col[1]) && (p[2] == col[2])) {
+		return;
+	}
+
+	p[0] = col[0];
+	p[1] = col[1];
+	p[2] = col[2];
+	p[3] = 0xff;
+
+	trm->remap = 1;
+}
+
+/*
+ * Convert lines from the indexed buffer to the terminal buffer
+ */
+static
+void trm_remap_lines (terminal_t *trm, unsigned y, unsigned cnt)
+{
+	unsigned long       i, n;
+	const unsigned char *src, *col;
+	unsigned char       *dst;
+
+	n = (unsigned long) trm->w * cnt;
+	src = trm->ibuf + (unsigned long) trm->w * y;
+	dst = trm->buf + trm->term_bpp * (unsigned long) trm->w * y;
+
+	if (trm->term_bpp == 3) {
+		for (i = 0; i < n; i++) {
+			col = trm->pal[src[i]];
+
+			dst[0] = col[0];
+			dst[1] = col[1];
+			dst[2] = col[2];
+
+			dst += 3;
+		}
 	}
 	else {
-		if (y < trm->update_y) {
-			trm->update_h += trm->update_y - y;
-			trm->update_y = y;
+		for (i = 0; i < n; i++) {
+			memcpy (dst, trm->pal[src[i]], 4);
+			dst += 4;
 		}
+	}
+}
 
-		if ((y + cnt) > (trm->update_y + trm->update_h)) {
-			trm->update_h = (y + cnt) - trm->update_y;
+void trm_set_lines_idx (terminal_t *trm, const void *buf, unsigned y, unsigned cnt)
+{
+	unsigned            i, y1, y2;
+	unsigned long       w, n;
+	const unsigned char *src;
+	unsigned char       *dst;
+
+	if ((trm->buf == NULL) || (y >= trm->h)) {
+		return;
+	}
+
+	if (cnt > (trm->h - y)) {
+		cnt = trm->h - y;
+	}
+
+	w = trm->w;
+	n = w * trm->h;
+
+	if (trm->ibuf_cnt != n) {
+		unsigned char *tmp;
+
+		tmp = realloc (trm->ibuf, n);
+		if (tmp == NULL) {
+			return;
+		}
+
+		memset (tmp, 0, n);
+
+		trm->ibuf = tmp;
+		trm->ibuf_cnt = n;
+		trm->remap = 1;
+	}
+
+	src = buf;
+	dst = trm->ibuf + w * y;
+
+	if (trm->remap) {
+		memcpy (dst, src, w * cnt);
+
+		trm_remap_lines (trm, 0, trm->h);
+		trm_set_update_lines (trm, 0, trm->h);
+
+		trm->remap = 0;
+
+		return;
+	}
+
+	y1 = y;
+	y2 = y;
+
+	for (i = 0; i < cnt; i++) {
+		if (memcmp (dst, src, w) != 0) {
+			memcpy (dst, src, w);
+
+			trm_remap_lines (trm, y + i, 1);
+
+			if (y1 == y2) {
+				y1 = y + i;
+			}
+
+			y2 = y + i + 1;
 		}
+
+		src += w;
+		dst += w;
+	}
+
+	if (y1 < y2) {
+		trm_set_update_lines (trm, y1, y2 - y1);
 	}
 }
 
@@ -75,6 +75,16 @@ typedef struct {
 	unsigned char *buf;
 	size_t term_bpp;
 
+	/* the indexed buffer, 1 byte per pixel, see trm_set_lines_idx() */
+	unsigned long ibuf_cnt;
+	unsigned char *ibuf;
+
+	/* the palette in the terminal buffer pixel format */
+	unsigned char pal[256][4];
+
+	/* buf must be rebuilt from ibuf on the next trm_set_lines_idx() */
+	char          remap;
+
 	unsigned      scale;
 
 	unsigned      aspect_x;
@@ -212,10 +222,32 @@ void trm_set_pixel (terminal_t *trm, unsigned x, unsigned y, const unsigned char
  * @param y   The first line in the terminal buffer
  * @param cnt The number of lines
  *
- * The buffer width is implicit, as set by trm_set_size().
+ * The buffer width is implicit, as set by trm_set_size(). Lines below
+ * the terminal height are ignored.
  *****************************************************************************/
 void trm_set_lines (terminal_t *trm, const void *buf, unsigned y, unsigned cnt);
 
+/*!***************************************************************************
+ * @short Set a palette entry for trm_set_lines_idx()
+ * @param col The color. This is an array of three RGB values.
+ *
+ * Changing a palette entry causes the entire terminal buffer to be
+ * converted again on the next call to trm_set_lines_idx().
+ *****************************************************************************/
+void trm_set_palette (terminal_t *trm, unsigned idx, const unsigned char *col);
+
+/*!***************************************************************************
+ * @short Set lines in the terminal buffer from palette indices
+ * @param buf The source buffer, 1 byte per pixel
+ * @param y   The first line in the terminal buffer
+ * @param cnt The number of lines
+ *
+ * Only lines that differ from the previous call are converted to the
+ * terminal buffer pixel format. Lines below the terminal height are
+ * ignored.
+ *****************************************************************************/
+void trm_set_lines_idx (terminal_t *trm, const void *buf, unsigned y, unsigned cnt);
+
 /*!***************************************************************************
  * @short Update the screen from the terminal buffer
  *****************************************************************************/
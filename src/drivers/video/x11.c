@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -341,6 +343,103 @@ void xt_set_window_title (xterm_t *xt, const char *str)
 	XFlush (xt->display);
 }
 
+#ifdef PCE_X11_HAVE_XSHM
+static int xt_shm_error;
+
+static
+int xt_shm_error_handler (Display *display, XErrorEvent *evt)
+{
+	xt_shm_error = 1;
+
+	return (0);
+}
+
+static
+Bool xt_shm_is_completion (Display *display, XEvent *evt, XPointer arg)
+{
+	xterm_t *xt = (xterm_t *) arg;
+
+	return (evt->type == xt->shm_completion);
+}
+
+/*
+ * Allocate the backing image in a shared memory segment
+ */
+static
+int xt_image_alloc_shm (xterm_t *xt, Visual *vis, unsigned depth, unsigned w, unsigned h)
+{
+	int (*handler) (Display *, XErrorEvent *);
+
+	xt->img = XShmCreateImage (xt->display, vis, depth, ZPixmap, NULL,
+		&xt->shm_info, w, h
+	);
+
+	if (xt->img == NULL) {
+		return (1);
+	}
+
+	xt->shm_info.shmid = shmget (IPC_PRIVATE,
+		(size_t) xt->img->bytes_per_line * h, IPC_CREAT | 0600
+	);
+
+	if (xt->shm_info.shmid < 0) {
+		XDestroyImage (xt->img);
+		xt->img = NULL;
+		return (1);
+	}
+
+	xt->shm_info.shmaddr = shmat (xt->shm_info.shmid, NULL, 0);
+
+	if (xt->shm_info.shmaddr == (char *) -1) {
+		shmctl (xt->shm_info.shmid, IPC_RMID, NULL);
+		XDestroyImage (xt->img);
+		xt->img = NULL;
+		return (1);
+	}
+
+	xt->shm_info.readOnly = False;
+
+	/* attaching fails asynchronously if the server is remote */
+	xt_shm_error = 0;
+	handler = XSetErrorHandler (xt_shm_error_handler);
+	XShmAttach (xt->display, &xt->shm_info);
+	XSync (xt->display, False);
+	XSetErrorHandler (handler);
+
+	/* the segment goes away when both sides have detached */
+	shmctl (xt->shm_info.shmid, IPC_RMID, NULL);
+
+	if (xt_shm_error) {
+		shmdt (xt->shm_info.shmaddr);
+		XDestroyImage (xt->img);
+		xt->img = NULL;
+		return (1);
+	}
+
+	xt->img->data = xt->shm_info.shmaddr;
+	xt->img_buf = (unsigned char *) xt->shm_info.shmaddr;
+	xt->img_shm = 1;
+
+	return (0);
+}
+#endif
+
+/*
+ * Wait until the X server is done reading the backing image
+ */
+static
+void xt_shm_wait (xterm_t *xt)
+{
+#ifdef PCE_X11_HAVE_XSHM
+	XEvent evt;
+
+	while (xt->shm_pending > 0) {
+		XIfEvent (xt->display, &evt, xt_shm_is_completion, (XPointer) xt);
+		xt->shm_pending -= 1;
+	}
+#endif
+}
+
 /*
  * Allocate the backing image
  */
@@ -357,6 +456,21 @@ int xt_image_alloc (xterm_t *xt, unsigned w, unsigned h)
 
 	depth = attrib.depth;
 
+	xt->img_shm = 0;
+	xt->shm_pending = 0;
+
+#ifdef PCE_X11_HAVE_XSHM
+	if (xt->use_shm) {
+		if (xt_image_alloc_shm (xt, vis, depth, w, h) == 0) {
+			return (0);
+		}
+
+		pce_log (MSG_INF, "x11: MIT-SHM attach failed, using XPutImage\n");
+
+		xt->use_shm = 0;
+	}
+#endif
+
 	xt->img = XCreateImage (xt->display, vis, depth, ZPixmap, 0, NULL, w, h, 8, 0);
 	xt->img_buf = malloc (xt->img->bytes_per_line * h);
 	xt->img->data = (char *) xt->img_buf;
@@ -370,12 +484,54 @@ int xt_image_alloc (xterm_t *xt, unsigned w, unsigned h)
 static
 void xt_image_free (xterm_t *xt)
 {
+	if (xt->img == NULL) {
+		return;
+	}
+
+	xt_shm_wait (xt);
+
+#ifdef PCE_X11_HAVE_XSHM
+	if (xt->img_shm) {
+		XShmDetach (xt->display, &xt->shm_info);
+		XSync (xt->display, False);
+		shmdt (xt->shm_info.shmaddr);
+
+		xt->img->data = NULL;
+		xt->img_shm = 0;
+	}
+#endif
+
 	XDestroyImage (xt->img);
 
-	xt->img = None;
+	xt->img = NULL;
 	xt->img_buf = NULL;
 }
 
+/*
+ * Send a rectangle of the backing image to the window
+ */
+static
+void xt_image_put (xterm_t *xt, unsigned x, unsigned y, unsigned w, unsigned h)
+{
+	if (xt->img == NULL) {
+		return;
+	}
+
+#ifdef PCE_X11_HAVE_XSHM
+	if (xt->img_shm) {
+		XShmPutImage (xt->display, xt->wdw, xt->gc, xt->img,
+			x, y, x, y, w, h, True
+		);
+
+		xt->shm_pending += 1;
+
+		return;
+	}
+#endif
+
+	XPutImage (xt->display, xt->wdw, xt->gc, xt->img, x, y, x, y, w, h);
+}
+
 /*
  * Decode a bit mask into the first set bit and the number of set bits
  */
@@ -422,38 +578,67 @@ unsigned long xt_get_pixel (const unsigned char *src,
 }
 
 /*
- * Render the terminal buffer into the backing image
+ * Replicate every pixel in an image line fx times
+ *
+ * The first copy of each pixel has already been stored at the start of
+ * its fx * bpp wide slot.
  */
 static
-void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned y, unsigned w, unsigned h)
+void xt_image_expand (unsigned char *dst, unsigned w, unsigned fx, unsigned bpp)
+{
+	unsigned i, k;
+
+	for (i = 0; i < w; i++) {
+		for (k = 1; k < fx; k++) {
+			memcpy (dst + bpp * k, dst, bpp);
+		}
+
+		dst += fx * bpp;
+	}
+}
+
+/*
+ * Render a rectangle of the terminal buffer into the backing image
+ *
+ * The rectangle (x, y, w, h) is in terminal coordinates, sw is the width
+ * of the terminal buffer. The image is scaled by (fx, fy) on the way, so
+ * no scaled copy of the terminal buffer is needed.
+ */
+static
+void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned sw,
+	unsigned x, unsigned y, unsigned w, unsigned h, unsigned fx, unsigned fy)
 {
 	unsigned char *dst;
 	unsigned      i, j, k;
 	unsigned      si, di;
 	unsigned      ri, rn, gi, gn, bi, bn;
-	unsigned      bpp;
+	unsigned      sbpp, bpp, dstep;
+	unsigned long bpl;
 	unsigned long val;
 
-	src = src + xt->trm.term_bpp * w * y;
-	dst = xt->img_buf + xt->img->bytes_per_line * y;
+	sbpp = xt->trm.term_bpp;
+	bpp = xt->img->bits_per_pixel / 8;
+	bpl = xt->img->bytes_per_line;
+	dstep = fx * bpp;
+
+	src = src + sbpp * ((unsigned long) sw * y + x);
+	dst = xt->img_buf + bpl * fy * y + dstep * x;
 
 	xt_decode_mask (xt->img->red_mask, &ri, &rn);
 	xt_decode_mask (xt->img->green_mask, &gi, &gn);
 	xt_decode_mask (xt->img->blue_mask, &bi, &bn);
 
-	bpp = xt->img->bits_per_pixel / 8;
-
 	for (j = 0; j < h; j++) {
-		si = xt->trm.term_bpp * x;
-		di = bpp * x;
+		si = 0;
+		di = 0;
 
 		switch ((bpp << 1) | (xt->img->byte_order == MSBFirst)) {
 		case ((1 << 1) | 0):
 		case ((1 << 1) | 1):
 			for (i = 0; i < w; i++) {
-				dst[di] = src[1];
-				si += xt->trm.term_bpp;
-				di += 1;
+				dst[di] = src[si + 1];
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -464,8 +649,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 0] = val & 0xff;
 				dst[di + 1] = (val >> 8) & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 2;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -476,8 +661,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 0] = (val >> 8) & 0xff;
 				dst[di + 1] = val & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 2;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -489,8 +674,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 1] = (val >> 8) & 0xff;
 				dst[di + 2] = (val >> 16) & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 3;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -502,8 +687,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 1] = (val >> 8) & 0xff;
 				dst[di + 2] = val & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 3;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -516,8 +701,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 2] = (val >> 16) & 0xff;
 				dst[di + 3] = (val >> 24) & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 4;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -530,8 +715,8 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 				dst[di + 2] = (val >> 8) & 0xff;
 				dst[di + 3] = val & 0xff;
 
-				si += xt->trm.term_bpp;
-				di += 4;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 
@@ -552,27 +737,37 @@ void xt_image_draw (xterm_t *xt, const unsigned char *src, unsigned x, unsigned
 					}
 				}
 
-				si += xt->trm.term_bpp;
-				di += bpp;
+				si += sbpp;
+				di += dstep;
 			}
 			break;
 		}
 
-		src += xt->trm.term_bpp * w;
-		dst += xt->img->bytes_per_line;
+		if (fx > 1) {
+			xt_image_expand (dst, w, fx, bpp);
+		}
+
+		for (k = 1; k < fy; k++) {
+			memcpy (dst + bpl * k, dst, (size_t) dstep * w);
+		}
+
+		src += sbpp * sw;
+		dst += bpl * fy;
 	}
 }
 
 /*
  * Set the window size and reallocate the backing image
+ *
+ * Returns true if the backing image was reallocated.
  */
 static
-void xt_set_window_size (xterm_t *xt, unsigned w, unsigned h)
+int xt_set_window_size (xterm_t *xt, unsigned w, unsigned h)
 {
 	XSizeHints size;
 
 	if ((xt->wdw_w == w) && (xt->wdw_h == h)) {
-		return;
+		return (0);
 	}
 
 	size.flags = PMinSize | PMaxSize;
@@ -590,40 +785,48 @@ void xt_set_window_size (xterm_t *xt, unsigned w, unsigned h)
 
 	xt_image_free (xt);
 	xt_image_alloc (xt, w, h);
+
+	return (1);
 }
 
 /*
  * Update the window from the terminal buffer
+ *
+ * Only the update rectangle is converted and sent to the server.
  */
 static
 void xt_update (void *ext)
 {
 	xterm_t *xt = (xterm_t *)ext;
-	terminal_t          *trm;
-	const unsigned char *buf;
-	unsigned            fx, fy;
-	unsigned            dw, dh;
-	unsigned            ux, uy, uw, uh;
+	terminal_t *trm;
+	unsigned   fx, fy;
+	unsigned   ux, uy, uw, uh;
 
 	trm = &xt->trm;
 
 	trm_get_scale (trm, trm->w, trm->h, &fx, &fy);
 
-	dw = fx * trm->w;
-	dh = fy * trm->h;
+	ux = trm->update_x;
+	uy = trm->update_y;
+	uw = trm->update_w;
+	uh = trm->update_h;
 
-	xt_set_window_size (xt, dw, dh);
+	if (xt_set_window_size (xt, fx * trm->w, fy * trm->h)) {
+		ux = 0;
+		uy = 0;
+		uw = trm->w;
+		uh = trm->h;
+	}
 
-	buf = trm_scale (trm, trm->buf, trm->w, trm->h, fx, fy);
+	if (xt->img == NULL) {
+		return;
+	}
 
-	ux = fx * trm->update_x;
-	uy = fy * trm->update_y;
-	uw = fx * trm->update_w;
-	uh = fy * trm->update_h;
+	xt_shm_wait (xt);
 
-	xt_image_draw (xt, buf, ux, uy, uw, uh);
+	xt_image_draw (xt, trm->buf, trm->w, ux, uy, uw, uh, fx, fy);
 
-	XPutImage (xt->display, xt->wdw, xt->gc, xt->img, ux, uy, ux, uy, uw, uh);
+	xt_image_put (xt, fx * ux, fy * uy, fx * uw, fy * uh);
 }
 
 /*
@@ -870,9 +1073,7 @@ void xt_event_expose (xterm_t *xt, XEvent *event)
 
 	evt = (XExposeEvent *) event;
 
-	XPutImage (xt->display, xt->wdw, xt->gc, xt->img,
-		evt->x, evt->y, evt->x, evt->y, evt->width, evt->height
-	);
+	xt_image_put (xt, evt->x, evt->y, evt->width, evt->height);
 }
 
 static
@@ -996,6 +1197,11 @@ int xt_check (void *ext)
 			break;
 
 		default:
+			if (event.type == xt->shm_completion) {
+				if (xt->shm_pending > 0) {
+					xt->shm_pending -= 1;
+				}
+			}
 			break;
 		}
 
@@ -1153,6 +1359,19 @@ int xt_open (void *ext, unsigned w, unsigned h)
 	xt->display_h = DisplayHeight (xt->display, xt->screen);
 	xt->root = RootWindow (xt->display, xt->screen);
 
+#ifdef PCE_X11_HAVE_XSHM
+	if (xt->use_shm) {
+		if (XShmQueryExtension (xt->display)) {
+			xt->shm_completion = XShmGetEventBase (xt->display) + ShmCompletion;
+		}
+		else {
+			xt->use_shm = 0;
+		}
+	}
+#else
+	xt->use_shm = 0;
+#endif
+
 	if (xt_open_window (xt, w, h)) {
 		XCloseDisplay (xt->display);
 		return (1);
@@ -1195,7 +1414,7 @@ int xt_close (void *ext)
 static
 void xt_init (xterm_t *xt, ini_sct_t *sct)
 {
-	int rep;
+	int rep, shm;
 
 	trm_init (&xt->trm, xt);
 	xt->trm.name = "x11";
@@ -1215,6 +1434,10 @@ void xt_init (xterm_t *xt, ini_sct_t *sct)
 	xt->img = NULL;
 	xt->img_buf = NULL;
 
+	xt->img_shm = 0;
+	xt->shm_pending = 0;
+	xt->shm_completion = -1;
+
 	xt->empty_cursor = None;
 
 	xt->wdw_w = 0;
@@ -1229,6 +1452,9 @@ void xt_init (xterm_t *xt, ini_sct_t *sct)
 	ini_get_bool (sct, "report_keys", &rep, 0);
 	xt->report_keys = (rep != 0);
 
+	ini_get_bool (sct, "shm", &shm, 1);
+	xt->use_shm = (shm != 0);
+
 	xt_init_keymap_default (xt);
 	xt_init_keymap_user (xt, sct);
 }
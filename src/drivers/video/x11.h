@@ -24,6 +24,8 @@
 #define PCE_VIDEO_X11_H 1
 
 
+#include <config.h>
+
 #include <stdio.h>
 
 #include <X11/Xlib.h>
@@ -31,6 +33,12 @@
 #include <X11/Xatom.h>
 #include <X11/keysym.h>
 
+#ifdef PCE_X11_HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
 #include <drivers/video/terminal.h>
 
 #include <libini/libini.h>
@@ -66,6 +74,22 @@ typedef struct {
 	XImage        *img;
 	unsigned char *img_buf;
 
+	/* use the MIT-SHM extension if available */
+	char          use_shm;
+
+	/* the current image is a shared memory image */
+	char          img_shm;
+
+	/* the number of shared memory puts still in progress */
+	unsigned      shm_pending;
+
+	/* the ShmCompletion event type */
+	int           shm_completion;
+
+#ifdef PCE_X11_HAVE_XSHM
+	XShmSegmentInfo shm_info;
+#endif
+
 	Cursor        empty_cursor;
 
 	unsigned      wdw_w;
@@ -20,6 +20,8 @@
  *****************************************************************************/
 
 
+#include <config.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +29,10 @@
 #include "console.h"
 #include "cmd.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 
 typedef struct {
 	char          *name;
@@ -34,14 +40,171 @@ typedef struct {
 } cmd_sym_t;
 
 
-static void  *cmd_get_sym_ext = NULL;
-static int   (*cmd_get_sym_fct) (void *ext, const char *sym, unsigned long *val);
+/*
+ * The symbol hooks and user symbols of one owner, usually an emulated
+ * machine. A context is only used by one thread at a time.
+ */
+typedef struct cmd_ctx_t {
+	struct cmd_ctx_t *next;
+
+	void             *owner;
+
+	void             *get_sym_ext;
+	int              (*get_sym_fct) (void *ext, const char *sym, unsigned long *val);
+
+	void             *set_sym_ext;
+	int              (*set_sym_fct) (void *ext, const char *sym, unsigned long val);
+
+	unsigned         sym_cnt;
+	cmd_sym_t        *sym;
+} cmd_ctx_t;
+
+
+static cmd_ctx_t cmd_dflt = {
+	NULL, NULL, NULL, NULL, NULL, NULL, 0, NULL
+};
+
+/* protects the list of contexts */
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t cmd_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  cmd_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   cmd_key;
+#else
+static cmd_ctx_t       *cmd_cur = &cmd_dflt;
+#endif
+
+
+#ifdef HAVE_PTHREAD_H
+static
+void cmd_key_init (void)
+{
+	pthread_key_create (&cmd_key, NULL);
+}
+#endif
+
+/*
+ * Get the context of the current thread
+ */
+static
+cmd_ctx_t *cmd_get_ctx (void)
+{
+#ifdef HAVE_PTHREAD_H
+	cmd_ctx_t *ctx;
+
+	pthread_once (&cmd_once, cmd_key_init);
+
+	ctx = pthread_getspecific (cmd_key);
+
+	return ((ctx != NULL) ? ctx : &cmd_dflt);
+#else
+	return (cmd_cur);
+#endif
+}
+
+static
+void cmd_set_ctx (cmd_ctx_t *ctx)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_once (&cmd_once, cmd_key_init);
+	pthread_setspecific (cmd_key, ctx);
+#else
+	cmd_cur = (ctx != NULL) ? ctx : &cmd_dflt;
+#endif
+}
+
+static
+void cmd_lock_ctx (void)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&cmd_lock);
+#endif
+}
+
+static
+void cmd_unlock_ctx (void)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&cmd_lock);
+#endif
+}
+
+void cmd_set_owner (void *owner)
+{
+	cmd_ctx_t *ctx;
+
+	cmd_lock_ctx ();
+
+	ctx = &cmd_dflt;
 
-static void  *cmd_set_sym_ext = NULL;
-static int   (*cmd_set_sym_fct) (void *ext, const char *sym, unsigned long val);
+	while ((ctx != NULL) && (ctx->owner != owner)) {
+		ctx = ctx->next;
+	}
+
+	if (ctx == NULL) {
+		ctx = malloc (sizeof (cmd_ctx_t));
+
+		if (ctx == NULL) {
+			ctx = &cmd_dflt;
+		}
+		else {
+			ctx->owner = owner;
+			ctx->get_sym_ext = NULL;
+			ctx->get_sym_fct = NULL;
+			ctx->set_sym_ext = NULL;
+			ctx->set_sym_fct = NULL;
+			ctx->sym_cnt = 0;
+			ctx->sym = NULL;
 
-static unsigned  cmd_sym_cnt = 0;
-static cmd_sym_t *cmd_sym = NULL;
+			ctx->next = cmd_dflt.next;
+			cmd_dflt.next = ctx;
+		}
+	}
+
+	cmd_unlock_ctx ();
+
+	cmd_set_ctx (ctx);
+}
+
+void cmd_del_owner (void *owner)
+{
+	unsigned  i;
+	cmd_ctx_t *ctx, *tmp;
+
+	if (owner == NULL) {
+		return;
+	}
+
+	cmd_lock_ctx ();
+
+	tmp = &cmd_dflt;
+
+	while ((tmp->next != NULL) && (tmp->next->owner != owner)) {
+		tmp = tmp->next;
+	}
+
+	ctx = tmp->next;
+
+	if (ctx != NULL) {
+		tmp->next = ctx->next;
+	}
+
+	cmd_unlock_ctx ();
+
+	if (ctx == NULL) {
+		return;
+	}
+
+	if (cmd_get_ctx () == ctx) {
+		cmd_set_ctx (NULL);
+	}
+
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		free (ctx->sym[i].name);
+	}
+
+	free (ctx->sym);
+	free (ctx);
+}
 
 
 static
@@ -149,7 +312,9 @@ int cmd_get_sym (cmd_t *cmd, const char *sym, unsigned long *val)
 {
 	unsigned   i;
 	const char *str;
+	cmd_ctx_t  *ctx;
 
+	ctx = cmd_get_ctx ();
 	str = sym;
 
 	if ((str[0] == '%') || (str[0] == '$')) {
@@ -157,8 +322,8 @@ int cmd_get_sym (cmd_t *cmd, const char *sym, unsigned long *val)
 	}
 
 	if (sym[0] != '$') {
-		if (cmd_get_sym_fct != NULL) {
-			if (cmd_get_sym_fct (cmd_get_sym_ext, str, val) == 0) {
+		if (ctx->get_sym_fct != NULL) {
+			if (ctx->get_sym_fct (ctx->get_sym_ext, str, val) == 0) {
 				return (0);
 			}
 		}
@@ -168,9 +333,9 @@ int cmd_get_sym (cmd_t *cmd, const char *sym, unsigned long *val)
 		}
 	}
 
-	for (i = 0; i < cmd_sym_cnt; i++) {
-		if (strcmp (cmd_sym[i].name, str) == 0) {
-			*val = cmd_sym[i].val;
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		if (strcmp (ctx->sym[i].name, str) == 0) {
+			*val = ctx->sym[i].val;
 			return (0);
 		}
 	}
@@ -183,7 +348,9 @@ int cmd_set_sym (cmd_t *cmd, const char *sym, unsigned long val)
 	unsigned   i;
 	const char *str;
 	cmd_sym_t  *tmp;
+	cmd_ctx_t  *ctx;
 
+	ctx = cmd_get_ctx ();
 	str = sym;
 
 	if ((str[0] == '%') || (str[0] == '$')) {
@@ -191,8 +358,8 @@ int cmd_set_sym (cmd_t *cmd, const char *sym, unsigned long val)
 	}
 
 	if (sym[0] != '$') {
-		if (cmd_set_sym_fct != NULL) {
-			if (cmd_set_sym_fct (cmd_set_sym_ext, str, val) == 0) {
+		if (ctx->set_sym_fct != NULL) {
+			if (ctx->set_sym_fct (ctx->set_sym_ext, str, val) == 0) {
 				return (0);
 			}
 		}
@@ -202,19 +369,19 @@ int cmd_set_sym (cmd_t *cmd, const char *sym, unsigned long val)
 		}
 	}
 
-	for (i = 0; i < cmd_sym_cnt; i++) {
-		if (strcmp (cmd_sym[i].name, str) == 0) {
-			cmd_sym[i].val = val;
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		if (strcmp (ctx->sym[i].name, str) == 0) {
+			ctx->sym[i].val = val;
 			return (0);
 		}
 	}
 
-	tmp = realloc (cmd_sym, (cmd_sym_cnt + 1) * sizeof (cmd_sym_t));
+	tmp = realloc (ctx->sym, (ctx->sym_cnt + 1) * sizeof (cmd_sym_t));
 	if (tmp == NULL) {
 		return (1);
 	}
 
-	i = cmd_sym_cnt;
+	i = ctx->sym_cnt;
 	while (i > 0) {
 		if (strcmp (tmp[i - 1].name, str) < 0) {
 			break;
@@ -228,15 +395,18 @@ int cmd_set_sym (cmd_t *cmd, const char *sym, unsigned long val)
 	tmp[i].name = strdup (str);
 	tmp[i].val = val;
 
-	cmd_sym = tmp;
-	cmd_sym_cnt += 1;
+	ctx->sym = tmp;
+	ctx->sym_cnt += 1;
 
 	return (0);
 }
 
 void cmd_del_sym (cmd_t *cmd, const char *sym, unsigned long *val)
 {
-	unsigned i, j;
+	unsigned  i, j;
+	cmd_ctx_t *ctx;
+
+	ctx = cmd_get_ctx ();
 
 	if (sym[0] == '%') {
 		return;
@@ -250,27 +420,30 @@ void cmd_del_sym (cmd_t *cmd, const char *sym, unsigned long *val)
 
 	j = 0;
 
-	for (i = 0; i < cmd_sym_cnt; i++) {
-		if (strcmp (cmd_sym[i].name, sym) == 0) {
-			*val = cmd_sym[i].val;
-			free (cmd_sym[i].name);
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		if (strcmp (ctx->sym[i].name, sym) == 0) {
+			*val = ctx->sym[i].val;
+			free (ctx->sym[i].name);
 		}
 		else {
-			cmd_sym[j] = cmd_sym[i];
+			ctx->sym[j] = ctx->sym[i];
 			j += 1;
 		}
 	}
 
-	cmd_sym_cnt = j;
+	ctx->sym_cnt = j;
 }
 
 void cmd_list_syms (cmd_t *cmd)
 {
-	unsigned i, k, n;
+	unsigned  i, k, n;
+	cmd_ctx_t *ctx;
+
+	ctx = cmd_get_ctx ();
 
 	n = 0;
-	for (i = 0; i < cmd_sym_cnt; i++) {
-		k = strlen (cmd_sym[i].name);
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		k = strlen (ctx->sym[i].name);
 		if (k > n) {
 			 n = k;
 		}
@@ -278,17 +451,17 @@ void cmd_list_syms (cmd_t *cmd)
 
 	n += 1;
 
-	for (i = 0; i < cmd_sym_cnt; i++) {
-		k = strlen (cmd_sym[i].name);
+	for (i = 0; i < ctx->sym_cnt; i++) {
+		k = strlen (ctx->sym[i].name);
 
-		pce_printf ("$%s", cmd_sym[i].name);
+		pce_printf ("$%s", ctx->sym[i].name);
 
 		while (k < n) {
 			pce_puts (" ");
 			k += 1;
 		}
 
-		pce_printf ("= %08lX\n", cmd_sym[i].val);
+		pce_printf ("= %08lX\n", ctx->sym[i].val);
 	}
 }
 
@@ -1309,9 +1482,13 @@ int cmd_match_uint16_16 (cmd_t *cmd, unsigned short *seg, unsigned short *ofs)
 
 void cmd_init (void *ext, void *getsym, void *setsym)
 {
-	cmd_get_sym_ext = ext;
-	cmd_get_sym_fct = getsym;
+	cmd_ctx_t *ctx;
+
+	ctx = cmd_get_ctx ();
+
+	ctx->get_sym_ext = ext;
+	ctx->get_sym_fct = getsym;
 
-	cmd_set_sym_ext = ext;
-	cmd_set_sym_fct = setsym;
+	ctx->set_sym_ext = ext;
+	ctx->set_sym_fct = setsym;
 }
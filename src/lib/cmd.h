@@ -60,6 +60,13 @@ int cmd_match_uint32b (cmd_t *cmd, unsigned long *val, unsigned base);
 int cmd_match_uint32 (cmd_t *cmd, unsigned long *val);
 int cmd_match_uint16_16 (cmd_t *cmd, unsigned short *seg, unsigned short *ofs);
 
+/*
+ * Select the symbol table used by the current thread. Each owner has
+ * its own symbol hooks and user symbols, NULL selects the default.
+ */
+void cmd_set_owner (void *owner);
+void cmd_del_owner (void *owner);
+
 void cmd_init (void *ext, void *getsym, void *setsym);
 
 
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/lib/runner.c                                             *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdlib.h>
+
+#include <lib/runner.h>
+
+#include <drivers/char/char-io.h>
+
+
+#define RUNNER_THREADS_MAX 256
+
+
+void runner_init (runner_t *run, unsigned threads)
+{
+	run->cnt = 0;
+	run->max = 0;
+	run->inst = NULL;
+
+	if (threads < 1) {
+		threads = 1;
+	}
+	else if (threads > RUNNER_THREADS_MAX) {
+		threads = RUNNER_THREADS_MAX;
+	}
+
+	run->threads = threads;
+
+	run->next = 0;
+	run->active = 0;
+
+	run->stop = 0;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_init (&run->lock, NULL);
+#endif
+}
+
+void runner_free (runner_t *run)
+{
+	free (run->inst);
+
+	run->inst = NULL;
+	run->cnt = 0;
+	run->max = 0;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_destroy (&run->lock);
+#endif
+}
+
+int runner_add (runner_t *run, void *ext, runner_step_f step)
+{
+	unsigned      max;
+	runner_inst_t *tmp;
+
+	if (run->cnt >= run->max) {
+		max = (run->max < 16) ? 16 : (2 * run->max);
+
+		tmp = realloc (run->inst, max * sizeof (runner_inst_t));
+
+		if (tmp == NULL) {
+			return (1);
+		}
+
+		run->inst = tmp;
+		run->max = max;
+	}
+
+	tmp = &run->inst[run->cnt++];
+
+	tmp->ext = ext;
+	tmp->step = step;
+	tmp->busy = 0;
+	tmp->done = 0;
+
+	run->active += 1;
+
+	return (0);
+}
+
+void runner_stop (runner_t *run)
+{
+	run->stop = 1;
+}
+
+static
+void runner_lock (runner_t *run)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&run->lock);
+#endif
+}
+
+static
+void runner_unlock (runner_t *run)
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&run->lock);
+#endif
+}
+
+/*
+ * Get the next instance that is neither running nor terminated.
+ * Must be called with the lock held.
+ */
+static
+runner_inst_t *runner_get_next (runner_t *run)
+{
+	unsigned      i, idx;
+	runner_inst_t *inst;
+
+	for (i = 0; i < run->cnt; i++) {
+		idx = run->next;
+
+		run->next += 1;
+
+		if (run->next >= run->cnt) {
+			run->next = 0;
+		}
+
+		inst = &run->inst[idx];
+
+		if ((inst->busy == 0) && (inst->done == 0)) {
+			inst->busy = 1;
+			return (inst);
+		}
+	}
+
+	return (NULL);
+}
+
+static
+void *runner_worker (void *ext)
+{
+	runner_t      *run;
+	runner_inst_t *inst;
+
+	run = ext;
+
+	runner_lock (run);
+
+	while (run->stop == 0) {
+		inst = runner_get_next (run);
+
+		if (inst == NULL) {
+			/* the remaining instances are owned by other workers */
+			break;
+		}
+
+		runner_unlock (run);
+
+		if (inst->step (inst->ext)) {
+			/* the instance has terminated, free its I/O reactor */
+			chr_io_del_owner (inst->ext);
+
+			runner_lock (run);
+			inst->done = 1;
+			run->active -= 1;
+		}
+		else {
+			runner_lock (run);
+		}
+
+		inst->busy = 0;
+	}
+
+	runner_unlock (run);
+
+	return (NULL);
+}
+
+unsigned runner_run (runner_t *run)
+{
+#ifdef HAVE_PTHREAD_H
+	unsigned  i, n;
+	pthread_t thr[RUNNER_THREADS_MAX];
+
+	n = (run->threads < run->cnt) ? run->threads : run->cnt;
+
+	/* the calling thread is the first worker */
+	for (i = 1; i < n; i++) {
+		if (pthread_create (&thr[i], NULL, runner_worker, run)) {
+			break;
+		}
+	}
+
+	n = i;
+
+	runner_worker (run);
+
+	for (i = 1; i < n; i++) {
+		pthread_join (thr[i], NULL);
+	}
+#else
+	runner_worker (run);
+#endif
+
+	return (run->active);
+}
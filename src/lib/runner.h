@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/lib/runner.h                                             *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_LIB_RUNNER_H
+#define PCE_LIB_RUNNER_H 1
+
+
+#include <config.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+
+/*
+ * Run one time slice of an instance. Returns 0 to continue running
+ * and non-zero if the instance has terminated.
+ */
+typedef int (*runner_step_f) (void *ext);
+
+
+typedef struct {
+	void          *ext;
+	runner_step_f step;
+
+	char          busy;
+	char          done;
+} runner_inst_t;
+
+
+/*!***************************************************************************
+ * @short Run independent machine instances on a pool of threads
+ *
+ * Each worker thread repeatedly takes the next idle instance in round
+ * robin order and runs one time slice of it. An instance is never run
+ * by two threads at the same time, but it can move between threads
+ * from one slice to the next.
+ *****************************************************************************/
+typedef struct {
+	unsigned        cnt;
+	unsigned        max;
+	runner_inst_t   *inst;
+
+	unsigned        threads;
+
+	unsigned        next;
+	unsigned        active;
+
+	volatile int    stop;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_t lock;
+#endif
+} runner_t;
+
+
+void runner_init (runner_t *run, unsigned threads);
+void runner_free (runner_t *run);
+
+/*!***************************************************************************
+ * @short Add an instance
+ * @param ext  The instance, passed to step
+ * @param step The function that runs one time slice
+ *
+ * When step returns non-zero, the instance has terminated and the char
+ * I/O reactor owned by ext is deleted (see chr_io_del_owner()).
+ *****************************************************************************/
+int runner_add (runner_t *run, void *ext, runner_step_f step);
+
+/*!***************************************************************************
+ * @short Stop all instances after their current time slice
+ *
+ * This can be called from a signal handler.
+ *****************************************************************************/
+void runner_stop (runner_t *run);
+
+/*!***************************************************************************
+ * @short Run all instances until they have terminated or runner_stop()
+ *        is called
+ * @return The number of instances that are still running
+ *
+ * If threads are not available, all instances are run on the calling
+ * thread.
+ *****************************************************************************/
+unsigned runner_run (runner_t *run);
+
+
+#endif
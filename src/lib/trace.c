@@ -0,0 +1,502 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/lib/trace.c                                              *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lib/trace.h>
+
+
+#define TRACE_VERSION 1
+
+/* the tag byte */
+#define TRACE_TAG_TYPE   0x07
+#define TRACE_TAG_ADDR   0x08
+#define TRACE_TAG_CNT    0xf0
+
+/* an execution record whose opcode bytes are in the cache */
+#define TRACE_EXEC_CACHED 6
+
+#define TRACE_OUT_SIZE 65536
+#define TRACE_REC_MAX  (1 + 5 + TRACE_DATA_MAX)
+
+
+static
+void trace_state_init (trace_state_t *st)
+{
+	unsigned i;
+
+	for (i = 0; i < 3; i++) {
+		st->addr[i] = 0;
+		st->cnt[i] = 0;
+	}
+
+	for (i = 0; i < TRACE_CACHE_CNT; i++) {
+		st->cache[i].type = 0;
+		st->cache[i].cnt = 0;
+		st->cache[i].addr = 0;
+	}
+}
+
+static
+unsigned trace_get_class (unsigned type)
+{
+	switch (type) {
+	case TRACE_MEM_RD:
+	case TRACE_MEM_WR:
+		return (1);
+
+	case TRACE_IO_RD:
+	case TRACE_IO_WR:
+		return (2);
+	}
+
+	return (0);
+}
+
+static
+trace_rec_t *trace_get_cache (trace_state_t *st, uint32_t addr)
+{
+	return (&st->cache[(addr ^ (addr >> 12)) & (TRACE_CACHE_CNT - 1)]);
+}
+
+/*
+ * Encode one record into buf and return the number of bytes used.
+ */
+static
+unsigned trace_encode (trace_state_t *st, const trace_rec_t *rec, unsigned char *buf)
+{
+	unsigned    i, n, cls, type, cnt;
+	uint32_t    addr, val;
+	trace_rec_t *ce;
+
+	cls = trace_get_class (rec->type);
+	type = rec->type;
+	cnt = rec->cnt;
+	addr = rec->addr;
+
+	if (type == TRACE_EXEC) {
+		ce = trace_get_cache (st, addr);
+
+		if ((ce->type == TRACE_EXEC) && (ce->addr == addr) && (ce->cnt == cnt)) {
+			if (memcmp (ce->data, rec->data, cnt) == 0) {
+				type = TRACE_EXEC_CACHED;
+			}
+		}
+
+		if (type == TRACE_EXEC) {
+			*ce = *rec;
+		}
+	}
+
+	n = 1;
+
+	if (addr != ((st->addr[cls] + st->cnt[cls]) & 0xffffffff)) {
+		type |= TRACE_TAG_ADDR;
+
+		/* zigzag coded difference to the previous address */
+		val = (addr - st->addr[cls]) & 0xffffffff;
+		val = (val & 0x80000000) ? ~(val << 1) : (val << 1);
+		val &= 0xffffffff;
+
+		while (val >= 0x80) {
+			buf[n++] = (val & 0x7f) | 0x80;
+			val >>= 7;
+		}
+
+		buf[n++] = val;
+	}
+
+	if ((type & TRACE_TAG_TYPE) != TRACE_EXEC_CACHED) {
+		for (i = 0; i < cnt; i++) {
+			buf[n++] = rec->data[i];
+		}
+	}
+
+	buf[0] = type | (cnt << 4);
+
+	st->addr[cls] = addr;
+	st->cnt[cls] = cnt;
+
+	return (n);
+}
+
+static
+void trace_write_buf (trace_t *tr, const trace_rec_t *rec, unsigned cnt)
+{
+	unsigned i, n;
+
+	n = 0;
+
+	for (i = 0; i < cnt; i++) {
+		n += trace_encode (&tr->st, rec + i, tr->out + n);
+
+		if ((n + TRACE_REC_MAX) > TRACE_OUT_SIZE) {
+			fwrite (tr->out, 1, n, tr->fp);
+			n = 0;
+		}
+	}
+
+	if (n > 0) {
+		fwrite (tr->out, 1, n, tr->fp);
+	}
+}
+
+#ifdef HAVE_PTHREAD_H
+static
+void *trace_thread (void *ext)
+{
+	trace_t *tr;
+
+	tr = ext;
+
+	pthread_mutex_lock (&tr->lock);
+
+	while (1) {
+		while ((tr->pend_buf < 0) && (tr->quit == 0)) {
+			pthread_cond_wait (&tr->cond, &tr->lock);
+		}
+
+		if (tr->pend_buf < 0) {
+			break;
+		}
+
+		pthread_mutex_unlock (&tr->lock);
+
+		trace_write_buf (tr, tr->buf[tr->pend_buf], tr->pend_cnt);
+
+		pthread_mutex_lock (&tr->lock);
+
+		tr->pend_buf = -1;
+
+		pthread_cond_broadcast (&tr->cond);
+	}
+
+	pthread_mutex_unlock (&tr->lock);
+
+	return (NULL);
+}
+#endif
+
+/*
+ * Hand the current buffer to the writer and switch to the other one.
+ */
+static
+void trace_swap (trace_t *tr)
+{
+	if (tr->idx == 0) {
+		return;
+	}
+
+#ifdef HAVE_PTHREAD_H
+	if (tr->thr_ok) {
+		pthread_mutex_lock (&tr->lock);
+
+		while (tr->pend_buf >= 0) {
+			pthread_cond_wait (&tr->cond, &tr->lock);
+		}
+
+		tr->pend_buf = tr->cur;
+		tr->pend_cnt = tr->idx;
+
+		pthread_cond_broadcast (&tr->cond);
+		pthread_mutex_unlock (&tr->lock);
+
+		tr->cur ^= 1;
+		tr->idx = 0;
+
+		return;
+	}
+#endif
+
+	trace_write_buf (tr, tr->buf[tr->cur], tr->idx);
+
+	tr->idx = 0;
+}
+
+static
+trace_rec_t *trace_get_rec (trace_t *tr)
+{
+	if (tr->idx >= TRACE_BUF_CNT) {
+		trace_swap (tr);
+	}
+
+	tr->cnt += 1;
+
+	return (&tr->buf[tr->cur][tr->idx++]);
+}
+
+trace_t *trace_new (const char *fname, const char *cpu)
+{
+	unsigned      n;
+	unsigned char buf[6];
+	trace_t       *tr;
+
+	tr = malloc (sizeof (trace_t));
+
+	if (tr == NULL) {
+		return (NULL);
+	}
+
+	tr->buf[0] = malloc (2 * TRACE_BUF_CNT * sizeof (trace_rec_t));
+	tr->out = malloc (TRACE_OUT_SIZE);
+
+	if ((tr->buf[0] == NULL) || (tr->out == NULL)) {
+		free (tr->out);
+		free (tr->buf[0]);
+		free (tr);
+		return (NULL);
+	}
+
+	tr->buf[1] = tr->buf[0] + TRACE_BUF_CNT;
+	tr->cur = 0;
+	tr->idx = 0;
+	tr->cnt = 0;
+
+	trace_state_init (&tr->st);
+
+	tr->fp = fopen (fname, "wb");
+
+	if (tr->fp == NULL) {
+		free (tr->out);
+		free (tr->buf[0]);
+		free (tr);
+		return (NULL);
+	}
+
+	n = strlen (cpu);
+
+	if (n > 255) {
+		n = 255;
+	}
+
+	memcpy (buf, "PTRC", 4);
+	buf[4] = TRACE_VERSION;
+	buf[5] = n;
+
+	fwrite (buf, 1, 6, tr->fp);
+	fwrite (cpu, 1, n, tr->fp);
+
+#ifdef HAVE_PTHREAD_H
+	tr->quit = 0;
+	tr->pend_buf = -1;
+	tr->pend_cnt = 0;
+
+	pthread_mutex_init (&tr->lock, NULL);
+	pthread_cond_init (&tr->cond, NULL);
+
+	tr->thr_ok = (pthread_create (&tr->thr, NULL, trace_thread, tr) == 0);
+#endif
+
+	return (tr);
+}
+
+void trace_del (trace_t *tr)
+{
+	if (tr == NULL) {
+		return;
+	}
+
+	trace_swap (tr);
+
+#ifdef HAVE_PTHREAD_H
+	if (tr->thr_ok) {
+		pthread_mutex_lock (&tr->lock);
+		tr->quit = 1;
+		pthread_cond_broadcast (&tr->cond);
+		pthread_mutex_unlock (&tr->lock);
+
+		pthread_join (tr->thr, NULL);
+	}
+
+	pthread_cond_destroy (&tr->cond);
+	pthread_mutex_destroy (&tr->lock);
+#endif
+
+	fclose (tr->fp);
+
+	free (tr->out);
+	free (tr->buf[0]);
+	free (tr);
+}
+
+void trace_exec (trace_t *tr, unsigned long addr, const unsigned char *op, unsigned cnt)
+{
+	trace_rec_t *rec;
+
+	if (cnt > TRACE_DATA_MAX) {
+		cnt = TRACE_DATA_MAX;
+	}
+
+	rec = trace_get_rec (tr);
+
+	rec->type = TRACE_EXEC;
+	rec->cnt = cnt;
+	rec->addr = addr & 0xffffffff;
+
+	memcpy (rec->data, op, cnt);
+}
+
+void trace_mem (trace_t *tr, unsigned type, unsigned long addr, unsigned long val, unsigned size)
+{
+	unsigned    i;
+	trace_rec_t *rec;
+
+	if (size > 4) {
+		size = 4;
+	}
+
+	rec = trace_get_rec (tr);
+
+	rec->type = type;
+	rec->cnt = size;
+	rec->addr = addr & 0xffffffff;
+
+	for (i = 0; i < size; i++) {
+		rec->data[i] = val & 0xff;
+		val >>= 8;
+	}
+}
+
+
+int trace_rd_open (trace_rd_t *rd, const char *fname)
+{
+	unsigned char buf[6];
+
+	rd->fp = fopen (fname, "rb");
+
+	if (rd->fp == NULL) {
+		return (1);
+	}
+
+	if (fread (buf, 1, 6, rd->fp) != 6) {
+		fclose (rd->fp);
+		return (1);
+	}
+
+	if ((memcmp (buf, "PTRC", 4) != 0) || (buf[4] != TRACE_VERSION)) {
+		fclose (rd->fp);
+		return (1);
+	}
+
+	if (fread (rd->cpu, 1, buf[5], rd->fp) != buf[5]) {
+		fclose (rd->fp);
+		return (1);
+	}
+
+	rd->cpu[buf[5]] = 0;
+
+	trace_state_init (&rd->st);
+
+	return (0);
+}
+
+void trace_rd_close (trace_rd_t *rd)
+{
+	if (rd->fp != NULL) {
+		fclose (rd->fp);
+		rd->fp = NULL;
+	}
+}
+
+int trace_rd_next (trace_rd_t *rd, trace_rec_t *rec)
+{
+	int         c;
+	unsigned    i, type, cnt, cls, sh;
+	uint32_t    addr, val;
+	trace_rec_t *ce;
+
+	c = fgetc (rd->fp);
+
+	if (c == EOF) {
+		return (1);
+	}
+
+	type = c & TRACE_TAG_TYPE;
+	cnt = (c & TRACE_TAG_CNT) >> 4;
+
+	if ((type == 0) || (type > TRACE_EXEC_CACHED)) {
+		return (-1);
+	}
+
+	rec->type = (type == TRACE_EXEC_CACHED) ? TRACE_EXEC : type;
+	rec->cnt = cnt;
+
+	cls = trace_get_class (rec->type);
+
+	if (c & TRACE_TAG_ADDR) {
+		val = 0;
+		sh = 0;
+
+		do {
+			c = fgetc (rd->fp);
+
+			if ((c == EOF) || (sh > 28)) {
+				return (-1);
+			}
+
+			val |= (uint32_t) (c & 0x7f) << sh;
+			sh += 7;
+		} while (c & 0x80);
+
+		val = (val & 1) ? ~(val >> 1) : (val >> 1);
+
+		addr = (rd->st.addr[cls] + val) & 0xffffffff;
+	}
+	else {
+		addr = (rd->st.addr[cls] + rd->st.cnt[cls]) & 0xffffffff;
+	}
+
+	rec->addr = addr;
+
+	if (type == TRACE_EXEC_CACHED) {
+		ce = trace_get_cache (&rd->st, addr);
+
+		if ((ce->type != TRACE_EXEC) || (ce->addr != addr) || (ce->cnt != cnt)) {
+			return (-1);
+		}
+
+		memcpy (rec->data, ce->data, cnt);
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			c = fgetc (rd->fp);
+
+			if (c == EOF) {
+				return (-1);
+			}
+
+			rec->data[i] = c;
+		}
+
+		if (type == TRACE_EXEC) {
+			*trace_get_cache (&rd->st, addr) = *rec;
+		}
+	}
+
+	rd->st.addr[cls] = addr;
+	rd->st.cnt[cls] = cnt;
+
+	return (0);
+}
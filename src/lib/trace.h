@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/lib/trace.h                                              *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_LIB_TRACE_H
+#define PCE_LIB_TRACE_H 1
+
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+
+#define TRACE_EXEC   1
+#define TRACE_MEM_RD 2
+#define TRACE_MEM_WR 3
+#define TRACE_IO_RD  4
+#define TRACE_IO_WR  5
+
+/* the maximum number of opcode or data bytes in a record */
+#define TRACE_DATA_MAX 15
+
+/* the number of records in each of the two buffers */
+#define TRACE_BUF_CNT 65536
+
+#define TRACE_CACHE_CNT 4096
+
+
+typedef struct {
+	unsigned char type;
+	unsigned char cnt;
+	uint32_t      addr;
+	unsigned char data[TRACE_DATA_MAX];
+} trace_rec_t;
+
+
+/*
+ * The state that is shared by the encoder and the decoder. Addresses
+ * are delta coded against the previous record of the same class and
+ * opcode bytes are looked up in a small cache indexed by address.
+ */
+typedef struct {
+	uint32_t      addr[3];
+	uint32_t      cnt[3];
+
+	trace_rec_t   cache[TRACE_CACHE_CNT];
+} trace_state_t;
+
+
+/*!***************************************************************************
+ * @short An execution trace recorder
+ *
+ * Records are collected in one of two buffers. When a buffer is full
+ * it is handed to a background thread that encodes it and writes it
+ * to the file, while the other buffer is filled.
+ *****************************************************************************/
+typedef struct {
+	FILE          *fp;
+
+	trace_rec_t   *buf[2];
+	unsigned      cur;
+	unsigned      idx;
+
+	trace_state_t st;
+
+	unsigned char *out;
+
+	unsigned long cnt;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_t       thr;
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+
+	char            thr_ok;
+	char            quit;
+
+	/* the buffer that is being written or -1 */
+	int             pend_buf;
+	unsigned        pend_cnt;
+#endif
+} trace_t;
+
+
+/*!***************************************************************************
+ * @short A trace file reader
+ *****************************************************************************/
+typedef struct {
+	FILE          *fp;
+
+	char          cpu[256];
+
+	trace_state_t st;
+} trace_rd_t;
+
+
+/*!***************************************************************************
+ * @short Create a trace recorder
+ * @param fname The trace file name
+ * @param cpu   The cpu name, used by pce-trace to select a disassembler
+ *****************************************************************************/
+trace_t *trace_new (const char *fname, const char *cpu);
+
+/*!***************************************************************************
+ * @short Write all pending records and delete the recorder
+ *****************************************************************************/
+void trace_del (trace_t *tr);
+
+/*!***************************************************************************
+ * @short Record the execution of an instruction
+ * @param addr The instruction address
+ * @param op   The opcode bytes, 32 bit opcodes most significant byte first
+ * @param cnt  The number of opcode bytes
+ *
+ * The signature matches the cpu trace hooks, so this function can be
+ * used directly as a hook with tr as the hook context.
+ *****************************************************************************/
+void trace_exec (trace_t *tr, unsigned long addr, const unsigned char *op, unsigned cnt);
+
+/*!***************************************************************************
+ * @short Record a memory or I/O access
+ * @param type One of TRACE_MEM_RD, TRACE_MEM_WR, TRACE_IO_RD and TRACE_IO_WR
+ * @param size The access size in bytes
+ *****************************************************************************/
+void trace_mem (trace_t *tr, unsigned type, unsigned long addr, unsigned long val, unsigned size);
+
+
+/*!***************************************************************************
+ * @short Open a trace file for reading
+ * @return Zero if successful
+ *****************************************************************************/
+int trace_rd_open (trace_rd_t *rd, const char *fname);
+
+void trace_rd_close (trace_rd_t *rd);
+
+/*!***************************************************************************
+ * @short Read the next record
+ * @return Zero if successful, 1 at the end of the file and -1 on error
+ *****************************************************************************/
+int trace_rd_next (trace_rd_t *rd, trace_rec_t *rec);
+
+
+#endif
@@ -0,0 +1,643 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/utils/pce-trace/main.c                                   *
+ * Created:     2026-10-19 by Hampa Hug <hampa@hampa.ch>                     *
+ * Copyright:   (C) 2026 Hampa Hug <hampa@hampa.ch>                          *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cpu/e8086/e8086.h>
+#include <cpu/e68000/e68000.h>
+#include <cpu/e8080/e8080.h>
+#include <cpu/e6502/e6502.h>
+#include <cpu/arm/arm.h>
+#include <cpu/ppc405/ppc405.h>
+#include <cpu/sparc32/sparc32.h>
+
+#include <lib/getopt.h>
+#include <lib/trace.h>
+
+
+#define CPU_NONE    0
+#define CPU_8086    1
+#define CPU_68000   2
+#define CPU_8080    3
+#define CPU_Z80     4
+#define CPU_6502    5
+#define CPU_ARM     6
+#define CPU_PPC405  7
+#define CPU_SPARC32 8
+
+
+typedef void (*disasm_f) (FILE *fp, const trace_rec_t *rec);
+
+
+const char    *arg0 = NULL;
+
+static const char    *par_cpu = NULL;
+
+static unsigned long par_skip = 0;
+static unsigned long par_cnt = 0;
+
+static char          par_addr_all = 1;
+static unsigned long par_addr[2];
+
+static char          par_exec_only = 0;
+static char          par_summary = 0;
+
+
+static pce_option_t opts[] = {
+	{ '?', 0, "help", NULL, "Print usage information" },
+	{ 'a', 1, "address", "addr1[-addr2]", "Only print instructions in an address range [all]" },
+	{ 'c', 1, "cpu", "name", "Override the cpu type [auto]" },
+	{ 'n', 1, "count", "n", "Print at most n records [all]" },
+	{ 's', 1, "skip", "n", "Skip the first n records [0]" },
+	{ 'S', 0, "summary", NULL, "Only print the number of records [no]" },
+	{ 'V', 0, "version", NULL, "Print version information" },
+	{ 'x', 0, "exec-only", NULL, "Omit memory and I/O accesses [no]" },
+	{  -1, 0, NULL, NULL, NULL }
+};
+
+
+static
+void print_help (void)
+{
+	pce_getopt_help (
+		"pce-trace: print PCE execution trace files",
+		"usage: pce-trace [options] file",
+		opts
+	);
+
+	fputs (
+		"\n"
+		"cpu types are:\n"
+		"  8086, 68000, 8080, z80, 6502, arm, ppc405, sparc32\n",
+		stdout
+	);
+
+	fflush (stdout);
+}
+
+static
+void print_version (void)
+{
+	fputs (
+		"pce-trace version " PCE_VERSION_STR
+		"\n\n"
+		"Copyright (C) 2026 Hampa Hug <hampa@hampa.ch>\n",
+		stdout
+	);
+
+	fflush (stdout);
+}
+
+static
+int parse_ulong (const char *str, unsigned long *val)
+{
+	char *end;
+
+	*val = strtoul (str, &end, 0);
+
+	if ((end == str) || (*end != 0)) {
+		fprintf (stderr, "%s: bad number (%s)\n", arg0, str);
+		return (1);
+	}
+
+	return (0);
+}
+
+static
+int parse_range (const char *str, unsigned long *val)
+{
+	char *end;
+
+	val[0] = strtoul (str, &end, 16);
+
+	if (end == str) {
+		fprintf (stderr, "%s: bad address range (%s)\n", arg0, str);
+		return (1);
+	}
+
+	if (*end == 0) {
+		val[1] = val[0];
+		return (0);
+	}
+
+	if (*end != '-') {
+		fprintf (stderr, "%s: bad address range (%s)\n", arg0, str);
+		return (1);
+	}
+
+	str = end + 1;
+
+	val[1] = strtoul (str, &end, 16);
+
+	if ((end == str) || (*end != 0)) {
+		fprintf (stderr, "%s: bad address range (%s)\n", arg0, str);
+		return (1);
+	}
+
+	return (0);
+}
+
+static
+unsigned get_cpu_type (const char *str)
+{
+	if (strcmp (str, "8086") == 0) {
+		return (CPU_8086);
+	}
+	else if (strcmp (str, "68000") == 0) {
+		return (CPU_68000);
+	}
+	else if (strcmp (str, "8080") == 0) {
+		return (CPU_8080);
+	}
+	else if (strcmp (str, "z80") == 0) {
+		return (CPU_Z80);
+	}
+	else if (strcmp (str, "6502") == 0) {
+		return (CPU_6502);
+	}
+	else if (strcmp (str, "arm") == 0) {
+		return (CPU_ARM);
+	}
+	else if (strcmp (str, "ppc405") == 0) {
+		return (CPU_PPC405);
+	}
+	else if (strcmp (str, "sparc32") == 0) {
+		return (CPU_SPARC32);
+	}
+
+	return (CPU_NONE);
+}
+
+static
+uint32_t get_ir (const trace_rec_t *rec)
+{
+	unsigned i;
+	uint32_t ir;
+
+	ir = 0;
+
+	for (i = 0; i < 4; i++) {
+		ir = (ir << 8) | ((i < rec->cnt) ? rec->data[i] : 0);
+	}
+
+	return (ir);
+}
+
+/*
+ * Copy the opcode bytes into a buffer that is large enough for
+ * every disassembler, padding with zeros.
+ */
+static
+void get_src (unsigned char *src, const trace_rec_t *rec)
+{
+	memset (src, 0, 16);
+	memcpy (src, rec->data, rec->cnt);
+}
+
+static
+void print_bytes (FILE *fp, const unsigned char *buf, unsigned cnt, unsigned w)
+{
+	unsigned i;
+
+	for (i = 0; i < cnt; i++) {
+		fprintf (fp, "%02X", buf[i]);
+	}
+
+	for (i = 2 * cnt; i < w; i++) {
+		fputc (' ', fp);
+	}
+}
+
+static
+void print_args (FILE *fp, const char *op, unsigned cnt, const char **arg)
+{
+	unsigned i;
+
+	fprintf (fp, "%-8s", op);
+
+	for (i = 0; i < cnt; i++) {
+		fprintf (fp, "%s%s", (i == 0) ? " " : ", ", arg[i]);
+	}
+}
+
+static
+void disasm_8086 (FILE *fp, const trace_rec_t *rec)
+{
+	unsigned char src[16];
+	const char    *arg[2];
+	e86_disasm_t  op;
+
+	get_src (src, rec);
+
+	e86_disasm (&op, src, rec->addr & 0xffff);
+
+	arg[0] = op.arg1;
+	arg[1] = op.arg2;
+
+	fprintf (fp, "%04lX:%04lX  ",
+		(unsigned long) (rec->addr >> 16) & 0xffff,
+		(unsigned long) rec->addr & 0xffff
+	);
+
+	print_bytes (fp, op.dat, op.dat_n, 14);
+	fputs ("  ", fp);
+	print_args (fp, op.op, op.arg_n, arg);
+}
+
+static
+void disasm_68000 (FILE *fp, const trace_rec_t *rec)
+{
+	unsigned char src[16];
+	const char    *arg[3];
+	e68_dasm_t    op;
+
+	get_src (src, rec);
+
+	e68_dasm (&op, rec->addr, src);
+
+	arg[0] = op.arg1;
+	arg[1] = op.arg2;
+	arg[2] = op.arg3;
+
+	fprintf (fp, "%08lX  ", (unsigned long) rec->addr);
+	print_bytes (fp, src, 2 * op.irn, 20);
+	fputs ("  ", fp);
+	print_args (fp, op.op, op.argn, arg);
+}
+
+static
+void disasm_8080 (FILE *fp, const trace_rec_t *rec, int z80)
+{
+	unsigned char  src[16];
+	const char     *arg[2];
+	e8080_disasm_t op;
+
+	get_src (src, rec);
+
+	if (z80) {
+		z80_disasm (&op, src, rec->addr & 0xffff);
+	}
+	else {
+		e8080_disasm (&op, src, rec->addr & 0xffff);
+	}
+
+	arg[0] = op.arg[0];
+	arg[1] = op.arg[1];
+
+	fprintf (fp, "%04lX  ", (unsigned long) rec->addr & 0xffff);
+	print_bytes (fp, op.data, op.data_cnt, 8);
+	fputs ("  ", fp);
+	print_args (fp, op.op, op.arg_cnt, arg);
+}
+
+static
+void disasm_i8080 (FILE *fp, const trace_rec_t *rec)
+{
+	disasm_8080 (fp, rec, 0);
+}
+
+static
+void disasm_z80 (FILE *fp, const trace_rec_t *rec)
+{
+	disasm_8080 (fp, rec, 1);
+}
+
+static
+void disasm_6502 (FILE *fp, const trace_rec_t *rec)
+{
+	unsigned char  src[16];
+	const char     *arg[1];
+	e6502_disasm_t op;
+
+	get_src (src, rec);
+
+	e6502_disasm (&op, src, rec->addr & 0xffff);
+
+	arg[0] = op.arg1;
+
+	fprintf (fp, "%04lX  ", (unsigned long) rec->addr & 0xffff);
+	print_bytes (fp, op.dat, op.dat_n, 6);
+	fputs ("  ", fp);
+	print_args (fp, op.op, op.arg_n, arg);
+}
+
+static
+void disasm_arm (FILE *fp, const trace_rec_t *rec)
+{
+	unsigned   i;
+	const char *arg[8];
+	arm_dasm_t op;
+
+	arm_dasm (&op, rec->addr, get_ir (rec));
+
+	for (i = 0; i < 8; i++) {
+		arg[i] = op.arg[i];
+	}
+
+	fprintf (fp, "%08lX  %08lX  ", (unsigned long) rec->addr, (unsigned long) op.ir);
+	print_args (fp, op.op, (op.argn < 8) ? op.argn : 8, arg);
+}
+
+static
+void disasm_ppc405 (FILE *fp, const trace_rec_t *rec)
+{
+	const char    *arg[5];
+	p405_disasm_t op;
+
+	p405_disasm (&op, rec->addr, get_ir (rec));
+
+	arg[0] = op.arg1;
+	arg[1] = op.arg2;
+	arg[2] = op.arg3;
+	arg[3] = op.arg4;
+	arg[4] = op.arg5;
+
+	fprintf (fp, "%08lX  %08lX  ", (unsigned long) rec->addr, (unsigned long) op.ir);
+	print_args (fp, op.op, (op.argn < 5) ? op.argn : 5, arg);
+}
+
+static
+void disasm_sparc32 (FILE *fp, const trace_rec_t *rec)
+{
+	const char *arg[3];
+	s32_dasm_t op;
+
+	s32_dasm (&op, rec->addr, get_ir (rec));
+
+	arg[0] = op.arg1;
+	arg[1] = op.arg2;
+	arg[2] = op.arg3;
+
+	fprintf (fp, "%08lX  %08lX  ", (unsigned long) rec->addr, (unsigned long) op.ir);
+	print_args (fp, op.op, (op.argn < 3) ? op.argn : 3, arg);
+}
+
+static
+void disasm_none (FILE *fp, const trace_rec_t *rec)
+{
+	fprintf (fp, "%08lX  ", (unsigned long) rec->addr);
+	print_bytes (fp, rec->data, rec->cnt, 0);
+}
+
+static
+disasm_f get_disasm (unsigned type)
+{
+	switch (type) {
+	case CPU_8086:
+		return (disasm_8086);
+
+	case CPU_68000:
+		return (disasm_68000);
+
+	case CPU_8080:
+		return (disasm_i8080);
+
+	case CPU_Z80:
+		return (disasm_z80);
+
+	case CPU_6502:
+		return (disasm_6502);
+
+	case CPU_ARM:
+		return (disasm_arm);
+
+	case CPU_PPC405:
+		return (disasm_ppc405);
+
+	case CPU_SPARC32:
+		return (disasm_sparc32);
+	}
+
+	return (disasm_none);
+}
+
+static
+void print_access (FILE *fp, const trace_rec_t *rec)
+{
+	unsigned      i;
+	unsigned long val;
+	const char    *str;
+
+	val = 0;
+
+	for (i = rec->cnt; i > 0; i--) {
+		val = (val << 8) | rec->data[i - 1];
+	}
+
+	switch (rec->type) {
+	case TRACE_MEM_RD:
+		str = "MEM RD";
+		break;
+
+	case TRACE_MEM_WR:
+		str = "MEM WR";
+		break;
+
+	case TRACE_IO_RD:
+		str = "IO  RD";
+		break;
+
+	case TRACE_IO_WR:
+		str = "IO  WR";
+		break;
+
+	default:
+		str = "?";
+		break;
+	}
+
+	fprintf (fp, "    %s%u  %08lX = %0*lX",
+		str, 8 * rec->cnt, (unsigned long) rec->addr, 2 * rec->cnt, val
+	);
+}
+
+static
+int print_trace (const char *fname)
+{
+	int           r;
+	unsigned      type;
+	unsigned long idx, cnt;
+	disasm_f      dis;
+	trace_rd_t    rd;
+	trace_rec_t   rec;
+
+	if (trace_rd_open (&rd, fname)) {
+		fprintf (stderr, "%s: can't open trace file (%s)\n", arg0, fname);
+		return (1);
+	}
+
+	type = get_cpu_type ((par_cpu != NULL) ? par_cpu : rd.cpu);
+
+	if (type == CPU_NONE) {
+		fprintf (stderr, "%s: unknown cpu (%s)\n", arg0,
+			(par_cpu != NULL) ? par_cpu : rd.cpu
+		);
+	}
+
+	dis = get_disasm (type);
+
+	idx = 0;
+	cnt = 0;
+
+	while ((r = trace_rd_next (&rd, &rec)) == 0) {
+		idx += 1;
+
+		if (par_summary) {
+			continue;
+		}
+
+		if (idx <= par_skip) {
+			continue;
+		}
+
+		if (rec.type == TRACE_EXEC) {
+			if (par_addr_all == 0) {
+				if ((rec.addr < par_addr[0]) || (rec.addr > par_addr[1])) {
+					continue;
+				}
+			}
+
+			dis (stdout, &rec);
+		}
+		else {
+			if (par_exec_only) {
+				continue;
+			}
+
+			print_access (stdout, &rec);
+		}
+
+		fputc ('\n', stdout);
+
+		cnt += 1;
+
+		if ((par_cnt > 0) && (cnt >= par_cnt)) {
+			break;
+		}
+	}
+
+	if (r < 0) {
+		fprintf (stderr, "%s: corrupt trace file at record %lu (%s)\n",
+			arg0, idx, fname
+		);
+	}
+
+	if (par_summary) {
+		printf ("cpu:     %s\nrecords: %lu\n", rd.cpu, idx);
+	}
+
+	trace_rd_close (&rd);
+
+	return (r < 0);
+}
+
+int main (int argc, char **argv)
+{
+	int        r;
+	char       **optarg;
+	const char *fname;
+
+	arg0 = argv[0];
+
+	fname = NULL;
+
+	while (1) {
+		r = pce_getopt (argc, argv, &optarg, opts);
+
+		if (r == GETOPT_DONE) {
+			break;
+		}
+
+		if (r < 0) {
+			return (1);
+		}
+
+		switch (r) {
+		case '?':
+			print_help();
+			return (0);
+
+		case 'V':
+			print_version();
+			return (0);
+
+		case 'a':
+			if (parse_range (optarg[0], par_addr)) {
+				return (1);
+			}
+			par_addr_all = 0;
+			break;
+
+		case 'c':
+			par_cpu = optarg[0];
+			break;
+
+		case 'n':
+			if (parse_ulong (optarg[0], &par_cnt)) {
+				return (1);
+			}
+			break;
+
+		case 's':
+			if (parse_ulong (optarg[0], &par_skip)) {
+				return (1);
+			}
+			break;
+
+		case 'S':
+			par_summary = 1;
+			break;
+
+		case 'x':
+			par_exec_only = 1;
+			break;
+
+		case 0:
+			if (fname != NULL) {
+				fprintf (stderr, "%s: too many files (%s)\n",
+					arg0, optarg[0]
+				);
+				return (1);
+			}
+			fname = optarg[0];
+			break;
+
+		default:
+			return (1);
+		}
+	}
+
+	if (fname == NULL) {
+		print_help();
+		return (1);
+	}
+
+	if (print_trace (fname)) {
+		return (1);
+	}
+
+	return (0);
+}